@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Host test of DHTAsync against synthetic DHT22 answers.
+ *
+ * The answer of the sensor is generated as a list of level changes of the
+ * data line. It is fed either through the pin change interrupt handler (pin
+ * A8) or through polling (pin 28), where each call to micros() advances the
+ * simulated time by 1us. Time starts shortly before micros() wraps around.
+ *
+ * Build and run from the repository root:
+ *
+ *     Docs/debug_host/run.sh Docs/debug_dht/dht_sim.cpp \
+ *         libraries/DHTAsync/DHTAsync.cpp
+ */
+
+#include "DHTAsync.h"
+#include "../debug_host/HostTest.h"
+
+#include <vector>
+
+namespace
+{
+  /// Pin with pin change interrupt (A8).
+  static constexpr uint8_t PIN_INTERRUPT = 62;
+  /// Pin without pin change interrupt.
+  static constexpr uint8_t PIN_POLLING = 28;
+  /// Start time of each read, so micros() wraps around during the answer.
+  static constexpr unsigned long START_TIME = 0xfffffe00UL;
+
+  /// Level change of the data line.
+  struct Change
+  {
+    unsigned long time;
+    bool level;
+  };
+
+  /// Simulated time in us.
+  unsigned long s_now = 0;
+  /// Set when polling, then each micros() call advances time and updates the pin.
+  bool s_polling = false;
+  /// Answer of the sensor being simulated.
+  std::vector<Change> s_answer;
+
+  /// Set input level of the data line at current time from the answer.
+  void updatePin()
+  {
+    bool level = true;
+    for (auto& c : s_answer)
+      if (long(s_now - c.time) >= 0)
+        level = c.level;
+    sim_port[0] = level ? 0x01 : 0;
+  }
+
+  /*!
+   * @brief Generate answer of the sensor for 5 data bytes.
+   *
+   * @param data data bytes (humidity, temperature, checksum).
+   * @param start time of releasing the data line.
+   * @param jitter maximum deviation of high phases in us.
+   * @param bits count of bits to send (fewer than 40 to simulate interrupted answer).
+   * @param stall_bit index of the bit with too long high phase (-1 for none).
+   */
+  void makeAnswer(const uint8_t* data, unsigned long start, int jitter, int bits = 40, int stall_bit = -1)
+  {
+    s_answer.clear();
+    unsigned long t = start + 30;   // sensor responds 20-40us after release
+    s_answer.push_back({t, false});
+    t += 80;
+    s_answer.push_back({t, true});
+    t += 80;
+    for (int i = 0; i < bits; ++i) {
+      s_answer.push_back({t, false});
+      t += 50;
+      s_answer.push_back({t, true});
+      bool bit = (data[i >> 3] >> (7 - (i & 7))) & 1;
+      t += (bit ? 70 : 27) + ((i % 3) - 1) * jitter;
+      if (i == stall_bit)
+        t += 200;
+    }
+    s_answer.push_back({t, false});
+    t += 50;
+    s_answer.push_back({t, true});
+  }
+
+  /// Fill in checksum of data bytes.
+  void setChecksum(uint8_t* data)
+  {
+    data[4] = uint8_t(data[0] + data[1] + data[2] + data[3]);
+  }
+
+  /// Run one read with the current answer and return its status.
+  DHTAsync::Status read(DHTAsync& dht)
+  {
+    s_now = START_TIME;
+    s_polling = false;
+    updatePin();
+    auto wait = dht.advance();   // request pulse
+    CHECK(wait > 1000);
+    CHECK((sim_port[1] & 0x01) && !(sim_port[2] & 0x01));
+    s_now += wait;
+    if (!dht.hasInterrupt()) {
+      s_polling = true;
+      wait = dht.advance();      // polls the answer synchronously
+      s_polling = false;
+      CHECK(wait == 0);
+      return dht.getStatus();
+    }
+    wait = dht.advance();        // start recording
+    CHECK(wait > 0);
+    CHECK(PCMSK2 & 0x01);
+    for (auto& c : s_answer) {
+      s_now = c.time + 3;        // interrupt latency
+      updatePin();
+      DHTAsync::interrupt();
+    }
+    s_now += wait;
+    dht.advance();               // finish recording
+    CHECK(!(PCMSK2 & 0x01));
+    return dht.getStatus();
+  }
+
+  /// Check reading of all answer variants on one pin.
+  void test(uint8_t pin)
+  {
+    DHTAsync dht(pin);
+    dht.begin();
+    CHECK(dht.hasInterrupt() == (pin == PIN_INTERRUPT));
+
+    // 65.2%, 35.1C with jitter, wrapping micros()
+    uint8_t data1[5] = { 0x02, 0x8c, 0x01, 0x5f, 0 };
+    setChecksum(data1);
+    makeAnswer(data1, START_TIME + 1100, 8);
+    CHECK(read(dht) == DHTAsync::Status::DONE);
+    CHECK(dht.getHumidity() == 652);
+    CHECK(dht.getTemperature() == 351);
+
+    // negative temperature -10.1C in sign-magnitude format
+    uint8_t data2[5] = { 0x01, 0xf4, 0x80, 0x65, 0 };
+    setChecksum(data2);
+    makeAnswer(data2, START_TIME + 1100, 0);
+    CHECK(read(dht) == DHTAsync::Status::DONE);
+    CHECK(dht.getHumidity() == 500);
+    CHECK(dht.getTemperature() == -101);
+
+    // wrong checksum, last values are kept
+    uint8_t data3[5] = { 0x01, 0xf4, 0x00, 0x65, 0x12 };
+    makeAnswer(data3, START_TIME + 1100, 0);
+    CHECK(read(dht) == DHTAsync::Status::CHECKSUM);
+    CHECK(dht.getTemperature() == -101);
+
+    // answer interrupted after 30 bits
+    makeAnswer(data1, START_TIME + 1100, 0, 30);
+    CHECK(read(dht) == DHTAsync::Status::TIMEOUT);
+
+    // sensor stalls in the middle of the answer
+    makeAnswer(data1, START_TIME + 1100, 0, 40, 20);
+    CHECK(read(dht) == DHTAsync::Status::TIMEOUT);
+
+    // no sensor
+    s_answer.clear();
+    CHECK(read(dht) == DHTAsync::Status::NO_RESPONSE);
+  }
+
+  /// Check decoding of recorded periods directly.
+  void testDecode()
+  {
+    uint8_t periods[DHTAsync::EDGE_COUNT - 1];
+    periods[0] = 160;
+    for (uint8_t i = 1; i < sizeof(periods); ++i)
+      periods[i] = 77;    // all zeroes, checksum OK
+    int16_t t = 1;
+    uint16_t h = 1;
+    CHECK(DHTAsync::decode(periods, sizeof(periods), t, h) == DHTAsync::Status::DONE);
+    CHECK(t == 0 && h == 0);
+    CHECK(DHTAsync::decode(periods, sizeof(periods) - 1, t, h) == DHTAsync::Status::TIMEOUT);
+    CHECK(DHTAsync::decode(periods, 0, t, h) == DHTAsync::Status::TIMEOUT);
+    periods[0] = 80;      // response too short
+    CHECK(DHTAsync::decode(periods, sizeof(periods), t, h) == DHTAsync::Status::TIMEOUT);
+    periods[0] = 160;
+    periods[10] = 255;    // saturated period
+    CHECK(DHTAsync::decode(periods, sizeof(periods), t, h) == DHTAsync::Status::TIMEOUT);
+  }
+}
+
+unsigned long micros()
+{
+  if (s_polling) {
+    ++s_now;
+    updatePin();
+  }
+  return s_now;
+}
+
+int main()
+{
+  testDecode();
+  test(PIN_INTERRUPT);
+  test(PIN_POLLING);
+  return hostTestResult();
+}
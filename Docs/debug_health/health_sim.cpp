@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Host simulation of temperature sensor health and estimates.
+ *
+ * TempSensors is driven by the scheduler over simulated time. OneWireAsync
+ * is replaced by a transaction-level model of one DS18B20 per bus, which
+ * honors the configured resolution, so the test can observe resolution
+ * switches like on the bus. The air temperatures follow the heat balance
+ * T1 + T3 = T2 + T4 with 75% efficiency and change slowly, except for the
+ * outlet air, which stays within one step of 11 bits.
+ *
+ * Scenarios in one run of about 13 hours of simulated time:
+ *   - T3 changing only at 12 bits switches to 12 bits after 6h and stays fresh,
+ *   - T4 not changing at all switches to 12 bits after 6h and is stuck after 12h,
+ *   - T2 disappearing is stale, T1 reporting 85C (power-on value) is out of range,
+ *   - T4 jumping between readings is noisy,
+ *   - single failed sensor is estimated from the heat balance,
+ *   - failed T1 and T4 estimate T1 from the last efficiency,
+ *   - implausible estimates and extreme efficiencies are not used,
+ *   - each failed sensor recovers to fresh.
+ *
+ * Build and run from the repository root:
+ *
+ *     Docs/debug_host/run.sh Docs/debug_health/health_sim.cpp \
+ *         TempSensors.cpp KWLConfig.cpp PublishPolicy.cpp CentiCelsius.cpp \
+ *         Antifreeze.cpp FanControl.cpp Relay.cpp libraries/FanRPM/FanRPM.cpp \
+ *         libraries/TimeScheduler/Task.cpp libraries/TimeScheduler/TaskTimingStats.cpp \
+ *         libraries/TimeScheduler/TaskTrace.cpp libraries/TimeScheduler/TimeScheduler.cpp \
+ *         libraries/Logger/Logger.cpp libraries/MessageHandler/MessageHandler.cpp \
+ *         libraries/PersistentConfiguration/PersistentConfiguration.cpp
+ */
+
+#include "KWLConfig.h"
+#include "TempSensors.h"
+#include "MQTTTopic.hpp"
+#include "../debug_host/HostTest.h"
+
+#include <OneWireAsync.h>
+#include <TimeScheduler.h>
+
+namespace
+{
+  /// Time between scheduler loops in us.
+  static constexpr unsigned long LOOP_US = 10000;
+  /// One minute in ms.
+  static constexpr unsigned long MINUTE = 60000UL;
+  /// One hour in ms.
+  static constexpr unsigned long HOUR = 60 * MINUTE;
+  /// Time to detect a failed or recovered sensor in ms (each sensor is read every 8s).
+  static constexpr unsigned long DETECT_MS = MINUTE;
+  /// Maximum error of the heat balance estimate in C (11 bits in three sensors).
+  static constexpr double MAX_BALANCE_ERROR = 0.5;
+  /// Maximum error of the efficiency estimate in C (quantization amplified by 1 / (1 - eff)).
+  static constexpr double MAX_EFFICIENCY_ERROR = 1.5;
+
+  /// Model of a DS18B20 sensor on its own bus.
+  struct SensorModel
+  {
+    bool present = true;        ///< Sensor answers.
+    double fixed = NAN;         ///< Reading independent of air temperature, if not NaN.
+    double noise = 0;           ///< Error added to readings with alternating sign.
+    bool noise_sign = false;    ///< Sign of the next error.
+    uint8_t resolution = 12;    ///< Configured resolution.
+    unsigned long full_resolution_ms = 0; ///< Time of the last switch to 12 bits.
+    uint8_t scratchpad[9] = {}; ///< Scratchpad with the last conversion.
+  };
+
+  /// Sensors on buses of T1-T4.
+  SensorModel s_sensors[4];
+  /// Efficiency of the simulated heat exchanger.
+  double s_efficiency = 0.75;
+
+  /// Message published last per health topic of T1-T4.
+  char s_health[4][24];
+
+  /// Output discarding initialization messages.
+  class NullPrint : public Print
+  {
+  public:
+    virtual size_t write(uint8_t) override { return 1; }
+  };
+
+  /// Get sensor index by OneWire bus pin.
+  uint8_t sensorIndex(uint8_t pin)
+  {
+    switch (pin) {
+      case KWLConfig::PinTemp1OneWireBus: return 0;
+      case KWLConfig::PinTemp2OneWireBus: return 1;
+      case KWLConfig::PinTemp3OneWireBus: return 2;
+      default: return 3;
+    }
+  }
+
+  /// Get air temperature at the sensor at a given time.
+  double airTemperature(uint8_t index, unsigned long ms)
+  {
+    double hours = ms / double(HOUR);
+    double t1 = 5 + sin(hours * M_PI);  // period 2h
+    double t3 = 20.06 + 0.04 * sin(hours * 6 * M_PI);  // 20.02-20.10C, period 20min
+    double t2 = t1 + s_efficiency * (t3 - t1);
+    switch (index) {
+      case 0: return t1;
+      case 1: return t2;
+      case 2: return t3;
+      default: return t1 + t3 - t2;
+    }
+  }
+
+  /// Convert temperature in the sensor and update its scratchpad.
+  void convert(uint8_t index)
+  {
+    auto& s = s_sensors[index];
+    double t = isnan(s.fixed) ? airTemperature(index, millis()) : s.fixed;
+    if (s.noise != 0) {
+      t += s.noise_sign ? s.noise : -s.noise;
+      s.noise_sign = !s.noise_sign;
+    }
+    auto raw = int16_t(floor(t * 16));
+    raw &= ~int16_t((1 << (12 - s.resolution)) - 1);
+    const uint8_t data[] = {
+      uint8_t(raw), uint8_t(raw >> 8), 0x4B, 0x46, uint8_t(((s.resolution - 9) << 5) | 0x1F), 0xFF, 0x0C, 0x10
+    };
+    memcpy(s.scratchpad, data, sizeof(data));
+    s.scratchpad[8] = OneWireAsync::crc8(data, sizeof(data));
+  }
+
+  /// Publish callback recording health messages.
+  bool recordPublish(void*, const char* topic, const char* payload, bool)
+  {
+    const __FlashStringHelper* const topics[] = {
+      MQTTTopic::KwlHealthAussenluft, MQTTTopic::KwlHealthZuluft,
+      MQTTTopic::KwlHealthAbluft, MQTTTopic::KwlHealthFortluft
+    };
+    for (uint8_t i = 0; i < 4; ++i)
+      if (strcmp_P(topic, reinterpret_cast<const char*>(topics[i])) == 0)
+        strlcpy(s_health[i], payload, sizeof(s_health[i]));
+    return true;
+  }
+
+  /// Run the scheduler and sending of messages (like NetworkClient) for a given time.
+  void run(Scheduler::TimeScheduler& scheduler, unsigned long ms)
+  {
+    auto start = millis();
+    while (millis() - start < ms) {
+      scheduler.loop();
+      PublishTask::loop();
+      sim_time_us += LOOP_US;
+    }
+  }
+
+  /// Check that sensor is in given health and published it.
+  bool hasHealth(const TempSensors& temp, uint8_t index, TempSensorHealth health, bool estimated)
+  {
+    char expected[24];
+    strlcpy_P(expected, reinterpret_cast<const char*>(TempSensors::getHealthName(health)), sizeof(expected));
+    if (estimated)
+      strlcat(expected, ",estimated", sizeof(expected));
+    bool ok = temp.getHealth(index) == health && temp.isEstimated(index) == estimated &&
+        strcmp(s_health[index], expected) == 0;
+    if (!ok)
+      printf("T%u at %lus: health %s, published %s, expected %s\n", index + 1, millis() / 1000,
+             reinterpret_cast<const char*>(TempSensors::getHealthName(temp.getHealth(index))),
+             s_health[index], expected);
+    return ok;
+  }
+
+  /// Check that all sensors are fresh and measured.
+  bool allFresh(const TempSensors& temp)
+  {
+    bool ok = true;
+    for (uint8_t i = 0; i < 4; ++i)
+      ok &= hasHealth(temp, i, TempSensorHealth::FRESH, false);
+    return ok;
+  }
+
+  /// Get temperature in C.
+  double degrees(CentiCelsius t) { return t.toCenti() / 100.0; }
+}
+
+// Transaction-level model of OneWireAsync: each transaction completes right away.
+
+OneWireAsync::OneWireAsync(uint8_t pin) noexcept :
+  in_reg_(nullptr), mode_reg_(nullptr), out_reg_(nullptr), mask_(sensorIndex(pin))
+{}
+
+bool OneWireAsync::start(const uint8_t* tx, uint8_t tx_len, uint8_t* rx, uint8_t rx_len, bool power) noexcept
+{
+  auto& s = s_sensors[mask_];
+  memcpy(tx_, tx, tx_len);
+  tx_len_ = tx_len;
+  power_ = power;
+  if (rx_len)
+    memset(rx, 0, rx_len);
+  if (!s.present) {
+    status_ = Status::NO_DEVICE;
+    return true;
+  }
+  if (tx[0] == 0x33) {
+    // Read ROM
+    const uint8_t rom[] = { 0x28, uint8_t(mask_ + 1), 0x12, 0x34, 0x56, 0x78, 0x9A };
+    memcpy(rx, rom, sizeof(rom));
+    rx[7] = crc8(rom, sizeof(rom));
+  } else if (tx[1] == 0x44) {
+    convert(mask_);
+  } else if (tx[1] == 0x4E) {
+    auto resolution = uint8_t(9 + ((tx[4] >> 5) & 3));
+    if (resolution == 12 && s.resolution < 12)
+      s.full_resolution_ms = millis();
+    s.resolution = resolution;
+  } else if (tx[1] == 0xB4) {
+    rx[0] = 0xFF;  // external power supply
+  } else if (tx[1] == 0xBE) {
+    memcpy(rx, s.scratchpad, rx_len < sizeof(s.scratchpad) ? rx_len : sizeof(s.scratchpad));
+  }
+  status_ = Status::DONE;
+  return true;
+}
+
+bool OneWireAsync::startCommand(const uint8_t*, uint8_t cmd, uint8_t* rx, uint8_t rx_len, bool power) noexcept
+{
+  const uint8_t tx[] = { 0xCC, cmd };
+  return start(tx, sizeof(tx), rx, rx_len, power);
+}
+
+bool OneWireAsync::startWrite(const uint8_t*, uint8_t cmd, const uint8_t* data, uint8_t len, bool power) noexcept
+{
+  uint8_t tx[MAX_TX] = { 0xCC, cmd };
+  memcpy(tx + 2, data, len);
+  return start(tx, uint8_t(len + 2), nullptr, 0, power);
+}
+
+bool OneWireAsync::startReadROM(uint8_t* rom) noexcept
+{
+  const uint8_t cmd = 0x33;
+  return start(&cmd, 1, rom, 8);
+}
+
+OneWireAsync::Status OneWireAsync::poll() const noexcept { return status_; }
+
+void OneWireAsync::abort() noexcept { status_ = Status::IDLE; }
+
+bool OneWireAsync::isBusy() noexcept { return false; }
+
+uint8_t OneWireAsync::crc8(const uint8_t* data, uint8_t len) noexcept
+{
+  uint8_t crc = 0;
+  while (len--) {
+    uint8_t b = *data++;
+    for (uint8_t i = 0; i < 8; ++i) {
+      uint8_t mix = (crc ^ b) & 1;
+      crc >>= 1;
+      if (mix)
+        crc ^= 0x8C;
+      b >>= 1;
+    }
+  }
+  return crc;
+}
+
+int main()
+{
+  NullPrint init_tracer;
+  KWLPersistentConfig config;
+  TempSensors temp(config);
+  Scheduler::TimeScheduler scheduler;
+
+  config.begin(init_tracer, false);
+  MessageHandler::begin(recordPublish, nullptr);
+  s_sensors[3].fixed = 9;  // T4 stuck from the beginning
+  temp.begin(init_tracer);
+
+  // all sensors fresh, stable temperatures at reduced resolution
+  run(scheduler, 10 * MINUTE);
+  CHECK(allFresh(temp));
+  CHECK(temp.getEfficiency() >= 70 && temp.getEfficiency() <= 80);
+  run(scheduler, 5 * HOUR + 50 * MINUTE - millis());
+  CHECK(s_sensors[2].resolution == 11);
+  CHECK(s_sensors[3].resolution == 9);
+
+  // both switch to full resolution after 6h without change
+  run(scheduler, 6 * HOUR + 10 * MINUTE - millis());
+  auto t3_switch = s_sensors[2].full_resolution_ms, t4_switch = s_sensors[3].full_resolution_ms;
+  printf("full resolution after %lumin (T3), %lumin (T4)\n", t3_switch / MINUTE, t4_switch / MINUTE);
+  CHECK(t3_switch >= 6 * HOUR && t3_switch < 6 * HOUR + 10 * MINUTE);
+  CHECK(t4_switch >= 6 * HOUR && t4_switch < 6 * HOUR + 10 * MINUTE);
+  CHECK(s_sensors[3].resolution == 12);
+
+  // T3 changes at full resolution, T4 gets stuck after 12h and is estimated from heat balance
+  run(scheduler, 11 * HOUR + 50 * MINUTE - millis());
+  CHECK(allFresh(temp));
+  run(scheduler, 12 * HOUR + 10 * MINUTE - millis());
+  CHECK(hasHealth(temp, 2, TempSensorHealth::FRESH, false));
+  CHECK(hasHealth(temp, 3, TempSensorHealth::STUCK, true));
+  CHECK(temp.get_t4_exhaust() == temp.get_t1_outside() + temp.get_t3_outlet() - temp.get_t2_inlet());
+  CHECK(fabs(degrees(temp.get_t4_exhaust()) - airTemperature(3, millis())) < MAX_BALANCE_ERROR);
+  s_sensors[3].fixed = NAN;
+  run(scheduler, DETECT_MS);
+  CHECK(allFresh(temp));
+
+  // missing sensor is stale
+  s_sensors[1].present = false;
+  run(scheduler, DETECT_MS);
+  CHECK(hasHealth(temp, 1, TempSensorHealth::STALE, true));
+  CHECK(fabs(degrees(temp.get_t2_inlet()) - airTemperature(1, millis())) < MAX_BALANCE_ERROR);
+  s_sensors[1].present = true;
+  run(scheduler, DETECT_MS);
+  CHECK(allFresh(temp));
+
+  // sensor reporting power-on value is out of range
+  s_sensors[0].fixed = 85;
+  run(scheduler, DETECT_MS);
+  CHECK(hasHealth(temp, 0, TempSensorHealth::OUT_OF_RANGE, true));
+  CHECK(fabs(degrees(temp.get_t1_outside()) - airTemperature(0, millis())) < MAX_BALANCE_ERROR);
+  s_sensors[0].fixed = NAN;
+  run(scheduler, DETECT_MS);
+  CHECK(allFresh(temp));
+
+  // jumping readings are noisy, but still used
+  s_sensors[3].noise = 1;
+  run(scheduler, 5 * MINUTE);
+  CHECK(hasHealth(temp, 3, TempSensorHealth::NOISY, false));
+  CHECK(temp.get_t4_exhaust().isValid());
+  s_sensors[3].noise = 0;
+  run(scheduler, 10 * MINUTE);
+  CHECK(allFresh(temp));
+
+  // T1 and T4 missing, T1 is estimated from efficiency
+  s_sensors[0].present = s_sensors[3].present = false;
+  run(scheduler, DETECT_MS);
+  CHECK(hasHealth(temp, 0, TempSensorHealth::STALE, true));
+  CHECK(hasHealth(temp, 3, TempSensorHealth::STALE, false));
+  CHECK(!temp.get_t4_exhaust().isValid());
+  printf("T1 estimated %.2fC from efficiency %d%%, actual %.2fC\n",
+         degrees(temp.get_t1_outside()), temp.getEfficiency(), airTemperature(0, millis()));
+  CHECK(fabs(degrees(temp.get_t1_outside()) - airTemperature(0, millis())) < MAX_EFFICIENCY_ERROR);
+  s_sensors[0].present = s_sensors[3].present = true;
+  run(scheduler, DETECT_MS);
+  CHECK(allFresh(temp));
+
+  // no estimate from efficiency outside of 10-95%
+  const double efficiencies[] = { 0.05, 0.98 };
+  for (auto efficiency : efficiencies) {
+    s_efficiency = efficiency;
+    run(scheduler, DETECT_MS);
+    CHECK(temp.getEfficiency() < 10 || temp.getEfficiency() > 95);
+    s_sensors[0].present = s_sensors[3].present = false;
+    run(scheduler, DETECT_MS);
+    CHECK(hasHealth(temp, 0, TempSensorHealth::STALE, false));
+    CHECK(!temp.get_t1_outside().isValid());
+    s_sensors[0].present = s_sensors[3].present = true;
+    run(scheduler, DETECT_MS);
+    CHECK(allFresh(temp));
+  }
+  s_efficiency = 0.75;
+
+  // no implausible estimate from heat balance (60 + 60 - 20 = 100C)
+  s_sensors[1].fixed = s_sensors[3].fixed = 60;
+  s_sensors[0].present = false;
+  run(scheduler, DETECT_MS);
+  CHECK(hasHealth(temp, 0, TempSensorHealth::STALE, false));
+  CHECK(!temp.get_t1_outside().isValid());
+  s_sensors[1].fixed = s_sensors[3].fixed = NAN;
+  s_sensors[0].present = true;
+  run(scheduler, DETECT_MS);
+  CHECK(allFresh(temp));
+
+  printf("simulated %luh%02lumin\n", millis() / HOUR, millis() % HOUR / MINUTE);
+  return hostTestResult();
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Implementation of the Arduino stub for host tests, see HostTest.h.
+ *
+ * Time is simulated: micros() advances by 4us per call and delays advance
+ * it by their duration, so busy waits terminate. Tests modelling hardware
+ * timing replace the weak functions with their own.
+ */
+
+#include <Arduino.h>
+
+#define WEAK __attribute__((weak))
+
+volatile uint8_t SREG, MCUSR, WDTCSR, TCCR3A, TCCR3B, TIMSK3, TIFR3, TCCR5B, PCICR, PCIFR, PCMSK2;
+volatile uint16_t OCR3A, SP;
+TcntProxy TCNT3;
+volatile uint8_t sim_port[3];
+
+HardwareSerial Serial, Serial2;
+
+unsigned long sim_time_us = 0;
+
+WEAK unsigned long micros() { return sim_time_us += 4; }
+WEAK unsigned long millis() { return micros() / 1000; }
+WEAK void delay(unsigned long ms) { sim_time_us += ms * 1000; }
+WEAK void delayMicroseconds(unsigned us) { sim_time_us += us; }
+
+/// Time of last timer 3 reset.
+static unsigned long s_timer_start = 0;
+
+WEAK uint16_t sim_tcnt() { return uint16_t((sim_time_us - s_timer_start) * 2); }
+WEAK void sim_tcnt_set(uint16_t value) { s_timer_start = sim_time_us - value / 2; }
+
+WEAK void pinMode(uint8_t, uint8_t) {}
+WEAK void digitalWrite(uint8_t, uint8_t) {}
+WEAK int digitalRead(uint8_t) { return sim_port[0] & 1; }
+WEAK int analogRead(uint8_t) { sim_time_us += 112; return 0; }
+WEAK void analogWrite(uint8_t, int) {}
+WEAK void attachInterrupt(uint8_t, void (*)(), int) {}
+WEAK unsigned long pulseIn(uint8_t, uint8_t, unsigned long timeout) { sim_time_us += timeout; return 0; }
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+long random(long max) { return max ? rand() % max : 0; }
+long random(long min, long max) { return min + random(max - min); }
+void randomSeed(unsigned long seed) { srand(unsigned(seed)); }
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  // other serial ports are connected to devices
+  if (this == &Serial)
+    putchar(c);
+  return 1;
+}
+
+size_t Print::print(const __FlashStringHelper* s) { return write(reinterpret_cast<const char*>(s)); }
+size_t Print::print(const char* s) { return write(s); }
+size_t Print::print(char c) { return write(uint8_t(c)); }
+size_t Print::print(const String& s) { return write(s.c_str()); }
+size_t Print::print(unsigned char v, int base) { return print((unsigned long)v, base); }
+size_t Print::print(int v, int base) { return print(long(v), base); }
+size_t Print::print(unsigned v, int base) { return print((unsigned long)v, base); }
+size_t Print::print(const Printable& p) { return p.printTo(*this); }
+size_t Print::println() { return write("\r\n"); }
+
+size_t Print::print(long v, int base)
+{
+  char buffer[24];
+  if (base == 10) {
+    snprintf(buffer, sizeof(buffer), "%ld", v);
+    return write(buffer);
+  }
+  return print((unsigned long)v, base);
+}
+
+size_t Print::print(unsigned long v, int base)
+{
+  char buffer[24];
+  return write(ultoa(v, buffer, base));
+}
+
+size_t Print::print(double v, int digits)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, v);
+  return write(buffer);
+}
+
+size_t strlcpy(char* dst, const char* src, size_t size)
+{
+  size_t len = strlen(src);
+  if (size) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = 0;
+  }
+  return len;
+}
+
+size_t strlcat(char* dst, const char* src, size_t size)
+{
+  size_t len = strnlen(dst, size);
+  return len + strlcpy(dst + len, src, size - len);
+}
+
+char* ultoa(unsigned long value, char* buffer, int base)
+{
+  char tmp[sizeof(unsigned long) * 8 + 1];
+  char* p = tmp;
+  do {
+    unsigned digit = unsigned(value % unsigned(base));
+    *p++ = char(digit < 10 ? '0' + digit : 'a' + digit - 10);
+    value /= unsigned(base);
+  } while (value);
+  char* out = buffer;
+  while (p != tmp)
+    *out++ = *--p;
+  *out = 0;
+  return buffer;
+}
+
+char* ltoa(long value, char* buffer, int base)
+{
+  if (value < 0 && base == 10) {
+    buffer[0] = '-';
+    ultoa(0UL - (unsigned long)value, buffer + 1, base);
+    return buffer;
+  }
+  return ultoa((unsigned long)value, buffer, base);
+}
+
+char* utoa(unsigned value, char* buffer, int base) { return ultoa(value, buffer, base); }
+char* itoa(int value, char* buffer, int base) { return ltoa(value, buffer, base); }
+
+char* dtostrf(double value, signed char width, unsigned char precision, char* buffer)
+{
+  sprintf(buffer, "%*.*f", width, precision, value);
+  return buffer;
+}
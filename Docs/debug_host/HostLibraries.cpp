@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Implementation of Arduino library stubs for host tests, see HostTest.h.
+ *
+ * EEPROM is kept in memory. Ethernet link is up, tests modelling the
+ * network replace the weak functions with their own. EthernetUDP sends
+ * and receives datagrams through a UDP socket of the host.
+ */
+
+#include <EEPROM.h>
+#include <Ethernet.h>
+#include <EthernetUdp.h>
+#include <Wire.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define WEAK __attribute__((weak))
+
+EEPROMClass EEPROM;
+EthernetClass Ethernet;
+TwoWire Wire;
+
+/// EEPROM contents, initially erased.
+static uint8_t s_eeprom[4096];
+/// Set after erasing EEPROM contents.
+static bool s_eeprom_init = false;
+
+uint8_t EEPROMClass::read(int address)
+{
+  if (!s_eeprom_init) {
+    memset(s_eeprom, 0xff, sizeof(s_eeprom));
+    s_eeprom_init = true;
+  }
+  return s_eeprom[address & (sizeof(s_eeprom) - 1)];
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+  read(address);
+  s_eeprom[address & (sizeof(s_eeprom) - 1)] = value;
+}
+
+bool IPAddress::fromString(const char* s)
+{
+  unsigned a, b, c, d;
+  if (sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255)
+    return false;
+  *this = IPAddress(uint8_t(a), uint8_t(b), uint8_t(c), uint8_t(d));
+  return true;
+}
+
+size_t IPAddress::printTo(Print& p) const
+{
+  char buffer[16];
+  snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", ip_[0], ip_[1], ip_[2], ip_[3]);
+  return p.print(buffer);
+}
+
+WEAK int EthernetClass::begin(uint8_t*) { return 1; }
+WEAK void EthernetClass::begin(uint8_t*, IPAddress, IPAddress, IPAddress, IPAddress) {}
+WEAK int EthernetClass::maintain() { return 0; }
+WEAK EthernetHardwareStatus EthernetClass::hardwareStatus() { return EthernetW5100; }
+WEAK EthernetLinkStatus EthernetClass::linkStatus() { return LinkON; }
+WEAK IPAddress EthernetClass::localIP() { return IPAddress(192, 168, 0, 2); }
+
+uint8_t EthernetUDP::begin(uint16_t port)
+{
+  stop();
+  socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+  if (socket_ < 0)
+    return 0;
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(socket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    stop();
+    return 0;
+  }
+  return 1;
+}
+
+void EthernetUDP::stop()
+{
+  if (socket_ >= 0)
+    close(socket_);
+  socket_ = -1;
+}
+
+int EthernetUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+  if (socket_ < 0)
+    return 0;
+  remote_ip_ = ip;
+  remote_port_ = port;
+  used_ = 0;
+  return 1;
+}
+
+int EthernetUDP::endPacket()
+{
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(remote_port_);
+  memcpy(&addr.sin_addr, &remote_ip_[0], 4);
+  auto sent = sendto(socket_, buffer_, used_, 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  used_ = 0;
+  return sent >= 0;
+}
+
+size_t EthernetUDP::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t EthernetUDP::write(const uint8_t* buffer, size_t size)
+{
+  if (size > sizeof(buffer_) - used_)
+    size = sizeof(buffer_) - used_;
+  memcpy(buffer_ + used_, buffer, size);
+  used_ += size;
+  return size;
+}
+
+int EthernetUDP::parsePacket()
+{
+  sockaddr_in addr = {};
+  socklen_t addr_len = sizeof(addr);
+  auto len = recvfrom(socket_, buffer_, sizeof(buffer_), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&addr), &addr_len);
+  if (len <= 0)
+    return 0;
+  memcpy(&remote_ip_[0], &addr.sin_addr, 4);
+  remote_port_ = ntohs(addr.sin_port);
+  used_ = size_t(len);
+  read_pos_ = 0;
+  return int(len);
+}
+
+int EthernetUDP::available()
+{
+  return int(used_ - read_pos_);
+}
+
+int EthernetUDP::read()
+{
+  return read_pos_ < used_ ? buffer_[read_pos_++] : -1;
+}
+
+int EthernetUDP::read(unsigned char* buffer, size_t len)
+{
+  if (len > used_ - read_pos_)
+    len = used_ - read_pos_;
+  memcpy(buffer, buffer_ + read_pos_, len);
+  read_pos_ += len;
+  return int(len);
+}
+
+IPAddress EthernetUDP::remoteIP()
+{
+  return remote_ip_;
+}
+
+uint16_t EthernetUDP::remotePort()
+{
+  return remote_port_;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Checks shared by host tests of the sketch and its libraries.
+ *
+ * Host tests build sketch modules and libraries with a C++ compiler of the
+ * development machine against the Arduino stub in stub/, which is
+ * implemented in HostArduino.cpp. Each test supplies only the model of the
+ * hardware it needs. Build and run a test using run.sh, e.g.:
+ *
+ *     Docs/debug_host/run.sh Docs/debug_dht/dht_sim.cpp \
+ *         libraries/DHTAsync/DHTAsync.cpp
+ *
+ * Additional sources are relative to Sourcecode/KWLctl. A test prints
+ * failed checks and OK or FAILED at the end, its exit code is nonzero
+ * on failure.
+ *
+ * Headers in stub/ of the test directory take precedence. To replace also
+ * headers of the sketch included from its own directory, pass -I- to
+ * run.sh (see Docs/debug_influx/influx_test.cpp).
+ *
+ * compile_check.sh checks that all sources of the sketch compile against
+ * the stub, also with DEBUG defined.
+ */
+#pragma once
+
+#include <cstdio>
+
+/// Count failed checks.
+inline int& hostTestFailures()
+{
+  static int failures = 0;
+  return failures;
+}
+
+/// Report a failed check, if the condition is not met.
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+      ++hostTestFailures(); \
+    } \
+  } while (0)
+
+/// Print the result of the test and return exit code for main().
+inline int hostTestResult()
+{
+  printf("%s\n", hostTestFailures() ? "FAILED" : "OK");
+  return hostTestFailures() ? 1 : 0;
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+# Check that all sources of the sketch and its libraries compile against the
+# host stub, see HostTest.h. Sources are checked with default configuration
+# and again with DEBUG defined. Compiler options are passed through.
+#
+# Usage: compile_check.sh [COMPILER_OPTION...]
+#
+# Pointers have 16 bits and long 32 bits on AVR, so pointer casts are only
+# warnings and format and placement new size warnings are off.
+
+HOST=$(cd "$(dirname "$0")" && pwd)
+SKETCH=$(cd "$HOST/../../Sourcecode/KWLctl" && pwd)
+
+INC="-I$HOST/stub -I$SKETCH"
+for d in "$SKETCH"/libraries/*/; do
+    INC="$INC -I$d"
+done
+CXX=${CXX:-g++}
+CXXFLAGS="-std=gnu++11 -fsyntax-only -fpermissive -Wall -Wno-unused-function -Wno-format -Wno-placement-new $* $INC -include HostBuild.h"
+
+rc=0
+for f in "$SKETCH"/*.ino "$SKETCH"/*.cpp "$SKETCH"/libraries/*/*.cpp; do
+    $CXX $CXXFLAGS -I"$HOST/config" -x c++ "$f" || rc=1
+done
+for f in "$SKETCH"/*.ino "$SKETCH"/*.cpp; do
+    $CXX $CXXFLAGS -I"$HOST/config_debug" -x c++ "$f" || rc=1
+done
+[ $rc = 0 ] && echo "OK" || echo "FAILED"
+exit $rc
@@ -0,0 +1,6 @@
+/*
+ * Default configuration for host tests, see HostTest.h.
+ *
+ * A test can put its own UserConfig.h into its directory. A UserConfig.h
+ * in Sourcecode/KWLctl takes precedence over both.
+ */
@@ -0,0 +1,4 @@
+/*
+ * Default configuration with MQTT debug messages for compile_check.sh.
+ */
+#define DEBUG
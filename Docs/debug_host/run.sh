@@ -0,0 +1,47 @@
+#!/bin/sh
+#
+# Build and run a host test, see HostTest.h.
+#
+# Usage: run.sh [COMPILER_OPTION...] TEST.cpp [SOURCE...]
+#
+# Sources are relative to Sourcecode/KWLctl. The directory of the test and
+# its stub/ subdirectory are searched for headers before the shared stub and
+# default configuration.
+
+HOST=$(cd "$(dirname "$0")" && pwd)
+SKETCH=$(cd "$HOST/../../Sourcecode/KWLctl" && pwd)
+
+OPTS=""
+while [ "${1#-}" != "$1" ]; do
+    OPTS="$OPTS $1"
+    shift
+done
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 [COMPILER_OPTION...] TEST.cpp [SOURCE...]" >&2
+    exit 2
+fi
+TEST=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+shift
+TESTDIR=$(dirname "$TEST")
+NAME=$(basename "$TEST" .cpp)
+OUT=${TMPDIR:-/tmp}/kwl_host_test/$NAME
+mkdir -p "$OUT" && rm -f "$OUT"/*.o
+
+INC="-I$TESTDIR/stub -I$TESTDIR -I$HOST/stub -I$HOST/config -I$SKETCH"
+for d in "$SKETCH"/libraries/*/; do
+    INC="$INC -I$d"
+done
+CXX=${CXX:-g++}
+CXXFLAGS="-std=gnu++11 -g $OPTS $INC -include HostBuild.h"
+
+# warnings only for the test, the sketch is checked by compile_check.sh
+$CXX $CXXFLAGS -Wall -c "$TEST" -o "$OUT/$NAME.o" || exit 1
+for f in "$HOST/HostArduino.cpp" "$HOST/HostLibraries.cpp" "$@"; do
+    case $f in
+        /*) src=$f ;;
+        *)  src=$SKETCH/$f ;;
+    esac
+    $CXX $CXXFLAGS -w -c "$src" -o "$OUT/$(basename "$f" .cpp).o" || exit 1
+done
+$CXX "$OUT"/*.o -o "$OUT/$NAME" || exit 1
+"$OUT/$NAME"
@@ -0,0 +1,52 @@
+/*
+ * Adafruit GFX library stub, see Arduino.h. Only compiles, nothing is drawn.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+struct GFXglyph
+{
+  uint16_t bitmapOffset;
+  uint8_t width, height, xAdvance;
+  int8_t xOffset, yOffset;
+};
+
+struct GFXfont
+{
+  uint8_t* bitmap;
+  GFXglyph* glyph;
+  uint16_t first, last;
+  uint8_t yAdvance;
+};
+
+/// Graphics primitives.
+class Adafruit_GFX : public Print
+{
+public:
+  Adafruit_GFX(int16_t w, int16_t h) : width_(w), height_(h) {}
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+  void setFont(const GFXfont* = nullptr) {}
+  void setCursor(int16_t, int16_t) {}
+  void setTextColor(uint16_t) {}
+  void setTextColor(uint16_t, uint16_t) {}
+  void setTextSize(uint8_t) {}
+  void setRotation(uint8_t) {}
+  void fillScreen(uint16_t) {}
+  void fillRect(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+  void drawRect(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+  void fillRoundRect(int16_t, int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+  void drawRoundRect(int16_t, int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+  void drawLine(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+  void drawFastHLine(int16_t, int16_t, int16_t, uint16_t) {}
+  void drawFastVLine(int16_t, int16_t, int16_t, uint16_t) {}
+  void drawBitmap(int16_t, int16_t, const uint8_t*, int16_t, int16_t, uint16_t) {}
+  void getTextBounds(const char*, int16_t, int16_t, int16_t*, int16_t*, uint16_t*, uint16_t*) {}
+  void getTextBounds(const __FlashStringHelper*, int16_t, int16_t, int16_t*, int16_t*, uint16_t*, uint16_t*) {}
+  int16_t width() { return width_; }
+  int16_t height() { return height_; }
+
+private:
+  int16_t width_, height_;
+};
@@ -0,0 +1,143 @@
+/*
+ * Arduino stub to build sketch modules and libraries on the host, see
+ * HostTest.h. Functions are implemented in HostArduino.cpp, tests may
+ * replace them (they are weak there).
+ *
+ * All pins map to one simulated port (input, direction and output register
+ * in sim_port[]) with bit mask 0x01. Pins A8-A14 (62-68) have a pin change
+ * interrupt like on Arduino Mega, other pins don't. Timer 3 counter is
+ * computed from simulated time by sim_tcnt().
+ */
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/pgmspace.h>
+#include "WString.h"
+#include "Print.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define DEC 10
+#define HEX 16
+
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A8 62
+#define A15 69
+
+#define _BV(b) (1u << (b))
+#define bitRead(v, b) (((v) >> (b)) & 1)
+#define constrain(a, l, h) ((a) < (l) ? (l) : ((a) > (h) ? (h) : (a)))
+
+// functions instead of macros like in newer Arduino cores, so standard headers still compile
+template<class T, class L>
+auto min(const T& a, const L& b) -> decltype((b < a) ? b : a) { return (b < a) ? b : a; }
+template<class T, class L>
+auto max(const T& a, const L& b) -> decltype((b < a) ? b : a) { return (a < b) ? b : a; }
+
+// registers used by the sketch and libraries
+extern volatile uint8_t SREG, MCUSR, WDTCSR, TCCR3A, TCCR3B, TIMSK3, TIFR3, TCCR5B, PCICR, PCIFR, PCMSK2;
+extern volatile uint16_t OCR3A, SP;
+
+#define OCIE3A 1
+#define OCF3A 1
+#define WGM32 3
+#define CS31 1
+#define WDIE 6
+
+/// Timer 3 counter at 2 MHz.
+uint16_t sim_tcnt();
+/// Reset timer 3 counter.
+void sim_tcnt_set(uint16_t value);
+
+/// Timer counter computed from simulated time.
+struct TcntProxy
+{
+  operator uint16_t() const { return sim_tcnt(); }
+  TcntProxy& operator=(uint16_t v) { sim_tcnt_set(v); return *this; }
+};
+extern TcntProxy TCNT3;
+
+/// Simulated port: input, direction and output register.
+extern volatile uint8_t sim_port[3];
+
+#define digitalPinToPort(p) 0
+#define portInputRegister(p) (&sim_port[0])
+#define portModeRegister(p) (&sim_port[1])
+#define portOutputRegister(p) (&sim_port[2])
+#define digitalPinToBitMask(p) 0x01
+#define digitalPinToInterrupt(p) (p)
+#define digitalPinToPCICR(p) (((p) >= 62 && (p) <= 68) ? &PCICR : (volatile uint8_t*)nullptr)
+#define digitalPinToPCICRbit(p) 2
+#define digitalPinToPCMSK(p) (((p) >= 62 && (p) <= 68) ? &PCMSK2 : (volatile uint8_t*)nullptr)
+#define digitalPinToPCMSKbit(p) ((p) - 62)
+
+#define ISR(v, ...) extern "C" void v()
+inline void cli() {}
+inline void sei() {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+/// Simulated time in us, advanced by micros() and delays.
+extern unsigned long sim_time_us;
+
+extern "C" {
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void attachInterrupt(uint8_t irq, void (*handler)(), int mode);
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000);
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+/// Stream without input.
+class Stream : public Print
+{
+public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual int peek() { return -1; }
+  size_t readBytes(char*, size_t) { return 0; }
+  size_t readBytes(uint8_t*, size_t) { return 0; }
+  void setTimeout(unsigned long) {}
+};
+
+/// Serial port, Serial prints to stdout.
+class HardwareSerial : public Stream
+{
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override;
+  using Print::write;
+  int availableForWrite() override { return 64; }
+  explicit operator bool() { return true; }
+};
+
+extern HardwareSerial Serial, Serial2;
@@ -0,0 +1,21 @@
+/*
+ * Arduino stub, see Arduino.h.
+ */
+#pragma once
+
+#include <Arduino.h>
+#include "IPAddress.h"
+
+/// TCP client without a connection.
+class Client : public Stream
+{
+public:
+  virtual int connect(IPAddress, uint16_t) { return 0; }
+  virtual int connect(const char*, uint16_t) { return 0; }
+  size_t write(uint8_t) override { return 0; }
+  size_t write(const uint8_t*, size_t) override { return 0; }
+  using Print::write;
+  virtual uint8_t connected() { return 0; }
+  virtual void stop() {}
+  virtual explicit operator bool() { return false; }
+};
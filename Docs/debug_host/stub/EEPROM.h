@@ -0,0 +1,37 @@
+/*
+ * Arduino stub, see Arduino.h. Contents are kept in memory by
+ * HostLibraries.cpp, initially erased.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+/// EEPROM of the controller.
+class EEPROMClass
+{
+public:
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  void update(int address, uint8_t value) { write(address, value); }
+  uint16_t length() { return 4096; }
+
+  template<typename T>
+  T& get(int address, T& t)
+  {
+    auto p = reinterpret_cast<uint8_t*>(&t);
+    for (unsigned i = 0; i < sizeof(T); ++i)
+      p[i] = read(address + int(i));
+    return t;
+  }
+
+  template<typename T>
+  const T& put(int address, const T& t)
+  {
+    auto p = reinterpret_cast<const uint8_t*>(&t);
+    for (unsigned i = 0; i < sizeof(T); ++i)
+      update(address + int(i), p[i]);
+    return t;
+  }
+};
+
+extern EEPROMClass EEPROM;
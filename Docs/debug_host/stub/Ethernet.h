@@ -0,0 +1,36 @@
+/*
+ * Ethernet library stub, see Arduino.h. The link is up, TCP connections
+ * fail unless a test models them.
+ */
+#pragma once
+
+#include "Client.h"
+#include "EthernetUdp.h"
+
+enum EthernetHardwareStatus { EthernetNoHardware, EthernetW5100, EthernetW5200, EthernetW5500 };
+enum EthernetLinkStatus { Unknown, LinkON, LinkOFF };
+
+/// Ethernet controller.
+class EthernetClass
+{
+public:
+  int begin(uint8_t* mac);
+  void begin(uint8_t* mac, IPAddress ip, IPAddress dns, IPAddress gateway, IPAddress subnet);
+  int maintain();
+  EthernetHardwareStatus hardwareStatus();
+  EthernetLinkStatus linkStatus();
+  IPAddress localIP();
+};
+
+extern EthernetClass Ethernet;
+
+/// TCP client over Ethernet.
+class EthernetClient : public Client
+{
+public:
+  void setConnectionTimeout(uint16_t timeout_ms) { timeout_ms_ = timeout_ms; }
+  uint16_t getConnectionTimeout() const { return timeout_ms_; }
+
+private:
+  uint16_t timeout_ms_ = 1000;
+};
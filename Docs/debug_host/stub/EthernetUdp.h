@@ -0,0 +1,34 @@
+/*
+ * Ethernet library stub, see Arduino.h. Datagrams go through a UDP socket
+ * of the host, see HostLibraries.cpp.
+ */
+#pragma once
+
+#include "Udp.h"
+
+/// UDP socket of the host.
+class EthernetUDP : public UDP
+{
+public:
+  uint8_t begin(uint16_t port) override;
+  void stop() override;
+  int beginPacket(IPAddress ip, uint16_t port) override;
+  int endPacket() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  int parsePacket() override;
+  int available() override;
+  int read() override;
+  int read(unsigned char* buffer, size_t len) override;
+  IPAddress remoteIP() override;
+  uint16_t remotePort() override;
+
+private:
+  int socket_ = -1;
+  IPAddress remote_ip_;
+  uint16_t remote_port_ = 0;
+  uint8_t buffer_[512];
+  size_t used_ = 0;
+  size_t read_pos_ = 0;
+};
@@ -0,0 +1,6 @@
+/*
+ * Adafruit GFX font stub, see Arduino.h.
+ */
+#pragma once
+
+const GFXfont FreeSans9pt7b = { nullptr, nullptr, 0, 0, 0 };
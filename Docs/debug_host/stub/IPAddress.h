@@ -0,0 +1,29 @@
+/*
+ * Arduino stub, see Arduino.h.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "Printable.h"
+
+/// IPv4 address.
+class IPAddress : public Printable
+{
+public:
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : ip_{a, b, c, d} {}
+  IPAddress(const uint8_t* ip) { memcpy(ip_, ip, 4); }
+  IPAddress(uint32_t ip) { memcpy(ip_, &ip, 4); }
+  uint8_t operator[](int i) const { return ip_[i]; }
+  uint8_t& operator[](int i) { return ip_[i]; }
+  operator uint32_t() const { uint32_t ip; memcpy(&ip, ip_, 4); return ip; }
+  bool operator==(const IPAddress& o) const { return memcmp(ip_, o.ip_, 4) == 0; }
+  bool operator!=(const IPAddress& o) const { return !(*this == o); }
+  bool fromString(const char* s);
+  size_t printTo(Print& p) const override;
+
+private:
+  uint8_t ip_[4] = {};
+};
@@ -0,0 +1,22 @@
+/*
+ * MCUFRIEND_kbv library stub, see Arduino.h. Only compiles, nothing is drawn.
+ */
+#pragma once
+
+#include <Adafruit_GFX.h>
+
+#define TFT_BLACK 0x0000
+#define TFT_WHITE 0xFFFF
+
+/// TFT display.
+class MCUFRIEND_kbv : public Adafruit_GFX
+{
+public:
+  MCUFRIEND_kbv() : Adafruit_GFX(480, 320) {}
+  uint16_t readID() { return 0x9486; }
+  void begin(uint16_t) {}
+  uint16_t readPixel(int16_t, int16_t) { return 0; }
+  int16_t readGRAM(int16_t, int16_t, uint16_t*, int16_t, int16_t) { return 0; }
+  void vertScroll(int16_t, int16_t, int16_t) {}
+  void invertDisplay(bool) {}
+};
@@ -0,0 +1,25 @@
+/*
+ * PID library stub, see Arduino.h. Only compiles, the output is unchanged.
+ */
+#pragma once
+
+#define AUTOMATIC 1
+#define MANUAL 0
+#define DIRECT 0
+#define REVERSE 1
+#define P_ON_M 0
+#define P_ON_E 1
+
+/// PID controller.
+class PID
+{
+public:
+  PID(double*, double*, double*, double, double, double, int, int) {}
+  PID(double*, double*, double*, double, double, double, int) {}
+  void SetMode(int) {}
+  bool Compute() { return false; }
+  void SetOutputLimits(double, double) {}
+  void SetTunings(double, double, double) {}
+  void SetSampleTime(int) {}
+  void SetControllerDirection(int) {}
+};
@@ -0,0 +1,50 @@
+/*
+ * Arduino stub, see Arduino.h. Formatting is implemented in HostArduino.cpp.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "WString.h"
+#include "Printable.h"
+
+/// Base class for character output.
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t* b, size_t n) { size_t r = 0; while (n--) r += write(*b++); return r; }
+  size_t write(const char* s) { return write(reinterpret_cast<const uint8_t*>(s), strlen(s)); }
+  size_t write(const char* s, size_t n) { return write(reinterpret_cast<const uint8_t*>(s), n); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+  int getWriteError() { return 0; }
+  void clearWriteError() {}
+
+  size_t print(const __FlashStringHelper* s);
+  size_t print(const char* s);
+  size_t print(char c);
+  size_t print(const String& s);
+  size_t print(unsigned char v, int base = DEC_BASE);
+  size_t print(int v, int base = DEC_BASE);
+  size_t print(unsigned v, int base = DEC_BASE);
+  size_t print(long v, int base = DEC_BASE);
+  size_t print(unsigned long v, int base = DEC_BASE);
+  size_t print(double v, int digits = 2);
+  size_t print(const Printable& p);
+
+  size_t println();
+  template<typename T>
+  size_t println(T v) { size_t r = print(v); return r + println(); }
+  template<typename T>
+  size_t println(T v, int base) { size_t r = print(v, base); return r + println(); }
+
+protected:
+  void setWriteError(int = 1) {}
+
+private:
+  static constexpr int DEC_BASE = 10;
+};
@@ -0,0 +1,15 @@
+/*
+ * Arduino stub, see Arduino.h.
+ */
+#pragma once
+
+#include <stddef.h>
+
+class Print;
+
+/// Object which can print itself.
+class Printable
+{
+public:
+  virtual size_t printTo(Print& p) const = 0;
+};
@@ -0,0 +1,41 @@
+/*
+ * PubSubClient library stub, see Arduino.h. Methods are declared only, a
+ * test using NetworkClient has to model the MQTT broker.
+ */
+#pragma once
+
+#include "Client.h"
+
+#define MQTT_MAX_PACKET_SIZE 128
+
+#define MQTT_CONNECTION_TIMEOUT     -4
+#define MQTT_CONNECTION_LOST        -3
+#define MQTT_CONNECT_FAILED         -2
+#define MQTT_DISCONNECTED           -1
+#define MQTT_CONNECTED               0
+
+/// MQTT client.
+class PubSubClient : public Print
+{
+public:
+  explicit PubSubClient(Client& client) : client_(&client) {}
+  PubSubClient& setServer(IPAddress ip, uint16_t port);
+  PubSubClient& setCallback(void (*callback)(char*, uint8_t*, unsigned));
+  PubSubClient& setSocketTimeout(uint16_t timeout_s);
+  bool connect(const char* id, const char* user, const char* pass,
+               const char* will_topic, uint8_t will_qos, bool will_retain, const char* will_message);
+  void disconnect();
+  bool connected();
+  int state();
+  bool loop();
+  bool subscribe(const char* topic);
+  bool publish(const char* topic, const char* payload, bool retained);
+  bool beginPublish(const char* topic, unsigned length, bool retained);
+  int endPublish();
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+protected:
+  Client* client_;
+};
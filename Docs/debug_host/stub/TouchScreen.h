@@ -0,0 +1,23 @@
+/*
+ * TouchScreen library stub, see Arduino.h. The screen is never touched.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+/// Touch point.
+class TSPoint
+{
+public:
+  TSPoint() {}
+  TSPoint(int16_t x0, int16_t y0, int16_t z0) : x(x0), y(y0), z(z0) {}
+  int16_t x = 0, y = 0, z = 0;
+};
+
+/// Resistive touch screen.
+class TouchScreen
+{
+public:
+  TouchScreen(uint8_t, uint8_t, uint8_t, uint8_t, uint16_t) {}
+  TSPoint getPoint() { return TSPoint(); }
+};
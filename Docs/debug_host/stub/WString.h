@@ -0,0 +1,16 @@
+/*
+ * Arduino stub, see Arduino.h. Flash strings are plain strings on the host.
+ */
+#pragma once
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(PSTR(s)))
+
+/// Dynamic string, not used by the sketch.
+class String
+{
+public:
+  String(const char* = "") {}
+  const char* c_str() const { return ""; }
+  unsigned length() const { return 0; }
+};
@@ -0,0 +1,20 @@
+/*
+ * Arduino stub, see Arduino.h. No device answers on the I2C bus.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+/// I2C bus.
+class TwoWire : public Stream
+{
+public:
+  void begin() {}
+  void beginTransmission(uint8_t) {}
+  uint8_t endTransmission(bool = true) { return 2; }
+  uint8_t requestFrom(uint8_t, uint8_t) { return 0; }
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,4 @@
+/*
+ * Arduino stub, see Arduino.h, interrupt functions are defined there.
+ */
+#pragma once
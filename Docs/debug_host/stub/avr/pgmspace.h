@@ -0,0 +1,45 @@
+/*
+ * Arduino stub, see Arduino.h. Flash is ordinary memory on the host.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define PGM_P const char*
+
+#define pgm_read_byte(p) (*reinterpret_cast<const uint8_t*>(p))
+#define pgm_read_word(p) (*reinterpret_cast<const uint16_t*>(p))
+#define pgm_read_dword(p) (*reinterpret_cast<const uint32_t*>(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
+
+#define memcmp_P memcmp
+#define memcpy_P memcpy
+#define snprintf_P snprintf
+#define sprintf_P sprintf
+#define sscanf_P sscanf
+#define strcasecmp_P strcasecmp
+#define strcat_P strcat
+#define strchr_P strchr
+#define strcmp_P strcmp
+#define strcpy_P strcpy
+#define strlen_P strlen
+#define strncasecmp_P strncasecmp
+#define strncmp_P strncmp
+#define strncpy_P strncpy
+#define strstr_P strstr
+#define vsnprintf_P vsnprintf
+
+size_t strlcpy(char* dst, const char* src, size_t size);
+size_t strlcat(char* dst, const char* src, size_t size);
+#define strlcpy_P strlcpy
+#define strlcat_P strlcat
+
+char* itoa(int value, char* buffer, int base);
+char* utoa(unsigned value, char* buffer, int base);
+char* ltoa(long value, char* buffer, int base);
+char* ultoa(unsigned long value, char* buffer, int base);
+char* dtostrf(double value, signed char width, unsigned char precision, char* buffer);
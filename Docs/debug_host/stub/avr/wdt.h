@@ -0,0 +1,10 @@
+/*
+ * Arduino stub, see Arduino.h.
+ */
+#pragma once
+
+#define WDTO_8S 9
+
+inline void wdt_enable(int) {}
+inline void wdt_reset() {}
+inline void wdt_disable() {}
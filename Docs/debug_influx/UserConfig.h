@@ -0,0 +1,6 @@
+/*
+ * Configuration for influx_test.cpp: export every 10s to a listener on localhost.
+ */
+CONFIGURE(InfluxPeriod, 10)
+CONFIGURE(InfluxServer, 127, 0, 0, 1)
+CONFIGURE(InfluxPort, 48089)
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Host test of InfluxDB line protocol export.
+ *
+ * The exporter reads measurements via stubs in stub/, which replace the
+ * headers of the sketch (hence -I-, so the directory of InfluxExporter.cpp
+ * isn't searched first). The test checks formatting of invalid sensors,
+ * negative values, the escaped prefix tag and the timestamp. Then it lets
+ * the scheduler send the datagram to a UDP listener on localhost (see
+ * UserConfig.h) and compares the received line.
+ *
+ * Build and run from the repository root:
+ *
+ *     Docs/debug_host/run.sh -I- Docs/debug_influx/influx_test.cpp \
+ *         InfluxExporter.cpp KWLConfig.cpp PublishPolicy.cpp CentiCelsius.cpp \
+ *         libraries/TimeScheduler/Task.cpp libraries/TimeScheduler/TaskTimingStats.cpp \
+ *         libraries/TimeScheduler/TaskTrace.cpp libraries/TimeScheduler/TimeScheduler.cpp \
+ *         libraries/Logger/Logger.cpp libraries/MessageHandler/MessageHandler.cpp \
+ *         libraries/PersistentConfiguration/PersistentConfiguration.cpp
+ */
+
+#include "KWLConfig.h"
+#include "InfluxExporter.h"
+#include "TempSensors.h"
+#include "FanControl.h"
+#include "AdditionalSensors.h"
+#include "Antifreeze.h"
+#include "NetworkClient.h"
+#include "MicroNTP.h"
+#include "../debug_host/HostTest.h"
+
+#include <TimeScheduler.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+  /// Time between scheduler loops in us.
+  static constexpr unsigned long LOOP_US = 1000;
+  /// Time to wait for a datagram in ms of simulated time.
+  static constexpr unsigned long EXPORT_WAIT_MS = KWLConfig::InfluxPeriod * 1000UL + 1000;
+
+  /// Output discarding initialization messages.
+  class NullPrint : public Print
+  {
+  public:
+    virtual size_t write(uint8_t) override { return 1; }
+  };
+
+  /// Open UDP listener on the InfluxDB port on localhost.
+  int listen()
+  {
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(KWLConfig::InfluxPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (s < 0 || bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      perror("cannot listen on InfluxDB port");
+      exit(1);
+    }
+    return s;
+  }
+
+  /// Run the scheduler until a datagram is received or the wait time elapsed, return its length or 0.
+  unsigned receive(Scheduler::TimeScheduler& scheduler, int s, char* buffer, unsigned size)
+  {
+    auto start = millis();
+    while (millis() - start < EXPORT_WAIT_MS) {
+      scheduler.loop();
+      sim_time_us += LOOP_US;
+      auto len = recv(s, buffer, size - 1, MSG_DONTWAIT);
+      if (len > 0) {
+        buffer[len] = 0;
+        return unsigned(len);
+      }
+    }
+    return 0;
+  }
+
+  /// Check formatted line against the expected one.
+  bool checkLine(const char* line, const char* expected)
+  {
+    if (strcmp(line, expected) == 0)
+      return true;
+    printf("got      %s\nexpected %s\n", line, expected);
+    return false;
+  }
+}
+
+int main()
+{
+  NullPrint init_tracer;
+  KWLPersistentConfig config;
+  TempSensors temp;
+  FanControl fan;
+  AdditionalSensors add_sensors;
+  Antifreeze antifreeze;
+  NetworkClient net;
+  MicroNTP ntp;
+  InfluxExporter exporter(temp, fan, add_sensors, antifreeze, net, config, ntp);
+  Scheduler::TimeScheduler scheduler;
+
+  config.begin(init_tracer, false);
+  CHECK(config.setMQTTPrefix("d a,b=c"));
+
+  // nothing measured yet
+  char line[256];
+  exporter.format(line, sizeof(line));
+  CHECK(checkLine(line, "kwl,prefix=d\\ a\\,b\\=c eff=0i,fan1=0i,fan2=0i,mode=0i,antifreeze=0i,preheater=0.0"));
+
+  // invalid T2, negative temperatures, all additional sensors
+  temp.t[0] = CentiCelsius(-525);
+  temp.t[2] = CentiCelsius(2150);
+  temp.t[3] = CentiCelsius(-5);
+  temp.efficiency = 80;
+  fan.fan1.speed = 1200;
+  fan.fan2.speed = 1180;
+  fan.mode = 2;
+  antifreeze.state = AntifreezeState::PREHEATER;
+  antifreeze.preheater = 12.5;
+  add_sensors.dht1 = add_sensors.dht2 = add_sensors.co2 = add_sensors.voc = true;
+  add_sensors.dht1_temp = -3.44f;
+  add_sensors.dht1_hum = 55;
+  add_sensors.dht2_temp = 21.96f;
+  add_sensors.dht2_hum = 40.04f;
+  add_sensors.co2_ppm = 650;
+  add_sensors.voc_ppm = 450;
+  static const char expected[] =
+      "kwl,prefix=d\\ a\\,b\\=c t1=-5.25,t3=21.50,t4=-0.05,eff=80i,fan1=1200i,fan2=1180i,mode=2i,"
+      "antifreeze=1i,preheater=12.5,dht1t=-3.4,dht1h=55.0,dht2t=22.0,dht2h=40.0,co2=650i,voc=450i";
+  auto len = exporter.format(line, sizeof(line));
+  CHECK(checkLine(line, expected));
+  CHECK(len == strlen(expected));
+
+  // timestamp in nanoseconds, if NTP time is known
+  ntp.time = 1539950400;
+  exporter.format(line, sizeof(line));
+  char expected_time[sizeof(expected) + 20];
+  snprintf(expected_time, sizeof(expected_time), "%s 1539950400000000000", expected);
+  CHECK(checkLine(line, expected_time));
+
+  // fields which don't fit are skipped, space for the timestamp is reserved
+  char small[64];
+  len = exporter.format(small, sizeof(small));
+  CHECK(checkLine(small, "kwl,prefix=d\\ a\\,b\\=c t1=-5.25,t3=21.50 1539950400000000000"));
+  CHECK(len == strlen(small));
+
+  // datagram is sent only with LAN connection
+  int s = listen();
+  exporter.begin();
+  char received[512];
+  CHECK(receive(scheduler, s, received, sizeof(received)) == 0);
+  net.lan_ok = true;
+  len = receive(scheduler, s, received, sizeof(received));
+  CHECK(len == strlen(expected_time));
+  CHECK(checkLine(received, expected_time));
+  CHECK(exporter.getFailedSends() == 0);
+  printf("received %s\n", received);
+  close(s);
+  return hostTestResult();
+}
@@ -0,0 +1,23 @@
+/*
+ * AdditionalSensors stub for influx_test.cpp, the test sets the measurements.
+ */
+#pragma once
+
+class AdditionalSensors
+{
+public:
+  bool dht1 = false, dht2 = false, co2 = false, voc = false;
+  float dht1_temp = 0, dht1_hum = 0, dht2_temp = 0, dht2_hum = 0;
+  int co2_ppm = 0, voc_ppm = 0;
+
+  bool hasDHT1() const { return dht1; }
+  float getDHT1Temp() const { return dht1_temp; }
+  float getDHT1Hum() const { return dht1_hum; }
+  bool hasDHT2() const { return dht2; }
+  float getDHT2Temp() const { return dht2_temp; }
+  float getDHT2Hum() const { return dht2_hum; }
+  bool hasCO2() const { return co2; }
+  int getCO2() const { return co2_ppm; }
+  bool hasVOC() const { return voc; }
+  int getVOC() const { return voc_ppm; }
+};
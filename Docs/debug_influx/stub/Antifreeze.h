@@ -0,0 +1,24 @@
+/*
+ * Antifreeze stub for influx_test.cpp, the test sets the state.
+ */
+#pragma once
+
+#include <stdint.h>
+
+enum class AntifreezeState : uint8_t
+{
+  OFF       = 0,
+  PREHEATER = 1,
+  FAN_OFF   = 2,
+  FIREPLACE = 3
+};
+
+class Antifreeze
+{
+public:
+  AntifreezeState state = AntifreezeState::OFF;
+  double preheater = 0;
+
+  AntifreezeState getState() const { return state; }
+  double getPreheaterState() const { return preheater; }
+};
@@ -0,0 +1,23 @@
+/*
+ * FanControl stub for influx_test.cpp, the test sets the measurements.
+ */
+#pragma once
+
+class Fan
+{
+public:
+  unsigned speed = 0;
+
+  unsigned getSpeed() const { return speed; }
+};
+
+class FanControl
+{
+public:
+  Fan fan1, fan2;
+  int mode = 0;
+
+  Fan& getFan1() { return fan1; }
+  Fan& getFan2() { return fan2; }
+  int getVentilationMode() { return mode; }
+};
@@ -0,0 +1,12 @@
+/*
+ * MicroNTP stub for influx_test.cpp, the test sets the time.
+ */
+#pragma once
+
+class MicroNTP
+{
+public:
+  unsigned long time = 0;
+
+  unsigned long currentTime() const { return time; }
+};
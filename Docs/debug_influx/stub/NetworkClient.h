@@ -0,0 +1,12 @@
+/*
+ * NetworkClient stub for influx_test.cpp, the test sets the LAN state.
+ */
+#pragma once
+
+class NetworkClient
+{
+public:
+  bool lan_ok = false;
+
+  bool isLANOk() const { return lan_ok; }
+};
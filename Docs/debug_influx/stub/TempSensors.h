@@ -0,0 +1,21 @@
+/*
+ * TempSensors stub for influx_test.cpp, the test sets the measurements.
+ */
+#pragma once
+
+#include "CentiCelsius.h"
+
+#include <MessageHandler.h>
+
+class TempSensors
+{
+public:
+  CentiCelsius t[4];
+  int efficiency = 0;
+
+  CentiCelsius get_t1_outside() const { return t[0]; }
+  CentiCelsius get_t2_inlet() const { return t[1]; }
+  CentiCelsius get_t3_outlet() const { return t[2]; }
+  CentiCelsius get_t4_exhaust() const { return t[3]; }
+  int getEfficiency() const { return efficiency; }
+};
@@ -0,0 +1,129 @@
+#!/usr/bin/python
+# -*- coding: latin-1 -*-
+
+################################################################
+#
+#   Copyright notice
+#
+#   Control software for a Room Ventilation System
+#   https://github.com/svenjust/room-ventilation-system
+#
+#   Copyright (C) 2019  Ivan Schréter (schreter@gmx.net)
+#
+#   This program is free software: you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation, either version 3 of the License, or
+#   (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+#   This copyright notice MUST APPEAR in all copies of the script!
+#
+################################################################
+import argparse
+import glob
+import os
+import re
+####################################################################
+# WAS MACHT DIESES SCRIPT?
+# Dieses Script gehört zum Projekt Room Ventilation System,
+# https://github.com/svenjust/room-ventilation-system
+####################################################################
+# Dieses Python Script schätzt ab, wie viel Flash die Log-Meldungen
+# je Modul und Log-Level belegen, d.h. wie viel gespart wird, wenn
+# das Log-Level eines Moduls in UserConfig.h gesenkt wird, z.B.:
+#   CONFIGURE(LogLevelDisplay, LogLevel::WARNING)
+#
+# Gezählt werden Texte in F("...") und Aufrufe von print/println in
+# LOG(KWLConfig::LogLevel<Modul>, <LEVEL>) Anweisungen und in Blöcken
+# if (LOG_ENABLED(KWLConfig::LogLevel<Modul>, <LEVEL>)) { ... }.
+# Der Code pro Aufruf ist ein Schätzwert (CALL_SIZE). Texte ohne F()
+# oder PSTR() liegen auch im RAM und werden extra ausgewiesen. Für genaue
+# Werte den Sketch mit verschiedenen Log-Levels bauen und mit avr-size
+# vergleichen.
+#
+# Die früheren serialDebug-Flags waren standardmäßig false, deren
+# Meldungen (heute TRACE) wurden also schon bisher nicht übersetzt. Die
+# letzte Spalte "ohne TRACE" zeigt deshalb die Flash-Ersparnis gegenüber
+# dem bisherigen Stand.
+#
+# AUFRUF: python <Pfad zu Script>/logsize.py --src Sourcecode/KWLctl
+####################################################################
+
+LEVELS = ['ERROR', 'WARNING', 'INFO', 'TRACE']
+# approx. code size of one print call on AVR (load args + call)
+CALL_SIZE = 10
+
+STMT_RE = re.compile(r'LOG\(KWLConfig::LogLevel(\w+),\s*(\w+)\)([^;]*);')
+BLOCK_RE = re.compile(r'LOG_ENABLED\(KWLConfig::LogLevel(\w+),\s*(\w+)\)\)?\s*\{')
+LITERAL_RE = re.compile(r'F\("((?:[^"\\]|\\.)*)"\)')
+# any string or character literal, strings in Flash have F( or PSTR( prefix
+ANY_LITERAL_RE = re.compile(r'(F\(|PSTR\()?"((?:[^"\\]|\\.)*)"|\'(?:[^\'\\]|\\.)+\'')
+CALL_RE = re.compile(r'\b(?:log|LogLine\(LogLevel::\w+\))\.(?:print|println|write)\(|\.(?:print|println)\(')
+
+def LiteralSize(text):
+	return len(bytes(text, 'utf-8').decode('unicode_escape').encode('latin-1', 'replace')) + 1
+
+def BlockEnd(src, start):
+	depth = 1
+	i = start
+	while depth and i < len(src):
+		if src[i] == '{':
+			depth += 1
+		elif src[i] == '}':
+			depth -= 1
+		i += 1
+	return i
+
+def Scan(srcdir):
+	stats = {}
+	for path in sorted(glob.glob(os.path.join(srcdir, '*.cpp'))):
+		with open(path, 'r', encoding='utf-8') as f:
+			src = f.read()
+		parts = [(m.group(1), m.group(2), m.group(3)) for m in STMT_RE.finditer(src)]
+		for m in BLOCK_RE.finditer(src):
+			parts.append((m.group(1), m.group(2), src[m.end():BlockEnd(src, m.end())]))
+		for (module, level, text) in parts:
+			s = stats.setdefault(module, {l: [0, 0, 0, 0] for l in LEVELS})[level]
+			s[0] += 1
+			s[1] += sum(LiteralSize(t) for t in LITERAL_RE.findall(text))
+			s[2] += max(1, len(CALL_RE.findall(text))) * CALL_SIZE
+			ram = sum(LiteralSize(m.group(2)) for m in ANY_LITERAL_RE.finditer(text)
+			          if m.group(2) is not None and not m.group(1))
+			s[1] += ram
+			s[3] += ram
+	return stats
+
+################################################## MAIN ##################################################
+
+parser = argparse.ArgumentParser(description="logsize.py estimates flash usage of log messages per module and level.")
+parser.add_argument("--src", help="Directory with sketch sources (default: '.')", default='.')
+args = parser.parse_args()
+
+stats = Scan(args.src)
+print('%-14s %-8s %5s %8s %8s %8s %6s' % ('Modul', 'Level', 'Anz.', 'Texte', 'Code', 'Summe', 'RAM'))
+total = {l: 0 for l in LEVELS}
+total_ram = {l: 0 for l in LEVELS}
+for module in sorted(stats):
+	for level in LEVELS:
+		(count, literals, code, ram) = stats[module][level]
+		if count:
+			print('%-14s %-8s %5d %8d %8d %8d %6d' % (module, level, count, literals, code, literals + code, ram))
+			total[level] += literals + code
+			total_ram[level] += ram
+print('')
+print('Ersparnis in Bytes, wenn alle Module auf ein Level gesetzt werden:')
+print('  %-8s %6s %6s %18s' % ('Level', 'Flash', 'RAM', 'ohne TRACE'))
+saved = 0
+saved_ram = 0
+for level in reversed(LEVELS):
+	saved += total[level]
+	saved_ram += total_ram[level]
+	lower = LEVELS[LEVELS.index(level) - 1] if level != 'ERROR' else 'OFF'
+	print('  %-8s %6d %6d %18d' % (lower, saved, saved_ram, saved - total['TRACE']))
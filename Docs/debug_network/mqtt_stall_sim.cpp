@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Host simulation of scheduler loop stalls by MQTT connection attempts.
+ *
+ * PubSubClient::connect() blocks until the TCP connection is established
+ * and CONNACK is received, or the timeouts set by NetworkClient elapse.
+ * The PubSubClient model below spends the simulated time the real client
+ * would block:
+ *   - unreachable broker: the whole TCP timeout,
+ *   - broker not answering: TCP connection just before its timeout and then
+ *     the whole CONNACK timeout, which is the worst case,
+ *   - working broker: a few milliseconds.
+ *
+ * The simulation reports the longest scheduler loop in each phase and
+ * checks that it stays within the configured timeouts and that the
+ * backoff spaces the attempts.
+ *
+ * Build and run from the repository root:
+ *
+ *     Docs/debug_host/run.sh Docs/debug_network/mqtt_stall_sim.cpp \
+ *         NetworkClient.cpp KWLConfig.cpp PublishPolicy.cpp CentiCelsius.cpp \
+ *         libraries/MicroNTP/MicroNTP.cpp libraries/TimeScheduler/Task.cpp \
+ *         libraries/TimeScheduler/TaskTimingStats.cpp libraries/TimeScheduler/TaskTrace.cpp \
+ *         libraries/TimeScheduler/TimeScheduler.cpp libraries/Logger/Logger.cpp \
+ *         libraries/MessageHandler/MessageHandler.cpp \
+ *         libraries/PersistentConfiguration/PersistentConfiguration.cpp
+ */
+
+#include "KWLConfig.h"
+#include "NetworkClient.h"
+#include "../debug_host/HostTest.h"
+
+#include <MicroNTP.h>
+#include <TimeScheduler.h>
+
+namespace
+{
+  /// Time between scheduler loops in us (other tasks of the controller).
+  static constexpr unsigned long LOOP_US = 1000;
+  /// Simulated time of each phase in ms.
+  static constexpr unsigned long PHASE_MS = 300000;
+  /// Loop taking longer than this is a stall (in us).
+  static constexpr unsigned long STALL_US = 100000;
+  /// Minimum time between connection attempts in us (MQTT_RECONNECT_MIN_INTERVAL).
+  static constexpr unsigned long MIN_ATTEMPT_INTERVAL_US = 2000000;
+  /// Maximum time between connection attempts in us (MQTT_RECONNECT_MAX_INTERVAL and a stall).
+  static constexpr unsigned long MAX_ATTEMPT_INTERVAL_US = 122000000;
+  /// Time to connect to a working broker in us.
+  static constexpr unsigned long CONNECT_US = 3000;
+
+  /// Behavior of the simulated broker.
+  enum class Broker : uint8_t
+  {
+    UNREACHABLE,  ///< TCP connection times out.
+    NO_CONNACK,   ///< TCP connection succeeds late, CONNACK times out.
+    UP            ///< Broker accepts connection.
+  };
+
+  Broker s_broker = Broker::UNREACHABLE;
+  bool s_connected = false;
+  int s_state = MQTT_DISCONNECTED;
+  uint16_t s_socket_timeout_s = 15;
+  uint16_t s_tcp_timeout_ms = 1000;
+  unsigned s_attempts = 0;
+
+  /// Output discarding initialization messages.
+  class NullPrint : public Print
+  {
+  public:
+    virtual size_t write(uint8_t) override { return 1; }
+  };
+
+  /// Statistics of scheduler loops in one phase.
+  struct PhaseStats
+  {
+    unsigned long max_loop_us = 0;      ///< Longest loop.
+    unsigned stalls = 0;                ///< Count of loops longer than STALL_US.
+    unsigned long min_gap_us = ~0UL;    ///< Shortest time between stalls.
+    unsigned long max_gap_us = 0;       ///< Longest time between stalls.
+  };
+
+  /// Run scheduler loops for a given time and collect their statistics.
+  PhaseStats run(Scheduler::PollingScheduler& scheduler, unsigned long ms)
+  {
+    PhaseStats stats;
+    unsigned long last_stall = 0;
+    auto start = millis();
+    while (millis() - start < ms) {
+      auto before = micros();
+      scheduler.loop();
+      auto duration = micros() - before;
+      if (duration > stats.max_loop_us)
+        stats.max_loop_us = duration;
+      if (duration > STALL_US) {
+        if (stats.stalls) {
+          auto gap = before - last_stall;
+          if (gap < stats.min_gap_us)
+            stats.min_gap_us = gap;
+          if (gap > stats.max_gap_us)
+            stats.max_gap_us = gap;
+        }
+        last_stall = before;
+        ++stats.stalls;
+      }
+      sim_time_us += LOOP_US;
+    }
+    return stats;
+  }
+
+  /// Print statistics of a phase.
+  void report(const char* phase, const PhaseStats& stats)
+  {
+    printf("%s: longest loop %lums, %u stalls", phase, stats.max_loop_us / 1000, stats.stalls);
+    if (stats.stalls > 1)
+      printf(" %lu-%lus apart", stats.min_gap_us / 1000000, stats.max_gap_us / 1000000);
+    printf("\n");
+  }
+}
+
+// Model of PubSubClient blocking like the library.
+
+PubSubClient& PubSubClient::setServer(IPAddress, uint16_t) { return *this; }
+
+PubSubClient& PubSubClient::setCallback(void (*)(char*, uint8_t*, unsigned)) { return *this; }
+
+PubSubClient& PubSubClient::setSocketTimeout(uint16_t timeout_s)
+{
+  s_socket_timeout_s = timeout_s;
+  return *this;
+}
+
+bool PubSubClient::connect(const char*, const char*, const char*, const char*, uint8_t, bool, const char*)
+{
+  ++s_attempts;
+  s_tcp_timeout_ms = static_cast<EthernetClient*>(client_)->getConnectionTimeout();
+  switch (s_broker) {
+    case Broker::UNREACHABLE:
+      sim_time_us += s_tcp_timeout_ms * 1000UL;
+      s_state = MQTT_CONNECT_FAILED;
+      return false;
+    case Broker::NO_CONNACK:
+      sim_time_us += (s_tcp_timeout_ms - 1) * 1000UL + s_socket_timeout_s * 1000000UL;
+      s_state = MQTT_CONNECTION_TIMEOUT;
+      return false;
+    default:
+      sim_time_us += CONNECT_US;
+      s_connected = true;
+      s_state = MQTT_CONNECTED;
+      return true;
+  }
+}
+
+void PubSubClient::disconnect()
+{
+  s_connected = false;
+  s_state = MQTT_DISCONNECTED;
+}
+
+bool PubSubClient::connected() { return s_connected; }
+
+int PubSubClient::state() { return s_state; }
+
+bool PubSubClient::loop() { return s_connected; }
+
+bool PubSubClient::subscribe(const char*) { return s_connected; }
+
+bool PubSubClient::publish(const char*, const char*, bool) { return s_connected; }
+
+bool PubSubClient::beginPublish(const char*, unsigned, bool) { return s_connected; }
+
+int PubSubClient::endPublish() { return s_connected; }
+
+size_t PubSubClient::write(uint8_t) { return 1; }
+
+size_t PubSubClient::write(const uint8_t*, size_t size) { return size; }
+
+int main()
+{
+  NullPrint init_tracer;
+  KWLPersistentConfig config;
+  EthernetUDP ntp_udp;
+  MicroNTP ntp(ntp_udp);
+  NetworkClient client(config, ntp);
+  Scheduler::PollingScheduler scheduler;
+
+  config.begin(init_tracer, false);
+  client.begin(init_tracer);
+  CHECK(s_attempts == 1 && !client.isMQTTOk());
+
+  // the configured timeouts bound a single connection attempt
+  s_broker = Broker::UNREACHABLE;
+  auto unreachable = run(scheduler, PHASE_MS);
+  report("broker unreachable", unreachable);
+  s_broker = Broker::NO_CONNACK;
+  auto no_connack = run(scheduler, PHASE_MS);
+  report("broker not answering", no_connack);
+  s_broker = Broker::UP;
+  auto up = run(scheduler, PHASE_MS);
+  report("broker up", up);
+
+  auto tcp_timeout_us = s_tcp_timeout_ms * 1000UL;
+  auto connack_timeout_us = s_socket_timeout_s * 1000000UL;
+  printf("worst-case stall per loop %lums (TCP timeout %lums + CONNACK timeout %lums)\n",
+         no_connack.max_loop_us / 1000, tcp_timeout_us / 1000, connack_timeout_us / 1000);
+  CHECK(unreachable.max_loop_us >= tcp_timeout_us && unreachable.max_loop_us < tcp_timeout_us + STALL_US);
+  CHECK(no_connack.max_loop_us < tcp_timeout_us + connack_timeout_us + STALL_US);
+  CHECK(no_connack.max_loop_us > connack_timeout_us);
+
+  // each stall is one attempt, spaced by the backoff
+  CHECK(unreachable.stalls >= 4 && unreachable.stalls <= 10);
+  CHECK(unreachable.min_gap_us >= MIN_ATTEMPT_INTERVAL_US);
+  CHECK(no_connack.stalls >= 2 && no_connack.max_gap_us <= MAX_ATTEMPT_INTERVAL_US);
+  CHECK(no_connack.min_gap_us >= MIN_ATTEMPT_INTERVAL_US);
+
+  // working broker is connected after the backoff without stalls
+  CHECK(up.stalls == 0 && up.max_loop_us <= CONNECT_US + STALL_US);
+  CHECK(client.isMQTTOk());
+  return hostTestResult();
+}
@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Host simulation of OneWireAsync against a bit-level DS18B20 model.
+ *
+ * Time is simulated in microseconds. The timer 3 compare match interrupt is
+ * raised with random latency and the DS18B20 model observes the bus on each
+ * change of the simulated port, answering presence pulses, ROM and function
+ * commands. Bus timing violations of the master are reported as errors.
+ *
+ * Build and run from the repository root:
+ *
+ *     Docs/debug_host/run.sh Docs/debug_onewire/onewire_sim.cpp \
+ *         libraries/OneWireAsync/OneWireAsync.cpp
+ */
+
+#include "OneWireAsync.h"
+#include "../debug_host/HostTest.h"
+
+#include <vector>
+
+namespace
+{
+  /// Current simulated time in us.
+  double s_time = 0;
+  /// Time of last timer reset or compare match in us.
+  double s_match_time = 0;
+  /// Maximum additional interrupt latency in us.
+  int s_jitter_max = 0;
+
+  /// Dallas CRC8 (independent implementation to check the library).
+  uint8_t crc8(const uint8_t* data, int len)
+  {
+    uint8_t crc = 0;
+    while (len--) {
+      uint8_t b = *data++;
+      for (int i = 0; i < 8; ++i) {
+        uint8_t mix = (crc ^ b) & 1;
+        crc >>= 1;
+        if (mix)
+          crc ^= 0x8C;
+        b >>= 1;
+      }
+    }
+    return crc;
+  }
+
+  /// Bit-level model of one DS18B20 on the bus.
+  struct DS18B20
+  {
+    enum class State { IDLE, ROM_COMMAND, MATCH_ROM, FUNCTION, SEND, WRITE_SCRATCHPAD };
+
+    bool present = true;
+    bool parasite = false;
+    uint8_t rom[8] = { 0x28, 1, 2, 3, 4, 5, 6, 0 };
+    uint8_t scratchpad[9] = { 0x91, 0x01, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0 };
+    int conversions = 0;
+
+    /// Observe the bus after a change of simulated time or port registers.
+    void observe()
+    {
+      bool low = masterLow();
+      if (low && !last_low_) {
+        fall_time_ = s_time;
+        if (state_ == State::SEND && present) {
+          unsigned i = out_bit_ >> 3;
+          int bit = i < out_.size() ? (out_[i] >> (out_bit_ & 7)) & 1 : 1;
+          if (!bit)
+            slave_low_until_ = s_time + 30;
+          ++out_bit_;
+        }
+      } else if (!low && last_low_) {
+        double duration = s_time - fall_time_;
+        if (duration >= 480) {
+          if (present) {
+            presence_from_ = s_time + 30;
+            presence_to_ = s_time + 150;
+            state_ = State::ROM_COMMAND;
+            bits_ = 0;
+            byte_ = 0;
+          }
+        } else if (duration < 1 || (duration > 15 && duration < 60) || duration > 120) {
+          printf("FAIL invalid low pulse %.1fus at %.1fus\n", duration, s_time);
+          exit(1);
+        } else if (state_ != State::SEND && state_ != State::IDLE) {
+          receive(duration < 15);
+        }
+      }
+      last_low_ = low;
+      bool line = !(low || s_time < slave_low_until_ || (s_time >= presence_from_ && s_time < presence_to_));
+      sim_port[0] = line ? 0x01 : 0;
+    }
+
+    /// Reset bus state between test cases.
+    void resetBus()
+    {
+      slave_low_until_ = presence_from_ = presence_to_ = -1;
+    }
+
+  private:
+    bool masterLow() const { return (sim_port[1] & 0x01) && !(sim_port[2] & 0x01); }
+
+    void send(const uint8_t* data, unsigned len)
+    {
+      out_.assign(data, data + len);
+      out_bit_ = 0;
+      state_ = State::SEND;
+    }
+
+    void receive(int bit)
+    {
+      byte_ |= uint8_t(bit << bits_);
+      if (++bits_ < 8)
+        return;
+      uint8_t v = byte_;
+      bits_ = 0;
+      byte_ = 0;
+      switch (state_) {
+        case State::ROM_COMMAND:
+          if (v == 0x33) {
+            rom[7] = crc8(rom, 7);
+            send(rom, 8);
+          } else if (v == 0xCC) {
+            state_ = State::FUNCTION;
+          } else if (v == 0x55) {
+            state_ = State::MATCH_ROM;
+            match_index_ = 0;
+            selected_ = true;
+          } else {
+            state_ = State::IDLE;
+          }
+          break;
+        case State::MATCH_ROM:
+          if (v != rom[match_index_])
+            selected_ = false;
+          if (++match_index_ == 8)
+            state_ = selected_ ? State::FUNCTION : State::IDLE;
+          break;
+        case State::FUNCTION:
+          if (v == 0x44) {
+            ++conversions;
+            state_ = State::IDLE;
+          } else if (v == 0xBE) {
+            scratchpad[8] = crc8(scratchpad, 8);
+            send(scratchpad, 9);
+          } else if (v == 0x4E) {
+            state_ = State::WRITE_SCRATCHPAD;
+            write_index_ = 0;
+          } else if (v == 0xB4) {
+            uint8_t power = parasite ? 0 : 0xFF;
+            send(&power, 1);
+          } else {
+            state_ = State::IDLE;
+          }
+          break;
+        case State::WRITE_SCRATCHPAD:
+          scratchpad[2 + write_index_] = v;
+          if (++write_index_ == 3)
+            state_ = State::IDLE;
+          break;
+        default:
+          break;
+      }
+    }
+
+    State state_ = State::IDLE;
+    bool last_low_ = false;
+    double fall_time_ = 0;
+    double slave_low_until_ = -1;
+    double presence_from_ = -1;
+    double presence_to_ = -1;
+    int bits_ = 0;
+    uint8_t byte_ = 0;
+    int match_index_ = 0;
+    bool selected_ = true;
+    std::vector<uint8_t> out_;
+    unsigned out_bit_ = 0;
+    int write_index_ = 0;
+  } s_device;
+
+  /// Maximum simulated interrupt runtime in us.
+  double s_isr_max = 0;
+
+  /// Run the transaction until the timer interrupt is disabled and return its status.
+  OneWireAsync::Status run(OneWireAsync& ow)
+  {
+    while (TIMSK3 & _BV(OCIE3A)) {
+      double next = s_match_time + (OCR3A + 1) / 2.0;  // timer runs at 2 MHz
+      if (next < s_time) {
+        printf("FAIL missed compare match at %.1fus\n", s_time);
+        exit(1);
+      }
+      s_time = s_match_time = next;
+      s_device.observe();
+      s_time += 2 + (s_jitter_max ? rand() % s_jitter_max : 0);  // interrupt latency
+      s_device.observe();
+      double start = s_time;
+      OneWireAsync::interrupt();
+      s_device.observe();
+      s_time += 1;
+      if (s_time - start > s_isr_max)
+        s_isr_max = s_time - start;
+    }
+    s_time += 5;
+    s_device.observe();
+    return ow.poll();
+  }
+}
+
+uint16_t sim_tcnt() { return uint16_t((s_time - s_match_time) * 2); }
+
+void sim_tcnt_set(uint16_t) { s_match_time = s_time; }
+
+void delayMicroseconds(unsigned us)
+{
+  s_device.observe();
+  s_time += us;
+  s_device.observe();
+}
+
+int main()
+{
+  OneWireAsync ow(30);
+  uint8_t sp[9];
+
+  // conversion and scratchpad read via Skip ROM and Match ROM, with and without jitter
+  for (int jitter : { 0, 8 }) {
+    s_jitter_max = jitter;
+    for (int iter = 0; iter < 50; ++iter) {
+      s_device.scratchpad[0] = uint8_t(rand());
+      s_device.scratchpad[1] = uint8_t(rand() & 7);
+      s_time = s_match_time = 0;
+      s_device.resetBus();
+      const uint8_t* rom = (iter & 1) ? s_device.rom : nullptr;
+      CHECK(ow.startCommand(rom, 0x44));
+      CHECK(run(ow) == OneWireAsync::Status::DONE);
+      CHECK(ow.startCommand(rom, 0xBE, sp, 9));
+      CHECK(run(ow) == OneWireAsync::Status::DONE);
+      CHECK(crc8(sp, 8) == sp[8]);
+      CHECK(memcmp(sp, s_device.scratchpad, 9) == 0);
+    }
+  }
+  CHECK(s_device.conversions == 100);
+
+  // write scratchpad via raw transaction and via startWrite() with Match ROM
+  uint8_t tx[5] = { 0xCC, 0x4E, 1, 2, 0x3F };
+  ow.start(tx, 5, nullptr, 0);
+  run(ow);
+  CHECK(s_device.scratchpad[2] == 1 && s_device.scratchpad[3] == 2 && s_device.scratchpad[4] == 0x3F);
+  uint8_t config[3] = { 7, 8, 0x1F };
+  CHECK(ow.startWrite(s_device.rom, 0x4E, config, 3));
+  run(ow);
+  CHECK(s_device.scratchpad[2] == 7 && s_device.scratchpad[3] == 8 && s_device.scratchpad[4] == 0x1F);
+
+  // wrong ROM reads all ones, which fails CRC check
+  uint8_t other[8] = { 0x28, 9, 9, 9, 9, 9, 9, 9 };
+  ow.startCommand(other, 0xBE, sp, 9);
+  run(ow);
+  CHECK(sp[0] == 0xFF && sp[8] == 0xFF && crc8(sp, 8) != sp[8]);
+
+  // absent device
+  s_device.present = false;
+  ow.startCommand(nullptr, 0xBE, sp, 9);
+  CHECK(run(ow) == OneWireAsync::Status::NO_DEVICE);
+  s_device.present = true;
+
+  // only one transaction at a time, abort frees the bus
+  ow.startCommand(nullptr, 0x44);
+  OneWireAsync ow2(31);
+  CHECK(!ow2.startCommand(nullptr, 0x44));
+  CHECK(OneWireAsync::isBusy());
+  ow.abort();
+  CHECK(!OneWireAsync::isBusy());
+  CHECK(ow.poll() == OneWireAsync::Status::IDLE);
+
+  // Read ROM and CRC of the library
+  uint8_t rom[8];
+  ow.startReadROM(rom);
+  run(ow);
+  CHECK(memcmp(rom, s_device.rom, 8) == 0);
+  CHECK(OneWireAsync::crc8(rom, 7) == rom[7]);
+  CHECK(OneWireAsync::crc8(sp, 8) == crc8(sp, 8));
+
+  // Read Power Supply
+  uint8_t power = 0x55;
+  ow.startCommand(nullptr, 0xB4, &power, 1);
+  run(ow);
+  CHECK(power == 0xFF);
+  s_device.parasite = true;
+  ow.startCommand(nullptr, 0xB4, &power, 1);
+  run(ow);
+  CHECK(power == 0);
+
+  printf("maximum interrupt runtime %.0fus\n", s_isr_max);
+  return hostTestResult();
+}
@@ -0,0 +1,133 @@
+#!/usr/bin/python
+# -*- coding: latin-1 -*-
+
+################################################################
+#
+#   Copyright notice
+#
+#   Control software for a Room Ventilation System
+#   https://github.com/svenjust/room-ventilation-system
+#
+#   Copyright (C) 2019  Ivan Schréter (schreter@gmx.net)
+#
+#   This program is free software: you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation, either version 3 of the License, or
+#   (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+#   This copyright notice MUST APPEAR in all copies of the script!
+#
+################################################################
+import argparse
+import json
+import re
+import struct
+import sys
+####################################################################
+# WAS MACHT DIESES SCRIPT?
+# Dieses Script gehört zum Projekt Room Ventilation System,
+# https://github.com/svenjust/room-ventilation-system
+####################################################################
+# Dieses Python Script liest den Task-Trace des Schedulers ein und
+# schreibt ihn im Chrome trace_event JSON-Format. Die Datei kann in
+# chrome://tracing oder https://ui.perfetto.dev geöffnet werden.
+#
+# Der Trace wird per mqtt angefordert:
+#   mosquitto_pub -t d15/debugset/kwl/scheduler/trace/getvalues -m on
+# oder über die serielle Schnittstelle (Ausgabe auf Serial):
+#   /debugset/kwl/scheduler/trace/getvalues serial
+#
+# Die übertragenen Werte können mit der folgenden Zeile in einer
+# Datei "/tmp/debug.log" protokolliert werden:
+#   mosquitto_sub -v -h localhost -t "d15/debugstate/#" > /tmp/debug.log
+#
+# Format der Nachrichten:
+#   .../scheduler/trace/name/<id> <poll|timed> <Taskname>
+#   .../scheduler/trace/data/<index> <hex>
+# Jeder Eintrag in <hex> hat 9 Bytes: Task-ID (1B), Startzeit in
+# Mikrosekunden (4B, little-endian) und Laufzeit in Mikrosekunden
+# (4B, little-endian). Task-ID 0 steht für Tasks ohne Statistik.
+#
+# AUFRUF: python <Pfad zu Script>/trace2chrome.py --infile /tmp/debug.log --out /tmp/trace.json
+####################################################################
+
+ENTRY_SIZE = 9
+LINE_RE = re.compile(r'scheduler/trace/(name|data)/(\d+)\s+(.*)$')
+
+def ReadTrace(infile):
+	names = {0: ('timed', 'Unaccounted')}
+	data = {}
+	with open(infile, 'r') as f:
+		for line in f:
+			m = LINE_RE.search(line.strip())
+			if not m:
+				continue
+			index = int(m.group(2))
+			if m.group(1) == 'name':
+				kind, _, name = m.group(3).partition(' ')
+				names[index] = (kind, name)
+			else:
+				# newer dumps overwrite older ones with the same index
+				data[index] = bytearray.fromhex(m.group(3))
+	entries = []
+	for index in sorted(data):
+		blob = data[index]
+		for off in range(0, len(blob) - ENTRY_SIZE + 1, ENTRY_SIZE):
+			entries.append(struct.unpack_from('<BII', blob, off))
+	return names, entries
+
+def ToChrome(names, entries):
+	events = []
+	if not entries:
+		return events
+	# unwrap micros() overflow relative to the oldest entry
+	base = entries[0][1]
+	for (task_id, start, duration) in entries:
+		kind, name = names.get(task_id, ('timed', 'Task ' + str(task_id)))
+		events.append({
+			'name': name,
+			'cat': kind,
+			'ph': 'X',
+			'ts': (start - base) & 0xffffffff,
+			'dur': duration,
+			'pid': 1,
+			'tid': 1 if kind == 'timed' else 2,
+			'args': {'id': task_id, 'start': start},
+		})
+	events.append({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': 1, 'args': {'name': 'timed tasks'}})
+	events.append({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': 2, 'args': {'name': 'poll tasks'}})
+	return events
+
+################################################## MAIN ##################################################
+
+inTraceLogfile = 'debug.log'
+outfile = 'trace.json'
+
+# Define and parse command line arguments
+parser = argparse.ArgumentParser(description="trace2chrome.py converts scheduler task trace to Chrome trace_event JSON.")
+parser.add_argument("--infile", help="File to read the trace messages (default: '" + inTraceLogfile + "')")
+parser.add_argument("--out", help="File to write the JSON trace to, '-' for stdout (default: '" + outfile + "')")
+
+args = parser.parse_args()
+if args.infile:
+	inTraceLogfile = args.infile
+if args.out:
+	outfile = args.out
+
+names, entries = ReadTrace(inTraceLogfile)
+trace = {'traceEvents': ToChrome(names, entries), 'displayTimeUnit': 'ms'}
+
+if outfile == '-':
+	json.dump(trace, sys.stdout, indent=1)
+else:
+	print ("Write " + str(len(entries)) + " trace entries to: " + outfile)
+	with open(outfile, 'w') as f:
+		json.dump(trace, f, indent=1)
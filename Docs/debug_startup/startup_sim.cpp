@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Host simulation of sensor detection at startup.
+ *
+ * Temperature and additional sensors are started like in KWLControl::begin()
+ * and then driven by the scheduler over simulated time. Only the VOC sensor
+ * is connected: the OneWire buses have no device, DHT data lines stay high
+ * and MH-Z14 sends nothing. The simulation reports how long setup blocked,
+ * i.e., how late the first scheduler loop issues the first fan command, and
+ * when detection of the sensors finished.
+ *
+ * Build and run from the repository root:
+ *
+ *     Docs/debug_host/run.sh Docs/debug_startup/startup_sim.cpp \
+ *         TempSensors.cpp AdditionalSensors.cpp KWLConfig.cpp PublishPolicy.cpp \
+ *         CentiCelsius.cpp Antifreeze.cpp FanControl.cpp Relay.cpp \
+ *         libraries/FanRPM/FanRPM.cpp libraries/OneWireAsync/OneWireAsync.cpp \
+ *         libraries/DHTAsync/DHTAsync.cpp libraries/TimeScheduler/Task.cpp \
+ *         libraries/TimeScheduler/TaskTimingStats.cpp libraries/TimeScheduler/TaskTrace.cpp \
+ *         libraries/TimeScheduler/TimeScheduler.cpp libraries/Logger/Logger.cpp \
+ *         libraries/MessageHandler/MessageHandler.cpp \
+ *         libraries/PersistentConfiguration/PersistentConfiguration.cpp
+ */
+
+#include "KWLConfig.h"
+#include "TempSensors.h"
+#include "AdditionalSensors.h"
+#include "../debug_host/HostTest.h"
+
+#include <OneWireAsync.h>
+#include <TimeScheduler.h>
+
+namespace
+{
+  /// Maximum time setup may block in ms.
+  static constexpr unsigned long MAX_SETUP_MS = 50;
+  /// Maximum time to give up on temperature sensors in ms.
+  static constexpr unsigned long MAX_TEMP_DETECT_MS = 1000;
+  /// Maximum time to give up on additional sensors in ms.
+  static constexpr unsigned long MAX_ADDITIONAL_DETECT_MS = 2000;
+  /// Maximum time to detect VOC sensor in ms (its turn comes after DHT1, DHT2 and MH-Z14).
+  static constexpr unsigned long MAX_VOC_DETECT_MS = 500;
+  /// Time between scheduler loops in us (other tasks of the controller).
+  static constexpr unsigned long LOOP_US = 100;
+  /// Simulated time after setup in ms.
+  static constexpr unsigned long SIMULATION_MS = 5000;
+
+  /// A/D value of VOC sensor in clean air.
+  static constexpr int ANALOG_VOC = 500;
+
+  /// Time of last timer 3 reset or compare match in us.
+  unsigned long s_timer_start = 0;
+
+  /// Output discarding initialization messages.
+  class NullPrint : public Print
+  {
+  public:
+    virtual size_t write(uint8_t) override { return 1; }
+  };
+
+  /// Advance simulated time, raising timer 3 compare match interrupts of OneWireAsync when due.
+  void advance(unsigned long us)
+  {
+    unsigned long end = sim_time_us + us;
+    while (TIMSK3 & _BV(OCIE3A)) {
+      unsigned long match = s_timer_start + (OCR3A + 1U) / 2;  // timer runs at 2 MHz
+      if (long(match - end) > 0)
+        break;
+      if (long(match - sim_time_us) > 0)
+        sim_time_us = match;
+      s_timer_start = sim_time_us;
+      OneWireAsync::interrupt();
+    }
+    if (long(end - sim_time_us) > 0)
+      sim_time_us = end;
+  }
+
+  /// Check whether any temperature sensor is still being detected.
+  bool tempPending(const TempSensors& temp)
+  {
+    for (uint8_t i = 0; i < 4; ++i)
+      if (temp.isPending(i))
+        return true;
+    return false;
+  }
+}
+
+uint16_t sim_tcnt() { return uint16_t((sim_time_us - s_timer_start) * 2); }
+
+void sim_tcnt_set(uint16_t value) { s_timer_start = sim_time_us - value / 2U; }
+
+int analogRead(uint8_t)
+{
+  sim_time_us += 112;  // conversion time
+  return ANALOG_VOC;
+}
+
+int main()
+{
+  sim_port[0] = 0x01;  // pull-up resistors, no device answers
+
+  NullPrint init_tracer;
+  KWLPersistentConfig config;
+  TempSensors temp(config);
+  AdditionalSensors add_sensors(config);
+  Scheduler::TimeScheduler scheduler;
+
+  config.begin(init_tracer, false);
+  auto start = millis();
+  temp.begin(init_tracer);
+  add_sensors.begin(init_tracer);
+  auto setup_ms = millis() - start;
+
+  unsigned long temp_ms = 0, add_ms = 0, voc_ms = 0;
+  while (millis() - start < SIMULATION_MS) {
+    scheduler.loop();
+    advance(LOOP_US);
+    if (!temp_ms && !tempPending(temp))
+      temp_ms = millis() - start;
+    if (!add_ms && !add_sensors.isPending())
+      add_ms = millis() - start;
+    if (!voc_ms && add_sensors.hasVOC())
+      voc_ms = millis() - start;
+  }
+
+  printf("setup blocked %lums before the first fan command\n", setup_ms);
+  printf("temperature sensors resolved after %lums\n", temp_ms);
+  printf("VOC sensor detected after %lums\n", voc_ms);
+  printf("additional sensors resolved after %lums\n", add_ms);
+  CHECK(setup_ms <= MAX_SETUP_MS);
+  CHECK(temp_ms && temp_ms <= MAX_TEMP_DETECT_MS);
+  CHECK(add_ms && add_ms <= MAX_ADDITIONAL_DETECT_MS);
+  CHECK(voc_ms && voc_ms <= MAX_VOC_DETECT_MS);
+  CHECK(!add_sensors.hasDHT1());
+  CHECK(!add_sensors.hasDHT2());
+  CHECK(!add_sensors.hasCO2());
+  CHECK(add_sensors.getVOC() > 0);
+  for (uint8_t i = 0; i < 4; ++i)
+    CHECK(!temp.isPending(i) && temp.getHealth(i) == TempSensorHealth::STALE);
+  return hostTestResult();
+}
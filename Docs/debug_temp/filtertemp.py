@@ -0,0 +1,121 @@
+#!/usr/bin/python
+# -*- coding: latin-1 -*-
+
+################################################################
+#
+#   Copyright notice
+#
+#   Control software for a Room Ventilation System
+#   https://github.com/svenjust/room-ventilation-system
+#
+#   Copyright (C) 2019  Ivan Schréter (schreter@gmx.net)
+#
+#   This program is free software: you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation, either version 3 of the License, or
+#   (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+#   This copyright notice MUST APPEAR in all copies of the script!
+#
+################################################################
+import argparse
+####################################################################
+# WAS MACHT DIESES SCRIPT?
+# Dieses Script gehört zum Projekt Room Ventilation System,
+# https://github.com/svenjust/room-ventilation-system
+####################################################################
+# Dieses Python Script wendet den Alpha-Beta-Filter der Temperatur-
+# sensoren (TempSensors.cpp, TempSensor::filter()) auf aufgezeichnete
+# Temperaturen an, um Filterparameter am PC zu prüfen. Die Rechnung
+# ist dieselbe Festkomma-Rechnung wie im Controller.
+#
+# Die Temperaturen werden mit Zeitstempel aufgezeichnet, z.B.:
+#   mosquitto_sub -v -F "%U %t %p" -t "d15/state/kwl/+/temperatur" > /tmp/temp.log
+#
+# Damit jede Messung gesendet wird, sollte die Publish-Policy der
+# Temperaturen vorher auf minimale Differenz 0 gesetzt werden.
+#
+# Ausgabe je Messung: Zeit, Messwert, gefilterter Wert, Steigung in C/min.
+#
+# AUFRUF: python <Pfad zu Script>/filtertemp.py --infile /tmp/temp.log --topic aussenluft
+####################################################################
+
+# must match constants in TempSensors.cpp
+FILTER_SHIFT = 16
+FILTER_ALPHA_SHIFT = 2
+FILTER_BETA_SHIFT = 5
+FILTER_MAX_RESIDUAL = 3 << FILTER_SHIFT
+FILTER_MAX_GAP_MS = 60000
+FILTER_MAX_SLOPE = int((20 << FILTER_SHIFT) / 60)
+
+def CDiv(a, b):
+	# integer division truncating towards zero like in C
+	q = abs(a) // abs(b)
+	return q if (a < 0) == (b < 0) else -q
+
+class Filter:
+	def __init__(self):
+		self.valid = False
+		self.t = 0
+		self.slope = 0
+		self.ms = 0
+
+	def Update(self, raw, now):
+		z = raw << (FILTER_SHIFT - 4)
+		dt = now - self.ms
+		self.ms = now
+		if self.valid and dt > 0 and dt <= FILTER_MAX_GAP_MS:
+			predicted = self.t + CDiv(self.slope * dt, 1000)
+			residual = z - predicted
+			if abs(residual) <= FILTER_MAX_RESIDUAL:
+				self.t = predicted + (residual >> FILTER_ALPHA_SHIFT)
+				self.slope += CDiv((residual >> FILTER_BETA_SHIFT) * 1000, dt)
+				self.slope = max(-FILTER_MAX_SLOPE, min(FILTER_MAX_SLOPE, self.slope))
+				return
+		self.t = z
+		self.slope = 0
+		self.valid = True
+
+	def Filtered(self):
+		return float(self.t) / (1 << FILTER_SHIFT)
+
+	def Slope(self):
+		return float(self.slope) * 60 / (1 << FILTER_SHIFT)
+
+################################################## MAIN ##################################################
+
+parser = argparse.ArgumentParser(description="filtertemp.py applies temperature filter to recorded temperatures.")
+parser.add_argument("--infile", help="Log file with '<unix time> <topic> <temperature>' lines (default: 'temp.log')", default='temp.log')
+parser.add_argument("--topic", help="Part of the topic to select a sensor (default: 'aussenluft')", default='aussenluft')
+args = parser.parse_args()
+
+f = Filter()
+count = 0
+sum_sq = 0.0
+max_slope = 0.0
+print('%14s %8s %8s %8s' % ('Zeit', 'Messung', 'Filter', 'C/min'))
+with open(args.infile, 'r') as log:
+	for line in log:
+		parts = line.split()
+		if len(parts) != 3 or args.topic not in parts[1]:
+			continue
+		now = int(float(parts[0]) * 1000)
+		t = float(parts[2])
+		if t <= -127:
+			continue
+		f.Update(int(round(t * 16)), now)
+		print('%14.3f %8.2f %8.3f %8.3f' % (now / 1000.0, t, f.Filtered(), f.Slope()))
+		count += 1
+		sum_sq += (f.Filtered() - t) ** 2
+		max_slope = max(max_slope, abs(f.Slope()))
+if count:
+	print('')
+	print('Messungen: %d, RMS Abweichung: %.3f C, max. Steigung: %.2f C/min' % (count, (sum_sq / count) ** 0.5, max_slope))
@@ -0,0 +1,212 @@
+#!/usr/bin/python
+# -*- coding: latin-1 -*-
+
+################################################################
+#
+#   Copyright notice
+#
+#   Control software for a Room Ventilation System
+#   https://github.com/svenjust/room-ventilation-system
+#
+#   Copyright (C) 2019  Ivan Schréter (schreter@gmx.net)
+#
+#   This program is free software: you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation, either version 3 of the License, or
+#   (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+#   This copyright notice MUST APPEAR in all copies of the script!
+#
+################################################################
+import argparse
+import math
+import os
+import re
+####################################################################
+# WAS MACHT DIESES SCRIPT?
+# Dieses Script gehört zum Projekt Room Ventilation System,
+# https://github.com/svenjust/room-ventilation-system
+####################################################################
+# Dieses Python Script erzeugt TGS2600Table.hpp mit der Kennlinie des
+# VOC Sensors TGS2600 als Tabelle. Der Controller rechnet damit ohne
+# pow(), exp() und log() (siehe TGS2600Curve.hpp, TGS2600_getppm()).
+#
+# Die Kennlinie ppm = SCALINGFACTOR * (Rs/Ro)^EXPONENT wird über
+# log2(Rs/RL) in Festkomma (1/2048) stückweise linear abgelegt. Die
+# Konstanten TGS2600_SCALINGFACTOR, TGS2600_EXPONENT, TGS2600_DEFAULTRO
+# und TGS2600_RL werden aus TGS2600Curve.hpp gelesen, das Script
+# muss also nach jeder Änderung dieser Konstanten aufgerufen werden.
+#
+# Zur Kontrolle wird die Festkomma-Rechnung des Controllers für alle
+# Messwerte des A/D-Wandlers nachgerechnet und der maximale Fehler
+# gegenüber der Formel ausgegeben. Dieselbe Prüfung mit dem Code des
+# Controllers macht tgs2600_test.cpp in diesem Verzeichnis.
+#
+# AUFRUF: python <Pfad zu Script>/gen_tgs2600_table.py [--src <Pfad zu KWLctl>]
+####################################################################
+
+# fixed point of log2 values as shift (1/2048)
+LOG_SHIFT = 11
+# size of log2 mantissa table as shift (32 entries)
+LOG_TABLE_SHIFT = 5
+# range of A/D converter
+ADC_MAX = 1024
+# step between entries of the ppm table as shift in log2 fixed point (1/16)
+TABLE_SHIFT = 7
+# maximum ppm value (saturated)
+MAX_PPM = 32767
+
+CONSTANT_RE = r'static constexpr \w+\s+%s\s*=\s*([-0-9.]+)'
+
+def ReadConstant(src, name):
+	m = re.search(CONSTANT_RE % name, src)
+	if not m:
+		raise Exception('Constant %s not found' % name)
+	return float(m.group(1))
+
+class Curve:
+	def __init__(self, src):
+		self.scaling = ReadConstant(src, 'TGS2600_SCALINGFACTOR')
+		self.exponent = ReadConstant(src, 'TGS2600_EXPONENT')
+		self.ro = ReadConstant(src, 'TGS2600_DEFAULTRO')
+		self.rl = ReadConstant(src, 'TGS2600_RL')
+
+	def PPM(self, rs):
+		# original floating-point formula
+		return self.scaling * math.pow(rs / self.ro, self.exponent)
+
+	def PPMAtLog(self, l):
+		# ppm for log2(Rs/RL) in fixed point
+		return self.PPM(math.pow(2, float(l) / (1 << LOG_SHIFT)) * self.rl)
+
+	def LogAtPPM(self, ppm):
+		# log2(Rs/RL) in fixed point for given ppm
+		return (math.log(ppm / self.scaling, 2) / self.exponent + math.log(self.ro / self.rl, 2)) * (1 << LOG_SHIFT)
+
+def LogTable():
+	size = 1 << LOG_TABLE_SHIFT
+	return [int(round(math.log(1 + float(i) / size, 2) * (1 << LOG_SHIFT))) for i in range(size + 1)]
+
+def PPMTable(curve):
+	step = 1 << TABLE_SHIFT
+	a = curve.LogAtPPM(MAX_PPM)
+	b = curve.LogAtPPM(0.5)
+	start = int(math.floor(min(a, b) / step)) * step
+	count = int(math.ceil((max(a, b) - start) / step)) + 1
+	# first entry is above MAX_PPM, so interpolation is exact up to saturation
+	values = [int(round(curve.PPMAtLog(start + i * step))) for i in range(count)]
+	if max(values) > 0xffff:
+		raise Exception('Table values out of range')
+	return (start, values)
+
+def Log2(x, log_table):
+	# same as log2Fixed() in TGS2600Curve.hpp
+	msb = x.bit_length() - 1
+	m = (x << (15 - msb)) & 0x7fff
+	i = m >> (15 - LOG_TABLE_SHIFT)
+	frac = m & ((1 << (15 - LOG_TABLE_SHIFT)) - 1)
+	y0 = log_table[i]
+	y1 = log_table[i + 1]
+	return (msb << LOG_SHIFT) + y0 + (((y1 - y0) * frac + (1 << (14 - LOG_TABLE_SHIFT))) >> (15 - LOG_TABLE_SHIFT))
+
+def Lookup(adc, start, values, log_table):
+	# same as TGS2600_getppm() in TGS2600Curve.hpp
+	l = Log2(ADC_MAX - adc, log_table) - Log2(adc, log_table)
+	d = l - start
+	if d <= 0:
+		return min(MAX_PPM, values[0])
+	i = d >> TABLE_SHIFT
+	if i >= len(values) - 1:
+		return min(MAX_PPM, values[-1])
+	frac = d & ((1 << TABLE_SHIFT) - 1)
+	return min(MAX_PPM, values[i] + (((values[i + 1] - values[i]) * frac + (1 << (TABLE_SHIFT - 1))) >> TABLE_SHIFT))
+
+def FormatTable(values, per_line):
+	lines = []
+	for i in range(0, len(values), per_line):
+		lines.append('  ' + ', '.join('%5d' % v for v in values[i:i + per_line]) + ',')
+	lines[-1] = lines[-1][:-1]
+	return '\n'.join(lines)
+
+HEADER = '''/*
+ * Copyright (C) 2019 Ivan Schr\xe9ter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Characteristic curve of TGS2600 VOC sensor.
+ *
+ * GENERATED by Docs/debug_voc/gen_tgs2600_table.py from constants in
+ * TGS2600Curve.hpp, do not edit.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+'''
+
+################################################## MAIN ##################################################
+
+parser = argparse.ArgumentParser(description="gen_tgs2600_table.py generates lookup table for TGS2600 VOC sensor.")
+parser.add_argument("--src", help="Directory with sketch sources (default: Sourcecode/KWLctl)",
+	default=os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'Sourcecode', 'KWLctl'))
+args = parser.parse_args()
+
+with open(os.path.join(args.src, 'TGS2600Curve.hpp'), 'r', encoding='utf-8') as f:
+	curve = Curve(f.read())
+log_table = LogTable()
+(start, values) = PPMTable(curve)
+
+with open(os.path.join(args.src, 'TGS2600Table.hpp'), 'w', encoding='utf-8') as f:
+	f.write(HEADER)
+	f.write('/// Fixed point of log2 values as shift (1/%d).\n' % (1 << LOG_SHIFT))
+	f.write('static constexpr uint8_t LOG2_SHIFT = %d;\n' % LOG_SHIFT)
+	f.write('/// Size of LOG2_TABLE as shift (without the last entry).\n')
+	f.write('static constexpr uint8_t LOG2_TABLE_SHIFT = %d;\n' % LOG_TABLE_SHIFT)
+	f.write('/// Step between entries of TGS2600_PPM_TABLE as shift in log2 fixed point.\n')
+	f.write('static constexpr uint8_t TGS2600_TABLE_SHIFT = %d;\n' % TABLE_SHIFT)
+	f.write('/// Maximum ppm value (saturated).\n')
+	f.write('static constexpr uint16_t TGS2600_MAX_PPM = %d;\n\n' % MAX_PPM)
+	f.write('/// log2(1 + i/%d) in 1/%d for i = 0..%d.\n' % (1 << LOG_TABLE_SHIFT, 1 << LOG_SHIFT, 1 << LOG_TABLE_SHIFT))
+	f.write('static const uint16_t LOG2_TABLE[] PROGMEM = {\n%s\n};\n\n' % FormatTable(log_table, 11))
+	f.write('/// log2(Rs/RL) in 1/%d at the first entry of TGS2600_PPM_TABLE.\n' % (1 << LOG_SHIFT))
+	f.write('static constexpr int16_t TGS2600_TABLE_START = %d;\n\n' % start)
+	f.write('/// ppm at log2(Rs/RL) = TGS2600_TABLE_START + i * %d/%d (ppm = %.10g * (Rs/%g)^%.10g).\n' %
+		(1 << TABLE_SHIFT, 1 << LOG_SHIFT, curve.scaling, curve.ro, curve.exponent))
+	f.write('static const uint16_t TGS2600_PPM_TABLE[] PROGMEM = {\n%s\n};\n' % FormatTable(values, 10))
+
+# check fixed-point computation against formula
+max_abs = 0.0       # below 100 ppm (dominated by rounding to whole ppm)
+max_rel = 0.0       # from 100 ppm
+for adc in range(1, ADC_MAX):
+	exact = curve.PPM(curve.rl * (ADC_MAX - adc) / adc)
+	err = abs(Lookup(adc, start, values, log_table) - min(exact, MAX_PPM))
+	if exact < 100:
+		max_abs = max(max_abs, err)
+	else:
+		max_rel = max(max_rel, err / min(exact, MAX_PPM))
+print('Tabelle: %d Eintraege ab %d' % (len(values), start))
+print('Max. Fehler: %.2f ppm unter 100 ppm, %.2f%% ab 100 ppm' % (max_abs, max_rel * 100))
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Host test of TGS2600 lookup table against the floating-point formula.
+ *
+ * For all A/D values 1..1023, the fixed-point computation of the controller
+ * must stay within 1.5 ppm of the formula below 100 ppm (where rounding to
+ * whole ppm dominates) and within 1% from 100 ppm. Run it after regenerating
+ * TGS2600Table.hpp with gen_tgs2600_table.py.
+ *
+ * Build and run from the repository root:
+ *
+ *     Docs/debug_host/run.sh Docs/debug_voc/tgs2600_test.cpp
+ */
+
+#include "TGS2600Curve.hpp"
+#include "../debug_host/HostTest.h"
+
+namespace
+{
+  /// Maximum absolute error below 100 ppm.
+  static constexpr double MAX_ABS_ERROR = 1.5;
+  /// Maximum relative error from 100 ppm.
+  static constexpr double MAX_REL_ERROR = 0.01;
+
+  /// ppm according to the original formula, saturated like the controller.
+  double exactPPM(int adc)
+  {
+    double rs = TGS2600_RL * (1024 - adc) / adc;
+    double ppm = TGS2600_SCALINGFACTOR * pow(rs / TGS2600_DEFAULTRO, TGS2600_EXPONENT);
+    return ppm > TGS2600_MAX_PPM ? TGS2600_MAX_PPM : ppm;
+  }
+}
+
+int main()
+{
+  // log2 in fixed point for all arguments used by TGS2600_getppm()
+  int max_log_error = 0;
+  for (unsigned x = 1; x <= 1024; ++x) {
+    int exact = int(lround(log2(double(x)) * (1 << LOG2_SHIFT)));
+    int error = abs(log2Fixed(uint16_t(x)) - exact);
+    if (error > max_log_error)
+      max_log_error = error;
+  }
+  CHECK(max_log_error <= 1);
+
+  // ppm for all A/D values
+  double max_abs = 0, max_rel = 0;
+  int last = -1;
+  for (int adc = 1; adc < 1024; ++adc) {
+    double exact = exactPPM(adc);
+    int ppm = TGS2600_getppm(adc);
+    double error = fabs(ppm - exact);
+    if (exact < 100) {
+      if (error > max_abs)
+        max_abs = error;
+    } else if (error / exact > max_rel) {
+      max_rel = error / exact;
+    }
+    CHECK(ppm >= last);   // monotonic, higher voltage means more gas
+    last = ppm;
+  }
+  CHECK(max_abs <= MAX_ABS_ERROR);
+  CHECK(max_rel <= MAX_REL_ERROR);
+  CHECK(TGS2600_getppm(1023) == TGS2600_MAX_PPM);
+
+  printf("maximum error %.2f ppm below 100 ppm, %.2f%% from 100 ppm, log2 %d/%d\n",
+         max_abs, max_rel * 100, max_log_error, 1 << LOG2_SHIFT);
+  return hostTestResult();
+}
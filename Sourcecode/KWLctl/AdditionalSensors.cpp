@@ -19,47 +19,80 @@
  */
 
 #include "AdditionalSensors.h"
+#include "SensorDriver.h"
 #include "KWLConfig.h"
 #include "MessageHandler.h"
 #include "MQTTTopic.hpp"
+#include "TGS2600Curve.hpp"
 
-#include <DHT.h>
-#include <DHT_U.h>
+#include <DHTAsync.h>
 
 // Definitionen für das Scheduling
 
 /// Interval between two DHT sensor readings (10s).
-static constexpr unsigned long INTERVAL_DHT_READ              = 10000000;
+static constexpr uint16_t INTERVAL_DHT_READ               = 10000;
 /// Interval between two CO2 sensor readings (10s).
-static constexpr unsigned long INTERVAL_MHZ14_READ            = 10000000;
+static constexpr uint16_t INTERVAL_MHZ14_READ             = 10000;
 /// Time between VOC sensor readings (1s).
-static constexpr unsigned long INTERVAL_TGS2600_READ          =  1000000;
-
-/// Minimum time between communicating DHT values.
-static constexpr unsigned long INTERVAL_MQTT_DHT              =  5000000;
-/// Maximum time between communicating DHT values.
-static constexpr unsigned long INTERVAL_MQTT_DHT_FORCE        = 300000000; // 5 * 60 * 1000; 5 Minuten
-/// Minimum time between communicating CO2 values.
-static constexpr unsigned long INTERVAL_MQTT_MHZ14            = 60000000;
-/// Maximum time between communicating CO2 values.
-static constexpr unsigned long INTERVAL_MQTT_MHZ14_FORCE      = 300000000; // 5 * 60 * 1000; 5 Minuten
-/// Minimum time between communicating VOC values.
-static constexpr unsigned long INTERVAL_MQTT_TGS2600          =  5000000;
-/// Maximum time between communicating VOC values.
-static constexpr unsigned long INTERVAL_MQTT_TGS2600_FORCE    = 30000000;
-
-// DHT Sensoren
-static DHT_Unified dht1(KWLConfig::PinDHTSensor1, DHT22);
-static DHT_Unified dht2(KWLConfig::PinDHTSensor2, DHT22);
-
-// TGS2600
-static constexpr float  TGS2600_DEFAULTPPM        = 10;           //default ppm of CO2 for calibration
-static constexpr long   TGS2600_DEFAULTRO         = 45000;        //default Ro for TGS2600_DEFAULTPPM ppm of CO2
-static constexpr double TGS2600_SCALINGFACTOR     = 0.3555567714; //CO2 gas value
-static constexpr double TGS2600_EXPONENT          = -3.337882361; //CO2 gas value
-//static constexpr double TGS2600_MAXRSRO           = 2.428;        //for CO2
-//static constexpr double TGS2600_MINRSRO           = 0.358;        //for CO2
-static constexpr double TGS2600_RL                = 1000;
+static constexpr uint16_t INTERVAL_TGS2600_READ           =  1000;
+/// Time after startup before DHT sensors are ready (1.5s).
+static constexpr uint16_t STARTUP_DHT                     =  1500;
+/// Time after wakeup request before the first CO2 sensor reading (100ms).
+static constexpr uint16_t STARTUP_MHZ14                   =   100;
+/// Time for CO2 sensor to answer a request (100ms).
+static constexpr unsigned long MHZ14_ANSWER_TIME          =   100000;
+/// Time between checking publish policies (1s).
+static constexpr unsigned long INTERVAL_SEND              =  1000000;
+/// Maximum time between checking for due sensor readings (1s).
+static constexpr unsigned long MAX_READ_WAIT              =  1000000;
+
+// Names of sensors for logging
+static constexpr auto NameDHT1 = makeFlashStringLiteral("DHT1");
+static constexpr auto NameDHT2 = makeFlashStringLiteral("DHT2");
+static constexpr auto NameCO2  = makeFlashStringLiteral("CO2");
+static constexpr auto NameVOC  = makeFlashStringLiteral("VOC");
+
+/// Get unit suffix for logging.
+static const __FlashStringHelper* unitName(SensorDriver::Unit unit)
+{
+  switch (unit) {
+    case SensorDriver::Unit::CELSIUS: return F("C");
+    case SensorDriver::Unit::PERCENT: return F("%");
+    case SensorDriver::Unit::PPM:     return F("ppm");
+  }
+  return F("");
+}
+
+// ----------------------------- TGS2600 ------------------------------------
+
+/*
+   get the calibrated ro based upon read resistance, and a know ppm
+*/
+static double TGS2600_getro(double resvalue, float ppm) {
+  return resvalue * exp(log(TGS2600_SCALINGFACTOR / double(ppm)) / TGS2600_EXPONENT);
+}
+
+static int calcSensor_VOC(int valr)
+{
+  if (valr <= 0)
+    return 0;
+  if (valr >= 1024)
+    return TGS2600_MAX_PPM;
+  int val_voc = TGS2600_getppm(valr);
+  if (LOG_ENABLED(KWLConfig::LogLevelSensor, TRACE)) {
+    double val = TGS2600_RL * (1024 - valr) / valr;
+    LogLine log(LogLevel::TRACE);
+    log.print( F("Vrl / Rs / ratio:"));
+    log.print( val);
+    log.print( F(" / "));
+    log.print( TGS2600_getro(val, TGS2600_DEFAULTPPM));
+    log.print( F(" / "));
+    log.println(val_voc);
+  }
+  return val_voc;
+}
+
+// ----------------------------- TGS2600 END --------------------------------
 
 // **************************** CO2 Sensor MH-Z14 ******************************************
 static const uint8_t cmdReadGasPpm[9]   = {0xFF, 0x01, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x79};
@@ -77,323 +110,408 @@ static const uint8_t cmdReadGasPpm[9]   = {0xFF, 0x01, 0x86, 0x00, 0x00, 0x00, 0
 //  return checksum;
 //}
 
-// ----------------------------- TGS2600 ------------------------------------
-
-// TODO there are many warnings when computing the value. For now, added
-// explicit casts to proper types and/or cleaned up types, but it needs
-// to be checked.
+// ----------------------------- Drivers ----------------------------------
 
-/*
-   get the calibrated ro based upon read resistance, and a know ppm
-*/
-static double TGS2600_getro(double resvalue, float ppm) {
-  return resvalue * exp(log(TGS2600_SCALINGFACTOR / double(ppm)) / TGS2600_EXPONENT);
-}
+/// Driver for DHT22 temperature and humidity sensor.
+class DHTSensor : public SensorDriver
+{
+public:
+  DHTSensor(uint8_t pin, const __FlashStringHelper* name, const __FlashStringHelper* temp_topic, const __FlashStringHelper* hum_topic) noexcept :
+    SensorDriver(name, PublishGroup::DHT, 2, INTERVAL_DHT_READ, STARTUP_DHT),
+    dht_(pin), temp_topic_(temp_topic), hum_topic_(hum_topic)
+  {}
+
+  virtual bool begin() noexcept override
+  {
+    dht_.begin();
+    return true;
+  }
 
-/*
-   get the ppm concentration
-*/
-static double TGS2600_getppm(double resvalue, long ro) {
-  return TGS2600_SCALINGFACTOR * pow((resvalue / ro), TGS2600_EXPONENT);
-}
+  virtual unsigned long start() noexcept override { return dht_.advance(); }
+
+  virtual unsigned long poll() noexcept override
+  {
+    auto wait = dht_.advance();
+    if (wait)
+      return wait;
+    // keep values of the last read, status is BUSY during the next one
+    valid_ = (dht_.getStatus() == DHTAsync::Status::DONE);
+    if (valid_) {
+      temperature_ = dht_.getTemperature();
+      humidity_ = dht_.getHumidity();
+    } else if (LOG_ENABLED(KWLConfig::LogLevelSensor, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(getName());
+      log.print(F(" status "));
+      log.println(int(dht_.getStatus()));
+    }
+    return 0;
+  }
 
-static int calcSensor_VOC(int valr)
-{
-  double val;
-  double TGS2600_ro = 0;  // unused except for debugging
-  double val_voc = 0;
-
-  //Serial.println(valr);
-  if (valr > 0) {
-    val =  (TGS2600_RL * (1024 - valr) / valr);
-    TGS2600_ro = TGS2600_getro(val, TGS2600_DEFAULTPPM);
-    //convert to ppm (using default ro)
-    val_voc = TGS2600_getppm(val, TGS2600_DEFAULTRO);
+  virtual long getValue(uint8_t index) const noexcept override
+  {
+    if (!valid_)
+      return INVALID_VALUE;
+    return index ? long(humidity_) : long(temperature_);
   }
-  if (KWLConfig::serialDebugSensor) {
-    Serial.print ( F("Vrl / Rs / ratio:"));
-    Serial.print ( val);
-    Serial.print ( F(" / "));
-    Serial.print ( TGS2600_ro);
-    Serial.print ( F(" / "));
-    Serial.println (val_voc);
+
+  virtual ValueInfo getValueInfo(uint8_t index) const noexcept override
+  {
+    // deadband is in 0.1C for temperature and in % for humidity
+    if (index)
+      return { hum_topic_, Unit::PERCENT, 1, 10 };
+    else
+      return { temp_topic_, Unit::CELSIUS, 1, 1 };
   }
-  return int(val_voc);
-}
 
-// ----------------------------- TGS2600 END --------------------------------
+  /// Get temperature or NAN, if not measured.
+  float getTemperature() const noexcept { return isPresent() && valid_ ? temperature_ * 0.1f : NAN; }
 
+  /// Get humidity or NAN, if not measured.
+  float getHumidity() const noexcept { return isPresent() && valid_ ? humidity_ * 0.1f : NAN; }
 
-AdditionalSensors::AdditionalSensors() :
-  stats_(F("AdditionalSensors")),
-  dht1_read_(stats_, &AdditionalSensors::readDHT1, *this),
-  dht2_read_(stats_, &AdditionalSensors::readDHT2, *this),
-  mhz14_read_(stats_, &AdditionalSensors::readMHZ14, *this),
-  voc_read_(stats_, &AdditionalSensors::readVOC, *this),
-  dht_send_task_(stats_, &AdditionalSensors::sendDHT, *this, false),
-  dht_send_oversample_task_(stats_, &AdditionalSensors::sendDHT, *this, true),
-  co2_send_task_(stats_, &AdditionalSensors::sendCO2, *this, false),
-  co2_send_oversample_task_(stats_, &AdditionalSensors::sendCO2, *this, true),
-  voc_send_task_(stats_, &AdditionalSensors::sendVOC, *this, false),
-  voc_send_oversample_task_(stats_, &AdditionalSensors::sendVOC, *this, true)
-{}
+private:
+  DHTAsync dht_;
+  const __FlashStringHelper* temp_topic_;
+  const __FlashStringHelper* hum_topic_;
+  int16_t temperature_ = 0;   ///< Temperature of the last successful read in 0.1C.
+  uint16_t humidity_ = 0;     ///< Humidity of the last successful read in 0.1%.
+  bool valid_ = false;        ///< Set if the last read was successful.
+};
 
-bool AdditionalSensors::setupMHZ14()
+/// Driver for MH-Z14 CO2 sensor.
+class MHZ14Sensor : public SensorDriver
 {
-  MHZ14_available_ = false;
-
-  uint8_t response[9];
-
-  KWLConfig::SerialMHZ14.begin(9600);
-  delay(100);
-  // Folgende zwei Zeilen sind notwendig, damit der Sensor nach Anlegen der Spannung erkannt wird, ansonsten wird er nur nach Reset erkannt.
-  KWLConfig::SerialMHZ14.write(cmdReadGasPpm, 9);
-  KWLConfig::SerialMHZ14.readBytes(response, 9);
-  delay(100);
-  KWLConfig::SerialMHZ14.write(cmdReadGasPpm, 9);
-  if (KWLConfig::SerialMHZ14.readBytes(response, 9) == 9) {
-    int responseHigh = response[2];
-    int responseLow = response[3];
-    int ppm = (256 * responseHigh) + responseLow;
-    if (KWLConfig::serialDebugSensor) {
-      Serial.print(F("CO2 ppm: "));
-      Serial.println(ppm);
-    }
-    if (ppm > 0) {
-      mhz14_read_.runRepeated(INTERVAL_MHZ14_READ);
-      MHZ14_available_ = true;
-    }
+public:
+  MHZ14Sensor() noexcept :
+    SensorDriver(NameCO2, PublishGroup::CO2, 1, INTERVAL_MHZ14_READ, STARTUP_MHZ14)
+  {}
+
+  virtual bool begin() noexcept override
+  {
+    KWLConfig::SerialMHZ14.begin(9600);
+    // Folgende Anfrage ist notwendig, damit der Sensor nach Anlegen der Spannung erkannt wird, ansonsten wird er nur nach Reset erkannt.
+    KWLConfig::SerialMHZ14.write(cmdReadGasPpm, 9);
+    return true;
   }
-  return MHZ14_available_;
-}
 
-bool AdditionalSensors::setupTGS2600()
-{
-  pinMode(KWLConfig::PinVocSensor, INPUT_PULLUP);
-  analogRead(KWLConfig::PinVocSensor);  // discard a read to get more stable reading
-  int analogVal = analogRead(KWLConfig::PinVocSensor);
-  if (KWLConfig::serialDebugSensor) Serial.println(analogVal);
-  if (analogVal < 1020 /* some reserve for not exact analog read of empty pin */) {
-    voc_read_.runRepeated(INTERVAL_TGS2600_READ, INTERVAL_TGS2600_READ);
-    TGS2600_available_ = true;
-  } else {
-    TGS2600_available_ = false;
+  virtual unsigned long start() noexcept override
+  {
+    while (KWLConfig::SerialMHZ14.available())
+      KWLConfig::SerialMHZ14.read();
+    KWLConfig::SerialMHZ14.write(cmdReadGasPpm, 9);
+    return MHZ14_ANSWER_TIME;
   }
-  return TGS2600_available_;
-}
 
-void AdditionalSensors::readDHT1()
-{
-  sensors_event_t event;
-
-  dht1.temperature().getEvent(&event);
-  if (isnanf(event.temperature)) {
-    if (!KWLConfig::SendErroneousMeasurement)
-      dht1_temp_ = event.temperature;
-    Serial.println(F("Failed reading temperature from DHT1"));
-  } else if (event.temperature != dht1_temp_) {
-    dht1_temp_ = event.temperature;
-    if (KWLConfig::serialDebugSensor) {
-      Serial.print(F("DHT1 T: "));
-      Serial.println(dht1_temp_);
+  virtual unsigned long poll() noexcept override
+  {
+    uint8_t response[9];
+    if (KWLConfig::SerialMHZ14.available() < 9) {
+      // no answer, readBytes() would block
+      ppm_ = -1000;
+      return 0;
     }
+    KWLConfig::SerialMHZ14.readBytes(response, 9);
+    int responseHigh = response[2];
+    int responseLow = response[3];
+    int ppm = (256 * responseHigh) + responseLow;
+    // Automatische Kalibrieren des Nullpunktes auf den kleinstmöglichen Wert
+    //if (ppm < Co2Min)
+    //  KWLConfig::SerialMHZ14.write(cmdCalZeroPoint, 9);
+    ppm_ = ppm;
+    return 0;
   }
 
-  dht1.humidity().getEvent(&event);
-  if (isnanf(event.relative_humidity)) {
-    if (!KWLConfig::SendErroneousMeasurement)
-      dht1_hum_ = event.relative_humidity;
-    Serial.println(F("Failed reading humidity from DHT1"));
-  } else if (event.relative_humidity != dht1_hum_) {
-    dht1_hum_ = event.relative_humidity;
-    if (KWLConfig::serialDebugSensor) {
-      Serial.print(F("DHT1 H: "));
-      Serial.println(dht1_hum_);
-    }
-  }
-}
+  virtual long getValue(uint8_t) const noexcept override { return ppm_ >= 0 ? ppm_ : INVALID_VALUE; }
+
+  virtual ValueInfo getValueInfo(uint8_t) const noexcept override { return { MQTTTopic::KwlCO2Abluft, Unit::PPM, 0, 1 }; }
 
-void AdditionalSensors::readDHT2()
+  /// Get CO2 concentration in ppm or -1000, if not measured.
+  int getPPM() const noexcept { return isPresent() ? ppm_ : -1000; }
+
+private:
+  int ppm_ = -1000;
+};
+
+/// Driver for TGS2600 VOC sensor.
+class TGS2600Sensor : public SensorDriver
 {
-  sensors_event_t event;
-
-  dht2.temperature().getEvent(&event);
-  if (isnanf(event.temperature)) {
-    if (!KWLConfig::SendErroneousMeasurement)
-      dht2_temp_ = event.temperature;
-    Serial.println(F("Failed reading temperature from DHT2"));
-  } else if (event.temperature != dht2_temp_) {
-    dht2_temp_ = event.temperature;
-    if (KWLConfig::serialDebugSensor) {
-      Serial.print(F("DHT2 T: "));
-      Serial.println(dht2_temp_);
-    }
+public:
+  TGS2600Sensor() noexcept :
+    SensorDriver(NameVOC, PublishGroup::VOC, 1, INTERVAL_TGS2600_READ, 0)
+  {}
+
+  virtual bool begin() noexcept override
+  {
+    pinMode(KWLConfig::PinVocSensor, INPUT_PULLUP);
+    analogRead(KWLConfig::PinVocSensor);  // discard a read to get more stable reading
+    int analogVal = analogRead(KWLConfig::PinVocSensor);
+    LOG(KWLConfig::LogLevelSensor, TRACE).println(analogVal);
+    return analogVal < 1020; /* some reserve for not exact analog read of empty pin */
   }
 
-  dht2.humidity().getEvent(&event);
-  if (isnanf(event.relative_humidity)) {
-    if (!KWLConfig::SendErroneousMeasurement)
-      dht2_hum_ = event.relative_humidity;
-    Serial.println(F("Failed reading humidity from DHT2"));
-  } else if (event.relative_humidity != dht2_hum_) {
-    dht2_hum_ = event.relative_humidity;
-    if (KWLConfig::serialDebugSensor) {
-      Serial.print(F("DHT2 H: "));
-      Serial.println(dht2_hum_);
+  virtual unsigned long start() noexcept override
+  {
+    analogRead(KWLConfig::PinVocSensor);  // discard a read to get more stable reading
+    int analogVal = analogRead(KWLConfig::PinVocSensor);
+    voc_ = calcSensor_VOC(analogVal);
+    if (LOG_ENABLED(KWLConfig::LogLevelSensor, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("VOC analogVal: "));
+      log.print(analogVal);
+      log.print(F(", ppm="));
+      log.println(voc_);
     }
+    return 0;
   }
-}
 
-void AdditionalSensors::readMHZ14()
-{
-  uint8_t response[9];
-  KWLConfig::SerialMHZ14.write(cmdReadGasPpm, 9);
-  if (KWLConfig::SerialMHZ14.readBytes(response, 9) == 9) {
-    int responseHigh = response[2];
-    int responseLow = response[3];
-    int ppm = (256 * responseHigh) + responseLow;
+  // published in 0.1ppm for compatibility, deadband is in ppm
+  virtual long getValue(uint8_t) const noexcept override { return voc_ >= 0 ? voc_ * 10L : INVALID_VALUE; }
 
-    if (KWLConfig::serialDebugSensor) {
-      Serial.print(F("CO2 ppm: "));
-      Serial.println(ppm);
-    }
-    // Automatische Kalibrieren des Nullpunktes auf den kleinstmöglichen Wert
-    //if (ppm < Co2Min)
-    //  KWLConfig::SerialMHZ14.write(cmdCalZeroPoint, 9);
+  virtual ValueInfo getValueInfo(uint8_t) const noexcept override { return { MQTTTopic::KwlVOCAbluft, Unit::PPM, 1, 10 }; }
+
+  /// Get VOC concentration in ppm or -1, if not measured.
+  int getPPM() const noexcept { return isPresent() ? voc_ : -1; }
+
+private:
+  int voc_ = -1;
+};
+
+// Sensor instances
+static DHTSensor dht1(KWLConfig::PinDHTSensor1, NameDHT1, MQTTTopic::KwlDHT1Temperatur, MQTTTopic::KwlDHT1Humidity);
+static DHTSensor dht2(KWLConfig::PinDHTSensor2, NameDHT2, MQTTTopic::KwlDHT2Temperatur, MQTTTopic::KwlDHT2Humidity);
+static MHZ14Sensor mhz14;
+static TGS2600Sensor tgs2600;
+
+/// Registry of additional sensors, sensors disabled in the configuration are nullptr.
+static SensorDriver* const SENSOR_REGISTRY[] = {
+  KWLConfig::UseDHTSensor1 ? &dht1 : nullptr,
+  KWLConfig::UseDHTSensor2 ? &dht2 : nullptr,
+  KWLConfig::UseCO2Sensor ? &mhz14 : nullptr,
+  KWLConfig::UseVOCSensor ? &tgs2600 : nullptr
+};
+static_assert(sizeof(SENSOR_REGISTRY) / sizeof(SENSOR_REGISTRY[0]) <= AdditionalSensors::MAX_SENSORS, "Too many sensors, increase MAX_SENSORS");
+
+// ----------------------------- Drivers END -------------------------------
 
-    co2_ppm_ = ppm;
+
+AdditionalSensors::AdditionalSensors(const KWLPersistentConfig& config) :
+  config_(config),
+  stats_(F("AdditionalSensors")),
+  read_task_(stats_, &AdditionalSensors::read, *this),
+  send_task_(stats_, &AdditionalSensors::send, *this)
+{}
+
+void AdditionalSensors::begin(Print& initTracer)
+{
+  initTracer.print(F("Initialisierung Sensoren:"));
+  auto now = millis();
+  sensor_count_ = 0;
+  for (auto sensor : SENSOR_REGISTRY) {
+    if (!sensor || !sensor->begin())
+      continue;
+    // sensors need time to answer, they are detected in the background
+    sensor->state_ = SensorDriver::State::DETECTING;
+    sensor->next_start_ = now + sensor->startup_delay_;
+    sensor->send_ticks_ = 0xffff;  // send right after the first measurement
+    sensors_[sensor_count_++] = sensor;
+    initTracer.print(' ');
+    initTracer.print(sensor->getName());
+  }
+  if (sensor_count_) {
+    current_ = sensor_count_ - 1;
+    read_task_.runOnce(0);
+    send_task_.runRepeated(INTERVAL_SEND);
+    initTracer.println(F(" (werden im Hintergrund erkannt)"));
   } else {
-    co2_ppm_ = -1000;
+    initTracer.println(F(" keine"));
   }
 }
 
-void AdditionalSensors::readVOC()
+bool AdditionalSensors::isPending() const noexcept
 {
-  analogRead(KWLConfig::PinVocSensor);  // discard a read to get more stable reading
-  int analogVal = analogRead(KWLConfig::PinVocSensor);
-  voc_ = calcSensor_VOC(analogVal);
-  if (KWLConfig::serialDebugSensor) {
-    Serial.print(F("VOC analogVal: "));
-    Serial.print(analogVal);
-    Serial.print(F(", ppm="));
-    Serial.println(voc_);
-  }
+  for (uint8_t i = 0; i < sensor_count_; ++i)
+    if (sensors_[i]->isDetecting())
+      return true;
+  return false;
 }
 
-void AdditionalSensors::begin(Print& initTracer)
+bool AdditionalSensors::hasDHT1() const noexcept { return dht1.isPresent(); }
+float AdditionalSensors::getDHT1Temp() const noexcept { return dht1.getTemperature(); }
+float AdditionalSensors::getDHT1Hum() const noexcept { return dht1.getHumidity(); }
+bool AdditionalSensors::hasDHT2() const noexcept { return dht2.isPresent(); }
+float AdditionalSensors::getDHT2Temp() const noexcept { return dht2.getTemperature(); }
+float AdditionalSensors::getDHT2Hum() const noexcept { return dht2.getHumidity(); }
+bool AdditionalSensors::hasVOC() const noexcept { return tgs2600.isPresent(); }
+int AdditionalSensors::getVOC() const noexcept { return tgs2600.getPPM(); }
+bool AdditionalSensors::hasCO2() const noexcept { return mhz14.isPresent(); }
+int AdditionalSensors::getCO2() const noexcept { return mhz14.getPPM(); }
+
+void AdditionalSensors::read()
 {
-  initTracer.print(F("Initialisierung Sensoren:"));
-  // DHT Sensoren
-  dht1.begin();
-  dht2.begin();
-  delay(1500);
-  sensors_event_t event;
-  dht1.temperature().getEvent(&event);
-  if (!isnan(event.temperature)) {
-    DHT1_available_ = true;
-    initTracer.print(F(" DHT1"));
-    dht1_read_.runRepeated(INTERVAL_DHT_READ);
-  }
-  dht2.temperature().getEvent(&event);
-  if (!isnan(event.temperature)) {
-    DHT2_available_ = true;
-    initTracer.print(F(" DHT2"));
-    dht2_read_.runRepeated(INTERVAL_DHT_READ);
+  if (measuring_) {
+    auto& sensor = *sensors_[current_];
+    auto wait = sensor.poll();
+    if (wait) {
+      read_task_.runOnce(wait);
+      return;
+    }
+    measuring_ = false;
+    finishRead(sensor);
   }
-  if (DHT1_available_ || DHT2_available_) {
-    dht_send_task_.runRepeated(INTERVAL_DHT_READ + 1000000, INTERVAL_MQTT_DHT);
-    dht_send_oversample_task_.runRepeated(INTERVAL_DHT_READ + 1000000, INTERVAL_MQTT_DHT_FORCE);
+
+  // find the next sensor due for measurement, round-robin
+  auto now = millis();
+  unsigned long next = MAX_READ_WAIT;
+  bool active = false;
+  for (uint8_t i = 0; i < sensor_count_; ++i) {
+    if (++current_ >= sensor_count_)
+      current_ = 0;
+    auto& sensor = *sensors_[current_];
+    if (sensor.state_ == SensorDriver::State::ABSENT)
+      continue;
+    active = true;
+    long due = long(sensor.next_start_ - now);
+    if (due > 0) {
+      if ((unsigned long)(due) * 1000 < next)
+        next = (unsigned long)(due) * 1000;
+      continue;
+    }
+    sensor.next_start_ = now + sensor.interval_;
+    auto wait = sensor.start();
+    if (wait) {
+      measuring_ = true;
+      read_task_.runOnce(wait);
+    } else {
+      finishRead(sensor);
+      read_task_.runOnce(0);  // give other tasks a chance before the next sensor
+    }
+    return;
   }
+  if (active)
+    read_task_.runOnce(next);
+}
 
-  // MH-Z14 CO2 Sensor
-  if (setupMHZ14()) {
-    initTracer.print(F(" CO2"));
-    co2_send_task_.runRepeated(INTERVAL_MHZ14_READ + 1000000, INTERVAL_MQTT_MHZ14);
-    co2_send_oversample_task_.runRepeated(INTERVAL_MHZ14_READ + 1000000, INTERVAL_MQTT_MHZ14_FORCE);
+void AdditionalSensors::finishRead(SensorDriver& sensor)
+{
+  bool valid = false;
+  for (uint8_t i = 0; i < sensor.getValueCount(); ++i)
+    if (sensor.getValue(i) != SensorDriver::INVALID_VALUE)
+      valid = true;
+
+  if (sensor.isDetecting()) {
+    sensor.state_ = valid ? SensorDriver::State::PRESENT : SensorDriver::State::ABSENT;
+    if (!isPending())
+      logDetected();
+    return;
   }
 
-  // TGS2600 VOC Sensor
-  if (setupTGS2600()) {
-    initTracer.print(F(" VOC"));
-    voc_send_task_.runRepeated(INTERVAL_MQTT_TGS2600 + 1000000, INTERVAL_MQTT_TGS2600);
-    voc_send_oversample_task_.runRepeated(INTERVAL_MQTT_TGS2600 + 1000000, INTERVAL_MQTT_TGS2600_FORCE);
+  if (!valid) {
+    if (LOG_ENABLED(KWLConfig::LogLevelSensor, WARNING)) {
+      LogLine log(LogLevel::WARNING);
+      log.print(F("Failed reading "));
+      log.println(sensor.getName());
+    }
+  } else if (LOG_ENABLED(KWLConfig::LogLevelSensor, TRACE)) {
+    LogLine log(LogLevel::TRACE);
+    log.print(sensor.getName());
+    for (uint8_t i = 0; i < sensor.getValueCount(); ++i) {
+      char buffer[FixedPoint::MAX_STRING_SIZE];
+      auto info = sensor.getValueInfo(i);
+      FixedPoint(sensor.getValue(i), info.decimals).toString(buffer);
+      log.print(' ');
+      log.print(buffer);
+      log.print(unitName(info.unit));
+    }
+    log.println();
   }
+}
 
-  if (!DHT1_available_ && !DHT2_available_ && !MHZ14_available_ && !TGS2600_available_) {
-    initTracer.println(F(" keine Sensoren"));
-  } else {
-    initTracer.println();
+void AdditionalSensors::logDetected()
+{
+  if (!LOG_ENABLED(KWLConfig::LogLevelSensor, INFO))
+    return;
+  LogLine log(LogLevel::INFO);
+  log.print(F("Sensors detected:"));
+  bool any = false;
+  for (uint8_t i = 0; i < sensor_count_; ++i) {
+    if (sensors_[i]->isPresent()) {
+      log.print(' ');
+      log.print(sensors_[i]->getName());
+      any = true;
+    }
   }
+  if (!any)
+    log.print(F(" none"));
+  log.println();
 }
 
 void AdditionalSensors::forceSend() noexcept
 {
-  if (DHT1_available_ || DHT2_available_)
-    sendDHT(true);
-  if (MHZ14_available_)
-    sendCO2(true);
-  if (TGS2600_available_)
-    sendVOC(true);
+  sendValues(true);
 }
 
-void AdditionalSensors::sendDHT(bool force) noexcept
+void AdditionalSensors::send()
 {
-  if (!force
-      && (abs(dht1_temp_ - dht1_last_sent_temp_) < 0.1f) && (abs(dht2_temp_ - dht2_last_sent_temp_) < 0.1f)
-      && (abs(dht1_hum_ - dht2_last_sent_hum_) < 1) && (abs(dht2_hum_ - dht2_last_sent_hum_) < 1)) {
-    // not enough change, no point to send
-    return;
-  }
-  dht1_last_sent_temp_ = dht1_temp_;
-  dht1_last_sent_hum_  = dht1_hum_;
-  dht2_last_sent_temp_ = dht2_temp_;
-  dht2_last_sent_hum_  = dht2_hum_;
-  uint8_t bitmap = (DHT1_available_ ? 0x3 : 0) | (DHT2_available_ ? 0xc: 0);
-  publish_dht_.publish([this, bitmap]() mutable {
-    uint8_t bit = 1;
-    while (bit < 16) {
-      if (bitmap & bit) {
-        bool res = true;
-        switch (bit) {
-          case 1: res = isnanf(dht1_temp_) || MessageHandler::publish(MQTTTopic::KwlDHT1Temperatur, dht1_temp_, 1, KWLConfig::RetainAdditionalSensors); break;
-          case 2: res = isnanf(dht1_hum_)  || MessageHandler::publish(MQTTTopic::KwlDHT1Humidity, dht1_hum_, 1, KWLConfig::RetainAdditionalSensors); break;
-          case 4: res = isnanf(dht2_temp_) || MessageHandler::publish(MQTTTopic::KwlDHT2Temperatur, dht2_temp_, 1, KWLConfig::RetainAdditionalSensors); break;
-          case 8: res = isnanf(dht2_hum_)  || MessageHandler::publish(MQTTTopic::KwlDHT2Humidity, dht2_hum_, 1, KWLConfig::RetainAdditionalSensors); break;
-          default: return true; // paranoia
-        }
-        if (!res)
-          return false; // will retry later
-        bitmap &= ~bit;
-      }
-      bit <<= 1;
-    }
-    return true;  // all sent
-  });
-  dht_send_task_.runRepeated(INTERVAL_MQTT_DHT);
-  dht_send_oversample_task_.runRepeated(INTERVAL_MQTT_DHT_FORCE);
+  for (uint8_t i = 0; i < sensor_count_; ++i)
+    if (sensors_[i]->send_ticks_ < 0xffff)
+      ++sensors_[i]->send_ticks_;
+  sendValues(false);
 }
 
-void AdditionalSensors::sendCO2(bool force) noexcept
+void AdditionalSensors::sendValues(bool force) noexcept
 {
-  if (!force && (abs(co2_ppm_ - co2_last_sent_ppm_) < 20)) {
-    // not enough change
-    return;
+  uint16_t pending = 0;
+  for (uint8_t i = 0; i < sensor_count_; ++i) {
+    auto& sensor = *sensors_[i];
+    if (!sensor.isPresent())
+      continue;
+    // maximum change of any value in units of the deadband
+    long change = 0;
+    for (uint8_t v = 0; v < sensor.getValueCount(); ++v) {
+      long value = sensor.getValue(v);
+      long last = sensor.last_sent_[v];
+      long c;
+      if (value == SensorDriver::INVALID_VALUE || last == SensorDriver::INVALID_VALUE)
+        c = (value == last) ? 0 : 0x7fffffffL;  // sensor failed or recovered
+      else
+        c = labs(value - last) / sensor.getValueInfo(v).deadband_scale;
+      if (c > change)
+        change = c;
+    }
+    if (!force && !config_.getPublishPolicy(sensor.getPublishGroup()).shouldPublish(sensor.send_ticks_, change))
+      continue;
+    sensor.send_ticks_ = 0;
+    for (uint8_t v = 0; v < sensor.getValueCount(); ++v) {
+      sensor.last_sent_[v] = sensor.getValue(v);
+      pending |= 1U << (i * SensorDriver::MAX_VALUES + v);
+    }
   }
-  if (co2_ppm_ >= 0)
-    publish_co2_.publish(MQTTTopic::KwlCO2Abluft, co2_ppm_, KWLConfig::RetainAdditionalSensors);
-  else if (KWLConfig::SendErroneousMeasurement)
-    publish_co2_.publish(MQTTTopic::KwlCO2Abluft, -1, KWLConfig::RetainAdditionalSensors);
-  co2_send_task_.runRepeated(INTERVAL_MQTT_MHZ14);
-  co2_send_oversample_task_.runRepeated(INTERVAL_MQTT_MHZ14_FORCE);
+  if (!pending)
+    return;
+  pending_ |= pending;
+  publish_.publish([this]() { return publishPending(); });
 }
 
-void AdditionalSensors::sendVOC(bool force) noexcept
+bool AdditionalSensors::publishPending() noexcept
 {
-  if (!force && (abs(voc_ - voc_last_sent_) < 20)) {
-    // not enough change
-    return;
+  // values are taken at the time of sending, so they are always current
+  for (uint8_t bit = 0; pending_; ++bit) {
+    uint16_t mask = 1U << bit;
+    if (!(pending_ & mask))
+      continue;
+    auto& sensor = *sensors_[bit / SensorDriver::MAX_VALUES];
+    uint8_t index = bit % SensorDriver::MAX_VALUES;
+    auto info = sensor.getValueInfo(index);
+    auto value = sensor.getValue(index);
+    bool res = true;
+    if (value != SensorDriver::INVALID_VALUE)
+      res = MessageHandler::publish(info.topic, FixedPoint(value, info.decimals), KWLConfig::RetainAdditionalSensors);
+    else if (KWLConfig::SendErroneousMeasurement)
+      res = MessageHandler::publish(info.topic, -1, KWLConfig::RetainAdditionalSensors);
+    if (!res)
+      return false; // will retry later
+    pending_ &= ~mask;
   }
-  publish_voc_.publish(MQTTTopic::KwlVOCAbluft, voc_, 1, KWLConfig::RetainAdditionalSensors);
-  voc_send_task_.runRepeated(INTERVAL_MQTT_TGS2600);
-  voc_send_oversample_task_.runRepeated(INTERVAL_MQTT_TGS2600_FORCE);
+  return true;  // all sent
 }
@@ -27,20 +27,33 @@
 #include "TimeScheduler.h"
 #include "MessageHandler.h"
 
-#include <math.h>
-
 class Print;
+class SensorDriver;
+class KWLPersistentConfig;
 
 /*!
  * @brief Additional sensors of the ventilation system (optional).
  *
  * This class reads and publishes values of additional sensors like
  * humidity, CO2 and VOC.
+ *
+ * Sensors are implemented as drivers (see SensorDriver), which are
+ * registered in a static registry in AdditionalSensors.cpp. One task
+ * measures the sensors one after another and another one publishes
+ * changed values once per second according to publish policies.
  */
 class AdditionalSensors
 {
 public:
-  AdditionalSensors();
+  /// Maximum count of registered sensors.
+  static constexpr uint8_t MAX_SENSORS = 8;
+
+  /*!
+   * @brief Construct additional sensors.
+   *
+   * @param config configuration with publish policies for sensor values.
+   */
+  explicit AdditionalSensors(const KWLPersistentConfig& config);
 
   /// Initialize sensors.
   void begin(Print& initTracer);
@@ -48,96 +61,73 @@ public:
   /// Force sending values via MQTT on the next MQTT run.
   void forceSend() noexcept;
 
+  /// Check if detection of sensors is still running (they are reported as not present until detected).
+  bool isPending() const noexcept;
+
   /// Check if DHT1 sensor is present.
-  bool hasDHT1() const noexcept { return DHT1_available_; }
+  bool hasDHT1() const noexcept;
 
   /// Get DHT1 temperature.
-  float getDHT1Temp() const noexcept { return dht1_temp_; }
+  float getDHT1Temp() const noexcept;
 
   /// Get DHT1 humidity.
-  float getDHT1Hum() const noexcept { return dht1_hum_; }
+  float getDHT1Hum() const noexcept;
 
   /// Check if DHT2 sensor is present.
-  bool hasDHT2() const noexcept { return DHT2_available_; }
+  bool hasDHT2() const noexcept;
 
   /// Get DHT2 temperature.
-  float getDHT2Temp() const noexcept { return dht2_temp_; }
+  float getDHT2Temp() const noexcept;
 
   /// Get DHT2 humidity.
-  float getDHT2Hum() const noexcept { return dht2_hum_; }
+  float getDHT2Hum() const noexcept;
 
   /// Check if VOC sensor is present.
-  bool hasVOC() const noexcept { return TGS2600_available_; }
+  bool hasVOC() const noexcept;
 
   /// Get VOC sensor value.
-  int getVOC() const noexcept { return voc_; }
+  int getVOC() const noexcept;
 
   /// Check if CO2 sensor is present.
-  bool hasCO2() const noexcept { return MHZ14_available_; }
+  bool hasCO2() const noexcept;
 
   /// Get CO2 sensor value.
-  int getCO2() const noexcept { return co2_ppm_; }
+  int getCO2() const noexcept;
 
 private:
-  /// Set up CO2 sensor.
-  bool setupMHZ14();
-  /// Set up VOC sensor.
-  bool setupTGS2600();
-
-  /// Read value of DHT1.
-  void readDHT1();
-  /// Read value of DHT2.
-  void readDHT2();
-  /// Read value of CO2 sensor.
-  void readMHZ14();
-  /// Read value of air quality sensor.
-  void readVOC();
-
-  /// Schedule sending DHT values now.
-  void sendDHT(bool force) noexcept;
-  /// Schedule sending CO2 values now.
-  void sendCO2(bool force) noexcept;
-  /// Schedule sending CO2 values now.
-  void sendVOC(bool force) noexcept;
-
-  // sensor availability
-  bool DHT1_available_ = false;
-  bool DHT2_available_ = false;
-  bool TGS2600_available_ = false;
-  bool MHZ14_available_ = false;
-
-  // current values
-  float dht1_temp_ = NAN;
-  float dht2_temp_ = NAN;
-  float dht1_hum_ = NAN;
-  float dht2_hum_ = NAN;
-  int co2_ppm_ = -1000;
-  int voc_ = -1;
-
-  // last sent values per MQTT
-  float dht1_last_sent_temp_ = 0;
-  float dht2_last_sent_temp_ = 0;
-  float dht1_last_sent_hum_ = 0;
-  float dht2_last_sent_hum_ = 0;
-  int co2_last_sent_ppm_ = -1;
-  int voc_last_sent_ = -1;
+  /// Start or continue measurement of the next sensor.
+  void read();
+  /// Evaluate finished measurement of a sensor.
+  void finishRead(SensorDriver& sensor);
+  /// Log detected sensors.
+  void logDetected();
+
+  /// Check publish policies and publish changed values (called every second).
+  void send();
+  /// Publish values, which changed enough or all values, if forced.
+  void sendValues(bool force) noexcept;
+  /// Publish pending values, return true if all sent.
+  bool publishPending() noexcept;
+
+  /// Configuration with publish policies.
+  const KWLPersistentConfig& config_;
+
+  /// Registered sensors, which may be connected.
+  SensorDriver* sensors_[MAX_SENSORS];
+  /// Count of registered sensors.
+  uint8_t sensor_count_ = 0;
+  /// Index of the sensor measured last.
+  uint8_t current_ = 0;
+  /// Set if measurement of the current sensor is running.
+  bool measuring_ = false;
+  /// Values to publish, bit (sensor index * SensorDriver::MAX_VALUES + value index).
+  uint16_t pending_ = 0;
 
   // Tasks running on timeout
   Scheduler::TaskTimingStats stats_;
-  Scheduler::TimedTask<AdditionalSensors> dht1_read_;
-  Scheduler::TimedTask<AdditionalSensors> dht2_read_;
-  Scheduler::TimedTask<AdditionalSensors> mhz14_read_;
-  Scheduler::TimedTask<AdditionalSensors> voc_read_;
-
-  Scheduler::TimedTask<AdditionalSensors, bool> dht_send_task_;
-  Scheduler::TimedTask<AdditionalSensors, bool> dht_send_oversample_task_;
-  Scheduler::TimedTask<AdditionalSensors, bool> co2_send_task_;
-  Scheduler::TimedTask<AdditionalSensors, bool> co2_send_oversample_task_;
-  Scheduler::TimedTask<AdditionalSensors, bool> voc_send_task_;
-  Scheduler::TimedTask<AdditionalSensors, bool> voc_send_oversample_task_;
-
-  // Tasks publishing MQTT values
-  PublishTask publish_dht_;
-  PublishTask publish_co2_;
-  PublishTask publish_voc_;
+  Scheduler::TimedTask<AdditionalSensors> read_task_;
+  Scheduler::TimedTask<AdditionalSensors> send_task_;
+
+  /// Task publishing MQTT values.
+  PublishTask publish_;
 };
@@ -25,6 +25,7 @@
 #include "FanControl.h"
 #include "MQTTTopic.hpp"
 
+#include <Logger.h>
 #include <Wire.h>
 
 /// Run the check every minute.
@@ -37,12 +38,33 @@ static constexpr unsigned long INTERVAL_ANTIFREEZE_ALARM_CHECK = 600000;
 /// Time to turn off fans when antifreeze is used in combination with heating appliance (4h).
 static constexpr unsigned long INTERVAL_HEATING_APP_COMB_USE_ANTIFREEZE = 14400000;   // 4 Stunden = 4 *60 * 60 * 1000
 
-/// Threshold exhaust air temperature under which to do antifreeze processing.
-static constexpr double EXHAUST_ANTIFREEZE_TEMP_THRESHOLD = 1.5;     // Nach kaltem Wetter im Feb 2018 gemäß Messwerte
-
 /// Maximum hysteresis temperature, which makes sense.
 static constexpr long MAX_TEMP_HYSTERESIS = 10;
 
+constexpr CentiCelsius Antifreeze::EXHAUST_ANTIFREEZE_TEMP_THRESHOLD;
+
+namespace
+{
+  /// Get exhaust temperature for the preheater PID, filtered, so it doesn't react to quantization steps.
+  CentiCelsius getExhaustForControl(const TempSensors& temp)
+  {
+    auto t4 = temp.get_t4_exhaust_filtered();
+    if (!t4.isValid() || !temp.isHealthy(3))
+      return temp.get_t4_exhaust();   // possibly estimated from other sensors
+    return t4;
+  }
+
+  /// Get exhaust temperature expected at the next check (in one minute) to start preheating in time.
+  CentiCelsius getExhaustPrediction(const TempSensors& temp)
+  {
+    auto t4 = temp.get_t4_exhaust_filtered();
+    if (!t4.isValid() || !temp.isHealthy(3))
+      return temp.get_t4_exhaust();
+    auto slope = temp.get_t4_exhaust_slope();
+    return slope < CentiCelsius(0) ? t4 + slope : t4;
+  }
+}
+
 // PID REGLER
 static constexpr double heaterKp = 50, heaterKi = 0.1, heaterKd = 0.025;
 
@@ -51,8 +73,8 @@ Antifreeze::Antifreeze(FanControl& fan, TempSensors& temp, KWLPersistentConfig&
   fan_(fan),
   temp_(temp),
   config_(config),
-  hysteresis_temp_delta_(KWLConfig::StandardAntifreezeHystereseTemp),
-  pid_preheater_(&temp_.get_t4_exhaust(), &tech_setpoint_preheater_, &antifreeze_temp_upper_limit_, heaterKp, heaterKi, heaterKd, P_ON_M, DIRECT),
+  hysteresis_temp_delta_(CentiCelsius::fromDegrees(KWLConfig::StandardAntifreezeHystereseTemp)),
+  pid_preheater_(&pid_exhaust_temp_, &tech_setpoint_preheater_, &antifreeze_temp_upper_limit_, heaterKp, heaterKi, heaterKd, P_ON_M, DIRECT),
   heating_app_comb_use_(KWLConfig::StandardHeatingAppCombUse != 0),
   stats_(F("Antifreeze")),
   timer_task_(stats_, &Antifreeze::run, *this)
@@ -62,7 +84,7 @@ void Antifreeze::begin(Print& /*initTracer*/)
 {
   // antifreeze
   hysteresis_temp_delta_ = config_.getAntifreezeHystereseTemp(); // TODO variable name is wrong
-  antifreeze_temp_upper_limit_ = EXHAUST_ANTIFREEZE_TEMP_THRESHOLD + hysteresis_temp_delta_;
+  antifreeze_temp_upper_limit_ = (EXHAUST_ANTIFREEZE_TEMP_THRESHOLD + hysteresis_temp_delta_).toDouble();
 
   pid_preheater_.SetOutputLimits(100, 1000);
   pid_preheater_.SetMode(MANUAL);
@@ -78,12 +100,10 @@ void Antifreeze::setHeatingAppCombUse(bool on)
 {
   if (heating_app_comb_use_ != on) {
     heating_app_comb_use_ = on;
-    if (KWLConfig::serialDebug) {
-      if (on)
-        Serial.println(F("Feuerstättenmodus wird aktiviert und gespeichert"));
-      else
-        Serial.println(F("Feuerstättenmodus wird DEAKTIVIERT und gespeichert"));
-    }
+    if (on)
+      LOG(KWLConfig::LogLevelAntifreeze, TRACE).println(F("Feuerstättenmodus wird aktiviert und gespeichert"));
+    else
+      LOG(KWLConfig::LogLevelAntifreeze, TRACE).println(F("Feuerstättenmodus wird DEAKTIVIERT und gespeichert"));
     config_.setHeatingAppCombUse(on);
   }
   forceSend();
@@ -97,8 +117,7 @@ void Antifreeze::forceSend()
 void Antifreeze::run()
 {
   // Funktion wird regelmäßig zum Überprüfen ausgeführt
-  if (KWLConfig::serialDebugAntifreeze)
-    Serial.println(F("Antifreeze: check start"));
+  LOG(KWLConfig::LogLevelAntifreeze, TRACE).println(F("Antifreeze: check start"));
 
   // antifreeze_state_ = aktueller Status der AntiFrostSchaltung
   // Es wird in jeden Status überprüft, ob die Bedingungen für einen Statuswechsel erfüllt sind
@@ -109,23 +128,25 @@ void Antifreeze::run()
   switch (antifreeze_state_) {
 
     case AntifreezeState::OFF:
-      if ((temp_.get_t4_exhaust() <= EXHAUST_ANTIFREEZE_TEMP_THRESHOLD)
-          && (temp_.get_t1_outside() < 0.0)
-          && (temp_.get_t4_exhaust() > TempSensors::INVALID)
-          && (temp_.get_t1_outside() > TempSensors::INVALID))
-        // Wenn Sensoren fehlen, ist der Wert INVALID
+      // Abluft fällt schnell, dann schon vor Erreichen der Schwelle einschalten
+      if ((temp_.get_t4_exhaust() <= EXHAUST_ANTIFREEZE_TEMP_THRESHOLD
+           || getExhaustPrediction(temp_) <= EXHAUST_ANTIFREEZE_TEMP_THRESHOLD)
+          && (temp_.get_t1_outside() < CentiCelsius(0))
+          && temp_.get_t4_exhaust().isValid()
+          && temp_.get_t1_outside().isValid())
+        // Wenn Sensoren fehlen, ist der Wert ungültig
       {
         // Neuer Status: AntifreezeState::PREHEATER
         antifreeze_state_ = AntifreezeState::PREHEATER;
         send_mqtt = true;
 
         // Vorheizer einschalten
-        antifreeze_temp_upper_limit_  = EXHAUST_ANTIFREEZE_TEMP_THRESHOLD + hysteresis_temp_delta_;
+        antifreeze_temp_upper_limit_  = (EXHAUST_ANTIFREEZE_TEMP_THRESHOLD + hysteresis_temp_delta_).toDouble();
+        pid_exhaust_temp_ = getExhaustForControl(temp_).toDouble();
         pid_preheater_.SetMode(AUTOMATIC);  // Pid einschalten
         preheater_start_time_ms_ = millis();
 
-        if (KWLConfig::serialDebugAntifreeze)
-          Serial.println(F("Antifreeze: threshold reached; state = PREHEATER"));
+        LOG(KWLConfig::LogLevelAntifreeze, TRACE).println(F("Antifreeze: threshold reached; state = PREHEATER"));
       }
       break;
 
@@ -136,13 +157,12 @@ void Antifreeze::run()
         antifreeze_state_ = AntifreezeState::OFF;
         send_mqtt = true;
         pid_preheater_.SetMode(MANUAL);
-        if (KWLConfig::serialDebugAntifreeze)
-          Serial.println(F("Antifreeze: threshold reached; state = OFF"));
+        LOG(KWLConfig::LogLevelAntifreeze, TRACE).println(F("Antifreeze: threshold reached; state = OFF"));
       } else if ((millis() - preheater_start_time_ms_ > INTERVAL_ANTIFREEZE_ALARM_CHECK)
           && (temp_.get_t4_exhaust() <= EXHAUST_ANTIFREEZE_TEMP_THRESHOLD)
-          && (temp_.get_t1_outside() < 0.0)
-          && (temp_.get_t4_exhaust() > TempSensors::INVALID)
-          && (temp_.get_t1_outside() > TempSensors::INVALID)) {
+          && (temp_.get_t1_outside() < CentiCelsius(0))
+          && temp_.get_t4_exhaust().isValid()
+          && temp_.get_t1_outside().isValid()) {
         // 10 Minuten vergangen seit antifreeze_state_ == AntifreezeState::PREHEATER und Temperatur immer noch unter EXHAUST_ANTIFREEZE_TEMP_THRESHOLD
         if (heating_app_comb_use_) {
           // Neuer Status: AntifreezeState::FIREPLACE
@@ -151,15 +171,13 @@ void Antifreeze::run()
           pid_preheater_.SetMode(MANUAL);
           // Zeit speichern
           heating_app_comb_use_antifreeze_start_time_ms_ = millis();
-          if (KWLConfig::serialDebugAntifreeze)
-            Serial.println(F("Antifreeze: preheater timeout; state = FIREPLACE"));
+          LOG(KWLConfig::LogLevelAntifreeze, TRACE).println(F("Antifreeze: preheater timeout; state = FIREPLACE"));
         } else {
           // Neuer Status: AntifreezeState::FAN_OFF
           antifreeze_state_ = AntifreezeState::FAN_OFF;
           send_mqtt = true;
           pid_preheater_.SetMode(MANUAL);
-          if (KWLConfig::serialDebugAntifreeze)
-            Serial.println(F("Antifreeze: preheater timeout; state = FAN_OFF"));
+          LOG(KWLConfig::LogLevelAntifreeze, TRACE).println(F("Antifreeze: preheater timeout; state = FAN_OFF"));
         }
         break;
 
@@ -185,11 +203,12 @@ void Antifreeze::run()
       }
   }
 
-  if (KWLConfig::serialDebugAntifreeze) {
-    Serial.print (F("millis: "));
-    Serial.println (millis());
-    Serial.print (F("antifreeze_state_: "));
-    Serial.println(uint8_t(antifreeze_state_));
+  if (LOG_ENABLED(KWLConfig::LogLevelAntifreeze, TRACE)) {
+    LogLine log(LogLevel::TRACE);
+    log.print(F("millis: "));
+    log.println(millis());
+    log.print(F("antifreeze_state_: "));
+    log.println(uint8_t(antifreeze_state_));
   }
 
   if (send_mqtt)
@@ -203,22 +222,21 @@ void Antifreeze::setPreheater()
   // Wenn der Zuluftventilator unter einer Schwelle des Tachosignals liegt, wird das Vorheizregister IMMER ausgeschaltet (SICHERHEIT)
   // Schwelle: 1000 U/min
 
-  if (KWLConfig::serialDebugAntifreeze) {
-    Serial.println(F("SetPreheater start"));
-  }
+  LOG(KWLConfig::LogLevelAntifreeze, TRACE).println(F("SetPreheater start"));
 
   // Sicherheitsabfrage
   if (fan_.getFan1().getSpeed() < 600 || fan_.getFan1().isOff()) {
     // Sicherheitsabschaltung Vorheizer unter 600 Umdrehungen Zuluftventilator
     tech_setpoint_preheater_ = 0;
   }
-  if (KWLConfig::serialDebugAntifreeze) {
-    Serial.print(F("Preheater - M: "));
-    Serial.print(millis());
-    Serial.print(F(", Gap: "));
-    Serial.print(abs(antifreeze_temp_upper_limit_ - temp_.get_t4_exhaust()));
-    Serial.print(F(", tech_setpoint_preheater_: "));
-    Serial.println(tech_setpoint_preheater_);
+  if (LOG_ENABLED(KWLConfig::LogLevelAntifreeze, TRACE)) {
+    LogLine log(LogLevel::TRACE);
+    log.print(F("Preheater - M: "));
+    log.print(millis());
+    log.print(F(", Gap: "));
+    log.print(abs(antifreeze_temp_upper_limit_ - temp_.get_t4_exhaust().toDouble()));
+    log.print(F(", tech_setpoint_preheater_: "));
+    log.println(tech_setpoint_preheater_);
     // TODO based on what to send via MQTT?
     //MessageHandler::publish(MQTTTopic::KwlDebugstatePreheater, _buffer);
   }
@@ -260,13 +278,13 @@ void Antifreeze::doActionAntiFreezeState()
   switch (antifreeze_state_)
   {
     case AntifreezeState::PREHEATER:
+      pid_exhaust_temp_ = getExhaustForControl(temp_).toDouble();
       pid_preheater_.Compute();
       break;
 
     case AntifreezeState::FAN_OFF:
       // Zuluft aus
-      if (KWLConfig::serialDebugAntifreeze)
-        Serial.println(F("Antifreeze: fan1 = 0"));
+      LOG(KWLConfig::LogLevelAntifreeze, TRACE).println(F("Antifreeze: fan1 = 0"));
       fan_.getFan1().off();
       tech_setpoint_preheater_ = 0;
       break;
@@ -274,8 +292,7 @@ void Antifreeze::doActionAntiFreezeState()
     case AntifreezeState::FIREPLACE:
       // Feuerstättenmodus
       // beide Lüfter aus
-      if (KWLConfig::serialDebugAntifreeze)
-        Serial.println(F("Antifreeze: fan1 = 0, fan2 = 0 (fireplace)"));
+      LOG(KWLConfig::LogLevelAntifreeze, TRACE).println(F("Antifreeze: fan1 = 0, fan2 = 0 (fireplace)"));
       fan_.getFan1().off();
       fan_.getFan2().off();
       tech_setpoint_preheater_ = 0;
@@ -299,8 +316,8 @@ bool Antifreeze::mqttReceiveMsg(const StringView& topic, const StringView& s)
       i = 0;
     if (i > MAX_TEMP_HYSTERESIS)
       i = MAX_TEMP_HYSTERESIS;
-    hysteresis_temp_delta_ = unsigned(i);
-    antifreeze_temp_upper_limit_ = EXHAUST_ANTIFREEZE_TEMP_THRESHOLD + hysteresis_temp_delta_;
+    hysteresis_temp_delta_ = CentiCelsius::fromDegrees(int(i));
+    antifreeze_temp_upper_limit_ = (EXHAUST_ANTIFREEZE_TEMP_THRESHOLD + hysteresis_temp_delta_).toDouble();
     config_.setAntifreezeHystereseTemp(hysteresis_temp_delta_);
   } else if (topic == MQTTTopic::CmdHeatingAppCombUse) {
     if (s == F("YES"))
@@ -26,6 +26,7 @@
 
 #include "TimeScheduler.h"
 #include "MessageHandler.h"
+#include "CentiCelsius.h"
 
 #include <PID_v1.h>
 
@@ -49,6 +50,9 @@ enum class AntifreezeState : uint8_t
 class Antifreeze : private MessageHandler
 {
 public:
+  /// Threshold exhaust air temperature under which to do antifreeze processing.
+  static constexpr CentiCelsius EXHAUST_ANTIFREEZE_TEMP_THRESHOLD = CentiCelsius(150);     // Nach kaltem Wetter im Feb 2018 gemäß Messwerte
+
   Antifreeze(const Antifreeze&) = delete;
   Antifreeze& operator=(const Antifreeze&) = delete;
 
@@ -96,7 +100,8 @@ private:
   TempSensors& temp_;
   KWLPersistentConfig& config_;
   AntifreezeState antifreeze_state_ = AntifreezeState::OFF;
-  unsigned hysteresis_temp_delta_;
+  CentiCelsius hysteresis_temp_delta_;
+  double pid_exhaust_temp_ = 0.0;   // Eingang des PID-Reglers (T4)
   double antifreeze_temp_upper_limit_;
   double tech_setpoint_preheater_   = 0.0;      // Analogsignal 0..1000 für Vorheizer
   unsigned long preheater_start_time_ms_ = 0;      // Beginn der Vorheizung
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2018 Sven Just (sven@familie-just.de)
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+#include "CentiCelsius.h"
+
+/// Highest temperature representable (and plausible for any sensor).
+static constexpr double MAX_TEMPERATURE = 300.0;
+
+CentiCelsius CentiCelsius::fromDouble(double t) noexcept
+{
+  // comparisons are false for NaN
+  if (!(t > INVALID_VALUE * 0.01 && t < MAX_TEMPERATURE))
+    return CentiCelsius();
+  return CentiCelsius(int16_t(lround(t * 100)));
+}
+
+size_t PrintableCentiCelsius::printTo(Print& p) const
+{
+  char buffer[8];
+  auto v = toCenti();
+  unsigned u = unsigned(v < 0 ? -v : v);
+  snprintf_P(buffer, sizeof(buffer), PSTR("%s%u.%02u"), v < 0 ? "-" : "", u / 100, u % 100);
+  return p.print(buffer);
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018 Sven Just (sven@familie-just.de)
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Temperature in hundredths of a degree Celsius.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+class PrintableCentiCelsius;
+
+/*!
+ * @brief Temperature in hundredths of a degree Celsius.
+ *
+ * Temperatures are passed between modules and compared as integers, so control
+ * logic doesn't need floating-point code and comparisons with thresholds are
+ * exact. Floating point is only used at the boundary to sensor drivers and
+ * PID controllers.
+ *
+ * The same type is used for temperature differences (e.g., hysteresis).
+ *
+ * @note This class intentionally doesn't derive from Printable to keep it small.
+ *    Convert to PrintableCentiCelsius to get a printable version.
+ */
+class CentiCelsius
+{
+public:
+  /// Raw value of invalid temperature (sensor not working), equivalent to -127C.
+  static constexpr int16_t INVALID_VALUE = -12700;
+
+  /// Construct invalid temperature.
+  constexpr CentiCelsius() noexcept : value_(INVALID_VALUE) {}
+
+  /// Construct temperature from hundredths of a degree.
+  explicit constexpr CentiCelsius(int16_t centi) noexcept : value_(centi) {}
+
+  /// Construct temperature from whole degrees.
+  static constexpr CentiCelsius fromDegrees(int degrees) noexcept { return CentiCelsius(int16_t(degrees * 100)); }
+
+  /// Construct temperature from floating-point value (invalid, if out of range or NaN).
+  static CentiCelsius fromDouble(double t) noexcept;
+
+  /// Check whether the temperature is valid.
+  constexpr bool isValid() const noexcept { return value_ > INVALID_VALUE; }
+
+  /// Get temperature in hundredths of a degree.
+  constexpr int16_t toCenti() const noexcept { return value_; }
+
+  /// Get temperature in whole degrees (truncated).
+  constexpr int toDegrees() const noexcept { return value_ / 100; }
+
+  /// Get temperature as floating-point value (for PID controllers).
+  double toDouble() const noexcept { return value_ * 0.01; }
+
+  /// Get absolute value.
+  constexpr CentiCelsius absolute() const noexcept { return CentiCelsius(value_ < 0 ? int16_t(-value_) : value_); }
+
+  constexpr CentiCelsius operator+(CentiCelsius o) const noexcept { return CentiCelsius(int16_t(value_ + o.value_)); }
+  constexpr CentiCelsius operator-(CentiCelsius o) const noexcept { return CentiCelsius(int16_t(value_ - o.value_)); }
+  constexpr bool operator==(CentiCelsius o) const noexcept { return value_ == o.value_; }
+  constexpr bool operator!=(CentiCelsius o) const noexcept { return value_ != o.value_; }
+  constexpr bool operator<(CentiCelsius o) const noexcept { return value_ < o.value_; }
+  constexpr bool operator<=(CentiCelsius o) const noexcept { return value_ <= o.value_; }
+  constexpr bool operator>(CentiCelsius o) const noexcept { return value_ > o.value_; }
+  constexpr bool operator>=(CentiCelsius o) const noexcept { return value_ >= o.value_; }
+
+  /// Convert to printable temperature (e.g., "21.50").
+  inline operator PrintableCentiCelsius() const;
+
+private:
+  int16_t value_; ///< Temperature in hundredths of a degree.
+};
+
+/// Printable version of the temperature.
+class PrintableCentiCelsius : public CentiCelsius, public Printable
+{
+public:
+  PrintableCentiCelsius(const CentiCelsius& other) : CentiCelsius(other) {}
+
+  virtual size_t printTo(Print& p) const override;
+};
+
+inline CentiCelsius::operator PrintableCentiCelsius() const {
+  return PrintableCentiCelsius(*this);
+}
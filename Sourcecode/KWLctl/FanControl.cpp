@@ -23,6 +23,7 @@
 #include "KWLConfig.h"
 
 #include <StringView.h>
+#include <Logger.h>
 
 #include <Arduino.h>
 #include <Wire.h>
@@ -34,14 +35,8 @@ static FanControl* instance_ = nullptr;
 
 /// Interval for scheduling fan regulation (1s)
 static constexpr unsigned long FAN_INTERVAL = 1000000;
-/// Interval for sending fan information (5s), if speed changed.
-static constexpr unsigned long FAN_MQTT_INTERVAL = 5000000;
-/// Interval for sending fan information unconditionally (2min).
-static constexpr unsigned long FAN_MQTT_INTERVAL_OVERSAMPLING = 120000000;
 /// Interval for sending mode information unconditionally (5min).
 static constexpr unsigned long MODE_MQTT_INTERVAL = 300000000;
-/// Only send fan speed if changed by at least 50rpm.
-static constexpr int MIN_SPEED_DIFF = 50;
 
 // Calibration timing:
 
@@ -50,6 +45,8 @@ static constexpr int MIN_SPEED_DIFF = 50;
 static constexpr unsigned long TIMEOUT_CALIBRATION = 600000000;
 /// Timeout for the calibration of one PWM step (5 minutes).
 static constexpr unsigned long TIMEOUT_PWM_CALIBRATION = 300000000;
+/// Runtime budget of fan task (3s), storing calibration results writes EEPROM.
+static constexpr uint16_t FAN_TASK_BUDGET_MS = 3000;
 
 // Define the aggressive and conservative Tuning Parameters
 // Nenndrehzahl Lüfter 3200, Stellwert 0..1000 entspricht 0-10V
@@ -84,16 +81,19 @@ void Fan::begin(void (*countUp)(), unsigned standardSpeed, float ipr)
   auto intr = uint8_t(digitalPinToInterrupt(tacho_pin_));
   attachInterrupt(intr, countUp, KWLConfig::TachoSamplingMode);
 
-  Serial.print(F("Fan pins(tacho/PWM), interrupt, std speed, ipr:\t"));
-  Serial.print(tacho_pin_);
-  Serial.print('\t');
-  Serial.print(pwm_pin_);
-  Serial.print('\t');
-  Serial.print(intr);
-  Serial.print('\t');
-  Serial.print(standardSpeed);
-  Serial.print('\t');
-  Serial.println(ipr);
+  if (LOG_ENABLED(KWLConfig::LogLevelFan, INFO)) {
+    LogLine log(LogLevel::INFO);
+    log.print(F("Fan pins(tacho/PWM), interrupt, std speed, ipr:\t"));
+    log.print(tacho_pin_);
+    log.print('\t');
+    log.print(pwm_pin_);
+    log.print('\t');
+    log.print(intr);
+    log.print('\t');
+    log.print(standardSpeed);
+    log.print('\t');
+    log.println(ipr);
+  }
 
   // Turn on power
   power_.on();
@@ -132,18 +132,19 @@ void Fan::computeSpeed(int ventMode, FanCalculateSpeedMode calcMode)
 
 void Fan::setSpeed(int id, uint8_t pwmPin, uint8_t dacChannel)
 {
-  if (KWLConfig::serialDebugFan) {
-    Serial.print(F("Fan "));
-    Serial.print(id);
-    Serial.print(F(": \tgap: "));
-    Serial.print(current_speed_ - speed_setpoint_);
-    Serial.print(F("\tspeedTacho: "));
-    Serial.print(current_speed_);
-    Serial.print(F("\ttechSetpoint: "));
-    Serial.print(tech_setpoint_);
-    Serial.print(F("\tspeedSetpoint: "));
-    Serial.println(speed_setpoint_);
-    rpm_.dump(Serial);
+  if (LOG_ENABLED(KWLConfig::LogLevelFan, TRACE)) {
+    LogLine log(LogLevel::TRACE);
+    log.print(F("Fan "));
+    log.print(id);
+    log.print(F(": \tgap: "));
+    log.print(current_speed_ - speed_setpoint_);
+    log.print(F("\tspeedTacho: "));
+    log.print(current_speed_);
+    log.print(F("\ttechSetpoint: "));
+    log.print(tech_setpoint_);
+    log.print(F("\tspeedSetpoint: "));
+    log.println(speed_setpoint_);
+    rpm_.dump(log);
   }
 
   // Setzen per PWM
@@ -243,7 +244,7 @@ FanControl::FanControl(KWLPersistentConfig& config, SetSpeedCallback *speedCallb
   speed_callback_(speedCallback),
   ventilation_mode_(KWLConfig::StandardKwlMode),
   persistent_config_(config),
-  stats_(F("FanControl")),
+  stats_(F("FanControl"), FAN_TASK_BUDGET_MS),
   timer_task_(stats_, &FanControl::run, *this)
 {}
 
@@ -281,14 +282,15 @@ void FanControl::run()
   fan1_.updateSpeed();
   fan2_.updateSpeed();
 
-  if (KWLConfig::serialDebugFan) {
-    Serial.print(F("Speed fan1: "));
-    Serial.print(fan1_.getSpeed());
-    Serial.print(F(", fan2: "));
-    Serial.print(fan2_.getSpeed());
+  if (LOG_ENABLED(KWLConfig::LogLevelFan, TRACE)) {
+    LogLine log(LogLevel::TRACE);
+    log.print(F("Speed fan1: "));
+    log.print(fan1_.getSpeed());
+    log.print(F(", fan2: "));
+    log.print(fan2_.getSpeed());
     if (mode_ == FanMode::Calibration)
-      Serial.print(F(" [calibration]"));
-    Serial.println();
+      log.print(F(" [calibration]"));
+    log.println();
   }
 
   if (mode_ == FanMode::Normal) {
@@ -304,24 +306,16 @@ void FanControl::run()
     mqtt_send_flags_ |= MQTT_SEND_MODE;
     send_mqtt = true;
   }
-  if (--send_fan_oversampling_countdown_ <= 0) {
-    send_fan_oversampling_countdown_ = int(FAN_MQTT_INTERVAL_OVERSAMPLING / FAN_INTERVAL);
-    send_fan_countdown_ = int(FAN_MQTT_INTERVAL / FAN_INTERVAL);
+  if (send_fan_ticks_ < 0xffff)
+    ++send_fan_ticks_;
+  int fan1 = int(fan1_.getSpeed());
+  int fan2 = int(fan2_.getSpeed());
+  // check whether we need to send data
+  int change = max(abs(fan1 - last_sent_fan1_speed_), abs(fan2 - last_sent_fan2_speed_));
+  if (persistent_config_.getPublishPolicy(PublishGroup::FAN).shouldPublish(send_fan_ticks_, change)) {
     mqtt_send_flags_ |= MQTT_SEND_FAN1 | MQTT_SEND_FAN2;
     send_mqtt = true;
   }
-  if (--send_fan_countdown_ <= 0) {
-    int fan1 = int(fan1_.getSpeed());
-    int fan2 = int(fan2_.getSpeed());
-    // check whether we need to send data
-    if (abs(fan1 - last_sent_fan1_speed_) >= MIN_SPEED_DIFF ||
-        abs(fan2 - last_sent_fan2_speed_) >= MIN_SPEED_DIFF) {
-      send_fan_oversampling_countdown_ = int(FAN_MQTT_INTERVAL_OVERSAMPLING / FAN_INTERVAL);
-      send_fan_countdown_ = int(FAN_MQTT_INTERVAL / FAN_INTERVAL);
-      mqtt_send_flags_ |= MQTT_SEND_FAN1 | MQTT_SEND_FAN2;
-      send_mqtt = true;
-    }
-  }
 
   if (send_mqtt)
     sendMQTT();
@@ -343,16 +337,17 @@ void FanControl::setSpeed()
   fan1_.sendMQTTDebug(1, timer_task_.getScheduleTime(), *this);
   fan2_.sendMQTTDebug(2, timer_task_.getScheduleTime(), *this);
 
-  if (KWLConfig::serialDebugFan) {
-    Serial.print(F("Timestamp: "));
-    Serial.println(timer_task_.getScheduleTime());
+  if (LOG_ENABLED(KWLConfig::LogLevelFan, TRACE)) {
+    LogLine log(LogLevel::TRACE);
+    log.print(F("Timestamp: "));
+    log.println(timer_task_.getScheduleTime());
   }
   fan1_.setSpeed(1, KWLConfig::PinFan1PWM, KWLConfig::DacChannelFan1);
   fan2_.setSpeed(2, KWLConfig::PinFan2PWM, KWLConfig::DacChannelFan2);
 }
 
 void FanControl::speedCalibrationStart() {
-  Serial.println(F("Kalibrierung der Lüfter wird gestartet"));
+  LOG(KWLConfig::LogLevelFan, INFO).println(F("Kalibrierung der Lüfter wird gestartet"));
   calibration_pwm_in_progress_ = false;
   calibration_in_progress_ = false;
   mode_ = FanMode::Calibration;
@@ -360,10 +355,10 @@ void FanControl::speedCalibrationStart() {
 
 void FanControl::speedCalibrationStep()
 {
-  Serial.println(F("SpeedCalibrationPwm startet"));
+  LOG(KWLConfig::LogLevelFan, INFO).println(F("SpeedCalibrationPwm startet"));
   if (!calibration_in_progress_) {
     // Erster Durchlauf der Kalibrierung
-    Serial.println(F("Erster Durchlauf"));
+    LOG(KWLConfig::LogLevelFan, INFO).println(F("Erster Durchlauf"));
     calibration_in_progress_ = true;
     calibration_start_time_us_ = timer_task_.getScheduleTime();
     current_calibration_mode_ = 0;
@@ -375,7 +370,7 @@ void FanControl::speedCalibrationStep()
   } else {
     if (!calibration_pwm_in_progress_) {
       // Erster Durchlauf der Kalibrierung
-      Serial.println(F("Erster Durchlauf für Stufe, calibration_pwm_in_progress_"));
+      LOG(KWLConfig::LogLevelFan, INFO).println(F("Erster Durchlauf für Stufe, calibration_pwm_in_progress_"));
       calibration_pwm_in_progress_ = true;
       calibration_pwm_start_time_us_ = timer_task_.getScheduleTime();
       fan1_.prepareCalibration();
@@ -391,13 +386,14 @@ void FanControl::speedCalibrationStep()
           fan1_.finishCalibration();
           fan2_.finishCalibration();
           storePWMSettingsToEEPROM();
-          for (unsigned i = 0; ((i < KWLConfig::StandardModeCnt) && (i < 10)); i++) {
-            Serial.print(F("Stufe: "));
-            Serial.print(i);
-            Serial.print(F("  PWM Fan 1: "));
-            Serial.print(fan1_.getPWM(i));
-            Serial.print(F("  PWM Fan 2: "));
-            Serial.println(fan2_.getPWM(i));
+          for (unsigned i = 0; LOG_ENABLED(KWLConfig::LogLevelFan, INFO) && i < KWLConfig::StandardModeCnt && i < 10; i++) {
+            LogLine log(LogLevel::INFO);
+            log.print(F("Stufe: "));
+            log.print(i);
+            log.print(F("  PWM Fan 1: "));
+            log.print(fan1_.getPWM(i));
+            log.print(F("  PWM Fan 2: "));
+            log.println(fan2_.getPWM(i));
           }
           stopCalibration(false);
         } else {
@@ -427,9 +423,9 @@ void FanControl::stopCalibration(bool timeout)
   calibration_in_progress_ = false;
   calibration_start_time_us_ = 0;
   if (timeout)
-    Serial.println(F("Error: Kalibrierung NICHT erfolgreich"));
+    LOG(KWLConfig::LogLevelFan, ERROR).println(F("Error: Kalibrierung NICHT erfolgreich"));
   else
-    Serial.println(F("Kalibrierung erfolgreich beendet"));
+    LOG(KWLConfig::LogLevelFan, INFO).println(F("Kalibrierung erfolgreich beendet"));
   // TODO shouldn't this also reset fan speed immediately?
 }
 
@@ -505,8 +501,11 @@ void FanControl::sendMQTT()
 {
   int fan1 = int(fan1_.getSpeed());
   int fan2 = int(fan2_.getSpeed());
-  last_sent_fan1_speed_ = fan1;
-  last_sent_fan2_speed_ = fan2;
+  if (mqtt_send_flags_ & (MQTT_SEND_FAN1 | MQTT_SEND_FAN2)) {
+    last_sent_fan1_speed_ = fan1;
+    last_sent_fan2_speed_ = fan2;
+    send_fan_ticks_ = 0;
+  }
   auto mode = ventilation_mode_;
   mqtt_publish_.publish([this, fan1, fan2, mode]() {
     if (!publish_if(mqtt_send_flags_, MQTT_SEND_MODE, MQTTTopic::StateKwlMode, mode, KWLConfig::RetainFanMode))
@@ -273,8 +273,7 @@ private:
   static constexpr uint8_t MQTT_SEND_FAN2 = 4;
 
   int send_mode_countdown_ = 0;     ///< Countdown until sending mode (in run intervals).
-  int send_fan_countdown_ = 0;      ///< Countdown until sending fan state (in run intervals).
-  int send_fan_oversampling_countdown_ = 0; ///< Countdown until sending fan state unconditionally.
+  uint16_t send_fan_ticks_ = 0xffff; ///< Seconds since sending fan state.
   int last_sent_fan1_speed_ = 0;    ///< Last reported fan 1 speed.
   int last_sent_fan2_speed_ = 0;    ///< Last reported fan 2 speed.
   PublishTask mqtt_publish_;        ///< Task to reliably send values.
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2018 Sven Just (sven@familie-just.de)
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+#include "InfluxExporter.h"
+#include "TempSensors.h"
+#include "FanControl.h"
+#include "AdditionalSensors.h"
+#include "Antifreeze.h"
+#include "NetworkClient.h"
+#include "KWLConfig.h"
+
+#include <MicroNTP.h>
+
+/// Local UDP port used for sending (any free port, no replies expected).
+static constexpr uint16_t LOCAL_PORT = 50124;
+
+/// Size of the buffer for one datagram.
+static constexpr unsigned INFLUX_BUFFER_SIZE = 256;
+
+namespace
+{
+  /// Writer for one line in InfluxDB line protocol into a fixed buffer.
+  class LineWriter
+  {
+  public:
+    LineWriter(char* buffer, unsigned size) : begin_(buffer), p_(buffer), end_(buffer + size - 1) {}
+
+    /// Add measurement name or tag without any escaping.
+    void addRaw(const char* s)
+    {
+      auto len = strlen(s);
+      if (unsigned(end_ - p_) < len)
+        return;
+      memcpy(p_, s, len);
+      p_ += len;
+    }
+
+    /// Add tag value, escaping commas, equal signs and spaces.
+    void addTagValue(const char* s)
+    {
+      while (*s && p_ != end_) {
+        if (*s == ',' || *s == '=' || *s == ' ') {
+          if (end_ - p_ < 2)
+            break;
+          *p_++ = '\\';
+        }
+        *p_++ = *s++;
+      }
+    }
+
+    /// Add measurement name or tag from Flash without any escaping.
+    void addRaw(const __FlashStringHelper* s)
+    {
+      char tmp[16];
+      strlcpy_P(tmp, reinterpret_cast<const char*>(s), sizeof(tmp));
+      addRaw(tmp);
+    }
+
+    /// Add integer field.
+    void add(const __FlashStringHelper* key, long value)
+    {
+      char tmp[13];
+      ltoa(value, tmp, 10);
+      strcat(tmp, "i");
+      addField(key, tmp);
+    }
+
+    /// Add fixed-point field.
+    void add(const __FlashStringHelper* key, FixedPoint value)
+    {
+      char tmp[FixedPoint::MAX_STRING_SIZE];
+      value.toString(tmp);
+      addField(key, tmp);
+    }
+
+    /// Add timestamp in seconds and finish the line.
+    unsigned finish(unsigned long time)
+    {
+      if (time) {
+        char tmp[24];
+        ultoa(time, tmp, 10);
+        strcat(tmp, "000000000"); // line protocol uses nanoseconds
+        if (unsigned(end_ - p_) > strlen(tmp)) {
+          *p_++ = ' ';
+          addRaw(tmp);
+        }
+      }
+      *p_ = 0;
+      return unsigned(p_ - begin_);
+    }
+
+  private:
+    /// Add field with already formatted value, skip it if it doesn't fit.
+    void addField(const __FlashStringHelper* key, const char* value)
+    {
+      auto key_len = strlen_P(reinterpret_cast<const char*>(key));
+      auto value_len = strlen(value);
+      // separator, equal sign and reserve for timestamp
+      if (unsigned(end_ - p_) < key_len + value_len + 2 + 20)
+        return;
+      *p_++ = first_ ? ' ' : ',';
+      first_ = false;
+      memcpy_P(p_, key, key_len);
+      p_ += key_len;
+      *p_++ = '=';
+      memcpy(p_, value, value_len);
+      p_ += value_len;
+    }
+
+    char* begin_;       ///< Start of the buffer.
+    char* p_;           ///< Current write position.
+    char* end_;         ///< End of usable buffer (space for NUL).
+    bool first_ = true; ///< Set if no field was written yet.
+  };
+
+  /// Add temperature field, if the sensor is working.
+  void addTemperature(LineWriter& line, const __FlashStringHelper* key, CentiCelsius t)
+  {
+    if (t.isValid())
+      line.add(key, FixedPoint(t.toCenti(), 2));
+  }
+}
+
+InfluxExporter::InfluxExporter(const TempSensors& temp, FanControl& fan, const AdditionalSensors& add_sensors,
+                               const Antifreeze& antifreeze, const NetworkClient& net,
+                               const KWLPersistentConfig& config, const MicroNTP& ntp) :
+  temp_(temp),
+  fan_(fan),
+  add_sensors_(add_sensors),
+  antifreeze_(antifreeze),
+  net_(net),
+  config_(config),
+  ntp_(ntp),
+  stats_(F("InfluxExporter")),
+  timer_task_(stats_, &InfluxExporter::run, *this)
+{}
+
+void InfluxExporter::begin()
+{
+  if (!KWLConfig::InfluxPeriod)
+    return;
+  if (!udp_.begin(LOCAL_PORT)) {
+    LOG(KWLConfig::LogLevelNetwork, ERROR).println(F("ERROR: Cannot start InfluxDB exporter, out of sockets"));
+    return;
+  }
+  timer_task_.runRepeated(KWLConfig::InfluxPeriod * 1000000UL);
+}
+
+unsigned InfluxExporter::format(char* buffer, unsigned size)
+{
+  LineWriter line(buffer, size);
+  line.addRaw(F("kwl,prefix="));
+  line.addTagValue(config_.getMQTTPrefix());
+  addTemperature(line, F("t1"), temp_.get_t1_outside());
+  addTemperature(line, F("t2"), temp_.get_t2_inlet());
+  addTemperature(line, F("t3"), temp_.get_t3_outlet());
+  addTemperature(line, F("t4"), temp_.get_t4_exhaust());
+  line.add(F("eff"), long(temp_.getEfficiency()));
+  line.add(F("fan1"), long(fan_.getFan1().getSpeed()));
+  line.add(F("fan2"), long(fan_.getFan2().getSpeed()));
+  line.add(F("mode"), long(fan_.getVentilationMode()));
+  line.add(F("antifreeze"), long(antifreeze_.getState()));
+  line.add(F("preheater"), FixedPoint(lround(antifreeze_.getPreheaterState() * 10), 1));
+  if (add_sensors_.hasDHT1()) {
+    line.add(F("dht1t"), FixedPoint(lround(add_sensors_.getDHT1Temp() * 10), 1));
+    line.add(F("dht1h"), FixedPoint(lround(add_sensors_.getDHT1Hum() * 10), 1));
+  }
+  if (add_sensors_.hasDHT2()) {
+    line.add(F("dht2t"), FixedPoint(lround(add_sensors_.getDHT2Temp() * 10), 1));
+    line.add(F("dht2h"), FixedPoint(lround(add_sensors_.getDHT2Hum() * 10), 1));
+  }
+  if (add_sensors_.hasCO2())
+    line.add(F("co2"), long(add_sensors_.getCO2()));
+  if (add_sensors_.hasVOC())
+    line.add(F("voc"), long(add_sensors_.getVOC()));
+  return line.finish(ntp_.currentTime());
+}
+
+void InfluxExporter::run()
+{
+  if (!net_.isLANOk())
+    return;
+  char buffer[INFLUX_BUFFER_SIZE];
+  auto len = format(buffer, sizeof(buffer));
+  static constexpr auto server = KWLConfig::InfluxServer;
+  IPAddress ip = server[0] ? IPAddress(server) : IPAddress(config_.getNetworkMQTTBroker());
+  if (!udp_.beginPacket(ip, KWLConfig::InfluxPort) ||
+      udp_.write(reinterpret_cast<const uint8_t*>(buffer), len) != len ||
+      !udp_.endPacket()) {
+    ++failed_;
+    LOG(KWLConfig::LogLevelNetwork, TRACE).println(F("InfluxDB: cannot send datagram"));
+  }
+}
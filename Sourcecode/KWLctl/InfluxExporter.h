@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2018 Sven Just (sven@familie-just.de)
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Exporter of measurements to InfluxDB via UDP.
+ */
+#pragma once
+
+#include "TimeScheduler.h"
+
+#include <EthernetUdp.h>
+
+class TempSensors;
+class FanControl;
+class AdditionalSensors;
+class Antifreeze;
+class NetworkClient;
+class KWLPersistentConfig;
+class MicroNTP;
+
+/*!
+ * @brief Exporter of measurements to InfluxDB via UDP.
+ *
+ * If enabled by KWLConfig::InfluxPeriod, all measurements are formatted
+ * in InfluxDB line protocol into a fixed buffer and sent as one UDP
+ * datagram per period directly to InfluxDB UDP listener. This bypasses
+ * MQTT broker and translation of individual topics.
+ *
+ * The datagram contains one line for measurement "kwl", tagged with
+ * the MQTT prefix of this controller, e.g.:
+ *
+ *     kwl,prefix=d15 t1=5.25,t2=19.50,fan1=1200i,fan2=1180i,mode=2i 1539950400000000000
+ *
+ * The timestamp is only sent if NTP time is known, otherwise InfluxDB
+ * uses the time of reception.
+ */
+class InfluxExporter
+{
+public:
+  InfluxExporter(const InfluxExporter&) = delete;
+  InfluxExporter& operator=(const InfluxExporter&) = delete;
+
+  /*!
+   * @brief Construct exporter.
+   *
+   * @param temp temperature sensors.
+   * @param fan fan control.
+   * @param add_sensors additional sensors.
+   * @param antifreeze antifreeze control.
+   * @param net network client to check LAN connection.
+   * @param config configuration with MQTT prefix.
+   * @param ntp NTP client to timestamp measurements.
+   */
+  InfluxExporter(const TempSensors& temp, FanControl& fan, const AdditionalSensors& add_sensors,
+                 const Antifreeze& antifreeze, const NetworkClient& net,
+                 const KWLPersistentConfig& config, const MicroNTP& ntp);
+
+  /// Start exporting, if enabled.
+  void begin();
+
+  /*!
+   * @brief Format current measurements in line protocol.
+   *
+   * @param buffer,size buffer where to materialize the line (NUL-terminated).
+   * @return length of the line.
+   */
+  unsigned format(char* buffer, unsigned size);
+
+  /// Get count of datagrams which could not be sent.
+  unsigned getFailedSends() const { return failed_; }
+
+private:
+  /// Send current measurements.
+  void run();
+
+  /// Temperature sensors.
+  const TempSensors& temp_;
+  /// Fan control.
+  FanControl& fan_;
+  /// Additional sensors.
+  const AdditionalSensors& add_sensors_;
+  /// Antifreeze control.
+  const Antifreeze& antifreeze_;
+  /// Network client.
+  const NetworkClient& net_;
+  /// Configuration.
+  const KWLPersistentConfig& config_;
+  /// NTP client.
+  const MicroNTP& ntp_;
+  /// UDP socket for sending.
+  EthernetUDP udp_;
+  /// Count of datagrams which could not be sent.
+  unsigned failed_ = 0;
+  /// Task timing statistics.
+  Scheduler::TaskTimingStats stats_;
+  /// Timer task sending measurements.
+  Scheduler::TimedTask<InfluxExporter> timer_task_;
+};
@@ -32,7 +32,7 @@ IPAddressLiteral::operator IPAddress() const noexcept
 
 #define KWL_COPY(name) name##_ = KWLConfig::Standard##name
 
-static_assert(sizeof(KWLPersistentConfig) == 298, "Persistent config size changed, ensure compatibility or increment version");
+static_assert(sizeof(KWLPersistentConfig) == 378, "Persistent config size changed, ensure compatibility or increment version");
 static constexpr auto PrefixMQTT = KWLConfig::PrefixMQTT;
 
 void KWLPersistentConfig::loadDefaults()
@@ -54,7 +54,7 @@ void KWLPersistentConfig::loadDefaults()
   KWL_COPY(TimezoneMin);
 
   if (KWLConfig::StandardModeCnt > 10) {
-    Serial.println(F("ERROR: StandardModeCnt too big, max. 10 supported"));
+    LOG(KWLConfig::LogLevelGeneral, ERROR).println(F("ERROR: StandardModeCnt too big, max. 10 supported"));
   }
   for (unsigned i = 0; ((i < KWLConfig::StandardModeCnt) && (i < 10)); i++) {
     FanPWMSetpoint_[i][0] = int(KWLConfig::StandardSpeedSetpointFan1 * KWLConfig::StandardKwlModeFactor[i] * 1000 / KWLConfig::StandardNenndrehzahlFan);
@@ -67,6 +67,7 @@ void KWLPersistentConfig::loadDefaults()
   strcpy(mqtt_prefix_, PrefixMQTT.load());
 
   loadNetworkDefaults();
+  loadPublishPolicyDefaults();
   touch_.reset();
 }
 
@@ -89,43 +90,61 @@ void KWLPersistentConfig::loadNetworkDefaults()
   mac_ = mac;
 }
 
+void KWLPersistentConfig::loadPublishPolicyDefaults()
+{
+  // indexed by PublishGroup
+  static const PublishPolicy defaults[] PROGMEM = {
+    { uint16_t(KWLConfig::MinDiffMqttTemp * 100 + 0.5), KWLConfig::MinIntervalMqttTemp, KWLConfig::MaxIntervalMqttTemp },
+    { KWLConfig::MinDiffMqttFan, KWLConfig::MinIntervalMqttFan, KWLConfig::MaxIntervalMqttFan },
+    { KWLConfig::MinDiffMqttDHT, KWLConfig::MinIntervalMqttDHT, KWLConfig::MaxIntervalMqttDHT },
+    { KWLConfig::MinDiffMqttCO2, KWLConfig::MinIntervalMqttCO2, KWLConfig::MaxIntervalMqttCO2 },
+    { KWLConfig::MinDiffMqttVOC, KWLConfig::MinIntervalMqttVOC, KWLConfig::MaxIntervalMqttVOC },
+    { 0, 0, KWLConfig::MaxIntervalMqttBypass }
+  };
+  static_assert(sizeof(defaults) == sizeof(publish_policy_), "Publish policy defaults don't match groups");
+  memcpy_P(publish_policy_, defaults, sizeof(publish_policy_));
+}
+
 void KWLPersistentConfig::migrate()
 {
   // "upgrade" existing config, if possible (all initialized to -1/0xff)
   if (TimezoneMin_ == -1) {
-    Serial.println(F("Config migration: setting timezone"));
+    LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Config migration: setting timezone"));
     TimezoneMin_ = KWLConfig::StandardTimezoneMin;
     update(TimezoneMin_);
   }
   if (*reinterpret_cast<const uint8_t*>(&DST_) == 0xff) {
-    Serial.println(F("Config migration: setting DST"));
+    LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Config migration: setting DST"));
     DST_ = KWLConfig::StandardDST;
     update(DST_);
   }
   if (BypassHysteresisTemp_ == 0xff) {
-    Serial.println(F("Config migration: setting bypass hysteresis temperature"));
+    LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Config migration: setting bypass hysteresis temperature"));
     BypassHysteresisTemp_ = KWLConfig::StandardBypassHysteresisTemp;
     update(BypassHysteresisTemp_);
   }
   if (programs_[0].start_h_ == 0xff) {
-    Serial.println(F("Config migration: clearing programs"));
+    LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Config migration: clearing programs"));
     memset(programs_, 0, sizeof(programs_));
     update(programs_);
   }
   if (crashes_[0].real_time == 0xffffffffUL) {
-    Serial.println(F("Config migration: clearing crash reports"));
+    LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Config migration: clearing crash reports"));
     memset(crashes_, 0, sizeof(crashes_));
     update(crashes_);
   }
   if (mqtt_prefix_[0] < 33 || mqtt_prefix_[0] > 126) {
-    Serial.print(F("Config migration: setting MQTT prefix: "));
     static_assert(KWLConfig::PrefixMQTT.length() < sizeof(mqtt_prefix_), "Too long MQTT prefix");
     strcpy(mqtt_prefix_, PrefixMQTT.load());
     update(mqtt_prefix_);
-    Serial.println(mqtt_prefix_);
+    if (LOG_ENABLED(KWLConfig::LogLevelGeneral, INFO)) {
+      LogLine log(LogLevel::INFO);
+      log.print(F("Config migration: setting MQTT prefix: "));
+      log.println(mqtt_prefix_);
+    }
   }
   if (ip_[0] == 0xff || ip_[0] == 0) {
-    Serial.println(F("Config migration: setting IP addresses and port"));
+    LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Config migration: setting IP addresses and port"));
     loadNetworkDefaults();
     update(ip_);
     update(netmask_);
@@ -138,7 +157,7 @@ void KWLPersistentConfig::migrate()
   }
   if ((touch_.left_ == 0 || touch_.left_ == 0xffff) &&
       (touch_.right_ == 0 || touch_.right_ == 0xffff)) {
-    Serial.println(F("Config migration: clearing touchscreen calibration"));
+    LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Config migration: clearing touchscreen calibration"));
     touch_.reset();
     update(touch_);
   }
@@ -148,6 +167,16 @@ void KWLPersistentConfig::migrate()
     update(Fan1ImpulsesPerRotation_);
     update(Fan2ImpulsesPerRotation_);
   }
+  if (publish_policy_[0].max_interval == 0xffff) {
+    LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Config migration: setting publish policy"));
+    loadPublishPolicyDefaults();
+    update(publish_policy_);
+  }
+  if (temp_sensor_rom_[0][0] == 0xff) {
+    LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Config migration: clearing temperature sensor ROMs"));
+    memset(temp_sensor_rom_, 0, sizeof(temp_sensor_rom_));
+    update(temp_sensor_rom_);
+  }
 }
 
 bool KWLPersistentConfig::hasCrash() const
@@ -158,7 +187,7 @@ bool KWLPersistentConfig::hasCrash() const
   return false;
 }
 
-void KWLPersistentConfig::storeCrash(uint32_t pc, unsigned sp, uint32_t real_time)
+void KWLPersistentConfig::storeCrash(uint32_t pc, unsigned sp, uint32_t real_time, uint8_t task, unsigned free_stack)
 {
   auto runtime = millis();
   unsigned oldest_crash = 0;
@@ -183,12 +212,20 @@ void KWLPersistentConfig::storeCrash(uint32_t pc, unsigned sp, uint32_t real_tim
   c.real_time = real_time;
   c.millis = runtime;
   update(c);
+  crash_task_[oldest_crash] = task;
+  update(crash_task_[oldest_crash]);
+  crash_free_stack_[oldest_crash] = uint16_t(free_stack);
+  update(crash_free_stack_[oldest_crash]);
 }
 
 void KWLPersistentConfig::resetCrashes()
 {
   memset(crashes_, 0, sizeof(crashes_));
   update(crashes_);
+  memset(crash_task_, 0, sizeof(crash_task_));
+  update(crash_task_);
+  memset(crash_free_stack_, 0, sizeof(crash_free_stack_));
+  update(crash_free_stack_);
 }
 
 bool KWLPersistentConfig::setMQTTPrefix(const char* prefix)
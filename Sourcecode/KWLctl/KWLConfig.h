@@ -50,10 +50,13 @@
 
 #pragma once
 
+#include "CentiCelsius.h"
 #include "ProgramData.h"
+#include "PublishPolicy.h"
 
 #include <FlashStringLiteral.h>
 #include <PersistentConfiguration.h>
+#include <Logger.h>
 #include <Arduino.h>
 
 class IPAddress;
@@ -302,12 +305,20 @@ public:
   /// Zusätzliche Ansteuerung durch DAC über SDA und SLC (und PWM)
   static constexpr bool ControlFansDAC = true;
 
+  // Die DHT Sensoren werden nur ohne Blockieren ausgelesen, wenn der Pin einen Pin Change Interrupt hat.
+  // Empfohlen ist daher der Anschluss an A8-A14. Die Standardpins 28 und 29 der Platine haben keinen,
+  // dort wird die Antwort (~5ms pro Messung) mit aktiven Interrupts abgefragt.
   /// Pin vom 1. DHT Sensor.
   static constexpr uint8_t PinDHTSensor1       = 28;
   /// Pin vom 2. DHT Sensor.
   static constexpr uint8_t PinDHTSensor2       = 29;
+  /// 1. DHT Sensor abfragen (wird beim Start erkannt, falls angeschlossen).
+  static constexpr bool UseDHTSensor1          = true;
+  /// 2. DHT Sensor abfragen (wird beim Start erkannt, falls angeschlossen).
+  static constexpr bool UseDHTSensor2          = true;
 
   // Für jeder Temperatursensor gibt es einen Anschluss auf dem Board, Vorteil: Temperatursensoren können per Kabel definiert werden, nicht Software
+  // Die Sensoren werden im Hintergrund per Timer 3 ausgelesen, PWM an Pins 2, 3 und 5 ist daher nicht möglich.
   /// Input Sensor Aussenlufttemperatur.
   static constexpr uint8_t PinTemp1OneWireBus  = 30;
   /// Input Sensor Zulufttemperatur.
@@ -322,6 +333,10 @@ public:
   /// CO2 Sensor (Winsen MH-Z14) wird über die Zweite Serielle Schnittstelle (Serial2) angeschlossen.
   // Serial2 nutzt beim Arduino Mega Pin 16 u 17
   static constexpr HardwareSerial& SerialMHZ14 = Serial2;
+  /// VOC Sensor abfragen (wird beim Start erkannt, falls angeschlossen).
+  static constexpr bool UseVOCSensor           = true;
+  /// CO2 Sensor abfragen (wird beim Start erkannt, falls angeschlossen).
+  static constexpr bool UseCO2Sensor           = true;
 
   // ******************************************* E N D E   A N S C H L U S S E I N S T E L L U N G E N **************************************************
 
@@ -346,6 +361,26 @@ public:
   /// Send timestamp as heartbeat.
   static constexpr bool HeartbeatTimestamp = false;
 
+  /// Period for sending all measurements as one JSON snapshot message, in seconds. Set to 0 to not send snapshots.
+  static constexpr uint16_t SnapshotPeriod = 0;
+
+  /// Interval for recording temperatures and fan speeds while MQTT is offline, in seconds.
+  static constexpr uint16_t HistoryInterval = 60;
+  /// Number of samples kept while MQTT is offline (8B RAM each). Set to 0 to not record history.
+  static constexpr uint8_t HistorySize = 32;
+
+  /// Period for sending all measurements to InfluxDB via UDP line protocol, in seconds. Set to 0 to not send.
+  static constexpr uint16_t InfluxPeriod = 0;
+  /// IP address of InfluxDB server with enabled UDP listener. Set to 0.0.0.0 to use the configured MQTT broker.
+  static constexpr IPAddressLiteral InfluxServer = {0, 0, 0, 0};
+  /// UDP port of InfluxDB server.
+  static constexpr uint16_t InfluxPort = 8089;
+
+  /// IP address of syslog server to mirror log messages to. Set to 0.0.0.0 to not send.
+  static constexpr IPAddressLiteral SyslogServer = {0, 0, 0, 0};
+  /// UDP port of syslog server.
+  static constexpr uint16_t SyslogPort = 514;
+
   /// At most how often to send temperature messages via MQTT, in seconds.
   static constexpr uint8_t MinIntervalMqttTemp = 5;
   /// At least how often to send temperature messages via MQTT, in seconds.
@@ -353,6 +388,48 @@ public:
   /// Minimum change in temperature to report per MQTT.
   static constexpr double MinDiffMqttTemp = 0.1;
 
+  /*
+   * NOTE: The following publishing intervals and minimum changes are only
+   * defaults for the EEPROM. They can be changed at runtime via MQTT, see
+   * publish policy in Docs/Status.md.
+   */
+
+  /// At most how often to send fan speed messages via MQTT, in seconds.
+  static constexpr uint16_t MinIntervalMqttFan = 5;
+  /// At least how often to send fan speed messages via MQTT, in seconds.
+  static constexpr uint16_t MaxIntervalMqttFan = 120;
+  /// Minimum change in fan speed to report per MQTT, in rpm.
+  static constexpr uint16_t MinDiffMqttFan = 50;
+  /// At most how often to send DHT messages via MQTT, in seconds.
+  static constexpr uint16_t MinIntervalMqttDHT = 5;
+  /// At least how often to send DHT messages via MQTT, in seconds.
+  static constexpr uint16_t MaxIntervalMqttDHT = 300;
+  /// Minimum change of DHT values to report per MQTT, in 0.1C for temperature and in % for humidity.
+  static constexpr uint16_t MinDiffMqttDHT = 1;
+  /// At most how often to send CO2 messages via MQTT, in seconds.
+  static constexpr uint16_t MinIntervalMqttCO2 = 60;
+  /// At least how often to send CO2 messages via MQTT, in seconds.
+  static constexpr uint16_t MaxIntervalMqttCO2 = 300;
+  /// Minimum change of CO2 value to report per MQTT, in ppm.
+  static constexpr uint16_t MinDiffMqttCO2 = 20;
+  /// At most how often to send VOC messages via MQTT, in seconds.
+  static constexpr uint16_t MinIntervalMqttVOC = 5;
+  /// At least how often to send VOC messages via MQTT, in seconds.
+  static constexpr uint16_t MaxIntervalMqttVOC = 30;
+  /// Minimum change of VOC value to report per MQTT.
+  static constexpr uint16_t MinDiffMqttVOC = 20;
+  /// At least how often to send bypass state via MQTT, in seconds (changes are sent immediately).
+  static constexpr uint16_t MaxIntervalMqttBypass = 900;
+
+  /// Maximum sustained rate of MQTT messages per second (0 for unlimited).
+  static constexpr uint8_t MQTTRateMessages = 20;
+  /// Maximum sustained rate of MQTT bytes per second (0 for unlimited).
+  static constexpr uint16_t MQTTRateBytes = 2048;
+  /// Maximum number of MQTT messages sent in one burst.
+  static constexpr uint8_t MQTTBurstMessages = 8;
+  /// Maximum number of MQTT bytes sent in one burst (keep below 2kB TX buffer of the Ethernet chip).
+  static constexpr uint16_t MQTTBurstBytes = 1024;
+
   /// Default for retain last measurements reading in the MQTT broker.
   static constexpr bool RetainMeasurements = true;
 
@@ -383,26 +460,36 @@ public:
   /// Retain last status bits readings in the MQTT broker.
   static const bool RetainStatusBits;
 
+  /// Retain publish policy configuration in the MQTT broker.
+  static const bool RetainPublishPolicy;
+
   /// If set, also erroneous measurements (like -127C for temperature) will be sent.
   static constexpr bool SendErroneousMeasurement = false;
 
   // ************************************** E N D E   M Q T T   R E P O R T I N G ***********************************************************************
 
   // ***************************************************  D E B U G E I N S T E L L U N G E N ********************************************************
-  // Allgemeine Debugausgaben auf der seriellen Schnittstelle aktiviert.
-  static constexpr bool serialDebug = false;
-  // Debugausgaben für die Lüfter auf der seriellen Schnittstelle aktiviert.
-  static constexpr bool serialDebugFan = false;
-  // Debugausgaben für die Antifreezeschaltung auf der seriellen Schnittstelle aktiviert.
-  static constexpr bool serialDebugAntifreeze = false;
-  // Debugausgaben für die Summerbypassschaltung auf der seriellen Schnittstelle aktiviert.
-  static constexpr bool serialDebugSummerbypass = false;
-  // Debugausgaben für die Displayanzeige.
-  static constexpr bool serialDebugDisplay = false;
-  // Debugausgaben für die Sensoren.
-  static constexpr bool serialDebugSensor = false;
-  // Debugausgaben für das Programm.
-  static constexpr bool serialDebugProgram = false;
+  // Log-Level je Modul (LogLevel::OFF, ERROR, WARNING, INFO oder TRACE). Meldungen oberhalb
+  // des Levels werden samt Texten nicht einkompiliert, das spart Flash und Laufzeit.
+  // Allgemeine Meldungen (Steuerung, Konfiguration).
+  static constexpr LogLevel LogLevelGeneral = LogLevel::INFO;
+  // Meldungen des Netzwerks und MQTT.
+  static constexpr LogLevel LogLevelNetwork = LogLevel::INFO;
+  // Meldungen der Lüftersteuerung.
+  static constexpr LogLevel LogLevelFan = LogLevel::INFO;
+  // Meldungen der Antifreezeschaltung.
+  static constexpr LogLevel LogLevelAntifreeze = LogLevel::INFO;
+  // Meldungen der Summerbypassschaltung.
+  static constexpr LogLevel LogLevelSummerbypass = LogLevel::INFO;
+  // Meldungen der Displayanzeige.
+  static constexpr LogLevel LogLevelDisplay = LogLevel::INFO;
+  // Meldungen der Sensoren.
+  static constexpr LogLevel LogLevelSensor = LogLevel::INFO;
+  // Meldungen des Programms.
+  static constexpr LogLevel LogLevelProgram = LogLevel::INFO;
+  /// Laufzeitbudget einer Task in ms, bei Überschreitung wird ein Overrun-Report gesendet (0 = aus).
+  /// Tasks mit regulär langen Laufzeiten (Lüfterkalibrierung, EEPROM-Schreibzugriffe) haben ein eigenes Budget.
+  static constexpr uint16_t TaskRuntimeBudgetMs = 500;
   // *******************************************E N D E ***  D E B U G E I N S T E L L U N G E N *****************************************************
 };
 
@@ -424,6 +511,10 @@ constexpr IPAddressLiteral KWLDefaultConfig<FinalConfig>::NetworkNTPServer;
 template<typename FinalConfig>
 constexpr IPAddressLiteral KWLDefaultConfig<FinalConfig>::NetworkMQTTBroker;
 template<typename FinalConfig>
+constexpr IPAddressLiteral KWLDefaultConfig<FinalConfig>::InfluxServer;
+template<typename FinalConfig>
+constexpr IPAddressLiteral KWLDefaultConfig<FinalConfig>::SyslogServer;
+template<typename FinalConfig>
 const bool KWLDefaultConfig<FinalConfig>::RetainTemperature = FinalConfig::RetainMeasurements;
 template<typename FinalConfig>
 const bool KWLDefaultConfig<FinalConfig>::RetainAdditionalSensors = FinalConfig::RetainMeasurements;
@@ -441,6 +532,8 @@ template<typename FinalConfig>
 const bool KWLDefaultConfig<FinalConfig>::RetainProgram = FinalConfig::RetainMeasurements;
 template<typename FinalConfig>
 const bool KWLDefaultConfig<FinalConfig>::RetainStatusBits = FinalConfig::RetainMeasurements;
+template<typename FinalConfig>
+const bool KWLDefaultConfig<FinalConfig>::RetainPublishPolicy = FinalConfig::RetainMeasurements;
 
 /// Helper template to convert user-defined configuration objects.
 template<typename T> struct UserConfig {
@@ -503,6 +596,11 @@ constexpr double KWLDefaultConfig<FinalConfig>::StandardKwlModeFactor[MAX_FAN_MO
   type get##name() const { return type(var); } \
   void set##name(type value) { var = decltype(var)(value); update(var); }
 
+// Helper for getters and setters of temperatures stored in whole degrees.
+#define KWL_GETSET_TEMP(name) \
+  CentiCelsius get##name() const { return CentiCelsius::fromDegrees(int(name##_)); } \
+  void set##name(CentiCelsius value) { name##_ = decltype(name##_)(value.toDegrees()); update(name##_); }
+
 /// Structure used to store crash data in EEPROM.
 struct CrashData
 {
@@ -580,7 +678,18 @@ private:
   // Fan RPM adjustment configuration
   float Fan1ImpulsesPerRotation_;              // 290
   float Fan2ImpulsesPerRotation_;              // 294
-  // 298
+
+  // Crash task attribution (trace ID of the running task for each crash slot)
+  uint8_t crash_task_[KWLConfig::MaxCrashReportCount];  // 298..302
+  // Minimum free stack in bytes for each crash slot
+  uint16_t crash_free_stack_[KWLConfig::MaxCrashReportCount];  // 302..310
+
+  // Publish policy for each group of published values
+  PublishPolicy publish_policy_[unsigned(PublishGroup::COUNT)];  // 310..346
+
+  // Cached ROM of temperature sensors T1-T4 (all zeroes if unknown)
+  uint8_t temp_sensor_rom_[4][8];     // 346..378
+  // 378
 
   /// Initialize with defaults, if version doesn't fit.
   void loadDefaults();
@@ -588,6 +697,9 @@ private:
   /// Initialize network default values.
   void loadNetworkDefaults();
 
+  /// Initialize publish policy default values.
+  void loadPublishPolicyDefaults();
+
   /// Migrate configuration.
   void migrate();
 
@@ -597,13 +709,13 @@ public:
   KWL_GETSET(SpeedSetpointFan2)
   KWL_GETSET(Fan1ImpulsesPerRotation)
   KWL_GETSET(Fan2ImpulsesPerRotation)
-  KWL_GETSET(BypassTempAbluftMin)
-  KWL_GETSET(BypassTempAussenluftMin)
+  KWL_GETSET_TEMP(BypassTempAbluftMin)
+  KWL_GETSET_TEMP(BypassTempAussenluftMin)
   KWL_GETSET(BypassHystereseMinutes)
-  KWL_GETSET(BypassHysteresisTemp)
+  KWL_GETSET_TEMP(BypassHysteresisTemp)
   KWL_GETSET3(BypassManualSetpoint, BypassManualSetpoint_, SummerBypassFlapState)
   KWL_GETSET3(BypassMode, BypassMode_, SummerBypassMode)
-  KWL_GETSET(AntifreezeHystereseTemp)
+  KWL_GETSET_TEMP(AntifreezeHystereseTemp)
   KWL_GETSET(DST)
   KWL_GETSET(HeatingAppCombUse)
   KWL_GETSET(TimezoneMin)
@@ -635,8 +747,14 @@ public:
   /// Get crash data from given slot.
   const CrashData& getCrash(unsigned index) const { return crashes_[index]; }
 
+  /// Get trace ID of the task running at the time of the crash in given slot.
+  uint8_t getCrashTask(unsigned index) const { return crash_task_[index]; }
+
+  /// Get minimum free stack at the time of the crash in given slot.
+  unsigned getCrashFreeStack(unsigned index) const { return crash_free_stack_[index]; }
+
   /// Store a crash report, overwriting oldest slot as necessary.
-  void storeCrash(uint32_t pc, unsigned sp, uint32_t real_time);
+  void storeCrash(uint32_t pc, unsigned sp, uint32_t real_time, uint8_t task, unsigned free_stack);
 
   /// Reset all crash data.
   void resetCrashes();
@@ -653,6 +771,18 @@ public:
   /// Set prefix for all MQTT messages.
   bool setMQTTPrefix(const char* prefix);
 
+  /// Get publish policy for a group of published values.
+  const PublishPolicy& getPublishPolicy(PublishGroup group) const { return publish_policy_[unsigned(group)]; }
+
+  /// Set publish policy for a group of published values.
+  void setPublishPolicy(PublishGroup group, const PublishPolicy& policy) { publish_policy_[unsigned(group)] = policy; update(publish_policy_[unsigned(group)]); }
+
+  /// Get cached ROM of the temperature sensor (0-3), all zeroes if unknown.
+  const uint8_t* getTempSensorROM(unsigned index) const { return temp_sensor_rom_[index]; }
+
+  /// Set cached ROM of the temperature sensor (0-3).
+  void setTempSensorROM(unsigned index, const uint8_t* rom) { memcpy(temp_sensor_rom_[index], rom, sizeof(temp_sensor_rom_[index])); update(temp_sensor_rom_[index]); }
+
   /// Get TFT calibration.
   const TouchCalibration& getTouchCalibration() const { return touch_; }
 
@@ -661,3 +791,4 @@ public:
 };
 
 #undef KWL_GETSET
+#undef KWL_GETSET_TEMP
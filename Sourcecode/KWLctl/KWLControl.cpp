@@ -26,18 +26,159 @@
 #include <EthernetUdp.h>
 #include <Wire.h>
 #include <DeadlockWatchdog.h>
+#include <MemoryMonitor.h>
 #include <avr/wdt.h>
 
+namespace
+{
+  /// Size of buffer for task trace messages (4 entries per message to fit into MQTT packet).
+  static constexpr unsigned TRACE_BUFFER_SIZE = 4 * 2 * Scheduler::TaskTrace::ENTRY_SIZE + 1;
+  /// Size of buffer for task trace topics (prefix and up to 3 digits).
+  static constexpr unsigned TRACE_TOPIC_SIZE = MQTTTopic::KwlDebugstateSchedulerTraceData.length() + 4;
+
+  /// Materialize task trace topic with given prefix and index.
+  template<unsigned len>
+  void makeTraceTopic(char* buffer, const FlashStringLiteral<len>& prefix, uint8_t index)
+  {
+    prefix.store(buffer);
+    utoa(index, buffer + prefix.length(), 10);
+  }
+
+  /// Materialize task trace name in form "<kind> <name>".
+  void makeTraceName(char* buffer, size_t size, const __FlashStringHelper* kind, const __FlashStringHelper* name)
+  {
+    strlcpy_P(buffer, reinterpret_cast<const char*>(kind), size);
+    strlcat_P(buffer, reinterpret_cast<const char*>(name), size);
+  }
+
+  /// Get name of the task with the given trace ID.
+  const __FlashStringHelper* getTaskName(uint8_t id)
+  {
+    if (id == Scheduler::TaskTrace::UNACCOUNTED_ID)
+      return F("unaccounted");
+    if (id == Scheduler::TaskTrace::NO_TASK_ID)
+      return F("none");
+    for (auto i = Scheduler::TaskTimingStats::begin(); i != Scheduler::TaskTimingStats::end(); ++i)
+      if (i->getTraceId() == id)
+        return i->getName();
+    for (auto i = Scheduler::TaskPollingStats::begin(); i != Scheduler::TaskPollingStats::end(); ++i)
+      if (i->getTraceId() == id)
+        return i->getName();
+    return F("?");
+  }
+
+  /*!
+   * @brief Simple writer of a flat JSON object to an output.
+   *
+   * The object is opened upon construction and must be closed by finish().
+   */
+  class JSONWriter
+  {
+  public:
+    explicit JSONWriter(Print& out) : out_(out) { out_.write('{'); }
+
+    /// Add integer member.
+    void add(const __FlashStringHelper* key, long value)
+    {
+      addKey(key);
+      out_.print(value);
+    }
+
+    /// Add fixed-point member.
+    void add(const __FlashStringHelper* key, FixedPoint value)
+    {
+      char tmp[FixedPoint::MAX_STRING_SIZE];
+      value.toString(tmp);
+      addKey(key);
+      out_.print(tmp);
+    }
+
+    /// Add string member.
+    void add(const __FlashStringHelper* key, const __FlashStringHelper* value)
+    {
+      addKey(key);
+      out_.write('"');
+      out_.print(value);
+      out_.write('"');
+    }
+
+    /// Finish the object.
+    void finish() { out_.write('}'); }
+
+  private:
+    /// Write separator, if needed, and quoted key with colon.
+    void addKey(const __FlashStringHelper* key)
+    {
+      if (!first_)
+        out_.write(',');
+      first_ = false;
+      out_.write('"');
+      out_.print(key);
+      out_.write('"');
+      out_.write(':');
+    }
+
+    Print& out_;        ///< Output to write to.
+    bool first_ = true; ///< Set if no member was written yet.
+  };
+
+  /// Add temperature in hundredths of a degree, if valid.
+  void addTemperature(JSONWriter& json, const __FlashStringHelper* key, CentiCelsius t)
+  {
+    if (t.isValid() || KWLConfig::SendErroneousMeasurement)
+      json.add(key, FixedPoint(t.toCenti(), 2));
+  }
+
+  /// Print task trace to serial port in the same format as sent via MQTT.
+  void printTrace()
+  {
+    char buffer[TRACE_BUFFER_SIZE];
+    char tbuffer[TRACE_TOPIC_SIZE];
+    for (auto i = Scheduler::TaskPollingStats::begin(); i != Scheduler::TaskPollingStats::end(); ++i) {
+      makeTraceTopic(tbuffer, MQTTTopic::KwlDebugstateSchedulerTraceName, i->getTraceId());
+      makeTraceName(buffer, sizeof(buffer), F("poll "), i->getName());
+      Serial.print(tbuffer);
+      Serial.print(' ');
+      Serial.println(buffer);
+    }
+    for (auto i = Scheduler::TaskTimingStats::begin(); i != Scheduler::TaskTimingStats::end(); ++i) {
+      makeTraceTopic(tbuffer, MQTTTopic::KwlDebugstateSchedulerTraceName, i->getTraceId());
+      makeTraceName(buffer, sizeof(buffer), F("timed "), i->getName());
+      Serial.print(tbuffer);
+      Serial.print(' ');
+      Serial.println(buffer);
+    }
+    uint8_t index = 0;
+    while (index < Scheduler::TaskTrace::size()) {
+      makeTraceTopic(tbuffer, MQTTTopic::KwlDebugstateSchedulerTraceData, index);
+      index += Scheduler::TaskTrace::toHex(index, buffer, sizeof(buffer));
+      Serial.print(tbuffer);
+      Serial.print(' ');
+      Serial.println(buffer);
+    }
+  }
+}
+
 KWLControl::KWLControl() :
   MessageHandler(F("KWLControl")),
   ntp_(udp_),
   network_client_(persistent_config_, ntp_),
+  temp_sensors_(persistent_config_),
+  add_sensors_(persistent_config_),
   fan_control_(persistent_config_, this),
   bypass_(persistent_config_, temp_sensors_),
   antifreeze_(fan_control_, temp_sensors_, persistent_config_),
   program_manager_(persistent_config_, fan_control_, ntp_),
+  history_(temp_sensors_, fan_control_, network_client_, ntp_),
+  influx_(temp_sensors_, fan_control_, add_sensors_, antifreeze_, network_client_, persistent_config_, ntp_),
   control_stats_(F("KWLControl")),
-  control_timer_(control_stats_, &KWLControl::run, *this)
+  control_timer_(control_stats_, &KWLControl::run, *this),
+  memory_stats_(F("MemoryMonitor")),
+  memory_timer_(memory_stats_, &KWLControl::checkMemory, *this),
+  snapshot_stats_(F("Snapshot")),
+  snapshot_timer_(snapshot_stats_, &KWLControl::mqttSendSnapshot, *this),
+  log_stats_(F("Logger")),
+  log_task_(log_stats_, &Logger::loop)
 {}
 
 void KWLControl::begin(Print& initTracer)
@@ -48,6 +189,11 @@ void KWLControl::begin(Print& initTracer)
     initTracer.println(F("Initialisierung DAC"));
   }
 
+  Logger::begin(&Serial, LogLevel::TRACE);
+  if (LOG_ENABLED(KWLConfig::LogLevelGeneral, TRACE)) {
+    // raw EEPROM dump takes ~0.6s and doesn't fit into the log ring, so print it only when tracing
+    PersistentConfigurationBase::dumpRaw(Serial);
+  }
   persistent_config_.begin(initTracer, KWLConfig::FACTORY_RESET_EEPROM);
   network_client_.begin(initTracer);
   temp_sensors_.begin(initTracer);
@@ -56,26 +202,43 @@ void KWLControl::begin(Print& initTracer)
   antifreeze_.begin(initTracer);
   add_sensors_.begin(initTracer);
   ntp_.begin(persistent_config_.getNetworkNTPServer());
+  static constexpr auto syslog_server = KWLConfig::SyslogServer;
+  if (syslog_server[0]) {
+    // share UDP socket with NTP, syslog only sends
+    Logger::setSyslog(&udp_, IPAddress(syslog_server), KWLConfig::SyslogPort, persistent_config_.getMQTTPrefix());
+  }
   program_manager_.begin();
+  history_.begin();
+  influx_.begin();
 
   // run error check loop every second, but give some time to initialize first
   control_timer_.runRepeated(8000000, 1000000);
+  // check memory usage every 10 seconds
+  memory_timer_.runRepeated(10000000);
+  // send measurement snapshot periodically, if configured
+  if (KWLConfig::SnapshotPeriod)
+    snapshot_timer_.runRepeated(10000000, KWLConfig::SnapshotPeriod * 1000000UL);
 
   if (persistent_config_.hasCrash()) {
     initTracer.println(F("*** NOTE *** Crash reports recorded in EEPROM"));
     for (uint8_t i = 0; i < KWLConfig::MaxCrashReportCount; ++i) {
       auto& c = persistent_config_.getCrash(i);
-      if (c.crash_addr) {
-        Serial.print(F(" - PC "));
-        Serial.print(c.crash_addr, HEX);
-        Serial.print('/');
-        Serial.print(c.crash_addr * 2, HEX);
-        Serial.print(F(", sp "));
-        Serial.print(c.crash_sp, HEX);
-        Serial.print(F(", timestamp "));
-        Serial.print(c.real_time);
-        Serial.print(F(", millis "));
-        Serial.println(c.millis);
+      if (c.crash_addr && LOG_ENABLED(KWLConfig::LogLevelGeneral, WARNING)) {
+        LogLine log(LogLevel::WARNING);
+        log.print(F(" - PC "));
+        log.print(c.crash_addr, HEX);
+        log.print('/');
+        log.print(c.crash_addr * 2, HEX);
+        log.print(F(", sp "));
+        log.print(c.crash_sp, HEX);
+        log.print(F(", timestamp "));
+        log.print(c.real_time);
+        log.print(F(", millis "));
+        log.print(c.millis);
+        log.print(F(", task "));
+        log.print(getTaskName(persistent_config_.getCrashTask(i)));
+        log.print(F(", min. free stack "));
+        log.println(persistent_config_.getCrashFreeStack(i));
       }
     }
     errors_ = ERROR_BIT_CRASH;
@@ -90,6 +253,7 @@ void KWLControl::begin(Print& initTracer)
 
   tft_.begin(initTracer, *this);
 
+  Scheduler::setOverrunHandler(&taskOverrun, this, KWLConfig::TaskRuntimeBudgetMs);
   DeadlockWatchdog::begin(&deadlockDetected, this);
 }
 
@@ -170,11 +334,11 @@ bool KWLControl::mqttReceiveMsg(const StringView& topic, const StringView& s)
   // Set Values
   if (topic == MQTTTopic::CmdResetAll) {
     if (s == F("YES"))   {
-      Serial.println(F("Speicherbereich wird gelöscht"));
+      LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Speicherbereich wird gelöscht"));
       getPersistentConfig().factoryReset();
       // Reboot
-      Serial.println(F("Reboot"));
-      Serial.flush();
+      LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Reboot"));
+      Logger::flush();
       delay(100);
       wdt_disable();
       asm volatile ("jmp 0");
@@ -182,8 +346,8 @@ bool KWLControl::mqttReceiveMsg(const StringView& topic, const StringView& s)
   } else if (topic == MQTTTopic::CmdRestart) {
     if (s == F("YES"))   {
       // Reboot
-      Serial.println(F("Reboot"));
-      Serial.flush();
+      LOG(KWLConfig::LogLevelGeneral, INFO).println(F("Reboot"));
+      Logger::flush();
       delay(100);
       wdt_disable();
       asm volatile ("jmp 0");
@@ -202,6 +366,8 @@ bool KWLControl::mqttReceiveMsg(const StringView& topic, const StringView& s)
     getFanControl().forceSend();
     getBypass().forceSend();
     getAdditionalSensors().forceSend();
+    if (KWLConfig::SnapshotPeriod)
+      mqttSendSnapshot();
   } else if (topic == MQTTTopic::KwlDebugsetSchedulerGetvalues) {
     // send statistics for scheduler
     auto i1 = Scheduler::TaskPollingStats::begin();
@@ -230,15 +396,56 @@ bool KWLControl::mqttReceiveMsg(const StringView& topic, const StringView& s)
       }
       return true;
     });
+  } else if (topic == MQTTTopic::KwlDebugsetSchedulerTrace) {
+    // send snapshot of the task trace, first task names, then hex-encoded entries
+    Scheduler::TaskTrace::stop();
+    if (s == F("serial")) {
+      printTrace();
+      Scheduler::TaskTrace::restart();
+      return true;
+    }
+    auto i1 = Scheduler::TaskPollingStats::begin();
+    auto i2 = Scheduler::TaskTimingStats::begin();
+    uint8_t index = 0;
+    scheduler_publish_.publish([i1, i2, index]() mutable {
+      char buffer[TRACE_BUFFER_SIZE];
+      char tbuffer[TRACE_TOPIC_SIZE];
+      while (i1 != Scheduler::TaskPollingStats::end()) {
+        makeTraceTopic(tbuffer, MQTTTopic::KwlDebugstateSchedulerTraceName, i1->getTraceId());
+        makeTraceName(buffer, sizeof(buffer), F("poll "), i1->getName());
+        if (publish(tbuffer, buffer, false))
+          ++i1;
+        return false;
+      }
+      while (i2 != Scheduler::TaskTimingStats::end()) {
+        makeTraceTopic(tbuffer, MQTTTopic::KwlDebugstateSchedulerTraceName, i2->getTraceId());
+        makeTraceName(buffer, sizeof(buffer), F("timed "), i2->getName());
+        if (publish(tbuffer, buffer, false))
+          ++i2;
+        return false;
+      }
+      if (index < Scheduler::TaskTrace::size()) {
+        makeTraceTopic(tbuffer, MQTTTopic::KwlDebugstateSchedulerTraceData, index);
+        auto count = Scheduler::TaskTrace::toHex(index, buffer, sizeof(buffer));
+        if (publish(tbuffer, buffer, false))
+          index += count;
+        return false;
+      }
+      Scheduler::TaskTrace::restart();
+      return true;
+    });
+  } else if (topic == MQTTTopic::KwlDebugsetMemoryGetvalues) {
+    mqttSendMemory();
   } else if (topic == MQTTTopic::KwlDebugsetNTPTime) {
     // set NTP time
     unsigned long time = static_cast<unsigned long>(s.toInt());
     ntp_.debugSetTime(time);
-    if (KWLConfig::serialDebug) {
-      Serial.print(F("Setting NTP time to "));
-      Serial.print(time);
-      Serial.print(F(", "));
-      Serial.println(PrintableHMS(ntp_.currentTimeHMS(persistent_config_.getTimezoneMin() * 60, persistent_config_.getDST())));
+    if (LOG_ENABLED(KWLConfig::LogLevelGeneral, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("Setting NTP time to "));
+      log.print(time);
+      log.print(F(", "));
+      log.println(PrintableHMS(ntp_.currentTimeHMS(persistent_config_.getTimezoneMin() * 60, persistent_config_.getDST())));
     }
   } else if (topic == MQTTTopic::KwlDebugsetCrashGetvalues) {
     // get crash information
@@ -247,14 +454,16 @@ bool KWLControl::mqttReceiveMsg(const StringView& topic, const StringView& s)
       while (index < KWLConfig::MaxCrashReportCount) {
         auto& c = persistent_config_.getCrash(index);
         if (c.crash_addr) {
-          char buffer[48], topic[MQTTTopic::KwlDebugstateCrash.length() + 3];
+          char buffer[96], topic[MQTTTopic::KwlDebugstateCrash.length() + 3];
           MQTTTopic::KwlDebugstateCrash.store(topic);
           char* p = topic + MQTTTopic::KwlDebugstateCrash.length();
           *p++ = char(index / 10) + '0';
           *p++ = (index % 10) + '0';
           *p = 0;
-          snprintf_P(buffer, sizeof(buffer), PSTR("ip %06lx sp %03lx ntp %lu ms %lu"),
-                   c.crash_addr * 2, c.crash_sp, c.real_time, c.millis);
+          snprintf_P(buffer, sizeof(buffer), PSTR("ip %06lx sp %03lx ntp %lu ms %lu stack %u task "),
+                   c.crash_addr * 2, c.crash_sp, c.real_time, c.millis,
+                   persistent_config_.getCrashFreeStack(index));
+          strlcat_P(buffer, reinterpret_cast<const char*>(getTaskName(persistent_config_.getCrashTask(index))), sizeof(buffer));
           if (MessageHandler::publish(topic, buffer))
             ++index;
           return false;
@@ -271,8 +480,8 @@ bool KWLControl::mqttReceiveMsg(const StringView& topic, const StringView& s)
   } else if (topic == MQTTTopic::KwlDebugsetCrashProvoke) {
     if (s == F("YES"))   {
       // provoke a crash by making a deadlock
-      Serial.println(F("CRASH: Deadlock provoked"));
-      Serial.flush();
+      LOG(KWLConfig::LogLevelGeneral, INFO).println(F("CRASH: Deadlock provoked"));
+      Logger::flush();
       while (true) {}
     }
   } else if (topic == MQTTTopic::CmdScreenshot) {
@@ -286,39 +495,42 @@ bool KWLControl::mqttReceiveMsg(const StringView& topic, const StringView& s)
         port = uint16_t(atoi(port_str));
       }
       if (!ip.fromString(ip_str)) {
-        Serial.println(F("Screenshot: invalid IP address"));
+        LOG(KWLConfig::LogLevelGeneral, WARNING).println(F("Screenshot: invalid IP address"));
         return true;
       }
       if (!port) {
-        Serial.println(F("Screenshot: invalid port specified"));
+        LOG(KWLConfig::LogLevelGeneral, WARNING).println(F("Screenshot: invalid port specified"));
         return true;
       }
     }
-    if (KWLConfig::serialDebug) {
-      Serial.print(F("Screenshot: trigger for "));
-      Serial.print(ip);
-      Serial.print(':');
-      Serial.print(port);
-      Serial.print(F(" received at "));
-      Serial.println(millis());
+    if (LOG_ENABLED(KWLConfig::LogLevelGeneral, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("Screenshot: trigger for "));
+      log.print(ip);
+      log.print(':');
+      log.print(port);
+      log.print(F(" received at "));
+      log.println(millis());
     }
     tft_.prepareForScreenshot();
     EthernetClient client;
     if (!client.connect(ip, port)) {
-      if (KWLConfig::serialDebug) {
-        Serial.println(F("Screenshot: cannot connect"));
-        return true;
-      }
+      LOG(KWLConfig::LogLevelGeneral, WARNING).println(F("Screenshot: cannot connect"));
+      return true;
     }
-    if (KWLConfig::serialDebug)
-      Serial.println(F("Screenshot: connected"));
+    LOG(KWLConfig::LogLevelGeneral, TRACE).println(F("Screenshot: connected"));
     ScreenshotService::make(tft_.getTFT(), client);
     client.flush();
     client.stop();
-    if (KWLConfig::serialDebug) {
-      Serial.print(F("Screenshot: done at "));
-      Serial.println(millis());
+    if (LOG_ENABLED(KWLConfig::LogLevelGeneral, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("Screenshot: done at "));
+      log.println(millis());
     }
+  } else if (topic == MQTTTopic::CmdPublishPolicyGet) {
+    mqttSendPublishPolicy();
+  } else if (topic.substr(0, MQTTTopic::CmdPublishPolicy.length()) == MQTTTopic::CmdPublishPolicy) {
+    mqttSetPublishPolicy(StringView(topic.c_str() + MQTTTopic::CmdPublishPolicy.length()), s);
   } else if (topic == MQTTTopic::CmdScreen) {
     // switch to given screen by ID
     tft_.gotoScreen(s.toInt());
@@ -347,13 +559,13 @@ void KWLControl::run()
   }
   if (!ntp_.hasTime())
     local_err |= ERROR_BIT_NTP;
-  if (temp_sensors_.get_t1_outside() <= TempSensors::INVALID)
+  if (!temp_sensors_.isHealthy(0))
     local_err |= ERROR_BIT_T1;
-  if (temp_sensors_.get_t2_inlet() <= TempSensors::INVALID)
+  if (!temp_sensors_.isHealthy(1))
     local_err |= ERROR_BIT_T2;
-  if (temp_sensors_.get_t3_outlet() <= TempSensors::INVALID)
+  if (!temp_sensors_.isHealthy(2))
     local_err |= ERROR_BIT_T3;
-  if (temp_sensors_.get_t4_exhaust() <= TempSensors::INVALID)
+  if (!temp_sensors_.isHealthy(3))
     local_err |= ERROR_BIT_T4;
 
   unsigned local_info = 0;
@@ -385,8 +597,127 @@ void KWLControl::mqttSendStatus()
   });
 }
 
+void KWLControl::checkMemory()
+{
+  auto free_stack = MemoryMonitor::scanMinFreeStack();
+  if (free_stack < min_free_stack_) {
+    // new low-water mark, report it
+    min_free_stack_ = free_stack;
+    mqttSendMemory();
+  }
+}
+
+void KWLControl::mqttSendMemory()
+{
+  memory_publish_.publish([this]() {
+    char buffer[112];
+    snprintf_P(buffer, sizeof(buffer), PSTR("stack %u free %u heap 0x%04x flist %u logdrop %u logtrunc %u syslogfail %u"),
+               min_free_stack_, MemoryMonitor::getFreeMemory(),
+               MemoryMonitor::getHeapTop(), MemoryMonitor::getFreeListSize(),
+               Logger::getDroppedMessages(), Logger::getTruncatedMessages(), Logger::getSyslogFailures());
+    return publish(MQTTTopic::KwlDebugstateMemory, buffer);
+  });
+}
+
+void KWLControl::mqttSendSnapshot()
+{
+  snapshot_publish_.publish([this]() {
+    // payload is written directly to the network, no buffer needed
+    return publish(MQTTTopic::KwlSnapshot, &KWLControl::writeSnapshot, this, KWLConfig::RetainMeasurements);
+  });
+}
+
+void KWLControl::writeSnapshot(void* arg, Print& out)
+{
+  // all values are read at once, so the snapshot is consistent
+  auto& self = *reinterpret_cast<KWLControl*>(arg);
+  JSONWriter json(out);
+  addTemperature(json, F("t1"), self.temp_sensors_.get_t1_outside());
+  addTemperature(json, F("t2"), self.temp_sensors_.get_t2_inlet());
+  addTemperature(json, F("t3"), self.temp_sensors_.get_t3_outlet());
+  addTemperature(json, F("t4"), self.temp_sensors_.get_t4_exhaust());
+  json.add(F("eff"), long(self.temp_sensors_.getEfficiency()));
+  json.add(F("fan1"), long(self.fan_control_.getFan1().getSpeed()));
+  json.add(F("fan2"), long(self.fan_control_.getFan2().getSpeed()));
+  json.add(F("mode"), long(self.fan_control_.getVentilationMode()));
+  json.add(F("bypass"), SummerBypass::toString(self.bypass_.getState()));
+  json.add(F("antifreeze"), (self.antifreeze_.getState() != AntifreezeState::OFF) ? F("on") : F("off"));
+  auto& add = self.add_sensors_;
+  if (add.hasDHT1()) {
+    json.add(F("dht1t"), FixedPoint(lround(add.getDHT1Temp() * 10), 1));
+    json.add(F("dht1h"), FixedPoint(lround(add.getDHT1Hum() * 10), 1));
+  }
+  if (add.hasDHT2()) {
+    json.add(F("dht2t"), FixedPoint(lround(add.getDHT2Temp() * 10), 1));
+    json.add(F("dht2h"), FixedPoint(lround(add.getDHT2Hum() * 10), 1));
+  }
+  if (add.hasCO2())
+    json.add(F("co2"), long(add.getCO2()));
+  if (add.hasVOC())
+    json.add(F("voc"), long(add.getVOC()));
+  json.finish();
+}
+
+void KWLControl::mqttSetPublishPolicy(const StringView& group_name, const StringView& s)
+{
+  auto group = PublishPolicy::findGroup(group_name);
+  PublishPolicy policy;
+  if (group == PublishGroup::COUNT || !policy.parse(s.c_str())) {
+    if (LOG_ENABLED(KWLConfig::LogLevelGeneral, WARNING)) {
+      LogLine log(LogLevel::WARNING);
+      log.print(F("Publish policy: invalid group or value for "));
+      log.println(group_name.c_str());
+    }
+    return;
+  }
+  persistent_config_.setPublishPolicy(group, policy);
+  mqttSendPublishPolicy();
+}
+
+void KWLControl::mqttSendPublishPolicy()
+{
+  uint8_t group = 0;
+  policy_publish_.publish([this, group]() mutable {
+    while (group < uint8_t(PublishGroup::COUNT)) {
+      char topic[MQTTTopic::KwlPublishPolicy.length() + 16], buffer[20];
+      MQTTTopic::KwlPublishPolicy.store(topic);
+      strlcpy_P(topic + MQTTTopic::KwlPublishPolicy.length(),
+                reinterpret_cast<const char*>(PublishPolicy::getGroupName(PublishGroup(group))),
+                sizeof(topic) - MQTTTopic::KwlPublishPolicy.length());
+      persistent_config_.getPublishPolicy(PublishGroup(group)).toString(buffer, sizeof(buffer));
+      if (!publish(topic, buffer, KWLConfig::RetainPublishPolicy))
+        return false;
+      ++group;
+    }
+    return true;
+  });
+}
+
 void KWLControl::deadlockDetected(unsigned long pc, unsigned sp, void* arg)
 {
   auto instance = reinterpret_cast<KWLControl*>(arg);
-  instance->persistent_config_.storeCrash(pc, sp, instance->ntp_.currentTime());
+  instance->persistent_config_.storeCrash(pc, sp, instance->ntp_.currentTime(),
+    Scheduler::TaskTrace::getCurrentTask(), MemoryMonitor::scanMinFreeStack());
+}
+
+void KWLControl::taskOverrun(const __FlashStringHelper* name, uint8_t id, unsigned long runtime, void* arg)
+{
+  auto instance = reinterpret_cast<KWLControl*>(arg);
+  instance->overrun_task_ = id;
+  instance->overrun_runtime_ = runtime;
+  ++instance->overrun_count_;
+  if (LOG_ENABLED(KWLConfig::LogLevelGeneral, WARNING)) {
+    LogLine log(LogLevel::WARNING);
+    log.print(F("Task overrun: "));
+    log.print(name);
+    log.print(F(", runtime "));
+    log.println(runtime);
+  }
+  instance->overrun_publish_.publish([instance]() {
+    char buffer[80];
+    snprintf_P(buffer, sizeof(buffer), PSTR("runtime %lu cnt %u task "),
+               instance->overrun_runtime_, instance->overrun_count_);
+    strlcat_P(buffer, reinterpret_cast<const char*>(getTaskName(instance->overrun_task_)), sizeof(buffer));
+    return publish(MQTTTopic::KwlDebugstateCrashOverrun, buffer);
+  });
 }
@@ -25,6 +25,7 @@
 #pragma once
 
 #include <MicroNTP.h>
+#include <Logger.h>
 
 #include "NetworkClient.h"
 #include "TempSensors.h"
@@ -34,6 +35,8 @@
 #include "SummerBypass.h"
 #include "AdditionalSensors.h"
 #include "TFT.h"
+#include "TelemetryHistory.h"
+#include "InfluxExporter.h"
 
 /*!
  * @brief Controller for the ventilation system.
@@ -144,6 +147,27 @@ private:
   /// Called by watchdog to report deadlock.
   static void deadlockDetected(unsigned long pc, unsigned sp, void* arg);
 
+  /// Scan free memory and report new low-water mark of the stack.
+  void checkMemory();
+
+  /// Send memory statistics.
+  void mqttSendMemory();
+
+  /// Send snapshot of all measurements in one message.
+  void mqttSendSnapshot();
+
+  /// Write snapshot of all measurements as JSON object (payload writer for MessageHandler::publish()).
+  static void writeSnapshot(void* arg, Print& out);
+
+  /// Set publish policy of the group given by name from string "<deadband>,<min>,<max>".
+  void mqttSetPublishPolicy(const StringView& group, const StringView& s);
+
+  /// Send publish policies of all groups.
+  void mqttSendPublishPolicy();
+
+  /// Called by scheduler to report a task exceeding its runtime budget.
+  static void taskOverrun(const __FlashStringHelper* name, uint8_t id, unsigned long runtime, void* arg);
+
   /// Scheduler for running tasks.
   Scheduler::PollingScheduler scheduler_;
   /// Persistent configuration.
@@ -168,10 +192,22 @@ private:
   ProgramManager program_manager_;
   /// Display control.
   TFT tft_;
+  /// History of measurements while MQTT is offline.
+  TelemetryHistory history_;
+  /// Exporter of measurements to InfluxDB.
+  InfluxExporter influx_;
   /// Task to send all scheduler infos reliably.
   PublishTask scheduler_publish_;
   /// Task to send errors.
   PublishTask error_publish_;
+  /// Task to send task overrun reports.
+  PublishTask overrun_publish_;
+  /// Trace ID of the last task which exceeded its runtime budget.
+  uint8_t overrun_task_ = Scheduler::TaskTrace::NO_TASK_ID;
+  /// Runtime of the last task which exceeded its runtime budget.
+  unsigned long overrun_runtime_ = 0;
+  /// Count of task overruns since start.
+  unsigned overrun_count_ = 0;
   /// Current error state.
   unsigned errors_ = 0;
   /// Current info state.
@@ -180,4 +216,24 @@ private:
   Scheduler::TaskTimingStats control_stats_;
   /// Timer firing checks.
   Scheduler::TimedTask<KWLControl> control_timer_;
+  /// Task to send memory statistics.
+  PublishTask memory_publish_;
+  /// Minimum free stack since start (low-water mark).
+  unsigned min_free_stack_ = 0xffff;
+  /// Memory check timing statistics.
+  Scheduler::TaskTimingStats memory_stats_;
+  /// Timer firing memory checks.
+  Scheduler::TimedTask<KWLControl> memory_timer_;
+  /// Task to send measurement snapshot.
+  PublishTask snapshot_publish_;
+  /// Snapshot timing statistics.
+  Scheduler::TaskTimingStats snapshot_stats_;
+  /// Timer sending measurement snapshots.
+  Scheduler::TimedTask<KWLControl> snapshot_timer_;
+  /// Task to send publish policies.
+  PublishTask policy_publish_;
+  /// Log output timing statistics.
+  Scheduler::TaskPollingStats log_stats_;
+  /// Task writing out pending log messages.
+  Scheduler::PollTask<> log_task_;
 };
@@ -77,6 +77,8 @@ namespace MQTTTopic
   constexpr auto CmdScreenshot              = makeFlashStringLiteral("screenshot");
   constexpr auto CmdScreen                  = makeFlashStringLiteral("screen");
   constexpr auto CmdTouch                   = makeFlashStringLiteral("touch");
+  constexpr auto CmdPublishPolicy           = makeFlashStringLiteral("publishpolicy/");
+  constexpr auto CmdPublishPolicyGet        = makeFlashStringLiteral("publishpolicy/getvalues");
 
   constexpr auto Heartbeat                  = makeFlashStringLiteral("heartbeat");
   constexpr auto StatusBits                 = makeFlashStringLiteral("statusbits");
@@ -88,6 +90,11 @@ namespace MQTTTopic
   constexpr auto KwlTemperaturAbluft        = makeFlashStringLiteral("abluft/temperatur");
   constexpr auto KwlTemperaturFortluft      = makeFlashStringLiteral("fortluft/temperatur");
   constexpr auto KwlEffiency                = makeFlashStringLiteral("effiencyKwl");
+  // Health of temperature sensors: fresh, stale, stuck, range or noisy, ",estimated" appended if the temperature is estimated
+  constexpr auto KwlHealthAussenluft        = makeFlashStringLiteral("aussenluft/health");
+  constexpr auto KwlHealthZuluft            = makeFlashStringLiteral("zuluft/health");
+  constexpr auto KwlHealthAbluft            = makeFlashStringLiteral("abluft/health");
+  constexpr auto KwlHealthFortluft          = makeFlashStringLiteral("fortluft/health");
   constexpr auto KwlAntifreeze              = makeFlashStringLiteral("antifreeze");
   constexpr auto KwlBypassState             = makeFlashStringLiteral("summerbypass/flap");
   constexpr auto KwlBypassMode              = makeFlashStringLiteral("summerbypass/mode");
@@ -106,6 +113,9 @@ namespace MQTTTopic
   constexpr auto KwlDHT2Humidity            = makeFlashStringLiteral("dht2/humidity");
   constexpr auto KwlCO2Abluft               = makeFlashStringLiteral("abluft/co2");
   constexpr auto KwlVOCAbluft               = makeFlashStringLiteral("abluft/voc");
+  constexpr auto KwlSnapshot                = makeFlashStringLiteral("snapshot");
+  constexpr auto KwlHistory                 = makeFlashStringLiteral("history");
+  constexpr auto KwlPublishPolicy           = makeFlashStringLiteral("publishpolicy/");
 
 
   // Die folgenden Topics sind nur für die SW-Entwicklung, und schalten Debugausgaben per mqtt ein und aus
@@ -125,12 +135,30 @@ namespace MQTTTopic
   constexpr auto KwlDebugsetSchedulerGetvalues   = makeFlashStringLiteral("/scheduler/getvalues");
   constexpr auto KwlDebugsetSchedulerResetvalues = makeFlashStringLiteral("/scheduler/resetvalues");
   constexpr auto KwlDebugstateScheduler    = makeFlashStringLiteral("/scheduler/");
+  constexpr auto KwlDebugsetSchedulerTrace       = makeFlashStringLiteral("/scheduler/trace/getvalues");
+  constexpr auto KwlDebugstateSchedulerTraceName = makeFlashStringLiteral("/scheduler/trace/name/");
+  constexpr auto KwlDebugstateSchedulerTraceData = makeFlashStringLiteral("/scheduler/trace/data/");
 
   // Die folgenden Topics sind nur für die SW-Entwicklung, um Crash info auszulesen
   constexpr auto KwlDebugsetCrashGetvalues = makeFlashStringLiteral("/crash/getvalues");
   constexpr auto KwlDebugsetCrashResetvalues = makeFlashStringLiteral("/crash/resetvalues");
   constexpr auto KwlDebugsetCrashProvoke   = makeFlashStringLiteral("/crash/provoke_IKNOWWHATIMDOING");
   constexpr auto KwlDebugstateCrash        = makeFlashStringLiteral("/crash/");
+  constexpr auto KwlDebugstateCrashOverrun = makeFlashStringLiteral("/crash/overrun");
+
+  // Die folgenden Topics sind nur für die SW-Entwicklung, um Speicherverbrauch auszulesen
+  constexpr auto KwlDebugsetMemoryGetvalues = makeFlashStringLiteral("/memory/getvalues");
+  constexpr auto KwlDebugstateMemory        = makeFlashStringLiteral("/memory");
+
+  // Die folgenden Topics sind nur für die SW-Entwicklung, um MQTT-Statistiken auszulesen
+  constexpr auto KwlDebugsetMqttStatsGetvalues   = makeFlashStringLiteral("/mqttstats/getvalues");
+  constexpr auto KwlDebugsetMqttStatsResetvalues = makeFlashStringLiteral("/mqttstats/resetvalues");
+  constexpr auto KwlDebugstateMqttStats          = makeFlashStringLiteral("/mqttstats");
+
+  // Die folgenden Topics sind nur für die SW-Entwicklung, um Fehlerzähler der Temperatursensoren auszulesen
+  constexpr auto KwlDebugsetTempSensorGetvalues   = makeFlashStringLiteral("/tempsensor/getvalues");
+  constexpr auto KwlDebugsetTempSensorResetvalues = makeFlashStringLiteral("/tempsensor/resetvalues");
+  constexpr auto KwlDebugstateTempSensor          = makeFlashStringLiteral("/tempsensor/");
 
   // Die folgenden Topics sind nur für die SW-Entwicklung, um NTP zu simulieren.
   constexpr auto KwlDebugsetNTPTime        = makeFlashStringLiteral("/ntp/time");
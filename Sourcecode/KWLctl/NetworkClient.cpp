@@ -31,17 +31,222 @@
 /// Interval for checking LAN network OK (10 seconds).
 static constexpr unsigned long LAN_CHECK_INTERVAL = 10000000;
 
-/// Interval for reconnecting MQTT (15 seconds).
-static constexpr unsigned long MQTT_RECONNECT_INTERVAL = 15000000;
+/// Initial interval for reconnecting MQTT, doubled after each failed attempt (2 seconds).
+static constexpr unsigned long MQTT_RECONNECT_MIN_INTERVAL = 2000000;
+
+/// Maximum interval for reconnecting MQTT (2 minutes).
+static constexpr unsigned long MQTT_RECONNECT_MAX_INTERVAL = 120000000;
+
+/// Timeout for establishing TCP connection to MQTT broker in milliseconds.
+static constexpr uint16_t MQTT_TCP_TIMEOUT_MS = 500;
+
+/// Timeout for receiving CONNACK from MQTT broker in seconds.
+static constexpr uint16_t MQTT_CONNACK_TIMEOUT_S = 1;
+
+/// Runtime budget of polling task, which may block for one MQTT connection attempt.
+static constexpr uint16_t POLL_TASK_BUDGET_MS = MQTT_TCP_TIMEOUT_MS + MQTT_CONNACK_TIMEOUT_S * 1000U + 500;
+
+/// Runtime budget of command task (3s), commands like resetting configuration write EEPROM.
+static constexpr uint16_t COMMAND_TASK_BUDGET_MS = 3000;
+
+/// Timeout for subscribing to command topics (5 seconds).
+static constexpr unsigned long MQTT_SUBSCRIBE_TIMEOUT = 5000000;
 
 /// MQTT heartbeat period.
 static constexpr unsigned long MQTT_HEARTBEAT_PERIOD = KWLConfig::HeartbeatPeriod * 1000000UL;
 
+/// Time budget for processing received commands in one scheduler loop (2ms).
+static constexpr unsigned long COMMAND_BUDGET = 2000;
+
 namespace {
   /// MQTT prefix length.
   static uint8_t s_mqtt_prefix_len = 0;
   /// MQTT prefix.
   static const char* s_mqtt_prefix = nullptr;
+
+  /// Groups of published topics for publish statistics.
+  enum TopicGroup : uint8_t
+  {
+    TOPIC_GROUP_OTHER,
+    TOPIC_GROUP_TEMPERATURE,
+    TOPIC_GROUP_FAN,
+    TOPIC_GROUP_SENSORS,
+    TOPIC_GROUP_BYPASS,
+    TOPIC_GROUP_ANTIFREEZE,
+    TOPIC_GROUP_CONFIG,
+    TOPIC_GROUP_STATUS,
+    TOPIC_GROUP_DEBUG,
+    TOPIC_GROUP_COUNT
+  };
+
+  static_assert(TOPIC_GROUP_COUNT <= MESSAGE_HANDLER_STATS_GROUPS, "Too many topic groups for publish statistics");
+
+  const char TOPIC_GROUP_NAME_OTHER[] PROGMEM = "other";
+  const char TOPIC_GROUP_NAME_TEMPERATURE[] PROGMEM = "temperature";
+  const char TOPIC_GROUP_NAME_FAN[] PROGMEM = "fan";
+  const char TOPIC_GROUP_NAME_SENSORS[] PROGMEM = "sensors";
+  const char TOPIC_GROUP_NAME_BYPASS[] PROGMEM = "bypass";
+  const char TOPIC_GROUP_NAME_ANTIFREEZE[] PROGMEM = "antifreeze";
+  const char TOPIC_GROUP_NAME_CONFIG[] PROGMEM = "config";
+  const char TOPIC_GROUP_NAME_STATUS[] PROGMEM = "status";
+  const char TOPIC_GROUP_NAME_DEBUG[] PROGMEM = "debug";
+
+  /// Topic group names indexed by TopicGroup.
+  const char* const TOPIC_GROUP_NAMES[TOPIC_GROUP_COUNT] PROGMEM = {
+    TOPIC_GROUP_NAME_OTHER, TOPIC_GROUP_NAME_TEMPERATURE, TOPIC_GROUP_NAME_FAN,
+    TOPIC_GROUP_NAME_SENSORS, TOPIC_GROUP_NAME_BYPASS, TOPIC_GROUP_NAME_ANTIFREEZE,
+    TOPIC_GROUP_NAME_CONFIG, TOPIC_GROUP_NAME_STATUS, TOPIC_GROUP_NAME_DEBUG
+  };
+
+  /// Mapping of a topic (prefix) in Flash memory to its group.
+  struct TopicGroupEntry
+  {
+    const void* topic;
+    TopicGroup group;
+  };
+
+  /// Table mapping published topics to groups, first matching prefix wins.
+  const TopicGroupEntry TOPIC_GROUPS[] PROGMEM = {
+    { &MQTTTopic::KwlTemperaturAussenluft, TOPIC_GROUP_TEMPERATURE },
+    { &MQTTTopic::KwlTemperaturZuluft, TOPIC_GROUP_TEMPERATURE },
+    { &MQTTTopic::KwlTemperaturAbluft, TOPIC_GROUP_TEMPERATURE },
+    { &MQTTTopic::KwlTemperaturFortluft, TOPIC_GROUP_TEMPERATURE },
+    { &MQTTTopic::KwlEffiency, TOPIC_GROUP_TEMPERATURE },
+    { &MQTTTopic::KwlHealthAussenluft, TOPIC_GROUP_TEMPERATURE },
+    { &MQTTTopic::KwlHealthZuluft, TOPIC_GROUP_TEMPERATURE },
+    { &MQTTTopic::KwlHealthAbluft, TOPIC_GROUP_TEMPERATURE },
+    { &MQTTTopic::KwlHealthFortluft, TOPIC_GROUP_TEMPERATURE },
+    { &MQTTTopic::Fan1Speed, TOPIC_GROUP_FAN },
+    { &MQTTTopic::Fan2Speed, TOPIC_GROUP_FAN },
+    { &MQTTTopic::StateKwlMode, TOPIC_GROUP_FAN },
+    { &MQTTTopic::KwlDHT1Temperatur, TOPIC_GROUP_SENSORS },
+    { &MQTTTopic::KwlDHT2Temperatur, TOPIC_GROUP_SENSORS },
+    { &MQTTTopic::KwlDHT1Humidity, TOPIC_GROUP_SENSORS },
+    { &MQTTTopic::KwlDHT2Humidity, TOPIC_GROUP_SENSORS },
+    { &MQTTTopic::KwlCO2Abluft, TOPIC_GROUP_SENSORS },
+    { &MQTTTopic::KwlVOCAbluft, TOPIC_GROUP_SENSORS },
+    { &MQTTTopic::KwlBypassState, TOPIC_GROUP_BYPASS },
+    { &MQTTTopic::KwlBypassMode, TOPIC_GROUP_BYPASS },
+    { &MQTTTopic::KwlBypassTempAbluftMin, TOPIC_GROUP_BYPASS },
+    { &MQTTTopic::KwlBypassTempAussenluftMin, TOPIC_GROUP_BYPASS },
+    { &MQTTTopic::KwlBypassHystereseMinutes, TOPIC_GROUP_BYPASS },
+    { &MQTTTopic::KwlBypassHysteresisTemp, TOPIC_GROUP_BYPASS },
+    { &MQTTTopic::KwlAntifreeze, TOPIC_GROUP_ANTIFREEZE },
+    { &MQTTTopic::KwlHeatingAppCombUse, TOPIC_GROUP_ANTIFREEZE },
+    { &MQTTTopic::KwlProgramData, TOPIC_GROUP_CONFIG },
+    { &MQTTTopic::KwlPublishPolicy, TOPIC_GROUP_CONFIG },
+    { &MQTTTopic::Heartbeat, TOPIC_GROUP_STATUS },
+    { &MQTTTopic::StatusBits, TOPIC_GROUP_STATUS },
+    { &MQTTTopic::KwlSnapshot, TOPIC_GROUP_STATUS },
+    { &MQTTTopic::KwlHistory, TOPIC_GROUP_STATUS }
+  };
+
+  /// Map published topic to its group for publish statistics.
+  uint8_t classifyTopic(const char* topic)
+  {
+    if (*topic == '/')
+      return TOPIC_GROUP_DEBUG;  // all debug topics start with '/'
+    for (auto& e : TOPIC_GROUPS) {
+      auto prefix = reinterpret_cast<const char*>(pgm_read_ptr(&e.topic));
+      if (strncmp_P(topic, prefix, strlen_P(prefix)) == 0)
+        return pgm_read_byte(&e.group);
+    }
+    return TOPIC_GROUP_OTHER;
+  }
+
+  /// Check whether the command is expensive (writes EEPROM or sends many messages).
+  bool isExpensiveCommand(const StringView& topic)
+  {
+    return topic == MQTTTopic::CmdResetAll ||
+        topic == MQTTTopic::CmdRestart ||
+        topic == MQTTTopic::CmdInstallPrefix ||
+        topic == MQTTTopic::CmdCalibrateFans ||
+        topic == MQTTTopic::CmdGetvalues ||
+        topic == MQTTTopic::CmdScreenshot ||
+        topic.substr(0, MQTTTopic::CmdSetProgram.length()) == MQTTTopic::CmdSetProgram ||
+        topic.substr(0, MQTTTopic::CmdPublishPolicy.length()) == MQTTTopic::CmdPublishPolicy;
+  }
+
+  /// Publish a message, streaming the payload directly to the socket if it doesn't fit into MQTT packet buffer.
+  bool mqttPublish(PubSubClient* client, const char* topic, const char* payload, bool retained)
+  {
+    auto topic_len = strlen(topic);
+    auto payload_len = strlen(payload);
+    // fixed header (up to 5B) and topic length (2B)
+    if (topic_len + payload_len + 7 <= MQTT_MAX_PACKET_SIZE)
+      return client->publish(topic, payload, retained);
+    if (!client->beginPublish(topic, unsigned(payload_len), retained))
+      return false;
+    client->write(reinterpret_cast<const uint8_t*>(payload), payload_len);
+    return client->endPublish() != 0;
+  }
+
+  /// Prefix the topic with MQTT prefix and state or debug state topic and publish it using @p send.
+  template<typename Func>
+  bool withRealTopic(const char* topic, Func&& send)
+  {
+    auto topiclen = strlen(topic);
+    if (topic[0] == '/') {
+      // debug state
+      char real_topic[topiclen + s_mqtt_prefix_len + MQTTTopic::StateDebug.length()];
+      memcpy(real_topic, s_mqtt_prefix, s_mqtt_prefix_len);
+      MQTTTopic::StateDebug.store(real_topic + s_mqtt_prefix_len);
+      memcpy(real_topic + MQTTTopic::StateDebug.length() + s_mqtt_prefix_len, topic + 1, topiclen);
+      return send(real_topic);
+    } else {
+      // normal state
+      char real_topic[topiclen + s_mqtt_prefix_len + MQTTTopic::State.length() + 1];
+      memcpy(real_topic, s_mqtt_prefix, s_mqtt_prefix_len);
+      MQTTTopic::State.store(real_topic + s_mqtt_prefix_len);
+      memcpy(real_topic + MQTTTopic::State.length() + s_mqtt_prefix_len, topic, topiclen + 1);
+      return send(real_topic);
+    }
+  }
+
+  /*!
+   * @brief Output streaming the payload to MQTT client in small chunks.
+   *
+   * PubSubClient passes each write directly to the network client, so single
+   * bytes are collected first. Exactly the announced length is sent, excess
+   * output is dropped and missing output is padded with spaces.
+   */
+  class MQTTStreamPrint : public Print
+  {
+  public:
+    MQTTStreamPrint(PubSubClient& client, unsigned length) : client_(client), remaining_(length) {}
+
+    virtual size_t write(uint8_t c) override
+    {
+      if (!remaining_)
+        return 0;
+      --remaining_;
+      buffer_[used_++] = c;
+      if (used_ == sizeof(buffer_))
+        send();
+      return 1;
+    }
+
+    /// Pad to announced length and send the rest of the data.
+    void finish()
+    {
+      while (remaining_)
+        write(' ');
+      send();
+    }
+
+  private:
+    void send()
+    {
+      if (used_)
+        client_.write(buffer_, used_);
+      used_ = 0;
+    }
+
+    PubSubClient& client_;
+    unsigned remaining_;
+    uint8_t used_ = 0;
+    uint8_t buffer_[32];
+  };
 }
 
 NetworkClient::NetworkClient(KWLPersistentConfig& config, MicroNTP& ntp) :
@@ -51,14 +256,16 @@ NetworkClient::NetworkClient(KWLPersistentConfig& config, MicroNTP& ntp) :
   ntp_(ntp),
   stats_(F("NetworkClient")),
   timer_task_(stats_, &NetworkClient::run, *this),
-  poll_stats_(F("NetworkClientPoll")),
+  poll_stats_(F("NetworkClientPoll"), POLL_TASK_BUDGET_MS),
   poll_task_(poll_stats_, &NetworkClient::loop, *this),
-  mqtt_send_poll_task_(poll_stats_, &NetworkClient::sendMQTT)
+  mqtt_send_poll_task_(poll_stats_, &NetworkClient::sendMQTT),
+  command_stats_(F("NetworkClientCmd"), COMMAND_TASK_BUDGET_MS),
+  command_task_(command_stats_, &NetworkClient::processCommands, *this)
 {}
 
 void NetworkClient::begin(Print& initTracer)
 {
-  initEthernet(initTracer);
+  initEthernet(&initTracer);
   delay(1500);  // to give Ethernet link time to start
   last_lan_reconnect_attempt_time_ = micros();
   lan_ok_ = true;
@@ -70,26 +277,30 @@ void NetworkClient::begin(Print& initTracer)
   initTracer.print(F("], broker "));
   initTracer.println(IPAddress(config_.getNetworkMQTTBroker()));
   mqtt_client_.setServer(config_.getNetworkMQTTBroker(), config_.getNetworkMQTTPort());
+  // bound blocking calls, unreachable broker is handled by backoff in loop()
+  eth_client_.setConnectionTimeout(MQTT_TCP_TIMEOUT_MS);
+  mqtt_client_.setSocketTimeout(MQTT_CONNACK_TIMEOUT_S);
   mqtt_client_.setCallback([](char* topic, uint8_t* payload, unsigned length) {
     // first check whether it's for us
     if (memcmp(topic, s_mqtt_prefix, s_mqtt_prefix_len) == 0) {
       StringView t(topic + s_mqtt_prefix_len);
       if (t.substr(0, MQTTTopic::Command.length()) == MQTTTopic::Command) {
         // yes, it's our command, cut off the leading part
-        MessageHandler::mqttMessageReceived(topic + s_mqtt_prefix_len + MQTTTopic::Command.length(), payload, length);
+        MessageHandler::mqttMessageQueued(topic + s_mqtt_prefix_len + MQTTTopic::Command.length(), payload, length);
         return;
       } else if (t.substr(0, MQTTTopic::CommandDebug.length()) == MQTTTopic::CommandDebug) {
         // yes, it's our debug command, keep leading '/' to differentiate
-        MessageHandler::mqttMessageReceived(topic + s_mqtt_prefix_len + MQTTTopic::CommandDebug.length() - 1, payload, length);
+        MessageHandler::mqttMessageQueued(topic + s_mqtt_prefix_len + MQTTTopic::CommandDebug.length() - 1, payload, length);
         return;
       }
     }
-    if (KWLConfig::serialDebug) {
-      Serial.print(F("MQTT: received message on not subscribed topic ["));
-      Serial.print(topic);
-      Serial.print(F("] = ["));
-      Serial.write(payload, length);
-      Serial.println(']');
+    if (LOG_ENABLED(KWLConfig::LogLevelNetwork, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("MQTT: received message on not subscribed topic ["));
+      log.print(topic);
+      log.print(F("] = ["));
+      log.write(payload, length);
+      log.println(']');
     }
   });
 
@@ -97,49 +308,61 @@ void NetworkClient::begin(Print& initTracer)
   #ifdef NO_ETHERNET
     return true;
   #else
-    // prefix name
     PubSubClient* client = reinterpret_cast<PubSubClient*>(instance);
-    auto topiclen = strlen(topic);
-    if (topic[0] == '/') {
-      // debug state
-      char real_topic[topiclen + s_mqtt_prefix_len + MQTTTopic::StateDebug.length()];
-      memcpy(real_topic, s_mqtt_prefix, s_mqtt_prefix_len);
-      MQTTTopic::StateDebug.store(real_topic + s_mqtt_prefix_len);
-      memcpy(real_topic + MQTTTopic::StateDebug.length() + s_mqtt_prefix_len, topic + 1, topiclen);
-      return client->publish(real_topic, payload, retained);
-    } else {
-      // normal state
-      char real_topic[topiclen + s_mqtt_prefix_len + MQTTTopic::State.length() + 1];
-      memcpy(real_topic, s_mqtt_prefix, s_mqtt_prefix_len);
-      MQTTTopic::State.store(real_topic + s_mqtt_prefix_len);
-      memcpy(real_topic + MQTTTopic::State.length() + s_mqtt_prefix_len, topic, topiclen + 1);
-      return client->publish(real_topic, payload, retained);
-    }
+    return withRealTopic(topic, [client, payload, retained](const char* real_topic) {
+      return mqttPublish(client, real_topic, payload, retained);
+    });
+  #endif
+  }, &mqtt_client_, LOG_ENABLED(KWLConfig::LogLevelNetwork, TRACE));
+  MessageHandler::setStreamPublisher([](void* instance, const char* topic, unsigned length,
+                                        MessageHandler::payload_writer writer, void* arg, bool retained) {
+  #ifdef NO_ETHERNET
+    return true;
+  #else
+    PubSubClient* client = reinterpret_cast<PubSubClient*>(instance);
+    return withRealTopic(topic, [client, length, writer, arg, retained](const char* real_topic) {
+      if (!client->beginPublish(real_topic, length, retained))
+        return false;
+      MQTTStreamPrint out(*client, length);
+      writer(arg, out);
+      out.finish();
+      return client->endPublish() != 0;
+    });
   #endif
-  }, &mqtt_client_, KWLConfig::serialDebug);
+  });
+  MessageHandler::setExpensiveClassifier(&isExpensiveCommand);
+  MessageHandler::setTopicClassifier(&classifyTopic);
+  MessageHandler::setRateLimit(KWLConfig::MQTTRateMessages, KWLConfig::MQTTRateBytes,
+                               KWLConfig::MQTTBurstMessages, KWLConfig::MQTTBurstBytes);
   last_mqtt_reconnect_attempt_time_ = micros();
-  mqtt_ok_ = true;
+  mqtt_state_ = MQTTState::CONNECT;
   loop();  // first run call here to connect MQTT
 }
 
-void NetworkClient::initEthernet(Print& initTracer)
+void NetworkClient::initEthernet(Print* initTracer)
 {
-  initTracer.print(F("Initialisierung Ethernet, IP "));
   IPAddress ip = config_.getNetworkIPAddress();
   IPAddress gw = config_.getNetworkGateway();
   IPAddress subnet = config_.getNetworkSubnetMask();
   IPAddress dns = config_.getNetworkDNSServer();
   IPAddress ntp = config_.getNetworkNTPServer();
-  initTracer.print(ip);
-  Serial.print('/');
-  Serial.print(subnet);
-  Serial.print(F(" gw "));
-  Serial.print(gw);
-  Serial.print(F(" dns "));
-  Serial.print(dns);
-  Serial.print(F(" ntp "));
-  Serial.print(ntp);
-  initTracer.println();
+  if (initTracer) {
+    initTracer->print(F("Initialisierung Ethernet, IP "));
+    initTracer->println(ip);
+  }
+  if (LOG_ENABLED(KWLConfig::LogLevelNetwork, INFO)) {
+    LogLine log(LogLevel::INFO);
+    log.print(F("Ethernet: IP "));
+    log.print(ip);
+    log.print('/');
+    log.print(subnet);
+    log.print(F(" gw "));
+    log.print(gw);
+    log.print(F(" dns "));
+    log.print(dns);
+    log.print(F(" ntp "));
+    log.println(ntp);
+  }
   uint8_t mac[6];
   config_.getNetworkMACAddress().copy_to(mac);
   Ethernet.begin(mac, ip, dns, gw, subnet);
@@ -147,10 +370,13 @@ void NetworkClient::initEthernet(Print& initTracer)
 
 bool NetworkClient::mqttConnect()
 {
-  Serial.print(F("MQTT connect start at "));
-  Serial.print(micros());
-  Serial.print(F(", prefix: "));
-  Serial.println(s_mqtt_prefix);
+  if (LOG_ENABLED(KWLConfig::LogLevelNetwork, INFO)) {
+    LogLine log(LogLevel::INFO);
+    log.print(F("MQTT connect start at "));
+    log.print(micros());
+    log.print(F(", prefix: "));
+    log.println(s_mqtt_prefix);
+  }
 
   static constexpr auto NAME = makeFlashStringLiteral("kwlClient");
   static constexpr auto WILL_MESSAGE = makeFlashStringLiteral("offline");
@@ -158,6 +384,10 @@ bool NetworkClient::mqttConnect()
   NAME.store(buffer);
   buffer[NAME.length()] = ':';
   strcpy(buffer + NAME.length() + 1, config_.getMQTTPrefix());
+  // PubSubClient has no asynchronous connect, so this call still stalls the
+  // loop for up to MQTT_TCP_TIMEOUT_MS (TCP) + MQTT_CONNACK_TIMEOUT_S (CONNACK)
+  // per attempt. Backoff only limits how often it happens, see
+  // Docs/debug_network/mqtt_stall_sim.cpp.
   bool rc = mqtt_client_.connect(buffer,
                                  KWLConfig::NetworkMQTTUsername, KWLConfig::NetworkMQTTPassword,
                                  MQTTTopic::Heartbeat.load(), 0, true, WILL_MESSAGE.load());
@@ -165,66 +395,118 @@ bool NetworkClient::mqttConnect()
     // reset prefix, if it was changed in the meantime
     s_mqtt_prefix = config_.getMQTTPrefix();
     s_mqtt_prefix_len = uint8_t(strlen(s_mqtt_prefix));
-    // subscribe
+    // subscribe in next loops
     subscribed_command_ = subscribed_debug_ = false;
-    resubscribe();
-    timer_task_.runRepeated(1, MQTT_HEARTBEAT_PERIOD); // next run should send heartbeat
   }
   last_mqtt_reconnect_attempt_time_ = micros();
-  Serial.print(F("MQTT connect end at "));
-  Serial.print(last_mqtt_reconnect_attempt_time_);
   if (mqtt_client_.connected()) {
-    Serial.println(F(" [successful]"));
+    if (LOG_ENABLED(KWLConfig::LogLevelNetwork, INFO)) {
+      LogLine log(LogLevel::INFO);
+      log.print(F("MQTT connect end at "));
+      log.print(last_mqtt_reconnect_attempt_time_);
+      log.println(F(" [successful]"));
+    }
     return true;
   } else {
-    Serial.println(F(" [failed]"));
-    timer_task_.cancel();
+    if (LOG_ENABLED(KWLConfig::LogLevelNetwork, WARNING)) {
+      LogLine log(LogLevel::WARNING);
+      log.print(F("MQTT connect end at "));
+      log.print(last_mqtt_reconnect_attempt_time_);
+      log.print(F(" [failed, state "));
+      log.print(mqtt_client_.state());
+      log.println(']');
+    }
     return false;
   }
 }
 
-void NetworkClient::loop()
+bool NetworkClient::mqttStep(unsigned long current_time)
 {
-  if (Serial.available()) {
-    // there is data on serial port, read command from there
-    char c = char(Serial.read());
-    if (c == 10 || c == 13) {
-      // process command in form <topic> <value>
-      if (serial_data_size_) {
-        serial_data_[serial_data_size_] = 0;
-        auto delim = strchr(serial_data_, ' ');
-        if (!delim) {
-          static constexpr auto NO_VALUE = makeFlashStringLiteral("<no value>");
-          char* p = NO_VALUE.load();
-          MessageHandler::mqttMessageReceived(
-                serial_data_,
-                reinterpret_cast<uint8_t*>(p),
-                NO_VALUE.length());
-        } else {
-          *delim++ = 0;
-          while (*delim == ' ' || *delim == '\t')
-            ++delim;
-          MessageHandler::mqttMessageReceived(
-                serial_data_,
-                reinterpret_cast<uint8_t*>(delim),
-                unsigned(serial_data_size_ - (delim - serial_data_)));
-        }
-        serial_data_size_ = 0;
+  // Each call does at most one potentially blocking step, so that other tasks
+  // can run in between. Failures back off exponentially up to maximum interval.
+  switch (mqtt_state_) {
+    case MQTTState::BACKOFF:
+      if (current_time - last_mqtt_reconnect_attempt_time_ >= mqtt_backoff_)
+        mqtt_state_ = MQTTState::CONNECT;
+      return false;
+
+    case MQTTState::CONNECT:
+      if (mqttConnect()) {
+        mqtt_state_ = MQTTState::SUBSCRIBE;
+      } else {
+        mqttBackoff(current_time);
       }
-    } else if (serial_data_size_ < SERIAL_BUFFER_SIZE - 1) {
-      serial_data_[serial_data_size_++] = c;
-    }
+      return false;
+
+    case MQTTState::SUBSCRIBE:
+      if (!mqtt_client_.connected()) {
+        LOG(KWLConfig::LogLevelNetwork, WARNING).println(F("MQTT disconnected while subscribing"));
+        mqttBackoff(current_time);
+        return false;
+      }
+      resubscribe();
+      if (subscribed_command_ && subscribed_debug_) {
+        mqtt_state_ = MQTTState::CONNECTED;
+        mqtt_ok_ = true;
+        mqtt_backoff_ = 0;
+        timer_task_.runRepeated(1, MQTT_HEARTBEAT_PERIOD); // next run should send heartbeat
+        return true;
+      }
+      if (current_time - last_mqtt_reconnect_attempt_time_ >= MQTT_SUBSCRIBE_TIMEOUT) {
+        LOG(KWLConfig::LogLevelNetwork, WARNING).println(F("MQTT subscribe timed out"));
+        mqttBackoff(current_time);
+      }
+      return false;
+
+    case MQTTState::CONNECTED:
+      if (mqtt_client_.connected())
+        return true;
+      LOG(KWLConfig::LogLevelNetwork, WARNING).println(F("MQTT disconnected, attempting to connect"));
+      timer_task_.cancel();
+      mqtt_ok_ = false;
+      // first reconnect attempt immediately in the next loop
+      mqtt_state_ = MQTTState::CONNECT;
+      return false;
   }
+  return false;
+}
+
+void NetworkClient::mqttBackoff(unsigned long current_time)
+{
+  mqtt_client_.disconnect();
+  timer_task_.cancel();
+  mqtt_ok_ = false;
+  if (mqtt_backoff_ < MQTT_RECONNECT_MIN_INTERVAL)
+    mqtt_backoff_ = MQTT_RECONNECT_MIN_INTERVAL;
+  else if (mqtt_backoff_ < MQTT_RECONNECT_MAX_INTERVAL / 2)
+    mqtt_backoff_ *= 2;
+  else
+    mqtt_backoff_ = MQTT_RECONNECT_MAX_INTERVAL;
+  last_mqtt_reconnect_attempt_time_ = current_time;
+  mqtt_state_ = MQTTState::BACKOFF;
+  if (LOG_ENABLED(KWLConfig::LogLevelNetwork, TRACE)) {
+    LogLine log(LogLevel::TRACE);
+    log.print(F("MQTT next connect attempt in "));
+    log.print(mqtt_backoff_ / 1000000);
+    log.println('s');
+  }
+}
+
+void NetworkClient::loop()
+{
+  readSerial();
 
 #ifndef NO_ETHERNET
   Ethernet.maintain();
   auto current_time = micros();
   if (lan_ok_) {
     if (Ethernet.localIP()[0] == 0) {
-      Serial.println(F("LAN disconnected, attempting to connect"));
+      LOG(KWLConfig::LogLevelNetwork, WARNING).println(F("LAN disconnected, attempting to connect"));
       lan_ok_ = false;
+      mqtt_ok_ = false;
+      mqtt_state_ = MQTTState::BACKOFF;
       timer_task_.cancel();
-      initEthernet(Serial); // nothing more to do now
+      initEthernet(nullptr); // nothing more to do now
       last_lan_reconnect_attempt_time_ = current_time;
       return;
     }
@@ -232,15 +514,19 @@ void NetworkClient::loop()
   } else {
     // no Ethernet previously, check if now connected
     if (Ethernet.localIP()[0] != 0) {
-      Serial.print(F("LAN connected, IP: "));
-      Serial.println(Ethernet.localIP());
+      if (LOG_ENABLED(KWLConfig::LogLevelNetwork, INFO)) {
+        LogLine log(LogLevel::INFO);
+        log.print(F("LAN connected, IP: "));
+        log.println(Ethernet.localIP());
+      }
       lan_ok_ = true;
-      mqtt_ok_ = true; // to force check and immediate reconnect
+      mqtt_backoff_ = 0;
+      mqtt_state_ = MQTTState::CONNECT; // immediate reconnect
     } else {
       // still no Ethernet
       if (current_time - last_lan_reconnect_attempt_time_ >= LAN_CHECK_INTERVAL) {
         // try reconnecting
-        initEthernet(Serial);
+        initEthernet(nullptr);
         last_lan_reconnect_attempt_time_ = current_time;
       }
       return;
@@ -249,32 +535,12 @@ void NetworkClient::loop()
 
   ntp_.loop();
 
-  if (mqtt_ok_) {
-    if (!mqtt_client_.connected()) {
-      Serial.println(F("MQTT disconnected, attempting to connect"));
-      timer_task_.cancel();
-      mqtt_ok_ = mqttConnect();
-      if (!mqtt_ok_)
-        return; // couldn't connect now, cannot continue
-    }
-    // have MQTT receive messages
-  } else {
-    // no MQTT previously, check if now connected
-    if (current_time - last_mqtt_reconnect_attempt_time_ >= MQTT_RECONNECT_INTERVAL) {
-      // new reconnect attempt
-      mqtt_ok_ = mqttConnect();
-      if (!mqtt_ok_)
-        return;
-    } else {
-      return; // not connected
-    }
-  }
-
-  // Make sure we are subscribed, if after connect we didn't succeed
-  resubscribe();
+  if (!mqttStep(current_time))
+    return; // not connected (yet)
 
-  // now MQTT messages can be received
+  // now MQTT messages can be received, they are processed in command task
   mqtt_client_.loop();
+  scheduleCommands();
 #endif
 }
 
@@ -302,29 +568,129 @@ void NetworkClient::sendMQTT()
   PublishTask::loop();
 }
 
+void NetworkClient::readSerial()
+{
+  // drain all received characters, so the RX buffer doesn't overrun while
+  // other tasks run
+  bool dispatched = false;
+  while (Serial.available()) {
+    char c = char(Serial.read());
+    if (c != 10 && c != 13) {
+      if (serial_data_size_ < SERIAL_BUFFER_SIZE - 1)
+        serial_data_[serial_data_size_++] = c;
+      else
+        serial_overflow_ = true;
+      continue;
+    }
+    if (serial_overflow_) {
+      // discard the whole line, a truncated command would do something else
+      ++serial_overflows_;
+      LOG(KWLConfig::LogLevelNetwork, WARNING).println(F("Serial: command too long, ignored"));
+      serial_overflow_ = false;
+      serial_data_size_ = 0;
+      continue;
+    }
+    if (!serial_data_size_)
+      continue; // empty line or second character of CR/LF
+    // process command in form <topic> <value>
+    serial_data_[serial_data_size_] = 0;
+    auto delim = strchr(serial_data_, ' ');
+    if (!delim) {
+      static constexpr auto NO_VALUE = makeFlashStringLiteral("<no value>");
+      char* p = NO_VALUE.load();
+      MessageHandler::mqttMessageQueued(
+            serial_data_,
+            reinterpret_cast<uint8_t*>(p),
+            NO_VALUE.length());
+    } else {
+      *delim++ = 0;
+      while (*delim == ' ' || *delim == '\t')
+        ++delim;
+      MessageHandler::mqttMessageQueued(
+            serial_data_,
+            reinterpret_cast<uint8_t*>(delim),
+            unsigned(serial_data_size_ - (delim - serial_data_)));
+    }
+    serial_data_size_ = 0;
+    dispatched = true;
+  }
+  if (dispatched)
+    scheduleCommands();
+}
+
+void NetworkClient::processCommands()
+{
+  if (MessageHandler::processQueue(COMMAND_BUDGET))
+    command_task_.runOnce(0); // continue in the next scheduler loop
+}
+
+void NetworkClient::scheduleCommands()
+{
+  if (MessageHandler::hasQueuedMessages() && !command_task_.getScheduleTime())
+    command_task_.runOnce(0);
+}
+
 bool NetworkClient::mqttReceiveMsg(const StringView& topic, const StringView& s)
 {
   if (topic == MQTTTopic::CmdInstallPrefix) {
     // installation - install new prefix for MQTT communication
     if (config_.setMQTTPrefix(s.c_str())) {
       // success, restart MQTT connection
-      if (KWLConfig::serialDebug) {
-        Serial.print(F("Installation: new MQTT prefix: "));
-        Serial.println(s.c_str());
+      if (LOG_ENABLED(KWLConfig::LogLevelNetwork, INFO)) {
+        LogLine log(LogLevel::INFO);
+        log.print(F("Installation: new MQTT prefix: "));
+        log.println(s.c_str());
       }
       mqtt_client_.disconnect();
     } else {
-      if (KWLConfig::serialDebug) {
-        Serial.print(F("Installation: too long MQTT prefix: "));
-        Serial.println(s.c_str());
+      if (LOG_ENABLED(KWLConfig::LogLevelNetwork, WARNING)) {
+        LogLine log(LogLevel::WARNING);
+        log.print(F("Installation: too long MQTT prefix: "));
+        log.println(s.c_str());
       }
     }
+  } else if (topic == MQTTTopic::KwlDebugsetMqttStatsGetvalues) {
+    mqttSendStats();
+  } else if (topic == MQTTTopic::KwlDebugsetMqttStatsResetvalues) {
+    MessageHandler::resetPublishStats();
   } else {
     return false;
   }
   return true;
 }
 
+void NetworkClient::mqttSendStats()
+{
+  // first send global counters, then statistics per topic group
+  uint8_t group = 0;
+  bool global = true;
+  stats_publish_.publish([this, group, global]() mutable {
+    char topic[MQTTTopic::KwlDebugstateMqttStats.length() + 16];
+    char buffer[80];
+    MQTTTopic::KwlDebugstateMqttStats.store(topic);
+    if (global) {
+      snprintf_P(buffer, sizeof(buffer), PSTR("throttled %lu failed %lu dropped %u serialovf %u"),
+                 MessageHandler::getThrottledPublishes(), MessageHandler::getFailedPublishes(),
+                 MessageHandler::getDroppedMessages(), serial_overflows_);
+      if (!publish(topic, buffer, false))
+        return false;
+      global = false;
+    }
+    auto p = topic + MQTTTopic::KwlDebugstateMqttStats.length();
+    *p++ = '/';
+    while (group < TOPIC_GROUP_COUNT) {
+      strcpy_P(p, reinterpret_cast<const char*>(pgm_read_ptr(&TOPIC_GROUP_NAMES[group])));
+      auto& stats = MessageHandler::getPublishStats(group);
+      snprintf_P(buffer, sizeof(buffer), PSTR("sent %u failed %u bytes %lu"),
+                 stats.sent, stats.failed, stats.bytes);
+      if (!publish(topic, buffer, false))
+        return false;
+      ++group;
+    }
+    return true;
+  });
+}
+
 void NetworkClient::run()
 {
   // once connected or after timeout, publish an announcement
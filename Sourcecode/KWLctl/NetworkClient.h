@@ -56,12 +56,27 @@ public:
   bool isMQTTOk() const { return mqtt_ok_; }
 
 private:
-  /// Initialize Ethernet connection.
-  void initEthernet(Print& initTracer);
+  /// State of MQTT connection.
+  enum class MQTTState : uint8_t
+  {
+    BACKOFF,    ///< Not connected, waiting for next connection attempt.
+    CONNECT,    ///< Connection attempt will be made in next loop.
+    SUBSCRIBE,  ///< Connected, subscribing to command topics.
+    CONNECTED   ///< Connected and subscribed.
+  };
+
+  /// Initialize Ethernet connection (boot progress goes to initTracer, if given).
+  void initEthernet(Print* initTracer);
 
   /// Initialize MQTT connection.
   bool mqttConnect();
 
+  /// Advance MQTT connection state machine, return true if connected.
+  bool mqttStep(unsigned long current_time);
+
+  /// Close MQTT connection and schedule next connection attempt with exponential backoff.
+  void mqttBackoff(unsigned long current_time);
+
   /// Check network.
   void run();
 
@@ -74,8 +89,20 @@ private:
   /// Loop task to send MQTT messages.
   static void sendMQTT();
 
+  /// Read all characters available on serial port and queue complete command lines.
+  void readSerial();
+
+  /// Process queued received commands within time budget.
+  void processCommands();
+
+  /// Schedule processing of queued received commands, if any.
+  void scheduleCommands();
+
   virtual bool mqttReceiveMsg(const StringView& topic, const StringView& s) override;
 
+  /// Send publish statistics per topic group.
+  void mqttSendStats();
+
   /// Maximum size of serial buffer for sending messages over serial port.
   static constexpr uint8_t SERIAL_BUFFER_SIZE = 128;
 
@@ -87,10 +114,14 @@ private:
   KWLPersistentConfig& config_;
   /// NTP client to report online as timestamp.
   MicroNTP& ntp_;
-  /// Last time when LAN started a reconnect attempt.
+  /// Last time when MQTT started a reconnect attempt or entered current state.
   unsigned long last_mqtt_reconnect_attempt_time_ = 0;
-  /// Last time when MQTT started a reconnect attempt.
+  /// Last time when LAN started a reconnect attempt.
   unsigned long last_lan_reconnect_attempt_time_ = 0;
+  /// Current delay before next MQTT connection attempt in microseconds.
+  unsigned long mqtt_backoff_ = 0;
+  /// State of MQTT connection.
+  MQTTState mqtt_state_ = MQTTState::BACKOFF;
   /// Flag set when LAN is present.
   bool lan_ok_ = false;
   /// Flag set when MQTT is present.
@@ -101,10 +132,16 @@ private:
   bool subscribed_debug_ = false;
   /// Task to publish MQTT heartbeat message.
   PublishTask publish_task_;
+  /// Task to publish MQTT statistics.
+  PublishTask stats_publish_;
   /// Data received over serial port.
   char serial_data_[SERIAL_BUFFER_SIZE];
   /// Size of data received so far.
   uint8_t serial_data_size_ = 0;
+  /// Set if the current serial line didn't fit into the buffer.
+  bool serial_overflow_ = false;
+  /// Count of serial command lines discarded, because they were too long.
+  unsigned serial_overflows_ = 0;
   /// Task timing statistics.
   Scheduler::TaskTimingStats stats_;
   /// Timer tasks handling heartbeat.
@@ -115,4 +152,8 @@ private:
   Scheduler::PollTask<NetworkClient> poll_task_;
   /// Poll tasks for sending MQTT messages.
   Scheduler::PollTask<> mqtt_send_poll_task_;
+  /// Command processing timing statistics.
+  Scheduler::TaskTimingStats command_stats_;
+  /// Timer task processing received commands.
+  Scheduler::TimedTask<NetworkClient> command_task_;
 };
@@ -75,17 +75,17 @@ void ProgramManager::run()
   // TODO handle additional input, like humidity sensor
 
   if (!ntp_.hasTime()) {
-    if (KWLConfig::serialDebugProgram)
-      Serial.println(F("PROG: check - no time"));
+    LOG(KWLConfig::LogLevelProgram, TRACE).println(F("PROG: check - no time"));
     return;
   }
   auto time = ntp_.currentTimeHMS(config_.getTimezoneMin() * 60L, config_.getDST());
   auto set_index = config_.getProgramSetIndex();
-  if (KWLConfig::serialDebugProgram) {
-    Serial.print(F("PROG: check at "));
-    Serial.print(PrintableHMS(time));
-    Serial.print(F(", set index "));
-    Serial.println(set_index);
+  if (LOG_ENABLED(KWLConfig::LogLevelProgram, TRACE)) {
+    LogLine log(LogLevel::TRACE);
+    log.print(F("PROG: check at "));
+    log.print(PrintableHMS(time));
+    log.print(F(", set index "));
+    log.println(set_index);
   }
 
   // iterate all programs and pick one which hits
@@ -99,23 +99,22 @@ void ProgramManager::run()
   }
   if (program != current_program_) {
     // switch programs
-    if (KWLConfig::serialDebugProgram) {
-      Serial.print(F("PROG: new program "));
-      Serial.print(program);
-      Serial.print(F(" active, previous program "));
-      Serial.print(current_program_);
-      Serial.print(F(", set mode="));
+    if (LOG_ENABLED(KWLConfig::LogLevelProgram, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("PROG: new program "));
+      log.print(program);
+      log.print(F(" active, previous program "));
+      log.print(current_program_);
+      log.print(F(", set mode="));
     }
     if (program >= 0) {
       auto& prog = config_.getProgram(unsigned(program));
-      if (KWLConfig::serialDebugProgram)
-        Serial.println(prog.fan_mode_);
+      LOG(KWLConfig::LogLevelProgram, TRACE).println(prog.fan_mode_);
       fan_.setVentilationMode(prog.fan_mode_);
     } else {
       // TODO what default to use if no program set? It should be last user
       // settings outside of the program. Or default. For now, set default.
-      if (KWLConfig::serialDebugProgram)
-        Serial.println(KWLConfig::StandardKwlMode);
+      LOG(KWLConfig::LogLevelProgram, TRACE).println(KWLConfig::StandardKwlMode);
       fan_.setVentilationMode(KWLConfig::StandardKwlMode);
     }
     current_program_ = program;
@@ -161,8 +160,7 @@ bool ProgramManager::mqttReceiveMsg(const StringView& topic, const StringView& s
     // set program index
     auto set = s.toInt();
     if (set < 0 || set > 7) {
-      if (KWLConfig::serialDebugProgram)
-        Serial.println(F("PROG: Invalid program set index"));
+      LOG(KWLConfig::LogLevelProgram, TRACE).println(F("PROG: Invalid program set index"));
     } else {
       config_.setProgramSetIndex(uint8_t(set));
       run();  // to pick proper program, if any change
@@ -205,8 +203,7 @@ bool ProgramManager::mqttReceiveMsg(const StringView& topic, const StringView& s
     } else if (valid_index) {
       publishProgram(index);
     } else {
-      if (KWLConfig::serialDebugProgram)
-        Serial.println(F("PROG: Invalid program index"));
+      LOG(KWLConfig::LogLevelProgram, TRACE).println(F("PROG: Invalid program index"));
     }
     publishProgramIndex();
   } else if (command_str == MQTTTopic::SubtopicProgramData) {
@@ -222,32 +219,30 @@ bool ProgramManager::mqttReceiveMsg(const StringView& topic, const StringView& s
     int rc = sscanf(s.c_str(), FORMAT,
                     &start_h, &start_m, &end_h, &end_m, &mode, wd_buf, ps_buf);
     if (rc < 5 || !valid_index) {
-      if (KWLConfig::serialDebugProgram) {
-        Serial.print(F("PROG: Invalid program string or program index, parsed items "));
-        Serial.print(rc);
-        Serial.print('/');
-        Serial.println('7');
+      if (LOG_ENABLED(KWLConfig::LogLevelProgram, TRACE)) {
+        LogLine log(LogLevel::TRACE);
+        log.print(F("PROG: Invalid program string or program index, parsed items "));
+        log.print(rc);
+        log.print('/');
+        log.println('7');
       }
       return true;
     }
     ProgramData prog;
     if (start_h > 23 || start_m > 59) {
-      if (KWLConfig::serialDebugProgram)
-        Serial.println(F("PROG: Invalid start time"));
+      LOG(KWLConfig::LogLevelProgram, TRACE).println(F("PROG: Invalid start time"));
       return true;
     }
     prog.start_h_ = uint8_t(start_h);
     prog.start_m_ = uint8_t(start_m);
     if (end_h > 23 || end_m > 59) {
-      if (KWLConfig::serialDebugProgram)
-        Serial.println(F("PROG: Invalid end time"));
+      LOG(KWLConfig::LogLevelProgram, TRACE).println(F("PROG: Invalid end time"));
       return true;
     }
     prog.end_h_ = uint8_t(end_h);
     prog.end_m_ = uint8_t(end_m);
     if (mode >= KWLConfig::StandardModeCnt) {
-      if (KWLConfig::serialDebugProgram)
-        Serial.println(F("PROG: Invalid mode"));
+      LOG(KWLConfig::LogLevelProgram, TRACE).println(F("PROG: Invalid mode"));
       return true;
     }
     prog.fan_mode_ = uint8_t(mode);
@@ -264,8 +259,7 @@ bool ProgramManager::mqttReceiveMsg(const StringView& topic, const StringView& s
           break;
         default:
           // invalid string
-          if (KWLConfig::serialDebugProgram)
-            Serial.println(F("PROG: Weekdays must be [01]{7}"));
+          LOG(KWLConfig::LogLevelProgram, TRACE).println(F("PROG: Weekdays must be [01]{7}"));
           return true;
         }
       }
@@ -286,8 +280,7 @@ bool ProgramManager::mqttReceiveMsg(const StringView& topic, const StringView& s
           break;
         default:
           // invalid string
-          if (KWLConfig::serialDebugProgram)
-            Serial.println(F("PROG: Program set mask must be [01]{8}"));
+          LOG(KWLConfig::LogLevelProgram, TRACE).println(F("PROG: Program set mask must be [01]{8}"));
           return true;
         }
       }
@@ -312,15 +305,13 @@ bool ProgramManager::mqttReceiveMsg(const StringView& topic, const StringView& s
           break;
         default:
           // invalid string
-          if (KWLConfig::serialDebugProgram)
-            Serial.println(F("PROG: Program set mask must be [01]{8}"));
+          LOG(KWLConfig::LogLevelProgram, TRACE).println(F("PROG: Program set mask must be [01]{8}"));
           return true;
         }
       }
       enableProgram(index, progset);
     } else {
-      if (KWLConfig::serialDebugProgram)
-        Serial.println(F("PROG: Invalid program index"));
+      LOG(KWLConfig::LogLevelProgram, TRACE).println(F("PROG: Invalid program index"));
     }
   } else {
     return false;
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+
+#include "PublishPolicy.h"
+
+#include <StringView.h>
+#include <avr/pgmspace.h>
+#include <stdio.h>
+
+namespace
+{
+  const char NAME_TEMPERATURE[] PROGMEM = "temperature";
+  const char NAME_FAN[] PROGMEM = "fan";
+  const char NAME_DHT[] PROGMEM = "dht";
+  const char NAME_CO2[] PROGMEM = "co2";
+  const char NAME_VOC[] PROGMEM = "voc";
+  const char NAME_BYPASS[] PROGMEM = "bypass";
+
+  /// Group names indexed by PublishGroup.
+  const char* const GROUP_NAMES[] PROGMEM = {
+    NAME_TEMPERATURE, NAME_FAN, NAME_DHT, NAME_CO2, NAME_VOC, NAME_BYPASS
+  };
+
+  static_assert(sizeof(GROUP_NAMES) / sizeof(GROUP_NAMES[0]) == unsigned(PublishGroup::COUNT), "Group names don't match groups");
+}
+
+bool PublishPolicy::parse(const char* s)
+{
+  unsigned d, mn, mx;
+  if (sscanf_P(s, PSTR("%u,%u,%u"), &d, &mn, &mx) != 3)
+    return false;
+  PublishPolicy tmp = { uint16_t(d), uint16_t(mn), uint16_t(mx) };
+  if (!tmp.isValid())
+    return false;
+  *this = tmp;
+  return true;
+}
+
+void PublishPolicy::toString(char* buffer, unsigned size) const
+{
+  snprintf_P(buffer, size, PSTR("%u,%u,%u"), deadband, min_interval, max_interval);
+}
+
+const __FlashStringHelper* PublishPolicy::getGroupName(PublishGroup group)
+{
+  return reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&GROUP_NAMES[uint8_t(group)]));
+}
+
+PublishGroup PublishPolicy::findGroup(const StringView& name)
+{
+  for (uint8_t i = 0; i < uint8_t(PublishGroup::COUNT); ++i)
+    if (name == getGroupName(PublishGroup(i)))
+      return PublishGroup(i);
+  return PublishGroup::COUNT;
+}
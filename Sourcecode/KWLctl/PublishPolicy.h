@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Policy for publishing measured values on change.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+class __FlashStringHelper;
+class StringView;
+
+/// Groups of published values sharing one publish policy.
+enum class PublishGroup : uint8_t
+{
+  TEMPERATURE,  ///< Temperatures T1-T4 and efficiency (deadband in 0.01C).
+  FAN,          ///< Fan speeds (deadband in rpm).
+  DHT,          ///< DHT sensors (deadband in 0.1C for temperature, in % for humidity).
+  CO2,          ///< CO2 sensor (deadband in ppm).
+  VOC,          ///< VOC sensor (deadband in ppm).
+  BYPASS,       ///< Bypass flap state (deadband not used, sent on change).
+  COUNT         ///< Count of groups.
+};
+
+/*!
+ * @brief Policy for publishing measured values on change.
+ *
+ * A value is published after max_interval in any case. After min_interval, it
+ * is published also if it changed by at least deadband since the last message.
+ * This allows trading bandwidth for freshness without recompiling.
+ */
+struct PublishPolicy
+{
+  /// Maximum supported interval in seconds (fits scheduler timeouts in microseconds).
+  static constexpr uint16_t MAX_INTERVAL = 3600;
+
+  /// Minimum change to publish before max_interval, in group-specific units.
+  uint16_t deadband;
+  /// Minimum time between two messages in seconds.
+  uint16_t min_interval;
+  /// Maximum time between two messages in seconds.
+  uint16_t max_interval;
+
+  /*!
+   * @brief Check whether to publish the value.
+   *
+   * @param elapsed time since last message in seconds.
+   * @param change change of the value since last message in group-specific units.
+   * @return @c true, if the value should be published now.
+   */
+  bool shouldPublish(unsigned long elapsed, long change) const
+  {
+    return elapsed >= max_interval ||
+        (elapsed >= min_interval && labs(change) >= long(deadband));
+  }
+
+  /// Check whether the policy is valid (min. interval not above max. interval, max. interval in range).
+  bool isValid() const { return max_interval && max_interval <= MAX_INTERVAL && min_interval <= max_interval; }
+
+  /*!
+   * @brief Parse policy in form "<deadband>,<min_interval>,<max_interval>".
+   *
+   * @param s string to parse.
+   * @return @c true, if parsed successfully and valid, @c false otherwise.
+   */
+  bool parse(const char* s);
+
+  /*!
+   * @brief Format policy in form "<deadband>,<min_interval>,<max_interval>".
+   *
+   * @param buffer,size buffer where to materialize the string (18B suffices).
+   */
+  void toString(char* buffer, unsigned size) const;
+
+  /// Get name of the group used in MQTT topics.
+  static const __FlashStringHelper* getGroupName(PublishGroup group);
+
+  /// Find group by name, returns PublishGroup::COUNT if not found.
+  static PublishGroup findGroup(const StringView& name);
+};
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+
+/*!
+ * @file
+ * @brief Interface of drivers for additional sensors.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+enum class PublishGroup : uint8_t;
+
+/*!
+ * @brief Interface of drivers for additional sensors.
+ *
+ * A driver measures one or more values of a sensor (e.g., temperature and
+ * humidity). Measurements are driven by AdditionalSensors, which runs one
+ * measurement at a time for all registered drivers in round-robin fashion
+ * and publishes measured values according to the publish policy of the
+ * driver's group.
+ *
+ * A measurement is started by start() and, if it needs time, completed by
+ * repeated calls to poll(). The first measurement after startup detects the
+ * sensor, a sensor without valid values is considered not connected.
+ *
+ * To add a new sensor, derive a class from this one, create a static
+ * instance and register it in AdditionalSensors.cpp.
+ */
+class SensorDriver
+{
+public:
+  /// Maximum count of values measured by one sensor.
+  static constexpr uint8_t MAX_VALUES = 2;
+  /// Value of a failed measurement.
+  static constexpr long INVALID_VALUE = -0x7fffffffL - 1;
+
+  /// Unit of a measured value.
+  enum class Unit : uint8_t
+  {
+    CELSIUS,  ///< Temperature in degrees Celsius.
+    PERCENT,  ///< Relative humidity in %.
+    PPM       ///< Concentration of a gas in ppm.
+  };
+
+  /// Description of a measured value.
+  struct ValueInfo
+  {
+    /// MQTT topic to publish the value (without prefix).
+    const __FlashStringHelper* topic;
+    /// Unit of the value (shown in trace log of measurements).
+    Unit unit;
+    /// Count of decimal places of the value (e.g., 1 for value in 0.1C).
+    uint8_t decimals;
+    /// Value units per unit of the deadband of the publish policy.
+    uint8_t deadband_scale;
+  };
+
+  SensorDriver(const SensorDriver&) = delete;
+  SensorDriver& operator=(const SensorDriver&) = delete;
+
+  /*!
+   * @brief Construct the driver.
+   *
+   * @param name name of the sensor for logging.
+   * @param group publish group with publish policy for sensor values.
+   * @param value_count count of measured values (at most MAX_VALUES).
+   * @param interval time between two measurements in ms.
+   * @param startup_delay time after begin() before the first measurement in ms.
+   */
+  SensorDriver(const __FlashStringHelper* name, PublishGroup group, uint8_t value_count, uint16_t interval, uint16_t startup_delay) noexcept :
+    name_(name), group_(group), value_count_(value_count), interval_(interval), startup_delay_(startup_delay)
+  {}
+
+  /*!
+   * @brief Initialize the sensor.
+   *
+   * @return @c false, if the sensor is certainly not connected.
+   */
+  virtual bool begin() noexcept = 0;
+
+  /*!
+   * @brief Start a measurement.
+   *
+   * @return time in microseconds until the next call to poll() or 0, if the
+   *    measurement already finished.
+   */
+  virtual unsigned long start() noexcept = 0;
+
+  /*!
+   * @brief Continue the measurement.
+   *
+   * @return time in microseconds until the next call to poll() or 0, if the
+   *    measurement finished.
+   */
+  virtual unsigned long poll() noexcept { return 0; }
+
+  /*!
+   * @brief Get the value of the last measurement.
+   *
+   * @param index index of the value.
+   * @return value in units given by getValueInfo() or INVALID_VALUE, if
+   *    the measurement failed.
+   */
+  virtual long getValue(uint8_t index) const noexcept = 0;
+
+  /// Get description of a value.
+  virtual ValueInfo getValueInfo(uint8_t index) const noexcept = 0;
+
+  /// Get name of the sensor.
+  const __FlashStringHelper* getName() const noexcept { return name_; }
+
+  /// Get publish group of sensor values.
+  PublishGroup getPublishGroup() const noexcept { return group_; }
+
+  /// Get count of measured values.
+  uint8_t getValueCount() const noexcept { return value_count_; }
+
+  /// Check whether the sensor was detected.
+  bool isPresent() const noexcept { return state_ == State::PRESENT; }
+
+  /// Check whether the sensor is still being detected.
+  bool isDetecting() const noexcept { return state_ == State::DETECTING; }
+
+private:
+  friend class AdditionalSensors;
+
+  /// Detection state of the sensor.
+  enum class State : uint8_t
+  {
+    ABSENT,     ///< Sensor not registered or not connected.
+    DETECTING,  ///< Waiting for the first measurement.
+    PRESENT     ///< Sensor detected.
+  };
+
+  // Configuration
+  const __FlashStringHelper* name_;
+  PublishGroup group_;
+  uint8_t value_count_;
+  uint16_t interval_;
+  uint16_t startup_delay_;
+
+  // Bookkeeping of AdditionalSensors
+  State state_ = State::ABSENT;
+  uint16_t send_ticks_ = 0;
+  unsigned long next_start_ = 0;
+  long last_sent_[MAX_VALUES] = { INVALID_VALUE, INVALID_VALUE };
+};
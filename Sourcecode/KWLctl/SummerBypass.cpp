@@ -24,12 +24,11 @@
 #include "TempSensors.h"
 #include "KWLConfig.h"
 
+#include <Logger.h>
+
 /// Check bypass every 20s (also terminates motor running, if needed).
 static constexpr unsigned long INTERVAL_BYPASS_CHECK = 20000000;
 
-/// Interval for sending MQTT messages when nothing changes (15 min).
-static constexpr unsigned long INTERVAL_MQTT_BYPASS_STATE = 900000000UL;
-
 /// Runtime of the bypass motor in ms (2 minutes).
 static constexpr unsigned long BYPASS_FLAPS_DRIVE_TIME = 120 * 1000000UL;
 
@@ -80,10 +79,11 @@ const __FlashStringHelper* SummerBypass::toString(SummerBypassFlapState state)
 
 void SummerBypass::run()
 {
+  LogLine log(LogLevel::TRACE);
   // Bedingungen für Sommer Bypass überprüfen und Variable ggfs setzen
-  if (KWLConfig::serialDebugSummerbypass) {
-    Serial.print(F("BYPASS: state "));
-    Serial.print(toString(flap_setpoint_));
+  if (LOG_ENABLED(KWLConfig::LogLevelSummerbypass, TRACE)) {
+    log.print(F("BYPASS: state "));
+    log.print(toString(flap_setpoint_));
   }
   if (bypass_motor_running_) {
     // check whether we are done with running the motor (just to be on the safe side, should be)
@@ -92,16 +92,16 @@ void SummerBypass::run()
       rel_bypass_power_.off();
       rel_bypass_direction_.off();
       state_ = flap_setpoint_;
-      if (KWLConfig::serialDebugSummerbypass)
-        Serial.print(F(" motor off; flap now "));
+      if (LOG_ENABLED(KWLConfig::LogLevelSummerbypass, TRACE))
+        log.print(F(" motor off; flap now "));
       bypass_motor_running_ = false;
     } else {
       // should never get here, we'll retry
-      if (KWLConfig::serialDebugSummerbypass)
-        Serial.print(F(" motor running; flap going to "));
+      if (LOG_ENABLED(KWLConfig::LogLevelSummerbypass, TRACE))
+        log.print(F(" motor running; flap going to "));
     }
-    if (KWLConfig::serialDebugSummerbypass)
-      Serial.println(toString(flap_setpoint_));
+    if (LOG_ENABLED(KWLConfig::LogLevelSummerbypass, TRACE))
+      log.println(toString(flap_setpoint_));
     sendMQTT();
     timer_task_.setInterval(INTERVAL_BYPASS_CHECK);
     return;
@@ -112,8 +112,7 @@ void SummerBypass::run()
   if (config_.getBypassMode() == SummerBypassMode::AUTO) {
     // Automatic - first compute desired state based on current values
     SummerBypassFlapState desired_setpoint = SummerBypassFlapState::UNKNOWN;
-    if ((temp_.get_t1_outside() > TempSensors::INVALID)
-        && (temp_.get_t3_outlet() > TempSensors::INVALID)) {
+    if (temp_.get_t1_outside().isValid() && temp_.get_t3_outlet().isValid()) {
       if ((temp_.get_t1_outside() < temp_.get_t3_outlet() - config_.getBypassHysteresisTemp())  // TODO configurable
           && (temp_.get_t3_outlet() > config_.getBypassTempAbluftMin())
           && (temp_.get_t1_outside() > config_.getBypassTempAussenluftMin())) {
@@ -124,22 +123,22 @@ void SummerBypass::run()
         desired_setpoint = SummerBypassFlapState::CLOSED;
       }
     } else {
-      if (KWLConfig::serialDebugSummerbypass)
-        Serial.print(F(" T1/T3 SENSOR ERROR"));
+      if (LOG_ENABLED(KWLConfig::LogLevelSummerbypass, TRACE))
+        log.print(F(" T1/T3 SENSOR ERROR"));
     }
-    if (KWLConfig::serialDebugSummerbypass) {
-      Serial.print(F(" auto check T1="));
-      Serial.print(temp_.get_t1_outside());
-      Serial.print('>');
-      Serial.print(config_.getBypassTempAussenluftMin());
-      Serial.print(F(" && T3="));
-      Serial.print(temp_.get_t3_outlet());
-      Serial.print('>');
-      Serial.print(config_.getBypassTempAbluftMin());
-      Serial.print(F(" && T3-T1>"));
-      Serial.print(config_.getBypassHysteresisTemp());
-      Serial.print(F(", desired state: "));
-      Serial.print(toString(desired_setpoint));
+    if (LOG_ENABLED(KWLConfig::LogLevelSummerbypass, TRACE)) {
+      log.print(F(" auto check T1="));
+      log.print(PrintableCentiCelsius(temp_.get_t1_outside()));
+      log.print('>');
+      log.print(PrintableCentiCelsius(config_.getBypassTempAussenluftMin()));
+      log.print(F(" && T3="));
+      log.print(PrintableCentiCelsius(temp_.get_t3_outlet()));
+      log.print('>');
+      log.print(PrintableCentiCelsius(config_.getBypassTempAbluftMin()));
+      log.print(F(" && T3-T1>"));
+      log.print(PrintableCentiCelsius(config_.getBypassHysteresisTemp()));
+      log.print(F(", desired state: "));
+      log.print(toString(desired_setpoint));
     }
 
     if (desired_setpoint != SummerBypassFlapState::UNKNOWN && desired_setpoint != flap_setpoint_) {
@@ -150,32 +149,32 @@ void SummerBypass::run()
         flap_setpoint_ = desired_setpoint;
         changed = true;
       } else {
-        if (KWLConfig::serialDebugSummerbypass)
-          Serial.print(F(" hysteresis"));
+        if (LOG_ENABLED(KWLConfig::LogLevelSummerbypass, TRACE))
+          log.print(F(" hysteresis"));
       }
     }
   } else {
     // Manuelle Schaltung
     if (config_.getBypassManualSetpoint() != flap_setpoint_) {
       flap_setpoint_ = config_.getBypassManualSetpoint();
-      if (KWLConfig::serialDebugSummerbypass)
-        Serial.print(F(" manual"));
+      if (LOG_ENABLED(KWLConfig::LogLevelSummerbypass, TRACE))
+        log.print(F(" manual"));
       changed = true;
     }
   }
 
   if (changed) {
-    if (KWLConfig::serialDebugSummerbypass) {
-      Serial.print(F(" change to "));
-      Serial.println(toString(flap_setpoint_));
+    if (LOG_ENABLED(KWLConfig::LogLevelSummerbypass, TRACE)) {
+      log.print(F(" change to "));
+      log.println(toString(flap_setpoint_));
     }
     // TODO start the motor, send MQTT message
     last_change_time_millis_ = millis();
     startMoveFlap();
     timer_task_.setInterval(BYPASS_FLAPS_DRIVE_TIME);
   } else {
-    if (KWLConfig::serialDebugSummerbypass)
-      Serial.println(F(" no change"));
+    if (LOG_ENABLED(KWLConfig::LogLevelSummerbypass, TRACE))
+      log.println(F(" no change"));
     timer_task_.setInterval(INTERVAL_BYPASS_CHECK);
   }
   if (--mqtt_countdown_ <= 0 || mqtt_state_ != state_) {
@@ -211,19 +210,19 @@ bool SummerBypass::mqttReceiveMsg(const StringView& topic, const StringView& s)
         i = 0;
       if (i > MAX_TEMP_HYSTERESIS)
         i = MAX_TEMP_HYSTERESIS;
-      config_.setBypassHysteresisTemp(uint8_t(i));
+      config_.setBypassHysteresisTemp(CentiCelsius::fromDegrees(int(i)));
       forceSend(true);
   } else if (topic == MQTTTopic::CmdBypassTempAbluftMin) {
       auto i = s.toInt();
       if (i < 0)
         i = 0;
-      config_.setBypassTempAbluftMin(unsigned(i));
+      config_.setBypassTempAbluftMin(CentiCelsius::fromDegrees(int(i)));
       forceSend(true);
   } else if (topic == MQTTTopic::CmdBypassTempAussenluftMin) {
       auto i = s.toInt();
       if (i < 0)
         i = 0;
-      config_.setBypassTempAussenluftMin(unsigned(i));
+      config_.setBypassTempAussenluftMin(CentiCelsius::fromDegrees(int(i)));
       forceSend(true);
   } else {
     return false;
@@ -248,7 +247,9 @@ void SummerBypass::startMoveFlap()
 
 void SummerBypass::sendMQTT(bool all_values)
 {
-  mqtt_countdown_ = INTERVAL_MQTT_BYPASS_STATE / INTERVAL_BYPASS_CHECK;
+  // send unchanged state again after max. interval of the publish policy
+  static constexpr unsigned CHECK_INTERVAL_S = unsigned(INTERVAL_BYPASS_CHECK / 1000000);
+  mqtt_countdown_ = int16_t((config_.getPublishPolicy(PublishGroup::BYPASS).max_interval + CHECK_INTERVAL_S - 1UL) / CHECK_INTERVAL_S);
   mqtt_state_ = state_;
 
   uint8_t bitmask = all_values ? 31 : 1;
@@ -259,9 +260,9 @@ void SummerBypass::sendMQTT(bool all_values)
                     (config_.getBypassMode() == SummerBypassMode::AUTO) ? F("auto") : F("manual"),
                     KWLConfig::RetainBypassConfigState))
       return false;
-    if (!publish_if(bitmask, uint8_t(4), MQTTTopic::KwlBypassTempAbluftMin, config_.getBypassTempAbluftMin(), KWLConfig::RetainBypassConfigState))
+    if (!publish_if(bitmask, uint8_t(4), MQTTTopic::KwlBypassTempAbluftMin, config_.getBypassTempAbluftMin().toDegrees(), KWLConfig::RetainBypassConfigState))
       return false;
-    if (!publish_if(bitmask, uint8_t(8), MQTTTopic::KwlBypassTempAussenluftMin, config_.getBypassTempAussenluftMin(), KWLConfig::RetainBypassConfigState))
+    if (!publish_if(bitmask, uint8_t(8), MQTTTopic::KwlBypassTempAussenluftMin, config_.getBypassTempAussenluftMin().toDegrees(), KWLConfig::RetainBypassConfigState))
       return false;
     if (!publish_if(bitmask, uint8_t(16), MQTTTopic::KwlBypassHystereseMinutes, config_.getBypassHystereseMinutes(), KWLConfig::RetainBypassConfigState))
       return false;
@@ -101,7 +101,7 @@ private:
   /// Set when motor is running and moving the flap.
   bool bypass_motor_running_ = false;
   /// Countdown for MQTT send.
-  int8_t mqtt_countdown_ = 0;
+  int16_t mqtt_countdown_ = 0;
   /// Task to publish MQTT values.
   PublishTask publish_task_;
   /// Task runtime statistics.
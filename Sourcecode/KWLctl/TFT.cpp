@@ -40,9 +40,16 @@
 static constexpr int16_t MINPRESSURE = 20;
 /// Maximum acceptable pressure.
 static constexpr int16_t MAXPRESSURE = 1000;
+/// Runtime budget of touch processing (2s), saving settings from a screen writes EEPROM.
+static constexpr uint16_t PROCESS_TOUCH_BUDGET_MS = 2000;
 
 #define SWAP(a, b) {auto tmp = a; a = b; b = tmp;}
 
+/// Displayed temperature of a sensor which is still being detected.
+static constexpr CentiCelsius PENDING_TEMP = CentiCelsius(-31000);
+/// Displayed value of a sensor which is still being detected.
+static constexpr int PENDING_VALUE = -2000;
+
 // Timing:
 
 /// Interval for updating displayed values (1s).
@@ -386,8 +393,7 @@ protected:
     Screen::init();
 
     // make screen black
-    if (KWLConfig::serialDebugDisplay)
-      Serial.println(F("TFT: Display off"));
+    LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: Display off"));
     // since we can't really turn off the display, make it at least black
     tft_.fillScreen(TFT_BLACK);
 
@@ -439,8 +445,7 @@ protected:
       return true;
 
     if (time - millis_screen_blank_ >= SCREEN_OFF_MIN_TIME) {
-      if (KWLConfig::serialDebugDisplay)
-        Serial.println(F("TFT: Display on"));
+      LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: Display on"));
       clear_state();
       // now redraw everything
       gotoScreen<ScreenMain>();
@@ -562,8 +567,7 @@ protected:
         timeout = POPUP_FLAG_TIMEOUT_MS;
       if (millis() - millis_popup_show_time_ > timeout) {
         // popup timed out, do the default action
-        if (KWLConfig::serialDebugDisplay)
-          Serial.println(F("TFT: Popup timed out"));
+        LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: Popup timed out"));
         auto tmp = popup_action_;
         popup_action_ = nullptr;
         (this->*tmp)();
@@ -712,9 +716,10 @@ protected:
       if (idx < popup_flags_->flag_count_) {
         // flip the flag
         if (time - millis_popup_show_time_ >= INTERVAL_MENU_BTN) {
-          if (KWLConfig::serialDebugDisplay) {
-            Serial.print(F("TFT: Popup flag touched: "));
-            Serial.println(idx);
+          if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+            LogLine log(LogLevel::TRACE);
+            log.print(F("TFT: Popup flag touched: "));
+            log.println(idx);
           }
           *popup_flags_->flags_ ^= uint8_t(1U << idx);
           drawPopupFlag(idx);
@@ -730,8 +735,7 @@ protected:
       // popup button hit, call action
       auto tmp = popup_action_;
       popup_action_ = nullptr;
-      if (KWLConfig::serialDebugDisplay)
-        Serial.println(F("TFT: Popup OK button touched"));
+      LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: Popup OK button touched"));
       (this->*tmp)();
       return true;
     }
@@ -1008,7 +1012,7 @@ public:
   void newMenuEntry(byte mnuBtn, const __FlashStringHelper* mnuTxt, Func&& action) noexcept
   {
     if (mnuBtn < 1 || mnuBtn > btn_count_) {
-      Serial.println(F("Trying to set menu action for invalid index"));
+      LOG(KWLConfig::LogLevelDisplay, WARNING).println(F("Trying to set menu action for invalid index"));
       return;
     }
     menu_btn_action_[mnuBtn - 1] = action;
@@ -1037,7 +1041,7 @@ public:
   void newMenuEntry(byte mnuBtn, const uint8_t mnuIcon[], uint8_t iconSize, Func&& action, uint16_t color = colMenuFontColor) noexcept
   {
     if (mnuBtn < 1 || mnuBtn > btn_count_) {
-      Serial.println(F("Trying to set menu action for invalid index"));
+      LOG(KWLConfig::LogLevelDisplay, WARNING).println(F("Trying to set menu action for invalid index"));
       return;
     }
     menu_btn_action_[mnuBtn - 1] = action;
@@ -1073,9 +1077,10 @@ protected:
         // touched a menu button
         millis_last_menu_btn_press_ = time;
 
-        if (KWLConfig::serialDebugDisplay) {
-          Serial.print(F("TFT: menu button touched: "));
-          Serial.println(button);
+        if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+          LogLine log(LogLevel::TRACE);
+          log.print(F("TFT: menu button touched: "));
+          log.println(button);
         }
 
         if (menu_btn_action_[button]) {
@@ -1434,17 +1439,18 @@ protected:
       if (col < INPUT_COL_COUNT && (mask & (uint8_t(1) << col)) != 0) {
         // active input field
         ++row;
-        if (KWLConfig::serialDebugDisplay) {
-          Serial.print(F("TFT: Input field touched: row="));
-          Serial.print(row);
-          Serial.print(F(", col="));
-          Serial.print(col);
-          Serial.print(F("; cx/w/x="));
-          Serial.print(cx);
-          Serial.print('/');
-          Serial.print(w);
-          Serial.print('/');
-          Serial.println(x);
+        if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+          LogLine log(LogLevel::TRACE);
+          log.print(F("TFT: Input field touched: row="));
+          log.print(row);
+          log.print(F(", col="));
+          log.print(col);
+          log.print(F("; cx/w/x="));
+          log.print(cx);
+          log.print('/');
+          log.print(w);
+          log.print('/');
+          log.println(x);
         }
         if (input_current_row_ != row || input_current_col_ != col) {
           if (input_current_row_) {
@@ -1678,10 +1684,10 @@ protected:
     // Now update various sensor readings
     tft_.setFont(&FreeSans12pt7b);
     // T1-T4
-    update_temp(XX, XY + 10, t1_, temp.get_t1_outside(), false);
-    update_temp(XX + 161, XY + 125 - HEIGHT_NUMBER_FIELD, t2_, temp.get_t2_inlet(), true);
-    update_temp(XX + 161, XY + 10, t3_, temp.get_t3_outlet(), true);
-    update_temp(XX, XY + 125 - HEIGHT_NUMBER_FIELD, t4_, temp.get_t4_exhaust(), false);
+    update_temp(XX, XY + 10, t1_, temp.get_t1_outside(), false, temp.isPending(0));
+    update_temp(XX + 161, XY + 125 - HEIGHT_NUMBER_FIELD, t2_, temp.get_t2_inlet(), true, temp.isPending(1));
+    update_temp(XX + 161, XY + 10, t3_, temp.get_t3_outlet(), true, temp.isPending(2));
+    update_temp(XX, XY + 125 - HEIGHT_NUMBER_FIELD, t4_, temp.get_t4_exhaust(), false, temp.isPending(3));
     // Fans (exhaust is on the top)
     update_fan(XX + 162, XY + 10 + HEIGHT_NUMBER_FIELD + 4, tacho_fan2_, int(fan.getFan2().getSpeed()));
     update_fan(XX + 162, XY + 125 - 2 * HEIGHT_NUMBER_FIELD - 4, tacho_fan1_, int(fan.getFan1().getSpeed()));
@@ -1720,11 +1726,11 @@ protected:
     if (addt.hasDHT1())
       update_dht(HX + 35, HY + 175 - 54, dht1t_, dht1h_, addt.getDHT1Temp(), addt.getDHT1Hum());
     else
-      update_dht(HX + 35, HY + 175 - 54, dht1t_, dht1h_, -999, -99);
+      update_dht(HX + 35, HY + 175 - 54, dht1t_, dht1h_, -999, -99, addt.isPending());
     if (addt.hasDHT2())
       update_dht(HX + 35, HY + 230 - 54, dht2t_, dht2h_, addt.getDHT2Temp(), addt.getDHT2Hum());
     else
-      update_dht(HX + 35, HY + 230 - 54, dht2t_, dht2h_, -999, -99);
+      update_dht(HX + 35, HY + 230 - 54, dht2t_, dht2h_, -999, -99, addt.isPending());
     if (addt.hasVOC())
       update_qual(HX + 35, HY + 120 - 54, voc_, addt.getVOC());
     else
@@ -1732,7 +1738,7 @@ protected:
     if (addt.hasCO2())
       update_qual(HX + 35, HY + 120 - 30, co2_, addt.getCO2());
     else
-      update_qual(HX + 35, HY + 120 - 30, co2_, -1);
+      update_qual(HX + 35, HY + 120 - 30, co2_, -1, addt.isPending());
 
     ScreenWithMenuButtons::update();
   }
@@ -1744,8 +1750,7 @@ protected:
     if (!touch_start_) {
       touch_start_ = time;
     } else if (time - touch_start_ > CALIBRATION_TIME) {
-      if (KWLConfig::serialDebugDisplay)
-        Serial.println(F("TFT: Very long touch detected, starting touch calibration"));
+      LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: Very long touch detected, starting touch calibration"));
       gotoScreen<TFT::ScreenCalibration>();
       return true;
     }
@@ -1760,24 +1765,26 @@ protected:
 
 private:
   /// Update temperature reading, if needed.
-  void update_temp(int x, int y, float& last, double cur, bool ralign) noexcept
+  void update_temp(int x, int y, CentiCelsius& last, CentiCelsius cur, bool ralign, bool pending = false) noexcept
   {
-    auto f = float(cur);
-    auto delta = last - f;
-    if (delta >= 0.1F || delta <= -0.1F) {
-      last = f;
+    if (pending)
+      cur = PENDING_TEMP;
+    auto delta = (last - cur).absolute();
+    if (delta >= CentiCelsius(10) || last.isValid() != cur.isValid()) {
+      last = cur;
       char buffer[10];
       int16_t x1, y1;
       uint16_t w, h;
       uint16_t fill_color = colBackColor + DEBUG_HIGHLIGHT;
       tft_.setTextColor(colFontColor);
-      if (cur > -126 && cur < 150) {
-        if (cur < -99.9)
-          cur = -99.9;
-        else if (cur > 99.9)
-          cur = 99.9;
-        dtostrf(cur, 3, 1, buffer);
-        strcat_P(buffer, PSTR("*C"));
+      if (pending) {
+        // sensor is still being detected
+        strcpy_P(buffer, PSTR("... *C"));
+      } else if (cur.isValid() && cur < CentiCelsius::fromDegrees(150)) {
+        // rounded to 0.1C, limited to -99.9..99.9
+        auto v = constrain(int(cur.toCenti()), -9990, 9990);
+        unsigned tenths = unsigned((v < 0 ? -v : v) + 5) / 10;
+        snprintf_P(buffer, sizeof(buffer), PSTR("%s%u.%u*C"), v < 0 ? "-" : "", tenths / 10, tenths % 10);
       } else if (&last == &dht1t_ || &last == &dht2t_) {
         // for DHT not present, we just display n/a, not an error
         strcpy_P(buffer, PSTR("n/a *C"));
@@ -1834,10 +1841,10 @@ private:
   }
 
   /// Update DHT sensor reading, if needed.
-  void update_dht(int x, int y, float& last_t, int& last_h, float cur_t, float cur_h)
+  void update_dht(int x, int y, CentiCelsius& last_t, int& last_h, float cur_t, float cur_h, bool pending = false)
   {
-    update_temp(x, y, last_t, double(cur_t), false);
-    auto h = int(cur_h);
+    update_temp(x, y, last_t, CentiCelsius::fromDouble(double(cur_t)), false, pending);
+    auto h = pending ? PENDING_VALUE : int(cur_h);
     if (h != last_h) {
       last_h = h;
       char buffer[8];
@@ -1846,6 +1853,8 @@ private:
       tft_.fillRect(x, y + 24, 80, HEIGHT_NUMBER_FIELD, colBackColor + DEBUG_HIGHLIGHT);
       if (h >= 0 && h <= 100)
         snprintf_P(buffer, sizeof(buffer), PSTR("%d %%"), h);
+      else if (pending)
+        strcpy_P(buffer, PSTR("... %"));
       else
         strcpy_P(buffer, PSTR("n/a %"));
       tft_.getTextBounds(buffer, 0, 0, &x1, &y1, &tw, &th);
@@ -1855,8 +1864,10 @@ private:
   }
 
   /// Update air quality reading, if needed.
-  void update_qual(int x, int y, int& last, int cur) noexcept
+  void update_qual(int x, int y, int& last, int cur, bool pending = false) noexcept
   {
+    if (pending)
+      cur = PENDING_VALUE;
     if (cur > 9999)
       cur = 9999;
     auto delta = last - cur;
@@ -1868,6 +1879,8 @@ private:
       tft_.fillRect(x, y, 80, HEIGHT_NUMBER_FIELD, colBackColor + DEBUG_HIGHLIGHT);
       if (cur >= 0)
         snprintf(buffer, sizeof(buffer), "%d/m", cur);
+      else if (pending)
+        strcpy_P(buffer, PSTR("..."));
       else
         strcpy_P(buffer, PSTR("n/a"));
       tft_.getTextBounds(buffer, 0, 0, &x1, &y1, &w, &h);
@@ -1884,7 +1897,8 @@ private:
   int kwl_mode_ = -1;
   int8_t symbol_ = -1;
   int efficiency_ = -100;
-  float t1_ = -1000, t2_ = -1000, t3_ = -1000, t4_ = -1000, dht1t_ = -1000, dht2t_ = -1000;
+  /// Last displayed temperatures (initially out of range to force display).
+  CentiCelsius t1_{-32000}, t2_{-32000}, t3_{-32000}, t4_{-32000}, dht1t_{-32000}, dht2t_{-32000};
   int dht1h_ = -1000, dht2h_ = -1000, voc_ = -1000, co2_ = -1000;
   uint8_t program_set_ = 255; ///< Active program set.
   int8_t program_index_ = -1; ///< Active program index.
@@ -2525,9 +2539,9 @@ public:
   {
     // copy current state
     auto& config = getControl().getPersistentConfig();
-    temp_outside_min_ = config.getBypassTempAussenluftMin();
-    temp_outtake_min_ = config.getBypassTempAbluftMin();
-    temp_hysteresis_ = config.getBypassHysteresisTemp();
+    temp_outside_min_ = unsigned(config.getBypassTempAussenluftMin().toDegrees());
+    temp_outtake_min_ = unsigned(config.getBypassTempAbluftMin().toDegrees());
+    temp_hysteresis_ = unsigned(config.getBypassHysteresisTemp().toDegrees());
     min_hysteresis_ = config.getBypassHystereseMinutes();
     if (config.getBypassMode() == SummerBypassMode::USER)
       mode_ = unsigned(config.getBypassManualSetpoint());  // manual (1=closed, 2=open)
@@ -2568,9 +2582,9 @@ protected:
       [this]() noexcept {
         resetInput();
         auto& config = getControl().getPersistentConfig();
-        config.setBypassTempAussenluftMin(temp_outside_min_);
-        config.setBypassTempAbluftMin(temp_outtake_min_);
-        config.setBypassHysteresisTemp(uint8_t(temp_hysteresis_));
+        config.setBypassTempAussenluftMin(CentiCelsius::fromDegrees(int(temp_outside_min_)));
+        config.setBypassTempAbluftMin(CentiCelsius::fromDegrees(int(temp_outtake_min_)));
+        config.setBypassHysteresisTemp(CentiCelsius::fromDegrees(int(temp_hysteresis_)));
         config.setBypassHystereseMinutes(min_hysteresis_);
         if (mode_ == unsigned(SummerBypassFlapState::UNKNOWN)) {
           config.setBypassMode(SummerBypassMode::AUTO);
@@ -2770,7 +2784,7 @@ public:
   {
     // copy current state
     auto& config = getControl().getPersistentConfig();
-    temp_hysteresis_ = config.getAntifreezeHystereseTemp();
+    temp_hysteresis_ = unsigned(config.getAntifreezeHystereseTemp().toDegrees());
     heating_app_ = config.getHeatingAppCombUse();
   }
 
@@ -2823,7 +2837,7 @@ protected:
       [this]() noexcept {
         resetInput();
         auto& config = getControl().getPersistentConfig();
-        config.setAntifreezeHystereseTemp(temp_hysteresis_);
+        config.setAntifreezeHystereseTemp(CentiCelsius::fromDegrees(int(temp_hysteresis_)));
         config.setHeatingAppCombUse(heating_app_);
         getControl().getAntifreeze().begin(Serial);  // restart antifreeze
         doPopup<ScreenSetup>(
@@ -3123,7 +3137,7 @@ protected:
     );
     newMenuEntry(6, icon_ok_40x40, 40,
       [this]() noexcept {
-        Serial.print(F("Speicherbereich wird geloescht... "));
+        LOG(KWLConfig::LogLevelDisplay, INFO).println(F("Speicherbereich wird geloescht"));
         tft_.setFont(&FreeSans9pt7b);
         tft_.setTextColor(colFontColor, colBackColor);
         tft_.setCursor(18, 220 + BASELINE_MIDDLE);
@@ -3131,7 +3145,6 @@ protected:
 
         getControl().getPersistentConfig().factoryReset();
         tft_.println(F("OK"));
-        Serial.println(F("OK"));
 
         doRestart(
           F("Einstellungen gespeichert"),
@@ -3204,11 +3217,12 @@ private:
       touch_start_time_ = time;
 
     auto delta = time - touch_start_time_;
-    if (KWLConfig::serialDebugDisplay) {
-      Serial.print(F("TFT: calibration touch delta ms="));
-      Serial.print(delta);
-      Serial.print(F(" in stage "));
-      Serial.println(stage_);
+    if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("TFT: calibration touch delta ms="));
+      log.print(delta);
+      log.print(F(" in stage "));
+      log.println(stage_);
     }
     if (stage_ < 0) {
       if (delta > 200) {
@@ -3234,8 +3248,7 @@ private:
 
   virtual void release(unsigned long time) noexcept override
   {
-    if (KWLConfig::serialDebugDisplay)
-      Serial.println(F("TFT: calibration touch release"));
+    LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: calibration touch release"));
     touch_start_time_ = 0;
   }
 
@@ -3249,9 +3262,10 @@ private:
   /// Start the next measurement.
   void startMeasurement() noexcept
   {
-    if (KWLConfig::serialDebugDisplay) {
-      Serial.print(F("TFT: starting calibration measurement "));
-      Serial.println(stage_);
+    if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("TFT: starting calibration measurement "));
+      log.println(stage_);
     }
     int16_t x;
     int16_t y;
@@ -3282,17 +3296,18 @@ private:
   void finish() noexcept
   {
     drawMarker(m_x_, m_y_, TFT_BLACK);
-    if (KWLConfig::serialDebugDisplay) {
-      Serial.print(F("TFT: Calibration points:"));
+    if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("TFT: Calibration points:"));
       for (uint8_t i = 0; i < 4; ++i) {
-        Serial.print(' ');
-        Serial.print('(');
-        Serial.print(x_[i]);
-        Serial.print(',');
-        Serial.print(y_[i]);
-        Serial.print(')');
+        log.print(' ');
+        log.print('(');
+        log.print(x_[i]);
+        log.print(',');
+        log.print(y_[i]);
+        log.print(')');
       }
-      Serial.println();
+      log.println();
     }
 
     TouchCalibration cal;
@@ -3300,8 +3315,7 @@ private:
     // detect X/Y swap
     if (abs(x_[0] - x_[2]) > abs(x_[0] - x_[1])) {
       // swapped X/Y
-      if (KWLConfig::serialDebugDisplay)
-        Serial.println(F("TFT: detected swapped X/Y axis"));
+      LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: detected swapped X/Y axis"));
       cal.swap_xy_ = true;
       for (uint8_t i = 0; i < 4; ++i) {
         auto t = x_[i];
@@ -3325,16 +3339,17 @@ private:
     cal.bottom_ = uint16_t(cal.top_ + (diff_per_pixel * tft_.height()));
     cal.calibrated_ = true;
 
-    if (KWLConfig::serialDebugDisplay) {
-      Serial.print(F("TFT: New calibration: X: ("));
-      Serial.print(cal.left_);
-      Serial.print(',');
-      Serial.print(cal.right_);
-      Serial.print(F("), Y: ("));
-      Serial.print(cal.top_);
-      Serial.print(',');
-      Serial.print(cal.bottom_);
-      Serial.println(')');
+    if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("TFT: New calibration: X: ("));
+      log.print(cal.left_);
+      log.print(',');
+      log.print(cal.right_);
+      log.print(F("), Y: ("));
+      log.print(cal.top_);
+      log.print(',');
+      log.print(cal.bottom_);
+      log.println(')');
     }
 
     // store in EEPROM
@@ -3361,17 +3376,17 @@ void TFT::Screen::update() noexcept
   auto time = millis() - last_input_time_;
   if (time > INTERVAL_DISPLAY_TIMEOUT) {
     // turn off display
-    if (KWLConfig::serialDebugDisplay)
-      Serial.println(F("TFT: Display timed out, turning it off"));
+    LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: Display timed out, turning it off"));
     gotoScreen<ScreenSaver>();
     return;
   } else if (time > INTERVAL_TOUCH_TIMEOUT) {
     // go to main screen if too long not touched
     if (owner_.current_screen_id_ != ScreenMain::ID) {
       // current screen is not the main screen
-      if (KWLConfig::serialDebugDisplay) {
-        Serial.print(F("TFT: Touch timeout, go to main screen, previous="));
-        Serial.println(owner_.current_screen_id_);
+      if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+        LogLine log(LogLevel::TRACE);
+        log.print(F("TFT: Touch timeout, go to main screen, previous="));
+        log.println(owner_.current_screen_id_);
       }
       gotoScreen<ScreenMain>();
     }
@@ -3385,7 +3400,7 @@ TFT::TFT() noexcept :
   ts_(KWLConfig::XP, KWLConfig::YP, KWLConfig::XM, KWLConfig::YM, 300),
   display_update_stats_(F("DisplayUpdate")),
   display_update_task_(display_update_stats_, &TFT::displayUpdate, *this),
-  process_touch_stats_(F("ProcessTouch")),
+  process_touch_stats_(F("ProcessTouch"), PROCESS_TOUCH_BUDGET_MS),
   process_touch_task_(process_touch_stats_, &TFT::loopTouch, *this)
 {}
 
@@ -3395,21 +3410,21 @@ void TFT::begin(Print& /*initTracer*/, KWLControl& control) noexcept {
 
   cal_ = &control.getPersistentConfig().getTouchCalibration();
   if (cal_->calibrated_) {
-    if (KWLConfig::serialDebugDisplay) {
-      Serial.print(F("TFT: Calibration is: LEFT = "));
-      Serial.print(cal_->left_);
-      Serial.print(F(" RT = "));
-      Serial.print(cal_->right_);
-      Serial.print(F(" TOP = "));
-      Serial.print(cal_->top_);
-      Serial.print(F(" BOT = "));
-      Serial.println(cal_->bottom_);
-      Serial.print(F("TFT: Wiring is: "));
-      Serial.println(cal_->swap_xy_ ? F("SwapXY") : F("PORTRAIT"));
+    if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("TFT: Calibration is: LEFT = "));
+      log.print(cal_->left_);
+      log.print(F(" RT = "));
+      log.print(cal_->right_);
+      log.print(F(" TOP = "));
+      log.print(cal_->top_);
+      log.print(F(" BOT = "));
+      log.println(cal_->bottom_);
+      log.print(F("TFT: Wiring is: "));
+      log.println(cal_->swap_xy_ ? F("SwapXY") : F("PORTRAIT"));
     }
   } else {
-    if (KWLConfig::serialDebugDisplay)
-      Serial.println(F("TFT: No calibration yet"));
+    LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: No calibration yet"));
   }
 }
 
@@ -3424,9 +3439,10 @@ void TFT::prepareForScreenshot() noexcept
 
 void TFT::gotoScreen(int id) noexcept
 {
-  if (KWLConfig::serialDebugDisplay) {
-    Serial.print(F("TFT: external screen switch to screen "));
-    Serial.println(id);
+  if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+    LogLine log(LogLevel::TRACE);
+    log.print(F("TFT: external screen switch to screen "));
+    log.println(id);
   }
   switch (id)
   {
@@ -3448,13 +3464,14 @@ void TFT::makeTouch(int x, int y) noexcept
   auto time = millis();
   touch_in_progress_ = true;
   millis_last_touch_ = time;
-  if (KWLConfig::serialDebugDisplay) {
-    Serial.print(F("TFT: external touch trigger at "));
-    Serial.print(x);
-    Serial.print(',');
-    Serial.print(y);
-    Serial.print(F(", ms="));
-    Serial.println(time);
+  if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+    LogLine log(LogLevel::TRACE);
+    log.print(F("TFT: external touch trigger at "));
+    log.print(x);
+    log.print(',');
+    log.print(y);
+    log.print(F(", ms="));
+    log.println(time);
   }
   if (current_screen_)
     current_screen_->touch(x, y, time);
@@ -3488,8 +3505,7 @@ inline void TFT::gotoScreen() noexcept
 
 void TFT::displayUpdate() noexcept
 {
-  if (KWLConfig::serialDebugDisplay == 1)
-    Serial.println(F("TFT: displayUpdate"));
+  LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: displayUpdate"));
 
   // Das Update wird alle 1000mS durchlaufen
   // Bevor Werte ausgegeben werden, wird auf Änderungen der Werte überprüft, nur geänderte Werte werden auf das Display geschrieben
@@ -3527,8 +3543,7 @@ void TFT::loopTouch() noexcept
 
     if (!cal_->calibrated_ && current_screen_id_ != ScreenCalibration::ID) {
       // cannot yet pass touch further, we need touch calibration
-      if (KWLConfig::serialDebugDisplay)
-        Serial.println(F("TFT: touch on uncalibrated display"));
+      LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("TFT: touch on uncalibrated display"));
 
       if (!touch_in_progress_) {
         touch_in_progress_ = true;
@@ -3553,17 +3568,18 @@ void TFT::loopTouch() noexcept
     int16_t xpos = int(map(tp.x, cal_->left_, cal_->right_, 0, tft_.width()));
     int16_t ypos = int(map(tp.y, cal_->top_, cal_->bottom_, 0, tft_.height()));
 
-    if (KWLConfig::serialDebugDisplay) {
-      Serial.print(F("Touch (xpos/ypos, tp.x/tp.y): "));
-      Serial.print(xpos);
-      Serial.print('/');
-      Serial.print(ypos);
-      Serial.print(',');
-      Serial.print(tp.x);
-      Serial.print('/');
-      Serial.print(tp.y);
-      Serial.print(F(", ms="));
-      Serial.println(time);
+    if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("Touch (xpos/ypos, tp.x/tp.y): "));
+      log.print(xpos);
+      log.print('/');
+      log.print(ypos);
+      log.print(',');
+      log.print(tp.x);
+      log.print('/');
+      log.print(tp.y);
+      log.print(F(", ms="));
+      log.println(time);
     }
 
     touch_in_progress_ = true;
@@ -3573,9 +3589,10 @@ void TFT::loopTouch() noexcept
 
   } else if (touch_in_progress_) {
     // released
-    if (KWLConfig::serialDebugDisplay) {
-      Serial.print(F("Touch release: ms="));
-      Serial.println(time);
+    if (LOG_ENABLED(KWLConfig::LogLevelDisplay, TRACE)) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("Touch release: ms="));
+      log.println(time);
     }
     touch_in_progress_ = false;
     if (current_screen_)
@@ -3587,31 +3604,30 @@ void TFT::loopTouch() noexcept
 
 void TFT::setupDisplay() noexcept
 {
-  if (KWLConfig::serialDebugDisplay == 1) {
-    Serial.println(F("start_tft"));
-  }
+  LOG(KWLConfig::LogLevelDisplay, TRACE).println(F("start_tft"));
   auto ID = tft_.readID();  // you must detect the correct controller
   tft_.begin(ID);      // everything will start working
 
   int16_t  x1, y1;
   uint16_t w, h;
-  Serial.print (F("Font baseline (middle / small): "));
   tft_.setFont(&FreeSans12pt7b);  // Mittlerer Font
   // Baseline bestimmen für mittleren Font
   tft_.getTextBounds(F("0123456789?-"), 0, 0, &x1, &y1, &w, &h);
   BASELINE_MIDDLE = int(h);
   HEIGHT_NUMBER_FIELD = int(h + 2);
-  Serial.print (HEIGHT_NUMBER_FIELD);
-  Serial.print (F(" / "));
   tft_.setFont(&FreeSans9pt7b);  // Kleiner Font
   // Baseline bestimmen für kleinen Font
   tft_.getTextBounds(F("M"), 0, 0, &x1, &y1, &w, &h);
   BASELINE_SMALL = int(h);
-  Serial.print (h);
-  Serial.println ();
-
-  Serial.print(F("TFT controller: "));
-  Serial.println(ID);
+  if (LOG_ENABLED(KWLConfig::LogLevelDisplay, INFO)) {
+    LogLine log(LogLevel::INFO);
+    log.print(F("Font baseline (middle / small): "));
+    log.print(HEIGHT_NUMBER_FIELD);
+    log.print(F(" / "));
+    log.print(h);
+    log.print(F(", TFT controller: "));
+    log.println(ID);
+  }
   tft_.setRotation(1);
 
   gotoScreen<ScreenInit>();
@@ -3625,18 +3641,21 @@ void TFT::setupTouch()
 
   // Dump debug info:
 
-  Serial.println(F("TFT: LCD driver ID = 0x"));
-  Serial.println(identifier, HEX);
-  Serial.print(F("TFT: Screen is "));
-  Serial.print(tft_.width());
-  Serial.print('x');
-  Serial.println(tft_.height());
-  Serial.print(F("TFT: YP = "));
-  Serial.print(KWLConfig::YP);
-  Serial.print(F(" XM = "));
-  Serial.println(KWLConfig::XM);
-  Serial.print(F("YM = "));
-  Serial.print(KWLConfig::YM);
-  Serial.print(F(" XP = "));
-  Serial.println(KWLConfig::XP);
+  if (LOG_ENABLED(KWLConfig::LogLevelDisplay, INFO)) {
+    LogLine log(LogLevel::INFO);
+    log.print(F("TFT: LCD driver ID = 0x"));
+    log.println(identifier, HEX);
+    log.print(F("TFT: Screen is "));
+    log.print(tft_.width());
+    log.print('x');
+    log.println(tft_.height());
+    log.print(F("TFT: YP = "));
+    log.print(KWLConfig::YP);
+    log.print(F(" XM = "));
+    log.println(KWLConfig::XM);
+    log.print(F("YM = "));
+    log.print(KWLConfig::YM);
+    log.print(F(" XP = "));
+    log.println(KWLConfig::XP);
+  }
 }
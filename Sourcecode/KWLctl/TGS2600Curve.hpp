@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Characteristic curve of TGS2600 VOC sensor and its fixed-point evaluation.
+ *
+ * After changing the curve, regenerate TGS2600Table.hpp using
+ * Docs/debug_voc/gen_tgs2600_table.py and check it with
+ * Docs/debug_voc/tgs2600_test.cpp.
+ */
+#pragma once
+
+#include "TGS2600Table.hpp"
+
+static constexpr float  TGS2600_DEFAULTPPM        = 10;           //default ppm of CO2 for calibration
+static constexpr long   TGS2600_DEFAULTRO         = 45000;        //default Ro for TGS2600_DEFAULTPPM ppm of CO2
+static constexpr double TGS2600_SCALINGFACTOR     = 0.3555567714; //CO2 gas value
+static constexpr double TGS2600_EXPONENT          = -3.337882361; //CO2 gas value
+//static constexpr double TGS2600_MAXRSRO           = 2.428;        //for CO2
+//static constexpr double TGS2600_MINRSRO           = 0.358;        //for CO2
+static constexpr double TGS2600_RL                = 1000;
+
+/*
+   get log2(x) in 1/2048 for x > 0
+*/
+static int16_t log2Fixed(uint16_t x)
+{
+  // normalize to 1.xxx and interpolate logarithm of the fraction in the table
+  int16_t res = 15 << LOG2_SHIFT;
+  while (!(x & 0x8000)) {
+    x <<= 1;
+    res -= 1 << LOG2_SHIFT;
+  }
+  constexpr uint8_t FRAC_BITS = 15 - LOG2_TABLE_SHIFT;
+  uint16_t m = x & 0x7fff;
+  uint8_t i = uint8_t(m >> FRAC_BITS);
+  uint16_t frac = m & ((1U << FRAC_BITS) - 1);
+  int16_t y0 = int16_t(pgm_read_word(&LOG2_TABLE[i]));
+  int16_t y1 = int16_t(pgm_read_word(&LOG2_TABLE[i + 1]));
+  return int16_t(res + y0 + ((long(y1 - y0) * frac + (1L << (FRAC_BITS - 1))) >> FRAC_BITS));
+}
+
+/*
+   get the ppm concentration from A/D value (using default ro) via lookup table
+*/
+static int TGS2600_getppm(int valr)
+{
+  constexpr uint8_t COUNT = sizeof(TGS2600_PPM_TABLE) / sizeof(TGS2600_PPM_TABLE[0]);
+  // log2(Rs/RL) = log2((1024 - valr) / valr)
+  int16_t d = log2Fixed(uint16_t(1024 - valr)) - log2Fixed(uint16_t(valr)) - TGS2600_TABLE_START;
+  if (d < 0)
+    d = 0;
+  uint16_t i = uint16_t(d) >> TGS2600_TABLE_SHIFT;
+  long ppm;
+  if (i >= COUNT - 1) {
+    ppm = pgm_read_word(&TGS2600_PPM_TABLE[COUNT - 1]);
+  } else {
+    long y0 = pgm_read_word(&TGS2600_PPM_TABLE[i]);
+    long y1 = pgm_read_word(&TGS2600_PPM_TABLE[i + 1]);
+    uint16_t frac = uint16_t(d) & ((1U << TGS2600_TABLE_SHIFT) - 1);
+    ppm = y0 + (((y1 - y0) * frac + (1L << (TGS2600_TABLE_SHIFT - 1))) >> TGS2600_TABLE_SHIFT);
+  }
+  return int(ppm > TGS2600_MAX_PPM ? TGS2600_MAX_PPM : ppm);
+}
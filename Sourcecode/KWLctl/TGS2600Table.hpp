@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Characteristic curve of TGS2600 VOC sensor.
+ *
+ * GENERATED by Docs/debug_voc/gen_tgs2600_table.py from constants in
+ * TGS2600Curve.hpp, do not edit.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+/// Fixed point of log2 values as shift (1/2048).
+static constexpr uint8_t LOG2_SHIFT = 11;
+/// Size of LOG2_TABLE as shift (without the last entry).
+static constexpr uint8_t LOG2_TABLE_SHIFT = 5;
+/// Step between entries of TGS2600_PPM_TABLE as shift in log2 fixed point.
+static constexpr uint8_t TGS2600_TABLE_SHIFT = 7;
+/// Maximum ppm value (saturated).
+static constexpr uint16_t TGS2600_MAX_PPM = 32767;
+
+/// log2(1 + i/32) in 1/2048 for i = 0..32.
+static const uint16_t LOG2_TABLE[] PROGMEM = {
+      0,    91,   179,   265,   348,   429,   508,   585,   659,   732,   803,
+    873,   941,  1007,  1072,  1136,  1198,  1259,  1319,  1377,  1435,  1491,
+   1546,  1600,  1653,  1706,  1757,  1808,  1857,  1906,  1954,  2001,  2048
+};
+
+/// log2(Rs/RL) in 1/2048 at the first entry of TGS2600_PPM_TABLE.
+static constexpr int16_t TGS2600_TABLE_START = 1024;
+
+/// ppm at log2(Rs/RL) = TGS2600_TABLE_START + i * 128/2048 (ppm = 0.3555567714 * (Rs/45000)^-3.337882361).
+static const uint16_t TGS2600_PPM_TABLE[] PROGMEM = {
+  36875, 31911, 27614, 23897, 20679, 17895, 15486, 13401, 11597, 10035,
+   8684,  7515,  6503,  5628,  4870,  4214,  3647,  3156,  2731,  2363,
+   2045,  1770,  1532,  1325,  1147,   993,   859,   743,   643,   557,
+    482,   417,   361,   312,   270,   234,   202,   175,   151,   131,
+    113,    98,    85,    74,    64,    55,    48,    41,    36,    31,
+     27,    23,    20,    17,    15,    13,    11,    10,     8,     7,
+      6,     5,     5,     4,     4,     3,     3,     2,     2,     2,
+      1,     1,     1,     1,     1,     1,     1,     1,     0
+};
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2018 Sven Just (sven@familie-just.de)
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+#include "TelemetryHistory.h"
+#include "TempSensors.h"
+#include "FanControl.h"
+#include "NetworkClient.h"
+#include "MQTTTopic.hpp"
+
+#include <MicroNTP.h>
+
+/// Interval for sending recorded samples after reconnect (500ms).
+static constexpr unsigned long INTERVAL_HISTORY_DRAIN = 500000;
+
+/// Temperature value at or below which the sensor is considered not working (in 0.1C).
+static constexpr int16_t INVALID_TEMP = CentiCelsius::INVALID_VALUE / 10;
+
+namespace
+{
+  /// Convert temperature to 0.1C, rounded.
+  int16_t toDeciCelsius(CentiCelsius t)
+  {
+    auto v = t.toCenti();
+    return int16_t((v + (v < 0 ? -5 : 5)) / 10);
+  }
+}
+
+TelemetryHistory::TelemetryHistory(const TempSensors& temp, FanControl& fan, const NetworkClient& net, const MicroNTP& ntp) :
+  temp_(temp),
+  fan_(fan),
+  net_(net),
+  ntp_(ntp),
+  stats_(F("TelemetryHistory")),
+  sample_task_(stats_, &TelemetryHistory::sample, *this),
+  drain_task_(stats_, &TelemetryHistory::drain, *this)
+{}
+
+void TelemetryHistory::begin()
+{
+  if (!KWLConfig::HistorySize)
+    return;
+  sample_task_.runRepeated(KWLConfig::HistoryInterval * 1000000UL);
+  drain_task_.runRepeated(INTERVAL_HISTORY_DRAIN);
+}
+
+void TelemetryHistory::read(int16_t (&values)[VALUE_COUNT]) const
+{
+  values[0] = toDeciCelsius(temp_.get_t1_outside());
+  values[1] = toDeciCelsius(temp_.get_t2_inlet());
+  values[2] = toDeciCelsius(temp_.get_t3_outlet());
+  values[3] = toDeciCelsius(temp_.get_t4_exhaust());
+  values[4] = int16_t((fan_.getFan1().getSpeed() + 5) / 10);
+  values[5] = int16_t((fan_.getFan2().getSpeed() + 5) / 10);
+}
+
+void TelemetryHistory::sample()
+{
+  if (net_.isMQTTOk())
+    return; // values are published directly
+  auto now = ntp_.currentTime();
+  if (!now)
+    return; // samples without time are useless for history
+
+  int16_t values[VALUE_COUNT];
+  read(values);
+  if (count_ == RING_SIZE) {
+    if (sending_)
+      return; // cannot drop the sample being sent, skip this one
+    removeOldest();
+    ++dropped_;
+  }
+  auto& d = ring_[(first_ + count_) % RING_SIZE];
+  if (!count_) {
+    memcpy(first_values_, values, sizeof(values));
+    memcpy(last_values_, values, sizeof(values));
+    first_time_ = last_time_ = now;
+    memset(&d, 0, sizeof(d));
+    first_invalid_ = 0;
+    for (uint8_t i = 0; i < TEMP_COUNT; ++i)
+      if (values[i] <= INVALID_TEMP)
+        first_invalid_ |= uint8_t(1 << i);
+    valid_base_ = uint8_t(~first_invalid_);
+  } else {
+    auto dt = now - last_time_;
+    if (dt > 0xffff)
+      dt = 0xffff;
+    d.dt = uint16_t(dt);
+    last_time_ += dt;
+    for (uint8_t i = 0; i < VALUE_COUNT; ++i) {
+      uint8_t bit = uint8_t(1 << i);
+      if (i < TEMP_COUNT && values[i] <= INVALID_TEMP) {
+        // keep last valid value, so the recovery doesn't ramp from invalid value
+        d.value[i] = INVALID_DELTA;
+        continue;
+      }
+      if (!(valid_base_ & bit)) {
+        // first valid value in the ring, all previous ones are invalid and
+        // thus the full value can be stored as the base for both ends
+        first_values_[i] = last_values_[i] = values[i];
+        valid_base_ |= bit;
+        d.value[i] = 0;
+        continue;
+      }
+      // Clamp changes out of range. The error is carried over to the next sample
+      // via last_values_, so the history converges after a big jump.
+      auto diff = values[i] - last_values_[i];
+      if (diff > 127)
+        diff = 127;
+      else if (diff < -127)
+        diff = -127;
+      d.value[i] = int8_t(diff);
+      last_values_[i] = int16_t(last_values_[i] + diff);
+    }
+  }
+  ++count_;
+}
+
+void TelemetryHistory::removeOldest()
+{
+  if (++first_ == RING_SIZE)
+    first_ = 0;
+  if (--count_) {
+    // fold the difference of the next sample into the full sample
+    auto& d = ring_[first_];
+    first_time_ += d.dt;
+    for (uint8_t i = 0; i < VALUE_COUNT; ++i) {
+      uint8_t bit = uint8_t(1 << i);
+      if (d.value[i] == INVALID_DELTA) {
+        first_invalid_ |= bit;
+      } else {
+        first_values_[i] = int16_t(first_values_[i] + d.value[i]);
+        first_invalid_ &= uint8_t(~bit);
+      }
+    }
+  }
+}
+
+void TelemetryHistory::drain()
+{
+  if (!count_ || sending_ || !net_.isMQTTOk())
+    return;
+  sending_ = true;
+  publish_task_.publish([this]() {
+    char temps[4][FixedPoint::MAX_STRING_SIZE];
+    for (uint8_t i = 0; i < TEMP_COUNT; ++i) {
+      if (!(first_invalid_ & (1 << i)))
+        FixedPoint(first_values_[i], 1).toString(temps[i]);
+      else
+        strcpy_P(temps[i], PSTR("null"));
+    }
+    char buffer[112];
+    snprintf_P(buffer, sizeof(buffer),
+               PSTR("{\"ts\":%lu,\"t1\":%s,\"t2\":%s,\"t3\":%s,\"t4\":%s,\"fan1\":%d,\"fan2\":%d}"),
+               first_time_, temps[0], temps[1], temps[2], temps[3],
+               first_values_[4] * 10, first_values_[5] * 10);
+    if (!MessageHandler::publish(MQTTTopic::KwlHistory, buffer, false))
+      return false;
+    removeOldest();
+    sending_ = false;
+    return true;
+  });
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2018 Sven Just (sven@familie-just.de)
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief History of measurements recorded while MQTT is offline.
+ */
+#pragma once
+
+#include "TimeScheduler.h"
+#include "MessageHandler.h"
+#include "KWLConfig.h"
+
+class TempSensors;
+class FanControl;
+class NetworkClient;
+class MicroNTP;
+
+/*!
+ * @brief History of measurements recorded while MQTT broker is not reachable.
+ *
+ * While MQTT is offline, temperatures and fan speeds are sampled periodically
+ * into a fixed-size RAM ring. Only the oldest sample is kept in full, each
+ * further sample is stored as a difference to the previous one (8B per sample).
+ * If the ring is full, the oldest sample is dropped. Temperatures of failed
+ * sensors are stored as a special difference value and sent as @c null,
+ * differences of valid temperatures are relative to the last valid value.
+ *
+ * After reconnect, samples are sent oldest first to the history topic at
+ * a limited rate, so they don't compete with regular messages.
+ */
+class TelemetryHistory
+{
+public:
+  TelemetryHistory(const TelemetryHistory&) = delete;
+  TelemetryHistory& operator=(const TelemetryHistory&) = delete;
+
+  /*!
+   * @brief Construct history recorder.
+   *
+   * @param temp temperature sensors to sample.
+   * @param fan fan control to sample fan speeds.
+   * @param net network client to check MQTT connection.
+   * @param ntp NTP client to timestamp samples.
+   */
+  TelemetryHistory(const TempSensors& temp, FanControl& fan, const NetworkClient& net, const MicroNTP& ntp);
+
+  /// Start recording.
+  void begin();
+
+  /// Get count of samples currently stored.
+  uint8_t size() const { return count_; }
+
+  /// Get count of samples dropped since start because the ring was full.
+  unsigned getDroppedSamples() const { return dropped_; }
+
+private:
+  /// Number of values in one sample (4 temperatures, 2 fan speeds).
+  static constexpr uint8_t VALUE_COUNT = 6;
+
+  /// Number of temperatures in one sample, which may be invalid.
+  static constexpr uint8_t TEMP_COUNT = 4;
+
+  /// Difference value marking an invalid temperature (not produced by clamping).
+  static constexpr int8_t INVALID_DELTA = -128;
+
+  /// Number of samples in the ring.
+  static constexpr uint8_t RING_SIZE = KWLConfig::HistorySize ? KWLConfig::HistorySize : 1;
+
+  /// One sample stored as a difference to the previous sample.
+  struct Delta
+  {
+    uint16_t dt;                ///< Time since previous sample in seconds.
+    int8_t value[VALUE_COUNT];  ///< Change of each value since previous sample.
+  };
+
+  /// Record a sample, if offline.
+  void sample();
+
+  /// Send the oldest sample, if online.
+  void drain();
+
+  /// Remove the oldest sample and make the next sample the full one.
+  void removeOldest();
+
+  /// Read current values (temperatures in 0.1C, fan speeds in 10rpm).
+  void read(int16_t (&values)[VALUE_COUNT]) const;
+
+  /// Temperature sensors.
+  const TempSensors& temp_;
+  /// Fan control.
+  FanControl& fan_;
+  /// Network client.
+  const NetworkClient& net_;
+  /// NTP client.
+  const MicroNTP& ntp_;
+  /// Samples, the first one is stored in first_values_ and first_time_.
+  Delta ring_[RING_SIZE];
+  /// Values of the oldest sample (last valid values for invalid temperatures).
+  int16_t first_values_[VALUE_COUNT];
+  /// Values of the newest sample as reconstructed from deltas (last valid values for invalid temperatures).
+  int16_t last_values_[VALUE_COUNT];
+  /// Bitmask of temperatures which are invalid in the oldest sample.
+  uint8_t first_invalid_ = 0;
+  /// Bitmask of temperatures having a valid value in first_values_ and last_values_.
+  uint8_t valid_base_ = 0;
+  /// Time of the oldest sample.
+  unsigned long first_time_ = 0;
+  /// Time of the newest sample.
+  unsigned long last_time_ = 0;
+  /// Index of the oldest sample in the ring.
+  uint8_t first_ = 0;
+  /// Count of samples in the ring.
+  uint8_t count_ = 0;
+  /// Set while the oldest sample is being sent.
+  bool sending_ = false;
+  /// Count of samples dropped because the ring was full.
+  unsigned dropped_ = 0;
+  /// Task to send samples.
+  PublishTask publish_task_;
+  /// Sampling timing statistics.
+  Scheduler::TaskTimingStats stats_;
+  /// Timer task sampling values.
+  Scheduler::TimedTask<TelemetryHistory> sample_task_;
+  /// Timer task sending samples.
+  Scheduler::TimedTask<TelemetryHistory> drain_task_;
+};
@@ -17,6 +17,7 @@
  * This copyright notice MUST APPEAR in all copies of the software!
  */
 #include "TempSensors.h"
+#include "Antifreeze.h"
 #include "MQTTTopic.hpp"
 #include "StringView.h"
 
@@ -24,73 +25,346 @@
 
 /// Precision of temperature reading (9-12 bits; 12 bits is 0.0625C, 9 bits is 0.5C).
 static constexpr uint8_t TEMPERATURE_PRECISION = 12;
+/// Minimum precision used for stable temperatures far from any threshold.
+static constexpr uint8_t MIN_TEMPERATURE_PRECISION = 9;
+/// Minimum precision of sensors used to compute efficiency (0.125C, 0.5C steps would make efficiency jump).
+static constexpr uint8_t MIN_EFFICIENCY_PRECISION = 11;
+/// Use full precision, if temperature is closer than this to a decision threshold.
+static constexpr CentiCelsius NEAR_THRESHOLD_MARGIN = CentiCelsius::fromDegrees(1);
+/// Temperature is considered stable, if it changes by less than this value between readings (~8s).
+static constexpr CentiCelsius STABLE_DELTA = CentiCelsius(15);
+/// Count of stable readings after which to lower the precision by one bit.
+static constexpr uint8_t STABLE_READINGS = 4;
+/// Margin reported for sensors without any threshold.
+static constexpr CentiCelsius NO_THRESHOLD_MARGIN = CentiCelsius::fromDegrees(100);
+/// Fixed-point shift of filter state (1/65536C).
+static constexpr uint8_t FILTER_SHIFT = 16;
+/// Filter gain for temperature as shift (alpha = 1/4).
+static constexpr uint8_t FILTER_ALPHA_SHIFT = 2;
+/// Filter gain for slope as shift (beta = 1/32, close to Benedict-Bordner alpha^2 / (2 - alpha) = 0.036 for alpha = 1/4).
+static constexpr uint8_t FILTER_BETA_SHIFT = 5;
+/// Restart the filter, if the reading differs from prediction by more than this (3C).
+static constexpr int32_t FILTER_MAX_RESIDUAL = 3L << FILTER_SHIFT;
+/// Restart the filter, if there was no reading for this time (60s).
+static constexpr unsigned long FILTER_MAX_GAP_MS = 60000;
+/// Maximum slope of the filter (20C/min in 1/65536C per second, prevents overflow in prediction).
+static constexpr int32_t FILTER_MAX_SLOPE = (20L << FILTER_SHIFT) / 60;
+/// Sensor is stale, if there was no reading for this time (30s).
+static constexpr unsigned long HEALTH_STALE_MS = 30000;
+/// Sensor is stuck, if the reading didn't change for this time (12h).
+static constexpr unsigned long HEALTH_STUCK_MS = 12UL * 3600 * 1000;
+/// Read with full resolution, if the reading didn't change for this time (6h), so reduced resolution doesn't look stuck.
+static constexpr unsigned long HEALTH_FULL_RESOLUTION_MS = HEALTH_STUCK_MS / 2;
+/// Minimum plausible temperature in the ventilation system.
+static constexpr CentiCelsius HEALTH_MIN_TEMP = CentiCelsius::fromDegrees(-40);
+/// Maximum plausible temperature (DS18B20 reports 85C after power-on reset without conversion).
+static constexpr CentiCelsius HEALTH_MAX_TEMP = CentiCelsius::fromDegrees(70);
+/// Sensor is noisy, if the average absolute filter residual is above this value (0.5C in 1/800C).
+static constexpr uint16_t HEALTH_NOISE_LIMIT = 400;
+/// Averaging of absolute filter residuals as shift (1/8).
+static constexpr uint8_t NOISE_AVERAGE_SHIFT = 3;
+/// Minimum efficiency in % to estimate T1 from it.
+static constexpr int ESTIMATE_MIN_EFFICIENCY = 10;
+/// Maximum efficiency in % to estimate T1 from it (estimate error grows with 1 / (1 - eff)).
+static constexpr int ESTIMATE_MAX_EFFICIENCY = 95;
 /// Scheduling interval for temperature sensor query (1s).
 static constexpr unsigned long SCHEDULING_INTERVAL = 1000000;
+/// Scheduling interval at startup until all sensors are discovered and converting (20ms).
+static constexpr unsigned long STARTUP_INTERVAL = 20000;
+/// Family code of DS18S20 sensor (0.5C resolution, no configuration register).
+static constexpr uint8_t FAMILY_DS18S20 = 0x10;
+/// DS18x20 command to start temperature conversion.
+static constexpr uint8_t CMD_CONVERT_T = 0x44;
+/// DS18x20 command to read scratchpad.
+static constexpr uint8_t CMD_READ_SCRATCHPAD = 0xBE;
+/// DS18x20 command to write scratchpad (alarm high, alarm low, configuration).
+static constexpr uint8_t CMD_WRITE_SCRATCHPAD = 0x4E;
+/// DS18x20 command to read power supply (parasitically powered sensor answers 0).
+static constexpr uint8_t CMD_READ_POWER_SUPPLY = 0xB4;
+
+namespace
+{
+  /// Check whether data is not all zeroes, which would pass CRC check (e.g., bus stuck low).
+  bool anyBits(const uint8_t* data, uint8_t len)
+  {
+    uint8_t bits = 0;
+    while (len--)
+      bits |= *data++;
+    return bits != 0;
+  }
+}
 
 TempSensors::TempSensor::TempSensor(uint8_t pin) :
-  onewire_ifc_(pin),
-  sensor_(&onewire_ifc_)
+  bus_(pin)
 {}
 
-void TempSensors::TempSensor::begin()
+void TempSensors::TempSensor::begin(const uint8_t* rom)
 {
-  sensor_.begin();
-  sensor_.setResolution(TEMPERATURE_PRECISION);
-  sensor_.setWaitForConversion(false);
-  if (!sensor_.getAddress(address_, 0))
-    state_ = -1;  // re-request later
-  else
-    loop(); // initial temperature request
+  if (anyBits(rom, 8) && OneWireAsync::crc8(rom, 7) == rom[7]) {
+    // single sensor per bus, so cached ROM is valid as long as the sensor is present
+    memcpy(rom_, rom, sizeof(rom_));
+    state_ = State::POWER;
+  } else {
+    state_ = State::DISCOVER;
+  }
 }
 
 bool TempSensors::TempSensor::loop()
 {
-  if (state_ == 0) {
-    // new reading requested
-    sensor_.requestTemperatures();
-    state_ = 1;
-  } else if (state_ < 0) {
-    // request address again upon retry
-    if (sensor_.getAddress(address_, 0))
-      state_ = 0; // successfull query
-    // else state_ stays at -1 to retry getting the address next time
-  } else if (state_ <= MAX_WAIT_TIME) {
-    if (sensor_.isConversionComplete()) {
-      // data can be read
-      auto res = sensor_.getTempC(address_);
-      if (res > DEVICE_DISCONNECTED_C) {
-        // successful reading, start next read next time
-        t_ = double(res);
-        state_ = 0;
-        return true;
+  bool started;
+  switch (state_) {
+    case State::DISCOVER:
+      // read ROM of the only sensor on the bus
+      started = bus_.startReadROM(scratchpad_);
+      break;
+
+    case State::POWER:
+      started = bus_.startCommand(nullptr, CMD_READ_POWER_SUPPLY, scratchpad_, 1);
+      break;
+
+    case State::CONFIGURE:
+    case State::CONVERT:
+      if (resolution_ != sensor_resolution_ && rom_[0] != FAMILY_DS18S20) {
+        // change resolution first, only in scratchpad to spare sensor's EEPROM
+        // (alarm registers are kept as read last time)
+        const uint8_t data[] = {
+          scratchpad_[2], scratchpad_[3], uint8_t(((resolution_ - 9) << 5) | 0x1F)
+        };
+        state_ = State::CONFIGURE;
+        started = bus_.startWrite(nullptr, CMD_WRITE_SCRATCHPAD, data, sizeof(data));
       } else {
-        // error reading data
-        retry();
+        // new reading requested, conversion runs in the background
+        state_ = State::CONVERT;
+        started = bus_.startCommand(nullptr, CMD_CONVERT_T, nullptr, 0, parasite_);
       }
+      break;
+
+    case State::READ:
+    default:
+      // conversion was started in the previous round (several seconds ago),
+      // so it's complete by now
+      started = bus_.startCommand(nullptr, CMD_READ_SCRATCHPAD, scratchpad_, sizeof(scratchpad_));
+      break;
+  }
+  if (!started)
+    fail(timeouts_, state_);  // bus busy, retry next time
+  return started;
+}
+
+bool TempSensors::TempSensor::finish()
+{
+  auto status = bus_.poll();
+  if (status == OneWireAsync::Status::BUSY) {
+    // transaction hangs, which should not happen
+    bus_.abort();
+    fail(timeouts_, state_);
+    return false;
+  }
+  if (status != OneWireAsync::Status::DONE) {
+    // sensor may have been replaced, so discover it again
+    fail(disconnects_, State::DISCOVER);
+    return false;
+  }
+
+  switch (state_) {
+    case State::DISCOVER:
+      if (!anyBits(scratchpad_, 8) || OneWireAsync::crc8(scratchpad_, 7) != scratchpad_[7]) {
+        fail(crc_errors_, State::DISCOVER);
+      } else {
+        if (memcmp(rom_, scratchpad_, sizeof(rom_)) != 0) {
+          memcpy(rom_, scratchpad_, sizeof(rom_));
+          rom_changed_ = true;
+        }
+        // scratchpad buffer doesn't contain alarm registers anymore, so don't
+        // change resolution before the resolution of the sensor is read again
+        sensor_resolution_ = resolution_;
+        state_ = State::POWER;
+      }
+      return false;
+
+    case State::POWER:
+      parasite_ = (scratchpad_[0] & 1) == 0;
+      state_ = State::CONVERT;
+      return false;
+
+    case State::CONFIGURE:
+      sensor_resolution_ = resolution_;
+      resolution_changed_ = true;
+      state_ = State::CONVERT;
+      return false;
+
+    case State::CONVERT:
+      state_ = State::READ;
+      return false;
+
+    case State::READ:
+    default:
+      break;
+  }
+
+  if (!anyBits(scratchpad_, 8) || OneWireAsync::crc8(scratchpad_, 8) != scratchpad_[8]) {
+    // error reading data, start new conversion
+    fail(crc_errors_, State::CONVERT);
+    return false;
+  }
+  // successful reading, start next conversion next time
+  auto raw = int16_t((uint16_t(scratchpad_[1]) << 8) | scratchpad_[0]);
+  bool resolution_changed = resolution_changed_;
+  resolution_changed_ = false;
+  if (rom_[0] == FAMILY_DS18S20) {
+    raw <<= 3;  // 0.5C resolution instead of 1/16C
+  } else {
+    // low bits are undefined with lower resolution (sensor may have been reset to default)
+    auto resolution = uint8_t(9 + ((scratchpad_[4] >> 5) & 3));
+    if (resolution != sensor_resolution_)
+      resolution_changed = true;
+    sensor_resolution_ = resolution;
+    raw &= ~int16_t((1 << (12 - resolution)) - 1);
+  }
+  // 1/16C to 1/100C, rounded
+  auto t = CentiCelsius(int16_t((long(raw) * 25 + (raw < 0 ? -2 : 2)) / 4));
+  // change caused by different quantization is not a real change
+  delta_ = (t_.isValid() && !resolution_changed) ? t - t_ : CentiCelsius(0);
+  read_ms_ = millis();
+  if (t != t_ && !resolution_changed)
+    change_ms_ = read_ms_;
+  t_ = t;
+  filter(raw);
+  retry_count_ = 0;
+  state_ = State::CONVERT;
+  return true;
+}
+
+void TempSensors::TempSensor::adaptResolution(CentiCelsius margin, uint8_t min_resolution)
+{
+  if (resolution_ < min_resolution) {
+    resolution_ = min_resolution;
+    stable_count_ = 0;
+  } else if (margin < NEAR_THRESHOLD_MARGIN) {
+    // control logic needs precise value
+    resolution_ = TEMPERATURE_PRECISION;
+    stable_count_ = 0;
+  } else if (read_ms_ - change_ms_ > HEALTH_FULL_RESOLUTION_MS) {
+    // stable temperature may not change in coarse steps for hours, check for stuck sensor precisely
+    resolution_ = TEMPERATURE_PRECISION;
+    stable_count_ = 0;
+  } else if (delta_.absolute() < STABLE_DELTA ||
+             delta_.absolute().toCenti() <= ((625 << (12 - sensor_resolution_)) + 99) / 100) {
+    // no significant change or just one step of the current resolution
+    if (++stable_count_ >= STABLE_READINGS) {
+      stable_count_ = 0;
+      if (resolution_ > min_resolution)
+        --resolution_;
     }
   } else {
-    // retry read next time, it took too long
-    retry();
+    // temperature is moving, increase resolution step by step
+    stable_count_ = 0;
+    if (resolution_ < TEMPERATURE_PRECISION)
+      ++resolution_;
   }
-  return false;
 }
 
-void TempSensors::TempSensor::retry()
+void TempSensors::TempSensor::filter(int16_t raw)
+{
+  // alpha-beta filter in fixed point:
+  //   prediction: t = t + slope * dt
+  //   correction: t = t + alpha * residual, slope = slope + beta * residual / dt
+  auto z = int32_t(raw) << (FILTER_SHIFT - 4);
+  auto now = millis();
+  auto dt = now - filter_ms_;
+  filter_ms_ = now;
+  if (filter_valid_ && dt > 0 && dt <= FILTER_MAX_GAP_MS) {
+    auto predicted = filter_t_ + filter_slope_ * long(dt) / 1000;
+    auto residual = z - predicted;
+    updateNoise(residual);
+    if (labs(residual) <= FILTER_MAX_RESIDUAL) {
+      filter_t_ = predicted + (residual >> FILTER_ALPHA_SHIFT);
+      filter_slope_ += (residual >> FILTER_BETA_SHIFT) * 1000 / long(dt);
+      filter_slope_ = constrain(filter_slope_, -FILTER_MAX_SLOPE, FILTER_MAX_SLOPE);
+      return;
+    }
+  }
+  // (re)start with the current reading
+  filter_t_ = z;
+  filter_slope_ = 0;
+  filter_valid_ = true;
+}
+
+void TempSensors::TempSensor::updateNoise(int32_t residual)
+{
+  // running average of absolute residuals, a single glitch counts at most as FILTER_MAX_RESIDUAL
+  auto r = labs(residual);
+  if (r > FILTER_MAX_RESIDUAL)
+    r = FILTER_MAX_RESIDUAL;
+  auto centi = uint16_t((r * 100) >> FILTER_SHIFT);
+  noise_ = uint16_t(noise_ - (noise_ >> NOISE_AVERAGE_SHIFT) + centi);
+}
+
+void TempSensors::TempSensor::set_t(CentiCelsius t)
+{
+  t_ = t;
+  read_ms_ = change_ms_ = millis();
+}
+
+TempSensorHealth TempSensors::TempSensor::evaluateHealth(unsigned long now) const
+{
+  if (!t_.isValid() || now - read_ms_ > HEALTH_STALE_MS)
+    return TempSensorHealth::STALE;
+  if (t_ < HEALTH_MIN_TEMP || t_ > HEALTH_MAX_TEMP)
+    return TempSensorHealth::OUT_OF_RANGE;
+  if (now - change_ms_ > HEALTH_STUCK_MS)
+    return TempSensorHealth::STUCK;
+  if (noise_ > HEALTH_NOISE_LIMIT)
+    return TempSensorHealth::NOISY;
+  return TempSensorHealth::FRESH;
+}
+
+CentiCelsius TempSensors::TempSensor::getFiltered() const
 {
+  if (!filter_valid_)
+    return CentiCelsius();
+  return CentiCelsius(int16_t((filter_t_ * 100 + (1L << (FILTER_SHIFT - 1))) >> FILTER_SHIFT));
+}
+
+CentiCelsius TempSensors::TempSensor::getSlope() const
+{
+  if (!filter_valid_)
+    return CentiCelsius(0);
+  return CentiCelsius(int16_t((filter_slope_ * 6000 + (1L << (FILTER_SHIFT - 1))) >> FILTER_SHIFT));
+}
+
+void TempSensors::TempSensor::fail(uint16_t& counter, State restart)
+{
+  if (counter < 0xffff)
+    ++counter;
+  // report only the first error in a row and giving up the sensor, since
+  // an absent sensor fails in every run (current counters are sent on request)
+  if (retry_count_ == 0 || (retry_count_ >= MAX_RETRIES && t_.isValid()))
+    counters_changed_ = true;
   if (retry_count_ >= MAX_RETRIES) {
-    t_ = INVALID;
+    t_ = CentiCelsius();
+    filter_valid_ = false;
+    noise_ = 0;
   } else {
     ++retry_count_;
   }
-  state_ = -1; // start next retry
+  state_ = restart;
+}
+
+void TempSensors::TempSensor::resetCounters()
+{
+  crc_errors_ = 0;
+  timeouts_ = 0;
+  disconnects_ = 0;
 }
 
-TempSensors::TempSensors() :
+TempSensors::TempSensors(KWLPersistentConfig& config) :
   MessageHandler(F("TempSensors")),
   t1_(KWLConfig::PinTemp1OneWireBus),
   t2_(KWLConfig::PinTemp2OneWireBus),
   t3_(KWLConfig::PinTemp3OneWireBus),
   t4_(KWLConfig::PinTemp4OneWireBus),
+  config_(config),
   stats_(F("TempSensors")),
   timer_task_(stats_, &TempSensors::run, *this)
 {}
@@ -99,53 +373,246 @@ void TempSensors::begin(Print& initTracer)
 {
   initTracer.println(F("Initialisierung Temperatursensoren"));
 
-  // initialize sensors and request temperature reading at startup
-  t1_.begin();
-  t2_.begin();
-  t3_.begin();
-  t4_.begin();
+  for (uint8_t i = 0; i < 4; ++i)
+    getSensor(i).begin(config_.getTempSensorROM(i));
 
-  // call regularly to update
-  timer_task_.runRepeated(SCHEDULING_INTERVAL);
+  // sensors are discovered and configured in the background, quickly at startup
+  timer_task_.runRepeated(STARTUP_INTERVAL);
 }
 
 void TempSensors::run()
 {
-  // sensor reading handling
-  TempSensor* t;
-  switch (next_sensor_) {
-    case 0: t = &t1_; next_sensor_ = 1; break;
-    case 1: t = &t2_; next_sensor_ = 2; break;
-    case 2: t = &t3_; next_sensor_ = 3; break;
-    default: t = &t4_; next_sensor_ = 0; break;
-  }
-  auto new_temp = t->loop();
-  if (new_temp) {
-    // compute efficiency
-    auto diff_out = get_t3_outlet() - get_t1_outside();
-    if (abs(diff_out) > 0.1) {
-      auto diff_in = get_t2_inlet() - get_t1_outside();
-      efficiency_ = int((100 * diff_in) / diff_out);
-      efficiency_ = constrain(efficiency_, 0, 100);
-    } else {
-      efficiency_ = 0;
+  // finish transaction started in the previous run, if any
+  bool new_temp = false;
+  if (pending_ >= 0) {
+    auto index = uint8_t(pending_);
+    auto& read = getSensor(index);
+    pending_ = -1;
+    new_temp = read.finish();
+    if (new_temp) {
+      auto old_resolution = read.getResolution();
+      // T1-T3 are used for efficiency, so they need finer resolution also when stable
+      read.adaptResolution(getThresholdMargin(read),
+                           &read == &t4_ ? MIN_TEMPERATURE_PRECISION : MIN_EFFICIENCY_PRECISION);
+      if (read.getResolution() != old_resolution && LOG_ENABLED(KWLConfig::LogLevelSensor, TRACE)) {
+        LogLine log(LogLevel::TRACE);
+        log.print(F("Temp: sensor "));
+        log.print(index + 1);
+        log.print(F(" resolution "));
+        log.println(read.getResolution());
+      }
+    }
+    if (read.romChanged()) {
+      config_.setTempSensorROM(index, read.getROM());
+      if (LOG_ENABLED(KWLConfig::LogLevelSensor, INFO)) {
+        LogLine log(LogLevel::INFO);
+        log.print(F("Temp: sensor "));
+        log.print(index + 1);
+        log.println(F(" discovered, ROM stored"));
+      }
     }
+    if (read.countersChanged()) {
+      diag_pending_ |= uint8_t(1 << index);
+      sendDiagnostics();
+    }
+  }
+
+  if (timer_task_.getInterval() == STARTUP_INTERVAL) {
+    // startup, only talk to sensors which didn't start the first conversion yet
+    for (uint8_t i = 0; i < 4; ++i) {
+      auto index = uint8_t((next_sensor_ + i) & 3);
+      auto& s = getSensor(index);
+      if (s.isStarting()) {
+        if (s.loop())
+          pending_ = int8_t(index);
+        next_sensor_ = (index + 1) & 3;
+        return;
+      }
+    }
+    // all sensors started or missing, continue with regular reading
+    timer_task_.setInterval(SCHEDULING_INTERVAL);
+    LOG(KWLConfig::LogLevelSensor, INFO).println(F("Temp: startup finished"));
+    return;
   }
 
+  // sensor reading handling
+  if (getSensor(next_sensor_).loop())
+    pending_ = int8_t(next_sensor_);
+  next_sensor_ = (next_sensor_ + 1) & 3;
+  new_temp = updateTemperatures(new_temp);
+
   // Send the temperatures via MQTT:
   //   - if max time reached, send,
   //   - if min time reached and min difference found, send,
   //   - else wait for the next call.
-  ++mqtt_ticks_;
-  if (mqtt_ticks_ >= KWLConfig::MaxIntervalMqttTemp ||
-      (mqtt_ticks_ >= KWLConfig::MinIntervalMqttTemp && new_temp && (
-         (abs(get_t1_outside() - last_mqtt_t1_) > KWLConfig::MinDiffMqttTemp) ||
-         (abs(get_t2_inlet() - last_mqtt_t2_) > KWLConfig::MinDiffMqttTemp) ||
-         (abs(get_t3_outlet() - last_mqtt_t3_) > KWLConfig::MinDiffMqttTemp) ||
-         (abs(get_t4_exhaust() - last_mqtt_t4_) > KWLConfig::MinDiffMqttTemp)
-      ))
-     )
+  if (mqtt_ticks_ < 0xffff)
+    ++mqtt_ticks_;
+  auto& policy = config_.getPublishPolicy(PublishGroup::TEMPERATURE);
+  if (new_temp) {
+    // maximum change of any sensor in 0.01C
+    const CentiCelsius diff[] = {
+      get_t1_outside() - last_mqtt_t1_, get_t2_inlet() - last_mqtt_t2_,
+      get_t3_outlet() - last_mqtt_t3_, get_t4_exhaust() - last_mqtt_t4_
+    };
+    long change = 0;
+    for (auto d : diff) {
+      long c = d.absolute().toCenti();
+      if (c > change)
+        change = c;
+    }
+    if (policy.shouldPublish(mqtt_ticks_, change))
+      sendMQTT();
+  } else if (mqtt_ticks_ >= policy.max_interval) {
     sendMQTT();
+  }
+}
+
+bool TempSensors::updateTemperatures(bool new_temp)
+{
+  // evaluate health of sensors
+  auto now = millis();
+  uint8_t usable = 0;
+  for (uint8_t i = 0; i < 4; ++i) {
+    auto& s = getSensor(i);
+    auto health = s.evaluateHealth(now);
+    if (health != s.getHealth()) {
+      s.setHealth(health);
+      health_pending_ |= uint8_t(1 << i);
+      new_temp = true;
+      if (health == TempSensorHealth::FRESH ? LOG_ENABLED(KWLConfig::LogLevelSensor, INFO) : LOG_ENABLED(KWLConfig::LogLevelSensor, WARNING)) {
+        LogLine log(health == TempSensorHealth::FRESH ? LogLevel::INFO : LogLevel::WARNING);
+        log.print(F("Temp: sensor "));
+        log.print(i + 1);
+        log.print(' ');
+        log.println(getHealthName(health));
+      }
+    }
+    if (health == TempSensorHealth::FRESH || health == TempSensorHealth::NOISY)
+      usable |= uint8_t(1 << i);
+  }
+  if (!new_temp)
+    return false;
+
+  CentiCelsius t[4];
+  for (uint8_t i = 0; i < 4; ++i)
+    if (usable & (1 << i))
+      t[i] = getSensor(i).get_t();
+
+  // estimate missing temperatures, if possible (only plausible estimates are used)
+  auto estimate = [](long centi) {
+    CentiCelsius e(int16_t(constrain(centi, long(INT16_MIN), long(INT16_MAX))));
+    return (e < HEALTH_MIN_TEMP || e > HEALTH_MAX_TEMP) ? CentiCelsius() : e;
+  };
+  uint8_t missing = uint8_t(~usable & 15);
+  uint8_t estimated = 0;
+  if (missing == 1 || missing == 2 || missing == 4 || missing == 8) {
+    // heat balance T1 + T3 = T2 + T4, solved for the missing sensor
+    long balance = 0;
+    for (uint8_t i = 0; i < 4; ++i)
+      if (usable & (1 << i))
+        balance += (i & 1) ? -long(t[i].toCenti()) : long(t[i].toCenti());
+    uint8_t index = (missing == 1) ? 0 : (missing == 2) ? 1 : (missing == 4) ? 2 : 3;
+    t[index] = estimate((index & 1) ? balance : -balance);
+    if (t[index].isValid())
+      estimated = missing;
+  } else if ((missing & 1) && (usable & 6) == 6 &&
+             efficiency_ >= ESTIMATE_MIN_EFFICIENCY && efficiency_ <= ESTIMATE_MAX_EFFICIENCY) {
+    // efficiency eff = (T2 - T1) / (T3 - T1), solved for T1
+    t[0] = estimate((100L * t[1].toCenti() - long(efficiency_) * t[2].toCenti()) / (100 - efficiency_));
+    if (t[0].isValid())
+      estimated = 1;
+  }
+  if (estimated != estimated_) {
+    health_pending_ |= uint8_t(estimated ^ estimated_);
+    estimated_ = estimated;
+  }
+
+  bool changed = false;
+  for (uint8_t i = 0; i < 4; ++i) {
+    if (t[i] != t_[i]) {
+      t_[i] = t[i];
+      changed = true;
+    }
+  }
+
+  if (changed && (usable & 7) == 7) {
+    // compute efficiency from measured temperatures only, keep the last one otherwise
+    auto diff_out = t_[2] - t_[0];
+    if (diff_out.absolute() > CentiCelsius(10)) {
+      auto diff_in = t_[1] - t_[0];
+      efficiency_ = int((100L * diff_in.toCenti()) / diff_out.toCenti());
+      efficiency_ = constrain(efficiency_, 0, 100);
+    } else {
+      efficiency_ = 0;
+    }
+  }
+
+  if (health_pending_)
+    sendHealth();
+  return changed;
+}
+
+TempSensors::TempSensor& TempSensors::getSensor(uint8_t index)
+{
+  switch (index) {
+    case 0: return t1_;
+    case 1: return t2_;
+    case 2: return t3_;
+    default: return t4_;
+  }
+}
+
+bool TempSensors::isPending(uint8_t index) const
+{
+  return const_cast<TempSensors*>(this)->getSensor(index).isPending();
+}
+
+TempSensorHealth TempSensors::getHealth(uint8_t index) const
+{
+  return const_cast<TempSensors*>(this)->getSensor(index).getHealth();
+}
+
+bool TempSensors::isHealthy(uint8_t index) const
+{
+  auto health = getHealth(index);
+  return health == TempSensorHealth::FRESH || health == TempSensorHealth::NOISY;
+}
+
+const __FlashStringHelper* TempSensors::getHealthName(TempSensorHealth health)
+{
+  switch (health) {
+    case TempSensorHealth::FRESH:         return F("fresh");
+    case TempSensorHealth::STALE:         return F("stale");
+    case TempSensorHealth::STUCK:         return F("stuck");
+    case TempSensorHealth::OUT_OF_RANGE:  return F("range");
+    case TempSensorHealth::NOISY:         return F("noisy");
+    default:                              return F("?");
+  }
+}
+
+CentiCelsius TempSensors::getThresholdMargin(const TempSensor& s) const
+{
+  CentiCelsius margin = NO_THRESHOLD_MARGIN;
+  auto check = [&margin](CentiCelsius t, CentiCelsius threshold) {
+    auto d = (t - threshold).absolute();
+    if (d < margin)
+      margin = d;
+  };
+  auto t1 = get_t1_outside(), t3 = get_t3_outlet(), t4 = get_t4_exhaust();
+  if (&s == &t1_) {
+    check(t1, CentiCelsius(0));  // antifreeze
+    check(t1, config_.getBypassTempAussenluftMin());
+    if (t3.isValid())
+      check(t1, t3 - config_.getBypassHysteresisTemp());
+  } else if (&s == &t3_) {
+    check(t3, config_.getBypassTempAbluftMin());
+    if (t1.isValid())
+      check(t3, t1 + config_.getBypassHysteresisTemp());
+  } else if (&s == &t4_) {
+    check(t4, Antifreeze::EXHAUST_ANTIFREEZE_TEMP_THRESHOLD);
+    check(t4, Antifreeze::EXHAUST_ANTIFREEZE_TEMP_THRESHOLD + config_.getAntifreezeHystereseTemp());
+  }
+  return margin;
 }
 
 bool TempSensors::mqttReceiveMsg(const StringView& topic, const StringView& s)
@@ -153,22 +620,36 @@ bool TempSensors::mqttReceiveMsg(const StringView& topic, const StringView& s)
   if (topic == MQTTTopic::CmdGetTemp) {
     forceSend();
   }
+  else if (topic == MQTTTopic::KwlDebugsetTempSensorGetvalues) {
+    diag_pending_ = 15;
+    sendDiagnostics();
+  }
+  else if (topic == MQTTTopic::KwlDebugsetTempSensorResetvalues) {
+    t1_.resetCounters();
+    t2_.resetCounters();
+    t3_.resetCounters();
+    t4_.resetCounters();
+  }
 #ifdef DEBUG
   // TODO this should also disable updating temperatures via sensors
   else if (topic == MQTTTopic::KwlDebugsetTemperaturAussenluft) {
-    get_t1_outside() = s.toDouble();
+    getSensor(0).set_t(CentiCelsius::fromDouble(s.toDouble()));
+    updateTemperatures(true);
     forceSend();
   }
   else if (topic == MQTTTopic::KwlDebugsetTemperaturZuluft) {
-    get_t2_inlet() = s.toDouble();
+    getSensor(1).set_t(CentiCelsius::fromDouble(s.toDouble()));
+    updateTemperatures(true);
     forceSend();
   }
   else if (topic == MQTTTopic::KwlDebugsetTemperaturAbluft) {
-    get_t3_outlet() = s.toDouble();
+    getSensor(2).set_t(CentiCelsius::fromDouble(s.toDouble()));
+    updateTemperatures(true);
     forceSend();
   }
   else if (topic == MQTTTopic::KwlDebugsetTemperaturFortluft) {
-    get_t4_exhaust() = s.toDouble();
+    getSensor(3).set_t(CentiCelsius::fromDouble(s.toDouble()));
+    updateTemperatures(true);
     forceSend();
   }
 #endif
@@ -187,20 +668,73 @@ void TempSensors::sendMQTT() {
 
   uint8_t bitmask = 31;
   publish_task_.publish([this, bitmask]() mutable {
-    if (last_mqtt_t1_ > INVALID || KWLConfig::SendErroneousMeasurement)
-      if (!publish_if(bitmask, uint8_t(1), MQTTTopic::KwlTemperaturAussenluft, last_mqtt_t1_, 2, KWLConfig::RetainTemperature))
+    if (last_mqtt_t1_.isValid() || KWLConfig::SendErroneousMeasurement)
+      if (!publish_if(bitmask, uint8_t(1), MQTTTopic::KwlTemperaturAussenluft, FixedPoint(last_mqtt_t1_.toCenti(), 2), KWLConfig::RetainTemperature))
         return false;
-    if (last_mqtt_t2_ > INVALID || KWLConfig::SendErroneousMeasurement)
-      if (!publish_if(bitmask, uint8_t(2), MQTTTopic::KwlTemperaturZuluft, last_mqtt_t2_, 2, KWLConfig::RetainTemperature))
+    if (last_mqtt_t2_.isValid() || KWLConfig::SendErroneousMeasurement)
+      if (!publish_if(bitmask, uint8_t(2), MQTTTopic::KwlTemperaturZuluft, FixedPoint(last_mqtt_t2_.toCenti(), 2), KWLConfig::RetainTemperature))
         return false;
-    if (last_mqtt_t3_ > INVALID || KWLConfig::SendErroneousMeasurement)
-      if (!publish_if(bitmask, uint8_t(4), MQTTTopic::KwlTemperaturAbluft, last_mqtt_t3_, 2, KWLConfig::RetainTemperature))
+    if (last_mqtt_t3_.isValid() || KWLConfig::SendErroneousMeasurement)
+      if (!publish_if(bitmask, uint8_t(4), MQTTTopic::KwlTemperaturAbluft, FixedPoint(last_mqtt_t3_.toCenti(), 2), KWLConfig::RetainTemperature))
         return false;
-    if (last_mqtt_t4_ > INVALID || KWLConfig::SendErroneousMeasurement)
-      if (!publish_if(bitmask, uint8_t(8), MQTTTopic::KwlTemperaturFortluft, last_mqtt_t4_, 2, KWLConfig::RetainTemperature))
+    if (last_mqtt_t4_.isValid() || KWLConfig::SendErroneousMeasurement)
+      if (!publish_if(bitmask, uint8_t(8), MQTTTopic::KwlTemperaturFortluft, FixedPoint(last_mqtt_t4_.toCenti(), 2), KWLConfig::RetainTemperature))
         return false;
     if (!publish_if(bitmask, uint8_t(16), MQTTTopic::KwlEffiency, getEfficiency(), KWLConfig::RetainTemperature))
       return false;
     return true;
   });
 }
+
+void TempSensors::sendHealth()
+{
+  // pending sensors are kept in health_pending_, so a restarted send doesn't lose any
+  health_publish_task_.publish([this]() {
+    for (uint8_t i = 0; i < 4; ++i) {
+      auto mask = uint8_t(1 << i);
+      if (!(health_pending_ & mask))
+        continue;
+      const __FlashStringHelper* topic;
+      switch (i) {
+        case 0: topic = MQTTTopic::KwlHealthAussenluft; break;
+        case 1: topic = MQTTTopic::KwlHealthZuluft; break;
+        case 2: topic = MQTTTopic::KwlHealthAbluft; break;
+        default: topic = MQTTTopic::KwlHealthFortluft; break;
+      }
+      char buffer[20];
+      strlcpy_P(buffer, reinterpret_cast<const char*>(getHealthName(getSensor(i).getHealth())), sizeof(buffer));
+      if (isEstimated(i))
+        strlcat_P(buffer, PSTR(",estimated"), sizeof(buffer));
+      if (!publish(topic, buffer, KWLConfig::RetainTemperature))
+        return false;
+      health_pending_ &= ~mask;
+    }
+    return true;
+  });
+}
+
+void TempSensors::sendDiagnostics()
+{
+  // pending sensors are kept in diag_pending_, so a restarted send doesn't lose any
+  diag_publish_task_.publish([this]() {
+    for (uint8_t i = 0; i < 4; ++i) {
+      auto mask = uint8_t(1 << i);
+      if (!(diag_pending_ & mask))
+        continue;
+      auto& s = getSensor(i);
+      auto rom = s.getROM();
+      char topic[MQTTTopic::KwlDebugstateTempSensor.length() + 2];
+      char buffer[80];
+      MQTTTopic::KwlDebugstateTempSensor.store(topic);
+      topic[MQTTTopic::KwlDebugstateTempSensor.length()] = char('1' + i);
+      topic[MQTTTopic::KwlDebugstateTempSensor.length() + 1] = 0;
+      snprintf_P(buffer, sizeof(buffer), PSTR("crc %u timeout %u disconnect %u res %u rom %02x%02x%02x%02x%02x%02x%02x%02x"),
+                 s.getCrcErrors(), s.getTimeouts(), s.getDisconnects(), s.getResolution(),
+                 rom[0], rom[1], rom[2], rom[3], rom[4], rom[5], rom[6], rom[7]);
+      if (!publish(topic, buffer, false))
+        return false;
+      diag_pending_ &= ~mask;
+    }
+    return true;
+  });
+}
@@ -25,14 +25,42 @@
 
 #include "TimeScheduler.h"
 #include "MessageHandler.h"
+#include "OneWireAsync.h"
+#include "CentiCelsius.h"
 
-#include <OneWire.h>            // OneWire Temperatursensoren
-#include <DallasTemperature.h>  // https://www.milesburton.com/Dallas_Temperature_Control_Library
+class KWLPersistentConfig;
+
+/// Health of a temperature sensor.
+enum class TempSensorHealth : uint8_t
+{
+  FRESH,        ///< Sensor delivers plausible readings.
+  STALE,        ///< No reading for a longer time (also sensor missing or not yet detected).
+  STUCK,        ///< Reading didn't change for a very long time (also at full resolution).
+  OUT_OF_RANGE, ///< Reading outside of the range possible in the ventilation system.
+  NOISY         ///< Readings jump (reading is still used).
+};
 
 /*!
  * @brief Collection of temperature sensors of the ventilation system.
  *
- * Sensors array will update in a loop scheduled by task scheduler.
+ * Sensors array will update in a loop scheduled by task scheduler. Each sensor
+ * has its own bus, so the sensors are addressed via Skip ROM and their ROM
+ * is only read once and cached in EEPROM. All bus transactions run in the
+ * background via OneWireAsync, so reading a sensor doesn't block the loop.
+ *
+ * Bus errors are counted per sensor and published to debug topics on the
+ * first error in a row, when a sensor is given up and on request.
+ *
+ * Health of each sensor is evaluated from the age of the last reading, time
+ * since the last change, range of the reading and residuals of the filter.
+ * If a sensor is unhealthy (except for noisy), its temperature is estimated
+ * from other sensors:
+ *   - from heat balance of the heat exchanger with the same air volume in
+ *     both directions: T1 + T3 = T2 + T4 (condensation in the exhaust air
+ *     makes the estimate less exact in winter),
+ *   - if more sensors fail, T1 is estimated from T2, T3 and the last
+ *     efficiency of heat exchange: T1 = (T2 - eff * T3) / (1 - eff).
+ * Health and use of the estimate are published per sensor.
  */
 class TempSensors : private MessageHandler
 {
@@ -47,87 +75,219 @@ class TempSensors : private MessageHandler
      */
     explicit TempSensor(uint8_t pin);
 
-    /// Initialize the sensor.
-    void begin();
+    /*!
+     * @brief Initialize the sensor, it will be discovered by subsequent loops.
+     *
+     * @param rom ROM of the sensor cached in EEPROM (all zeroes, if unknown).
+     */
+    void begin(const uint8_t* rom);
 
-    /// Execute one loop, returns true if temperature read.
+    /*!
+     * @brief Execute one loop.
+     *
+     * @return true, if asynchronous transaction was started, which must be
+     *    finished by finish().
+     */
     bool loop();
 
-    /// Get measured temperature or INVALID.
-    inline double get_t() const { return t_; }
+    /// Finish transaction started by loop(), returns true if temperature read.
+    bool finish();
+
+    /*!
+     * @brief Adapt resolution for next conversions after a new reading.
+     *
+     * @param margin distance of the temperature to the nearest decision threshold.
+     * @param min_resolution minimum resolution in bits for stable temperatures.
+     */
+    void adaptResolution(CentiCelsius margin, uint8_t min_resolution);
+
+    /// Check whether the sensor didn't deliver a temperature yet, but isn't considered missing.
+    inline bool isPending() const { return !t_.isValid() && retry_count_ < MAX_RETRIES; }
+
+    /// Check whether the sensor is pending and didn't start the first conversion yet.
+    inline bool isStarting() const { return isPending() && state_ != State::READ; }
+
+    /// Get current resolution in bits.
+    inline uint8_t getResolution() const { return resolution_; }
+
+    /// Get measured temperature (invalid, if not available).
+    inline CentiCelsius get_t() const { return t_; }
+
+    /// Set temperature from outside (for debugging), counts as a fresh reading.
+    void set_t(CentiCelsius t);
+
+    /// Evaluate health of the sensor at a given time.
+    TempSensorHealth evaluateHealth(unsigned long now) const;
+
+    /// Get health as of the last evaluation.
+    inline TempSensorHealth getHealth() const { return health_; }
 
-    /// Get measured temperature or INVALID.
-    inline double& get_t() { return t_; }
+    /// Set health after evaluation.
+    inline void setHealth(TempSensorHealth health) { health_ = health; }
+
+    /// Get filtered temperature (invalid, if not available).
+    CentiCelsius getFiltered() const;
+
+    /// Get estimated temperature change per minute (0 if not available).
+    CentiCelsius getSlope() const;
+
+    /// Get ROM of the sensor (all zeroes, if not known yet).
+    inline const uint8_t* getROM() const { return rom_; }
+
+    /// Check whether a different ROM was discovered since the last call.
+    inline bool romChanged() { bool res = rom_changed_; rom_changed_ = false; return res; }
+
+    /// Check whether error counters changed since the last call (only on first error in a row and on giving up the sensor).
+    inline bool countersChanged() { bool res = counters_changed_; counters_changed_ = false; return res; }
+
+    /// Get count of data with wrong CRC.
+    inline uint16_t getCrcErrors() const { return crc_errors_; }
+
+    /// Get count of transactions which didn't finish in time.
+    inline uint16_t getTimeouts() const { return timeouts_; }
+
+    /// Get count of transactions without presence pulse.
+    inline uint16_t getDisconnects() const { return disconnects_; }
+
+    /// Reset error counters.
+    void resetCounters();
 
   private:
-    /// Maximum wait time to wait for sensor to respond before reporting INVALID and retrying (5s).
-    static constexpr uint8_t MAX_WAIT_TIME = 3;
-    /// After how many errors do we consider temperature sensor to be dead (~1 min).
+    /// State of the sensor query.
+    enum class State : uint8_t
+    {
+      DISCOVER,   ///< Read ROM of the sensor.
+      POWER,      ///< Read power supply mode.
+      CONFIGURE,  ///< Write resolution to the scratchpad.
+      CONVERT,    ///< Start temperature conversion.
+      READ        ///< Read converted temperature from the scratchpad.
+    };
+
+    /// After how many errors do we consider temperature sensor to be dead (~20s).
     static constexpr uint8_t MAX_RETRIES = 5;
 
-    void retry();
+    /// Count an error, invalidate temperature after too many errors and restart in given state.
+    void fail(uint16_t& counter, State restart);
+
+    /// Update alpha-beta filter with a new reading in 1/16C.
+    void filter(int16_t raw);
 
-    OneWire onewire_ifc_;       ///< Interface on which to read.
-    DallasTemperature sensor_;  ///< Sensor.
-    DeviceAddress address_;     ///< Sensor address.
-    int8_t state_ = 0;          ///< Current query state.
-    uint8_t retry_count_ = 0;   ///< Retry count.
-    double t_ = INVALID;        ///< Current temperature.
+    /// Update noise estimate with a filter residual in 1/65536C.
+    void updateNoise(int32_t residual);
+
+    OneWireAsync bus_;          ///< Bus with the sensor.
+    uint8_t rom_[8] = {};       ///< Sensor ROM.
+    uint8_t scratchpad_[9] = {};  ///< Buffer for data being read.
+    State state_ = State::DISCOVER; ///< Current query state.
+    uint8_t retry_count_ = 0;   ///< Count of consecutive errors.
+    bool parasite_ = false;     ///< Set if the sensor is powered parasitically.
+    bool rom_changed_ = false;  ///< Set if a different ROM was discovered.
+    bool counters_changed_ = false; ///< Set if error counters changed and should be reported.
+    uint8_t resolution_ = 12;   ///< Requested resolution in bits.
+    uint8_t sensor_resolution_ = 12; ///< Resolution set in the sensor.
+    uint8_t stable_count_ = 0;  ///< Count of readings without significant change.
+    bool resolution_changed_ = false; ///< Set if resolution changed since last reading.
+    uint16_t crc_errors_ = 0;   ///< Count of data with wrong CRC.
+    uint16_t timeouts_ = 0;     ///< Count of transactions which didn't finish in time.
+    uint16_t disconnects_ = 0;  ///< Count of transactions without presence pulse.
+    bool filter_valid_ = false; ///< Set if filter state is valid.
+    int32_t filter_t_ = 0;      ///< Filtered temperature in 1/65536C.
+    int32_t filter_slope_ = 0;  ///< Estimated temperature change in 1/65536C per second.
+    unsigned long filter_ms_ = 0; ///< Time of the last filter update.
+    CentiCelsius delta_{0};     ///< Change of temperature against previous reading.
+    CentiCelsius t_;            ///< Current temperature.
+    unsigned long read_ms_ = 0;   ///< Time of the last successful reading.
+    unsigned long change_ms_ = 0; ///< Time of the last change of the reading.
+    uint16_t noise_ = 0;        ///< Average absolute filter residual in 1/800C.
+    TempSensorHealth health_ = TempSensorHealth::STALE; ///< Health as of the last evaluation.
   };
 
 public:
-  /// Construct sensor array.
-  TempSensors();
+  /*!
+   * @brief Construct sensor array.
+   *
+   * @param config configuration with publish policy for temperatures and sensor ROMs.
+   */
+  explicit TempSensors(KWLPersistentConfig& config);
 
-  /// Start sensors.
+  /// Start sensors (they are discovered in the background).
   void begin(Print& initTrace);
 
-  /// Constant for invalid temperature.
-  static constexpr double INVALID = -127.0;
-
-  /// Get the temperature of outside air being pulled into the device (or INVALID if not available).
-  inline double get_t1_outside() const { return t1_.get_t(); }
-  /// Get the temperature of inlet air being pushed into the house (or INVALID if not available).
-  inline double get_t2_inlet() const { return t2_.get_t(); }
-  /// Get the temperature of outlet air being pulled from the house (or INVALID if not available).
-  inline double get_t3_outlet() const { return t3_.get_t(); }
-  /// Get the temperature of exhaust air being pushed to outside (or INVALID if not available).
-  inline double get_t4_exhaust() const { return t4_.get_t(); }
-
-  /// Get the temperature of outside air being pulled into the device (or INVALID if not available).
-  inline double& get_t1_outside() { return t1_.get_t(); }
-  /// Get the temperature of inlet air being pushed into the house (or INVALID if not available).
-  inline double& get_t2_inlet() { return t2_.get_t(); }
-  /// Get the temperature of outlet air being pulled from the house (or INVALID if not available).
-  inline double& get_t3_outlet() { return t3_.get_t(); }
-  /// Get the temperature of exhaust air being pushed to outside (or INVALID if not available).
-  inline double& get_t4_exhaust() { return t4_.get_t(); }
+  /// Get the temperature of outside air being pulled into the device (invalid, if not available, may be estimated).
+  inline CentiCelsius get_t1_outside() const { return t_[0]; }
+  /// Get the temperature of inlet air being pushed into the house (invalid, if not available, may be estimated).
+  inline CentiCelsius get_t2_inlet() const { return t_[1]; }
+  /// Get the temperature of outlet air being pulled from the house (invalid, if not available, may be estimated).
+  inline CentiCelsius get_t3_outlet() const { return t_[2]; }
+  /// Get the temperature of exhaust air being pushed to outside (invalid, if not available, may be estimated).
+  inline CentiCelsius get_t4_exhaust() const { return t_[3]; }
+
+  /// Get filtered temperature of exhaust air (invalid, if not available).
+  inline CentiCelsius get_t4_exhaust_filtered() const { return t4_.getFiltered(); }
+  /// Get change of exhaust air temperature per minute (0 if not available).
+  inline CentiCelsius get_t4_exhaust_slope() const { return t4_.getSlope(); }
+
+  /// Check whether sensor by index (0-3) is still being detected at startup (no temperature yet).
+  bool isPending(uint8_t index) const;
+
+  /// Get health of sensor by index (0-3).
+  TempSensorHealth getHealth(uint8_t index) const;
+
+  /// Check whether sensor by index (0-3) delivers usable readings (fresh or noisy).
+  bool isHealthy(uint8_t index) const;
+
+  /// Check whether temperature of sensor by index (0-3) is estimated from other sensors.
+  inline bool isEstimated(uint8_t index) const { return (estimated_ & (1 << index)) != 0; }
+
+  /// Get name of the health state (e.g., "stale").
+  static const __FlashStringHelper* getHealthName(TempSensorHealth health);
 
   /// Get efficiency of the heat exchange in %.
   inline int getEfficiency() const { return efficiency_; }
 
   /// Force sending temperature messages via MQTT independent of timing.
-  inline void forceSend() { sendMQTT(); }
+  inline void forceSend() { sendMQTT(); health_pending_ = 15; sendHealth(); }
 
 private:
   void run();
+  /// Get sensor by index (0-3).
+  TempSensor& getSensor(uint8_t index);
+  /// Get distance of the sensor temperature to the nearest threshold of antifreeze or bypass control.
+  CentiCelsius getThresholdMargin(const TempSensor& s) const;
   virtual bool mqttReceiveMsg(const StringView& topic, const StringView& s) override;
 
+  /// Evaluate health of sensors and update temperatures and efficiency, return true if a temperature changed.
+  bool updateTemperatures(bool new_temp);
+
   /// Send messages via MQTT.
   void sendMQTT();
 
+  /// Send health of sensors flagged in health_pending_ via MQTT.
+  void sendHealth();
+
+  /// Send error counters of sensors flagged in diag_pending_ via MQTT.
+  void sendDiagnostics();
+
   TempSensor t1_; ///< Outside/intake temperature.
   TempSensor t2_; ///< Temperature of inlet air being pushed into the house.
   TempSensor t3_; ///< (Inside) temperature of outlet air being pulled from the house.
   TempSensor t4_; ///< Temperature of exhaust air being pushed to the outside.
+  int8_t pending_ = -1;       ///< Index of the sensor with transaction in progress or -1.
+  uint8_t diag_pending_ = 0;  ///< Bitmask of sensors with error counters to publish.
+  CentiCelsius t_[4];         ///< Current temperatures (measured or estimated).
+  uint8_t estimated_ = 0;     ///< Bitmask of sensors with estimated temperature.
+  uint8_t health_pending_ = 0;  ///< Bitmask of sensors with health to publish.
   int efficiency_ = 0;        ///< Current efficiency of heat exchange.
   uint8_t next_sensor_ = 0;   ///< Next sensor to talk to.
-  uint8_t mqtt_ticks_ = 0;    ///< MQTT seconds ticks.
-  double last_mqtt_t1_ = INVALID; ///< Last T1 temperature sent via MQTT.
-  double last_mqtt_t2_ = INVALID; ///< Last T2 temperature sent via MQTT.
-  double last_mqtt_t3_ = INVALID; ///< Last T3 temperature sent via MQTT.
-  double last_mqtt_t4_ = INVALID; ///< Last T4 temperature sent via MQTT.
+  uint16_t mqtt_ticks_ = 0;   ///< MQTT seconds ticks.
+  KWLPersistentConfig& config_; ///< Configuration with publish policy and sensor ROMs.
+  CentiCelsius last_mqtt_t1_;  ///< Last T1 temperature sent via MQTT.
+  CentiCelsius last_mqtt_t2_;  ///< Last T2 temperature sent via MQTT.
+  CentiCelsius last_mqtt_t3_;  ///< Last T3 temperature sent via MQTT.
+  CentiCelsius last_mqtt_t4_;  ///< Last T4 temperature sent via MQTT.
   PublishTask publish_task_;      ///< Task to publish measurements.
+  PublishTask diag_publish_task_; ///< Task to publish error counters.
+  PublishTask health_publish_task_; ///< Task to publish health of sensors.
   Scheduler::TaskTimingStats stats_;              ///< Task runtime statistics.
   Scheduler::TimedTask<TempSensors> timer_task_;  ///< Task for reading sensors periodically.
 };
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+#include "DHTAsync.h"
+
+#include <avr/interrupt.h>
+
+/// Length of request pulse (at least 1ms, sensor ignores pulses longer than ~20ms).
+static constexpr unsigned long REQUEST_LOW_US = 1100;
+/// Time to record the answer (response 20-40us + 160us, 40 bits up to 130us each).
+static constexpr unsigned long CAPTURE_US = 6000;
+/// Minimum period of the response (80us low + 80us high).
+static constexpr uint8_t RESPONSE_MIN_US = 120;
+/// Maximum period of the response.
+static constexpr uint8_t RESPONSE_MAX_US = 220;
+/// Minimum period of one bit (50us low + 26-28us high for 0).
+static constexpr uint8_t BIT_MIN_US = 50;
+/// Maximum period of one bit (50us low + 70us high for 1).
+static constexpr uint8_t BIT_MAX_US = 200;
+/// Bit periods longer than this are 1 bits.
+static constexpr uint8_t BIT_THRESHOLD_US = 100;
+
+DHTAsync* volatile DHTAsync::s_active_ = nullptr;
+
+#if defined(PCINT0_vect)
+ISR(PCINT0_vect)
+{
+  DHTAsync::interrupt();
+}
+#endif
+#if defined(PCINT1_vect)
+ISR(PCINT1_vect)
+{
+  DHTAsync::interrupt();
+}
+#endif
+#if defined(PCINT2_vect)
+ISR(PCINT2_vect)
+{
+  DHTAsync::interrupt();
+}
+#endif
+
+DHTAsync::DHTAsync(uint8_t pin) noexcept :
+  in_reg_(portInputRegister(digitalPinToPort(pin))),
+  mode_reg_(portModeRegister(digitalPinToPort(pin))),
+  out_reg_(portOutputRegister(digitalPinToPort(pin))),
+  pcicr_(digitalPinToPCICR(pin)),
+  pcmsk_(digitalPinToPCMSK(pin)),
+  mask_(digitalPinToBitMask(pin)),
+  pcicr_bit_(digitalPinToPCICRbit(pin)),
+  pcmsk_bit_(digitalPinToPCMSKbit(pin))
+{}
+
+void DHTAsync::begin() noexcept
+{
+  release();
+}
+
+unsigned long DHTAsync::advance() noexcept
+{
+  switch (phase_) {
+    case Phase::IDLE:
+    default:
+      driveLow();
+      phase_ = Phase::REQUEST;
+      status_ = Status::BUSY;
+      return REQUEST_LOW_US;
+
+    case Phase::REQUEST:
+      edges_ = 0;
+      last_level_ = true;
+      if (pcicr_) {
+        uint8_t sreg = SREG;
+        cli();
+        if (s_active_) {
+          // another sensor is recording, retry the whole read later
+          SREG = sreg;
+          release();
+          phase_ = Phase::IDLE;
+          status_ = Status::NO_RESPONSE;
+          return 0;
+        }
+        s_active_ = this;
+        release();
+        *pcmsk_ |= _BV(pcmsk_bit_);
+        PCIFR = _BV(pcicr_bit_);
+        *pcicr_ |= _BV(pcicr_bit_);
+        SREG = sreg;
+        phase_ = Phase::CAPTURE;
+        return CAPTURE_US;
+      }
+      release();
+      poll();
+      finish();
+      return 0;
+
+    case Phase::CAPTURE:
+      abort();
+      finish();
+      return 0;
+  }
+}
+
+void DHTAsync::abort() noexcept
+{
+  uint8_t sreg = SREG;
+  cli();
+  if (s_active_ == this) {
+    *pcmsk_ &= ~_BV(pcmsk_bit_);
+    s_active_ = nullptr;
+  }
+  SREG = sreg;
+  release();
+  phase_ = Phase::IDLE;
+  if (status_ == Status::BUSY)
+    status_ = Status::IDLE;
+}
+
+void DHTAsync::interrupt() noexcept
+{
+  auto self = s_active_;
+  if (!self)
+    return;
+  bool level = self->sample();
+  if (level == self->last_level_)
+    return; // change on another pin of the same group
+  self->last_level_ = level;
+  if (level)
+    return;
+  self->record(micros());
+  if (self->edges_ >= EDGE_COUNT) {
+    *self->pcmsk_ &= ~_BV(self->pcmsk_bit_);
+    s_active_ = nullptr;
+  }
+}
+
+void DHTAsync::record(unsigned long now) noexcept
+{
+  uint8_t edges = edges_;
+  if (edges) {
+    unsigned long period = now - last_edge_;
+    periods_[edges - 1] = period > 255 ? 255 : uint8_t(period);
+  }
+  last_edge_ = now;
+  edges_ = edges + 1;
+}
+
+void DHTAsync::poll() noexcept
+{
+  unsigned long start = micros();
+  while (edges_ < EDGE_COUNT && micros() - start < CAPTURE_US) {
+    bool level = sample();
+    if (level != last_level_) {
+      last_level_ = level;
+      if (!level)
+        record(micros());
+    }
+  }
+}
+
+void DHTAsync::finish() noexcept
+{
+  // periods are written by the interrupt, don't let the compiler cache them
+  asm volatile("" ::: "memory");
+  phase_ = Phase::IDLE;
+  uint8_t edges = edges_;
+  if (!edges)
+    status_ = Status::NO_RESPONSE;
+  else
+    status_ = decode(periods_, edges - 1, temperature_, humidity_);
+}
+
+DHTAsync::Status DHTAsync::decode(const uint8_t* periods, uint8_t count, int16_t& temperature, uint16_t& humidity) noexcept
+{
+  if (count < EDGE_COUNT - 1)
+    return Status::TIMEOUT;
+  if (periods[0] < RESPONSE_MIN_US || periods[0] > RESPONSE_MAX_US)
+    return Status::TIMEOUT;
+  uint8_t data[5] = {0, 0, 0, 0, 0};
+  for (uint8_t i = 0; i < 40; ++i) {
+    uint8_t period = periods[i + 1];
+    if (period < BIT_MIN_US || period > BIT_MAX_US)
+      return Status::TIMEOUT;
+    // MSB first
+    data[i >> 3] <<= 1;
+    if (period > BIT_THRESHOLD_US)
+      data[i >> 3] |= 1;
+  }
+  if (uint8_t(data[0] + data[1] + data[2] + data[3]) != data[4])
+    return Status::CHECKSUM;
+  humidity = (uint16_t(data[0]) << 8) | data[1];
+  // temperature is in sign-magnitude format
+  int16_t t = int16_t((uint16_t(data[2] & 0x7f) << 8) | data[3]);
+  temperature = (data[2] & 0x80) ? -t : t;
+  return Status::DONE;
+}
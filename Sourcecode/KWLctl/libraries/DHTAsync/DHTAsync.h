@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2019 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Non-blocking DHT22 (AM2302) reader.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+/*!
+ * @brief Non-blocking DHT22 (AM2302) reader.
+ *
+ * Standard DHT library bit-bangs the whole answer of the sensor with
+ * interrupts disabled, so each read blocks the caller for ~5ms and delays
+ * other interrupts (e.g., fan tachometer).
+ *
+ * This class splits the read into phases, which are executed by repeated
+ * calls to advance() from a scheduler task:
+ *   - drive the data line low to request a measurement,
+ *   - release the line and record falling edges of the answer,
+ *   - decode recorded edges and verify the checksum.
+ *
+ * If the pin supports pin change interrupts (on Arduino Mega e.g., A8-A14,
+ * 10-13 or 50-53), edges are timestamped by the interrupt handler in the
+ * background. Otherwise, edges are polled in advance() with interrupts
+ * enabled, which blocks the caller for ~5ms, but doesn't delay other
+ * interrupts. Only one sensor can record edges at a time.
+ *
+ * @note This class defines handlers for all pin change interrupt vectors,
+ *    so it cannot be combined with other users of pin change interrupts
+ *    (e.g., SoftwareSerial).
+ */
+class DHTAsync
+{
+public:
+  /// Status of the last read.
+  enum class Status : uint8_t
+  {
+    IDLE,         ///< No read started.
+    BUSY,         ///< Read in progress.
+    DONE,         ///< Read finished, values valid.
+    NO_RESPONSE,  ///< Sensor didn't answer the request.
+    TIMEOUT,      ///< Answer incomplete or with invalid timing.
+    CHECKSUM      ///< Answer complete, but checksum doesn't match.
+  };
+
+  /// Count of falling edges in a complete answer (response + 40 bits + end).
+  static constexpr uint8_t EDGE_COUNT = 42;
+
+  /*!
+   * @brief Construct reader on a given pin.
+   *
+   * @param pin data pin of the sensor.
+   */
+  explicit DHTAsync(uint8_t pin) noexcept;
+
+  /// Initialize pin (release the data line with pull-up).
+  void begin() noexcept;
+
+  /*!
+   * @brief Advance the read by one phase.
+   *
+   * The first call starts a new read. Subsequent calls must come after
+   * the returned time passes (later call is OK, but if the request pulse
+   * is too long, the sensor doesn't answer).
+   *
+   * @return time in microseconds to the next call or 0, if the read finished
+   *    (see getStatus()).
+   */
+  unsigned long advance() noexcept;
+
+  /// Abort running read (if any) and release the data line.
+  void abort() noexcept;
+
+  /// Get the status of the last read.
+  Status getStatus() const noexcept { return status_; }
+
+  /// Get temperature of the last successful read in 0.1C.
+  int16_t getTemperature() const noexcept { return temperature_; }
+
+  /// Get relative humidity of the last successful read in 0.1%.
+  uint16_t getHumidity() const noexcept { return humidity_; }
+
+  /// Check whether the pin supports recording edges in the background.
+  bool hasInterrupt() const noexcept { return pcicr_ != nullptr; }
+
+  /*!
+   * @brief Decode the answer of the sensor.
+   *
+   * Each period is the time between two subsequent falling edges. The
+   * first period is the response of the sensor (80us low, 80us high),
+   * each following one a bit (50us low, 26-28us high for 0, 70us high for 1).
+   *
+   * @param periods periods between falling edges in microseconds (saturated at 255).
+   * @param count count of periods.
+   * @param temperature set to temperature in 0.1C on success.
+   * @param humidity set to relative humidity in 0.1% on success.
+   * @return DONE on success, otherwise the error.
+   */
+  static Status decode(const uint8_t* periods, uint8_t count, int16_t& temperature, uint16_t& humidity) noexcept;
+
+  /// Pin change interrupt handler, do not call directly.
+  static void interrupt() noexcept;
+
+private:
+  /// Phase of the read.
+  enum class Phase : uint8_t
+  {
+    IDLE,     ///< No read running.
+    REQUEST,  ///< Data line driven low.
+    CAPTURE   ///< Recording answer.
+  };
+
+  /// Record one falling edge at a given time.
+  void record(unsigned long now) noexcept;
+
+  /// Record edges by polling the pin.
+  void poll() noexcept;
+
+  /// Finish recording and decode the answer.
+  void finish() noexcept;
+
+  inline void driveLow() noexcept { *out_reg_ &= ~mask_; *mode_reg_ |= mask_; }
+  inline void release() noexcept { *mode_reg_ &= ~mask_; *out_reg_ |= mask_; }
+  inline bool sample() const noexcept { return (*in_reg_ & mask_) != 0; }
+
+  volatile uint8_t* in_reg_;    ///< Input register of the pin.
+  volatile uint8_t* mode_reg_;  ///< Direction register of the pin.
+  volatile uint8_t* out_reg_;   ///< Output register of the pin.
+  volatile uint8_t* pcicr_;     ///< Pin change interrupt control register or nullptr.
+  volatile uint8_t* pcmsk_;     ///< Pin change mask register.
+  uint8_t mask_;                ///< Bit mask of the pin in registers.
+  uint8_t pcicr_bit_;           ///< Bit of the pin change interrupt group in PCICR.
+  uint8_t pcmsk_bit_;           ///< Bit of the pin in PCMSK.
+  Phase phase_ = Phase::IDLE;   ///< Current phase.
+  volatile Status status_ = Status::IDLE; ///< Status of the last read.
+  volatile uint8_t edges_ = 0;  ///< Count of recorded falling edges.
+  bool last_level_ = true;      ///< Level of the pin at the last interrupt.
+  unsigned long last_edge_ = 0; ///< Time of the last falling edge.
+  uint8_t periods_[EDGE_COUNT - 1]; ///< Periods between falling edges.
+  int16_t temperature_ = 0;     ///< Last temperature in 0.1C.
+  uint16_t humidity_ = 0;       ///< Last humidity in 0.1%.
+
+  /// Reader currently recording edges in the background.
+  static DHTAsync* volatile s_active_;
+};
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+#include "Logger.h"
+
+#include <Udp.h>
+
+namespace
+{
+  /// Size of message header in the ring (level, length).
+  static constexpr unsigned HEADER_SIZE = 2;
+
+  /// Syslog facility (local0) shifted for priority value.
+  static constexpr uint8_t SYSLOG_FACILITY = 16 << 3;
+
+  /// Syslog severity for each log level.
+  const uint8_t SYSLOG_SEVERITY[] PROGMEM = { 7, 3, 4, 6, 7 };
+
+  uint8_t s_ring[LOG_BUFFER_SIZE];
+  /// Index of the oldest message in the ring.
+  unsigned s_head = 0;
+  /// Count of used bytes in the ring.
+  unsigned s_used = 0;
+  /// Count of characters of the oldest message already written (incl. header and CR/LF).
+  uint8_t s_written = 0;
+
+  HardwareSerial* s_serial = nullptr;
+
+  UDP* s_syslog_udp = nullptr;
+  IPAddress s_syslog_server;
+  uint16_t s_syslog_port = 0;
+  const char* s_syslog_host = nullptr;
+
+  /// Get byte in the ring at given offset from the oldest message.
+  inline uint8_t at(unsigned offset)
+  {
+    return s_ring[(s_head + offset) % LOG_BUFFER_SIZE];
+  }
+}
+
+LogLevel Logger::s_level_ = LogLevel::INFO;
+unsigned Logger::s_dropped_ = 0;
+unsigned Logger::s_truncated_ = 0;
+unsigned Logger::s_syslog_failed_ = 0;
+
+LogLine::LogLine(LogLevel level) noexcept :
+  level_(level),
+  enabled_(Logger::isEnabled(level))
+{}
+
+LogLine::~LogLine()
+{
+  if (size_)
+    commit();
+}
+
+size_t LogLine::write(uint8_t c)
+{
+  if (!enabled_)
+    return 1;
+  if (c == '\n') {
+    commit();
+  } else if (c != '\r') {
+    if (size_ < LOG_LINE_SIZE)
+      buffer_[size_++] = char(c);
+    else
+      truncated_ = true;
+  }
+  return 1;
+}
+
+void LogLine::commit() noexcept
+{
+  if (truncated_)
+    ++Logger::s_truncated_;
+  if (!Logger::store(level_, buffer_, size_))
+    ++Logger::s_dropped_;
+  size_ = 0;
+  truncated_ = false;
+}
+
+void Logger::begin(HardwareSerial* serial, LogLevel level) noexcept
+{
+  s_serial = serial;
+  s_level_ = level;
+}
+
+void Logger::setSyslog(UDP* udp, IPAddress server, uint16_t port, const char* hostname) noexcept
+{
+  s_syslog_udp = udp;
+  s_syslog_server = server;
+  s_syslog_port = port;
+  s_syslog_host = hostname;
+}
+
+bool Logger::store(LogLevel level, const char* msg, uint8_t len) noexcept
+{
+  if (s_used + HEADER_SIZE + len > LOG_BUFFER_SIZE)
+    return false;
+  unsigned pos = (s_head + s_used) % LOG_BUFFER_SIZE;
+  s_ring[pos] = uint8_t(level);
+  pos = (pos + 1) % LOG_BUFFER_SIZE;
+  s_ring[pos] = len;
+  pos = (pos + 1) % LOG_BUFFER_SIZE;
+  // copy in at most two chunks
+  unsigned first = LOG_BUFFER_SIZE - pos;
+  if (first > len)
+    first = len;
+  memcpy(s_ring + pos, msg, first);
+  memcpy(s_ring, msg + first, len - first);
+  s_used += HEADER_SIZE + len;
+  return true;
+}
+
+void Logger::sendSyslog(uint8_t level, uint8_t len) noexcept
+{
+  if (!s_syslog_udp->beginPacket(s_syslog_server, s_syslog_port)) {
+    ++s_syslog_failed_;
+    return;
+  }
+  char header[48];
+  auto pri = SYSLOG_FACILITY | pgm_read_byte(&SYSLOG_SEVERITY[level <= uint8_t(LogLevel::TRACE) ? level : 0]);
+  snprintf_P(header, sizeof(header), PSTR("<%u>%s kwl: "), pri, s_syslog_host ? s_syslog_host : "");
+  s_syslog_udp->write(reinterpret_cast<const uint8_t*>(header), strlen(header));
+  for (uint8_t i = 0; i < len; ++i)
+    s_syslog_udp->write(at(HEADER_SIZE + i));
+  if (!s_syslog_udp->endPacket())
+    ++s_syslog_failed_;
+}
+
+void Logger::loop() noexcept
+{
+  while (s_used) {
+    uint8_t level = at(0);
+    uint8_t len = at(1);
+    if (s_serial) {
+      // message text followed by CR/LF, only as much as fits into TX buffer
+      auto available = s_serial->availableForWrite();
+      while (s_written < len + 2) {
+        if (available-- <= 0)
+          return;   // continue next time
+        if (s_written < len)
+          s_serial->write(at(HEADER_SIZE + s_written));
+        else
+          s_serial->write(s_written == len ? '\r' : '\n');
+        ++s_written;
+      }
+    }
+    if (s_syslog_udp)
+      sendSyslog(level, len);
+    s_head = (s_head + HEADER_SIZE + len) % LOG_BUFFER_SIZE;
+    s_used -= HEADER_SIZE + len;
+    s_written = 0;
+    if (s_syslog_udp)
+      return;   // at most one datagram per call
+  }
+}
+
+bool Logger::hasPending() noexcept
+{
+  return s_used != 0;
+}
+
+void Logger::flush() noexcept
+{
+  while (s_used)
+    loop();
+  if (s_serial)
+    s_serial->flush();
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Asynchronous leveled logging into a RAM ring buffer.
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+class UDP;
+
+/*
+ * NOTE: Size of the RAM ring buffer for log messages in bytes. Each message
+ * consumes 2B plus its length.
+ */
+#ifndef LOG_BUFFER_SIZE
+#define LOG_BUFFER_SIZE 384
+#endif
+
+/*
+ * NOTE: Maximum length of one log message. The message is assembled on the
+ * stack in LogLine, longer messages are truncated.
+ */
+#ifndef LOG_LINE_SIZE
+#define LOG_LINE_SIZE 96
+#endif
+
+/// Log level of a message (severity).
+enum class LogLevel : uint8_t
+{
+  OFF = 0,      ///< No messages (only usable as module level).
+  ERROR = 1,    ///< Error, which needs attention.
+  WARNING = 2,  ///< Unexpected condition, which is handled.
+  INFO = 3,     ///< Informational message about normal operation.
+  TRACE = 4     ///< Debugging message (not DEBUG, which is a configuration macro).
+};
+
+/*!
+ * @brief Check whether messages of a given level are compiled in for a module.
+ *
+ * @param module_level maximum level of messages of the module (constant expression).
+ * @param level level of the message (ERROR, WARNING, INFO or TRACE).
+ */
+#define LOG_ENABLED(module_level, level) \
+  (static_cast<uint8_t>(LogLevel::level) <= static_cast<uint8_t>(module_level))
+
+/*!
+ * @brief Log a message with a given level for a module.
+ *
+ * Use as <tt>LOG(KWLConfig::LogLevelFan, INFO).println(F("Message"));</tt>. If the
+ * level is above the module level, the whole statement including the arguments
+ * and their flash literals is removed by the compiler. For messages composed
+ * of several parts, use LOG_ENABLED() with a named LogLine.
+ *
+ * @param module_level maximum level of messages of the module (constant expression).
+ * @param level level of the message (ERROR, WARNING, INFO or TRACE).
+ */
+#define LOG(module_level, level) \
+  if (!LOG_ENABLED(module_level, level)) {} else LogLine(LogLevel::level)
+
+/*!
+ * @brief One log message, which is assembled using Print methods.
+ *
+ * Create an instance on the stack, print the message into it using standard
+ * Print methods and the message is stored in the log ring when the instance
+ * is destroyed or println() is called (each line is a separate message).
+ * Storing never blocks. If there is no space left in the ring, the message
+ * is dropped and counted.
+ *
+ * @note Each instance consumes about LOG_LINE_SIZE bytes of stack.
+ */
+class LogLine : public Print
+{
+public:
+  LogLine(const LogLine&) = delete;
+  LogLine& operator=(const LogLine&) = delete;
+
+  /// Start a new message with a given level.
+  explicit LogLine(LogLevel level) noexcept;
+
+  /// Store the message, if not stored yet.
+  ~LogLine();
+
+  using Print::write;
+
+  virtual size_t write(uint8_t c) override;
+
+private:
+  /// Store the message in the log ring and start a new one.
+  void commit() noexcept;
+
+  char buffer_[LOG_LINE_SIZE];  ///< Message being assembled.
+  uint8_t size_ = 0;            ///< Current message size.
+  LogLevel level_;              ///< Level of the message.
+  bool enabled_;                ///< Set if the level is enabled.
+  bool truncated_ = false;      ///< Set if the message didn't fit.
+};
+
+/*!
+ * @brief Asynchronous leveled logging into a RAM ring buffer.
+ *
+ * Messages are stored by LogLine in a RAM ring buffer in constant time and
+ * written out opportunistically by loop(), which should be called from a poll
+ * task. Only as many characters as fit into the serial TX buffer are written,
+ * so logging never blocks on the serial port.
+ *
+ * Optionally, messages are also sent to a syslog server via UDP (one
+ * datagram per message, facility local0).
+ */
+class Logger
+{
+public:
+  /*!
+   * @brief Start logging.
+   *
+   * @param serial serial port to write messages to (or @c nullptr for none).
+   * @param level maximum level of messages to store.
+   */
+  static void begin(HardwareSerial* serial, LogLevel level) noexcept;
+
+  /// Set maximum level of messages to store.
+  static void setLevel(LogLevel level) noexcept { s_level_ = level; }
+
+  /// Check whether messages of the given level are stored.
+  static bool isEnabled(LogLevel level) noexcept { return level != LogLevel::OFF && uint8_t(level) <= uint8_t(s_level_); }
+
+  /*!
+   * @brief Mirror messages to a syslog server.
+   *
+   * @param udp UDP socket to send messages (can be shared with other clients) or
+   *    @c nullptr to stop sending.
+   * @param server,port syslog server address.
+   * @param hostname host name to report (must stay valid).
+   */
+  static void setSyslog(UDP* udp, IPAddress server, uint16_t port, const char* hostname) noexcept;
+
+  /// Write out pending messages without blocking (call from a poll task).
+  static void loop() noexcept;
+
+  /// Check whether there are messages not yet written out.
+  static bool hasPending() noexcept;
+
+  /// Write out all pending messages, blocking if needed (e.g., before reset).
+  static void flush() noexcept;
+
+  /// Get count of messages dropped, because the ring was full.
+  static unsigned getDroppedMessages() noexcept { return s_dropped_; }
+
+  /// Get count of messages truncated, because they were too long.
+  static unsigned getTruncatedMessages() noexcept { return s_truncated_; }
+
+  /// Get count of messages which could not be sent to syslog server.
+  static unsigned getSyslogFailures() noexcept { return s_syslog_failed_; }
+
+private:
+  friend class LogLine;
+
+  /// Store one message in the ring, return false if no space.
+  static bool store(LogLevel level, const char* msg, uint8_t len) noexcept;
+
+  /// Send current message to syslog server.
+  static void sendSyslog(uint8_t level, uint8_t len) noexcept;
+
+  static LogLevel s_level_;
+  static unsigned s_dropped_;
+  static unsigned s_truncated_;
+  static unsigned s_syslog_failed_;
+};
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+#include "MemoryMonitor.h"
+
+#include <Arduino.h>
+
+// Symbols provided by the linker and avr-libc malloc implementation.
+extern uint8_t __heap_start;
+extern uint8_t* __brkval;
+
+/// Layout of avr-libc free list entry (see avr-libc stdlib_private.h).
+struct __freelist
+{
+  size_t sz;
+  struct __freelist* nx;
+};
+extern struct __freelist* __flp;
+
+/// Value used to paint free memory at boot (must match the value in paint_stack()).
+static constexpr uint8_t STACK_CANARY = 0xc5;
+
+// Paint free memory with canary value before anything else runs.
+void paint_stack(void) \
+  __attribute__((naked)) \
+  __attribute__((used)) \
+  __attribute__((section(".init1")));
+void paint_stack(void)
+{
+  __asm__ __volatile__ (
+    "    ldi r30, lo8(_end)     \n"
+    "    ldi r31, hi8(_end)     \n"
+    "    ldi r24, 0xc5          \n"
+    "    ldi r25, hi8(__stack)  \n"
+    "    rjmp 2f                \n"
+    "1:  st Z+, r24             \n"
+    "2:  cpi r30, lo8(__stack)  \n"
+    "    cpc r31, r25           \n"
+    "    brlo 1b                \n"
+    "    breq 1b                \n"
+  );
+}
+
+static inline const uint8_t* heap_top()
+{
+  return __brkval ? __brkval : &__heap_start;
+}
+
+unsigned MemoryMonitor::scanMinFreeStack() noexcept
+{
+  auto p = heap_top();
+  auto sp = reinterpret_cast<const uint8_t*>(SP);
+  unsigned count = 0;
+  while (p < sp && *p == STACK_CANARY) {
+    ++p;
+    ++count;
+  }
+  return count;
+}
+
+unsigned MemoryMonitor::getFreeMemory() noexcept
+{
+  return unsigned(SP - reinterpret_cast<unsigned>(heap_top()));
+}
+
+unsigned MemoryMonitor::getHeapTop() noexcept
+{
+  return reinterpret_cast<unsigned>(heap_top());
+}
+
+unsigned MemoryMonitor::getFreeListSize() noexcept
+{
+  unsigned size = 0;
+  for (auto p = __flp; p; p = p->nx)
+    size += p->sz;
+  return size;
+}
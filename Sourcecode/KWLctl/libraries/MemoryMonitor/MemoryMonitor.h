@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Monitoring of free stack and heap memory.
+ */
+#pragma once
+
+/*!
+ * @brief Monitoring of free stack and heap memory.
+ *
+ * At boot, the whole free RAM between the end of static data and the top
+ * of the stack is painted with a canary value. Later, the painted area can
+ * be scanned from the top of the heap upwards to find out, how deep the
+ * stack ever grew (the canary values are overwritten by the stack).
+ *
+ * @note Scanning starts at current heap top. If the heap shrinks after some
+ *    memory was freed, stale heap data is not repainted, so the reported free
+ *    stack may be lower than the actual one (conservative estimate).
+ */
+class MemoryMonitor
+{
+public:
+  /*!
+   * @brief Scan painted stack area to compute minimum-ever free stack.
+   *
+   * The scan is linear in the size of the free area (~1ms per 4KB).
+   *
+   * @return minimum free stack in bytes since boot.
+   */
+  static unsigned scanMinFreeStack() noexcept;
+
+  /// Get current free memory between heap top and stack pointer in bytes.
+  static unsigned getFreeMemory() noexcept;
+
+  /// Get current heap top address.
+  static unsigned getHeapTop() noexcept;
+
+  /// Get total size of memory blocks in heap free list in bytes.
+  static unsigned getFreeListSize() noexcept;
+};
@@ -20,16 +20,71 @@
 
 #include "MessageHandler.h"
 
+#include <Logger.h>
 #include <Arduino.h>
 #include <stdlib.h>
 
 PublishTask* PublishTask::s_first_task_ = nullptr;
 bool PublishTask::s_has_tasks_ = false;
+bool PublishTask::s_running_ = false;
 
 MessageHandler* MessageHandler::s_first_handler = nullptr;
 MessageHandler::publish_callback MessageHandler::s_cb_ = nullptr;
+MessageHandler::stream_publish_callback MessageHandler::s_stream_cb_ = nullptr;
 void *MessageHandler::s_cb_arg_ = nullptr;
 bool MessageHandler::s_debug_ = false;
+MessageHandler::classify_callback MessageHandler::s_classify_cb_ = nullptr;
+uint8_t MessageHandler::s_queue_[MESSAGE_HANDLER_QUEUE_SIZE];
+unsigned MessageHandler::s_queue_used_ = 0;
+unsigned MessageHandler::s_queue_dropped_ = 0;
+uint8_t MessageHandler::s_rate_msgs_ = 0;
+uint16_t MessageHandler::s_rate_bytes_ = 0;
+uint8_t MessageHandler::s_burst_msgs_ = 0;
+uint16_t MessageHandler::s_burst_bytes_ = 0;
+unsigned long MessageHandler::s_msg_tokens_ = 0;
+unsigned long MessageHandler::s_byte_tokens_ = 0;
+unsigned long MessageHandler::s_bucket_time_ = 0;
+unsigned long MessageHandler::s_throttled_ = 0;
+unsigned long MessageHandler::s_failed_ = 0;
+MessageHandler::topic_group_callback MessageHandler::s_topic_group_cb_ = nullptr;
+PublishStats MessageHandler::s_stats_[MESSAGE_HANDLER_STATS_GROUPS];
+
+namespace
+{
+  /// Size of queued message header (expensive flag, topic length, payload length).
+  static constexpr unsigned QUEUE_HEADER_SIZE = 3;
+
+  /// Maximum time to account for in one token refill (to prevent overflows).
+  static constexpr unsigned long MAX_REFILL_TIME = 10000;
+
+  /// Output only counting the bytes written, to determine payload size.
+  class CountingPrint : public Print
+  {
+  public:
+    virtual size_t write(uint8_t) override { ++count_; return 1; }
+    virtual size_t write(const uint8_t*, size_t size) override { count_ += size; return size; }
+    unsigned count() const noexcept { return count_; }
+  private:
+    unsigned count_ = 0;
+  };
+
+  /// Output writing into a buffer, if no stream publisher is set. Excess output is dropped.
+  class BufferPrint : public Print
+  {
+  public:
+    BufferPrint(char* buffer, unsigned size) noexcept : p_(buffer), end_(buffer + size) {}
+    virtual size_t write(uint8_t c) override
+    {
+      if (p_ == end_)
+        return 0;
+      *p_++ = char(c);
+      return 1;
+    }
+  private:
+    char* p_;
+    char* end_;
+  };
+}
 
 PublishTask::PublishTask() :
   next_(s_first_task_)
@@ -44,7 +99,9 @@ bool PublishTask::loop()
   while (cur) {
     if (cur->invoker_) {
       retval = true;
+      s_running_ = true;
       auto res = cur->invoker_(cur->closure_space_);
+      s_running_ = false;
       if (res)
         cur->invoker_ = nullptr;  // sent successfully
     }
@@ -54,6 +111,32 @@ bool PublishTask::loop()
   return retval;
 }
 
+char* FixedPoint::toString(char* buffer) const noexcept
+{
+  char* p = buffer;
+  unsigned long v;
+  if (value < 0) {
+    *p++ = '-';
+    v = 0UL - static_cast<unsigned long>(value);
+  } else {
+    v = static_cast<unsigned long>(value);
+  }
+  // write digits backwards, fractional part first
+  char tmp[MAX_STRING_SIZE];
+  uint8_t len = 0;
+  uint8_t frac = decimals;
+  do {
+    tmp[len++] = char('0' + v % 10);
+    v /= 10;
+    if (frac && --frac == 0)
+      tmp[len++] = '.';
+  } while (v || frac || tmp[len - 1] == '.');
+  while (len)
+    *p++ = tmp[--len];
+  *p = 0;
+  return p;
+}
+
 MessageHandler::MessageHandler(const __FlashStringHelper* name) :
   next_(s_first_handler),
   name_(name)
@@ -70,18 +153,140 @@ void MessageHandler::begin(publish_callback cb, void *cb_arg, bool debug)
   s_debug_ = debug;
 }
 
+void MessageHandler::setRateLimit(uint8_t msgs_per_s, uint16_t bytes_per_s, uint8_t burst_msgs, uint16_t burst_bytes) noexcept
+{
+  s_rate_msgs_ = msgs_per_s;
+  s_rate_bytes_ = bytes_per_s;
+  s_burst_msgs_ = burst_msgs ? burst_msgs : 1;
+  s_burst_bytes_ = burst_bytes;
+  s_msg_tokens_ = s_burst_msgs_ * 1000UL;
+  s_byte_tokens_ = s_burst_bytes_ * 1000UL;
+  s_bucket_time_ = millis();
+}
+
+bool MessageHandler::consumeTokens(unsigned size, bool force) noexcept
+{
+  // refill (tokens are kept in 1/1000 units, so rate * ms gives the increment)
+  auto now = millis();
+  auto elapsed = now - s_bucket_time_;
+  if (elapsed > MAX_REFILL_TIME)
+    elapsed = MAX_REFILL_TIME;
+  s_bucket_time_ = now;
+  if (s_rate_msgs_) {
+    s_msg_tokens_ += elapsed * s_rate_msgs_;
+    if (s_msg_tokens_ > s_burst_msgs_ * 1000UL)
+      s_msg_tokens_ = s_burst_msgs_ * 1000UL;
+  }
+  if (s_rate_bytes_) {
+    s_byte_tokens_ += elapsed * s_rate_bytes_;
+    if (s_byte_tokens_ > s_burst_bytes_ * 1000UL)
+      s_byte_tokens_ = s_burst_bytes_ * 1000UL;
+  }
+
+  // check, a message bigger than burst size can be sent with full bucket
+  unsigned long msg_cost = s_rate_msgs_ ? 1000UL : 0;
+  unsigned long byte_cost = 0;
+  if (s_rate_bytes_)
+    byte_cost = (size < s_burst_bytes_ ? size : s_burst_bytes_) * 1000UL;
+  if (s_msg_tokens_ < msg_cost || s_byte_tokens_ < byte_cost) {
+    if (!force)
+      return false;
+    // cannot be retried, send anyway and leave the bucket empty
+    s_msg_tokens_ = s_msg_tokens_ < msg_cost ? 0 : s_msg_tokens_ - msg_cost;
+    s_byte_tokens_ = s_byte_tokens_ < byte_cost ? 0 : s_byte_tokens_ - byte_cost;
+    return true;
+  }
+  s_msg_tokens_ -= msg_cost;
+  s_byte_tokens_ -= byte_cost;
+  return true;
+}
+
+void MessageHandler::resetPublishStats() noexcept
+{
+  memset(s_stats_, 0, sizeof(s_stats_));
+}
+
+void MessageHandler::accountPublish(const char* topic, bool sent, unsigned size) noexcept
+{
+  uint8_t group = s_topic_group_cb_ ? s_topic_group_cb_(topic) : 0;
+  if (group >= MESSAGE_HANDLER_STATS_GROUPS)
+    group = MESSAGE_HANDLER_STATS_GROUPS - 1;
+  auto& stats = s_stats_[group];
+  if (sent) {
+    if (stats.sent == 0xffff) {
+      // consolidate to prevent overflow
+      stats.sent >>= 1;
+      stats.bytes >>= 1;
+    }
+    ++stats.sent;
+    stats.bytes += size;
+  } else {
+    // failures are scaled separately, so a long outage doesn't destroy sent statistics
+    if (stats.failed == 0xffff)
+      stats.failed >>= 1;
+    ++stats.failed;
+  }
+}
+
 bool MessageHandler::publish(const char* topic, const char* payload, bool retained)
 {
+  unsigned size = strlen(topic) + strlen(payload);
+  if ((s_rate_msgs_ || s_rate_bytes_) &&
+      !consumeTokens(size + MESSAGE_HANDLER_PUBLISH_OVERHEAD, !PublishTask::isRunning())) {
+    ++s_throttled_;
+    return false; // will be retried later by the publish task
+  }
   bool sent = s_cb_(s_cb_arg_, topic, payload, retained);
+  if (!sent)
+    ++s_failed_;
+  accountPublish(topic, sent, size);
   if (s_debug_ && sent) {
-    Serial.print(F("MQTT send "));
-    Serial.print(topic);
-    Serial.print(':');
-    Serial.print(' ');
-    Serial.print(payload);
+    LogLine log(LogLevel::TRACE);
+    log.print(F("MQTT send "));
+    log.print(topic);
+    log.print(':');
+    log.print(' ');
+    log.print(payload);
     if (retained)
-      Serial.print(F(" [retained]"));
-    Serial.println();
+      log.print(F(" [retained]"));
+    log.println();
+  }
+  return sent;
+}
+
+bool MessageHandler::publish(const char* topic, payload_writer writer, void* arg, bool retained)
+{
+  CountingPrint counter;
+  writer(arg, counter);
+  unsigned length = counter.count();
+  if (!s_stream_cb_) {
+    char buffer[length + 1];
+    memset(buffer, ' ', length);
+    buffer[length] = 0;
+    BufferPrint out(buffer, length);
+    writer(arg, out);
+    return publish(topic, buffer, retained);
+  }
+  unsigned size = strlen(topic) + length;
+  if ((s_rate_msgs_ || s_rate_bytes_) &&
+      !consumeTokens(size + MESSAGE_HANDLER_PUBLISH_OVERHEAD, !PublishTask::isRunning())) {
+    ++s_throttled_;
+    return false; // will be retried later by the publish task
+  }
+  bool sent = s_stream_cb_(s_cb_arg_, topic, length, writer, arg, retained);
+  if (!sent)
+    ++s_failed_;
+  accountPublish(topic, sent, size);
+  if (s_debug_ && sent) {
+    LogLine log(LogLevel::TRACE);
+    log.print(F("MQTT send "));
+    log.print(topic);
+    log.print(F(": <"));
+    log.print(length);
+    log.print(F("B streamed>"));
+    if (retained)
+      log.print(F(" [retained]"));
+    log.println();
   }
   return sent;
 }
@@ -115,29 +320,39 @@ bool MessageHandler::publish(const char* topic, double payload, unsigned char pr
   return publish(topic, buffer, retained);
 }
 
+bool MessageHandler::publish(const char* topic, FixedPoint payload, bool retained)
+{
+  char buffer[FixedPoint::MAX_STRING_SIZE];
+  payload.toString(buffer);
+  return publish(topic, buffer, retained);
+}
+
 void MessageHandler::mqttMessageReceived(char* topic, uint8_t* payload, unsigned int length)
 {
   payload[length] = 0;  // ensure NUL termination
   const StringView topicStr(topic);
   const StringView s(reinterpret_cast<const char*>(payload), length);
   if (s_debug_) {
-    Serial.print(F("MQTT receive ["));
-    Serial.write(topicStr.c_str(), topicStr.length());
-    Serial.print(F("]: ["));
-    Serial.write(payload, length);
-    Serial.println(']');
+    LogLine log(LogLevel::TRACE);
+    log.print(F("MQTT receive ["));
+    log.write(topicStr.c_str(), topicStr.length());
+    log.print(F("]: ["));
+    log.write(payload, length);
+    log.println(']');
   }
 
   auto handler = s_first_handler;
   while (handler) {
     if (s_debug_) {
-      Serial.print(F("- trying MQTT handler: "));
-      Serial.println(handler->name_);
+      LogLine log(LogLevel::TRACE);
+      log.print(F("- trying MQTT handler: "));
+      log.println(handler->name_);
     }
     if (handler->mqttReceiveMsg(topicStr, s)) {
       if (s_debug_) {
-        Serial.print(F("MQTT message handled by: "));
-        Serial.println(handler->name_);
+        LogLine log(LogLevel::TRACE);
+        log.print(F("MQTT message handled by: "));
+        log.println(handler->name_);
       }
       return;
     }
@@ -145,6 +360,56 @@ void MessageHandler::mqttMessageReceived(char* topic, uint8_t* payload, unsigned
   }
 
   if (s_debug_) {
-    Serial.println(F("Unexpected MQTT message received, no handler found"));
+    LogLine(LogLevel::TRACE).println(F("Unexpected MQTT message received, no handler found"));
+  }
+}
+
+void MessageHandler::mqttMessageQueued(char* topic, uint8_t* payload, unsigned int length)
+{
+  auto topic_len = strlen(topic);
+  auto size = QUEUE_HEADER_SIZE + topic_len + 1 + length + 1;
+  if (topic_len > 255 || length > 255 || s_queue_used_ + size > sizeof(s_queue_)) {
+    ++s_queue_dropped_;
+    if (s_debug_) {
+      LogLine log(LogLevel::TRACE);
+      log.print(F("MQTT queue full, dropping message ["));
+      log.print(topic);
+      log.println(']');
+    }
+    return;
+  }
+  auto p = s_queue_ + s_queue_used_;
+  p[0] = (s_classify_cb_ && s_classify_cb_(StringView(topic))) ? 1 : 0;
+  p[1] = uint8_t(topic_len);
+  p[2] = uint8_t(length);
+  p += QUEUE_HEADER_SIZE;
+  memcpy(p, topic, topic_len + 1);
+  p += topic_len + 1;
+  memcpy(p, payload, length);
+  p[length] = 0;
+  s_queue_used_ += size;
+}
+
+bool MessageHandler::processQueue(unsigned long budget)
+{
+  auto start = micros();
+  bool first = true;
+  while (s_queue_used_) {
+    bool expensive = s_queue_[0] != 0;
+    if (expensive && !first)
+      break;  // process expensive message alone in the next call
+    uint8_t topic_len = s_queue_[1];
+    uint8_t length = s_queue_[2];
+    auto topic = reinterpret_cast<char*>(s_queue_ + QUEUE_HEADER_SIZE);
+    auto payload = s_queue_ + QUEUE_HEADER_SIZE + topic_len + 1;
+    // NOTE: handlers may queue new messages, which are appended behind this one
+    mqttMessageReceived(topic, payload, length);
+    auto size = QUEUE_HEADER_SIZE + topic_len + 1 + length + 1;
+    s_queue_used_ -= size;
+    memmove(s_queue_, s_queue_ + size, s_queue_used_);
+    if (expensive || micros() - start >= budget)
+      break;
+    first = false;
   }
+  return s_queue_used_ != 0;
 }
@@ -30,6 +30,8 @@
 #include <StringView.h>
 #include <avr/pgmspace.h>
 
+class Print;
+
 /*
  * NOTE: Messages are normally never published synchronously to save RAM. However,
  * you can define this macro before including the header to force trying to send
@@ -38,9 +40,80 @@
  */
 //#define MESSAGE_HANDLER_SYNC_PUBLISH
 
+/*
+ * NOTE: Size of the queue for deferred processing of received messages in bytes
+ * (see MessageHandler::mqttMessageQueued()). Each message consumes 5B plus
+ * the length of its topic and payload.
+ */
+#ifndef MESSAGE_HANDLER_QUEUE_SIZE
+#define MESSAGE_HANDLER_QUEUE_SIZE 192
+#endif
+
+/*
+ * NOTE: Estimated per-message overhead in bytes for rate limiting (MQTT header,
+ * topic prefix added by publish callback). See MessageHandler::setRateLimit().
+ */
+#ifndef MESSAGE_HANDLER_PUBLISH_OVERHEAD
+#define MESSAGE_HANDLER_PUBLISH_OVERHEAD 24
+#endif
+
+/*
+ * NOTE: Number of topic groups for publish statistics (see
+ * MessageHandler::setTopicClassifier()). Each group consumes 8B of RAM.
+ */
+#ifndef MESSAGE_HANDLER_STATS_GROUPS
+#define MESSAGE_HANDLER_STATS_GROUPS 10
+#endif
+
 /// In-place new operator.
 inline void* operator new(size_t, void* ptr) { return ptr; }
 
+/*!
+ * @brief Fixed-point number to publish without floating-point formatting.
+ *
+ * The number is stored as an integer scaled by 10^decimals, e.g., temperature
+ * 21.50 with 2 decimals is stored as 2150. Formatting uses integer arithmetic
+ * only, which is much cheaper than dtostrf() on AVR.
+ */
+struct FixedPoint
+{
+  /// Maximum size of the formatted number including terminating NUL.
+  static constexpr uint8_t MAX_STRING_SIZE = 14;
+
+  /*!
+   * @brief Construct fixed-point number.
+   *
+   * @param v value scaled by 10^d.
+   * @param d number of decimal places (at most 9).
+   */
+  constexpr FixedPoint(long v, uint8_t d) noexcept : value(v), decimals(d) {}
+
+  /*!
+   * @brief Format the number.
+   *
+   * @param buffer buffer of at least MAX_STRING_SIZE bytes.
+   * @return pointer to terminating NUL in the buffer.
+   */
+  char* toString(char* buffer) const noexcept;
+
+  long value;       ///< Value scaled by 10^decimals.
+  uint8_t decimals; ///< Number of decimal places.
+};
+
+/*!
+ * @brief Publish statistics for one group of topics.
+ *
+ * Counters are kept small. When the sent message counter would overflow,
+ * it is halved together with the byte counter, so the average message size
+ * stays meaningful. The failure counter is halved separately.
+ */
+struct PublishStats
+{
+  uint16_t sent;        ///< Count of sent messages.
+  uint16_t failed;      ///< Count of failed publish attempts (incl. retried ones, but not rate-limited ones).
+  unsigned long bytes;  ///< Sum of topic and payload sizes of sent messages.
+};
+
 /*!
  * @brief Task used to publish MQTT messages asynchronously.
  *
@@ -80,7 +153,10 @@ public:
   void publish(Func&& message_writer) {
     static_assert(sizeof(Func) < sizeof(closure_space_), "Too big writer closure, reduce");
   #ifdef MESSAGE_HANDLER_SYNC_PUBLISH
-    if (message_writer())
+    s_running_ = true;
+    bool sent = message_writer();
+    s_running_ = false;
+    if (sent)
       return;   // published immediately synchronously
   #endif
     // now move into closure
@@ -109,6 +185,9 @@ public:
   /// Check if any tasks are pending.
   static bool hasTasks() noexcept { return s_has_tasks_; }
 
+  /// Check if called from a message writer of a publish task (i.e., a failed publish will be retried).
+  static bool isRunning() noexcept { return s_running_; }
+
   /*!
    * @brief Continue sending on all tasks with unsent data in loop().
    *
@@ -127,6 +206,7 @@ private:
   PublishTask* next_;                 ///< Next registered publish task.
 
   static bool s_has_tasks_;           ///< Flag indicating if tasks are pending.
+  static bool s_running_;             ///< Flag indicating that a message writer is running.
   static PublishTask* s_first_task_;  ///< First registered task.
 };
 
@@ -158,6 +238,49 @@ public:
    */
   using publish_callback = bool (*)(void* instance, const char* topic, const char* payload, bool retained);
 
+  /*!
+   * @brief Signature of a payload writer for streamed publishing.
+   *
+   * The writer is called twice within one publish() call, first to determine
+   * payload size and then to send the payload, so it must produce the same
+   * output both times.
+   *
+   * @param arg writer argument as passed to publish().
+   * @param out output to write the payload to.
+   */
+  using payload_writer = void (*)(void* arg, Print& out);
+
+  /*!
+   * @brief Signature of a method publishing a streamed message.
+   *
+   * With PubSubClient, this maps to beginPublish(), writing the payload to the
+   * client and endPublish(), so the payload doesn't need to be buffered.
+   *
+   * @param instance instance pointer as specified in begin().
+   * @param topic message topic.
+   * @param length payload length in bytes.
+   * @param writer,arg payload writer and its argument.
+   * @param retained if set, retain the message on the server.
+   * @return @c true, if the message was sent, @c false, if not.
+   */
+  using stream_publish_callback = bool (*)(void* instance, const char* topic, unsigned length, payload_writer writer, void* arg, bool retained);
+
+  /*!
+   * @brief Signature of a method classifying expensive messages.
+   *
+   * @param topic MQTT topic of the message.
+   * @return @c true, if processing the message is expensive and it should be processed alone.
+   */
+  using classify_callback = bool (*)(const StringView& topic);
+
+  /*!
+   * @brief Signature of a method mapping published topics to statistics groups.
+   *
+   * @param topic MQTT topic of the published message.
+   * @return group index (values >= MESSAGE_HANDLER_STATS_GROUPS map to the last group).
+   */
+  using topic_group_callback = uint8_t (*)(const char* topic);
+
   MessageHandler(const MessageHandler&) = delete;
   MessageHandler& operator=(const MessageHandler&) = delete;
 
@@ -171,17 +294,58 @@ public:
    *
    * @param cb callback for sending messages.
    * @param cb_arg callback argument (instance of PubSubClient).
-   * @param debug if set, print debugging messages to Serial output.
+   * @param debug if set, log debugging messages (see Logger).
    */
   static void begin(publish_callback cb, void *cb_arg, bool debug = false);
 
+  /*!
+   * @brief Set global rate limit for publishing messages.
+   *
+   * Rate limit is implemented as a token bucket for messages and bytes. If not
+   * enough tokens are available, publish() fails without sending, so the message
+   * stays pending in its PublishTask and is retried later. This smooths out bursts
+   * of messages (e.g., after reconnect), which would otherwise overrun network
+   * buffers. Messages published directly outside of a PublishTask would be lost,
+   * so they are never throttled, but they still consume tokens.
+   *
+   * @param msgs_per_s,bytes_per_s sustained rate of messages and bytes (0 for unlimited).
+   * @param burst_msgs,burst_bytes maximum burst size (bucket capacity).
+   */
+  static void setRateLimit(uint8_t msgs_per_s, uint16_t bytes_per_s, uint8_t burst_msgs, uint16_t burst_bytes) noexcept;
+
+  /*!
+   * @brief Set callback for publishing streamed messages.
+   *
+   * @param cb callback or @c nullptr to format streamed messages into a stack buffer.
+   */
+  static void setStreamPublisher(stream_publish_callback cb) noexcept { s_stream_cb_ = cb; }
+
+  /// Get count of publish attempts deferred by rate limit.
+  static unsigned long getThrottledPublishes() noexcept { return s_throttled_; }
+
+  /// Get count of publish attempts which failed to send.
+  static unsigned long getFailedPublishes() noexcept { return s_failed_; }
+
+  /*!
+   * @brief Set classifier mapping published topics to statistics groups.
+   *
+   * @param cb callback classifying topics or @c nullptr to account all messages to group 0.
+   */
+  static void setTopicClassifier(topic_group_callback cb) noexcept { s_topic_group_cb_ = cb; }
+
+  /// Get publish statistics for a topic group.
+  static const PublishStats& getPublishStats(uint8_t group) noexcept { return s_stats_[group]; }
+
+  /// Reset publish statistics of all topic groups.
+  static void resetPublishStats() noexcept;
+
   /*!
    * @brief Publish a message.
    *
    * @param topic message topic.
    * @param payload message payload (string).
    * @param retained if set, retain the message on the server for quick read upon client connect.
-   * @return @c true, if published successfully, @c false otherwise.
+   * @return @c true, if published successfully, @c false otherwise (also if rate-limited).
    */
   static bool publish(const char* topic, const char* payload, bool retained = false);
 
@@ -250,6 +414,31 @@ public:
    */
   static bool publish(const char* topic, double payload, unsigned char precision = 2, bool retained = false);
 
+  /*!
+   * @brief Publish a message.
+   *
+   * Prefer this over floating-point publish(), since it doesn't need dtostrf().
+   *
+   * @param topic message topic.
+   * @param payload message payload (fixed-point number).
+   * @param retained if set, retain the message on the server for quick read upon client connect.
+   * @return @c true, if published successfully, @c false otherwise.
+   */
+  static bool publish(const char* topic, FixedPoint payload, bool retained = false);
+
+  /*!
+   * @brief Publish a message with payload written directly to the network.
+   *
+   * Use this for big messages to avoid formatting them in a buffer first.
+   *
+   * @param topic message topic.
+   * @param writer payload writer, see payload_writer.
+   * @param arg argument to pass to the writer.
+   * @param retained if set, retain the message on the server for quick read upon client connect.
+   * @return @c true, if published successfully, @c false otherwise.
+   */
+  static bool publish(const char* topic, payload_writer writer, void* arg, bool retained = false);
+
   /*!
    * @brief Publish a message to a topic string stored in Flash memory.
    *
@@ -304,6 +493,45 @@ public:
    */
   static void mqttMessageReceived(char* topic, uint8_t* payload, unsigned int length);
 
+  /*!
+   * @brief Queue a new message for deferred processing in processQueue().
+   *
+   * The method signature is the same as for mqttMessageReceived(), so it can be
+   * used with PubSubClient directly as PubSubClient's callback. If the queue is
+   * full, the message is dropped.
+   *
+   * @param topic MQTT topic.
+   * @param payload payload of the MQTT message.
+   * @param length length of the payload.
+   */
+  static void mqttMessageQueued(char* topic, uint8_t* payload, unsigned int length);
+
+  /*!
+   * @brief Process queued messages by calling all registered handlers.
+   *
+   * Messages are processed in the order of arrival until the time budget is
+   * exhausted. A message classified as expensive is only processed as the first
+   * message of the call and it ends the call, so that expensive messages never
+   * run together with other messages in one call.
+   *
+   * @param budget time budget in microseconds (at least one message is processed).
+   * @return @c true, if more messages are queued, @c false otherwise.
+   */
+  static bool processQueue(unsigned long budget);
+
+  /// Check if any messages are queued.
+  static bool hasQueuedMessages() noexcept { return s_queue_used_ != 0; }
+
+  /// Get count of messages dropped due to full queue.
+  static unsigned getDroppedMessages() noexcept { return s_queue_dropped_; }
+
+  /*!
+   * @brief Set classifier for expensive messages.
+   *
+   * @param cb callback classifying messages or @c nullptr to treat all messages as cheap.
+   */
+  static void setExpensiveClassifier(classify_callback cb) noexcept { s_classify_cb_ = cb; }
+
 private:
   /*!
    * @brief Try to handle received message.
@@ -314,12 +542,34 @@ private:
    */
   virtual bool mqttReceiveMsg(const StringView& topic, const StringView& s) = 0;
 
+  /// Check rate limit and consume tokens for a message of given size, if possible (or always, if forced).
+  static bool consumeTokens(unsigned size, bool force) noexcept;
+
+  /// Account a publish attempt in topic group statistics.
+  static void accountPublish(const char* topic, bool sent, unsigned size) noexcept;
+
   MessageHandler* next_;
   const __FlashStringHelper* name_;
   static MessageHandler* s_first_handler;
   static publish_callback s_cb_;
+  static stream_publish_callback s_stream_cb_;
   static void *s_cb_arg_;
   static bool s_debug_;
+  static classify_callback s_classify_cb_;
+  static uint8_t s_queue_[MESSAGE_HANDLER_QUEUE_SIZE];
+  static unsigned s_queue_used_;
+  static unsigned s_queue_dropped_;
+  static uint8_t s_rate_msgs_;
+  static uint16_t s_rate_bytes_;
+  static uint8_t s_burst_msgs_;
+  static uint16_t s_burst_bytes_;
+  static unsigned long s_msg_tokens_;   ///< Available message tokens in 1/1000 messages.
+  static unsigned long s_byte_tokens_;  ///< Available byte tokens in 1/1000 bytes.
+  static unsigned long s_bucket_time_;  ///< Time of last token refill in ms.
+  static unsigned long s_throttled_;
+  static unsigned long s_failed_;
+  static topic_group_callback s_topic_group_cb_;
+  static PublishStats s_stats_[MESSAGE_HANDLER_STATS_GROUPS];
 };
 
 template<typename TopicType, typename PayloadType, typename... Args>
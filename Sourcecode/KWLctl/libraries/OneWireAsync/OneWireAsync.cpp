@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+#include "OneWireAsync.h"
+
+#include <avr/interrupt.h>
+
+/// Timer ticks per microsecond (16MHz clock, prescaler 8).
+static constexpr uint8_t TICKS_PER_US = 2;
+/// Minimum distance of the next compare match from current timer value.
+static constexpr uint16_t MIN_TICKS = 4;
+
+/// Length of reset pulse (at least 480us, leaves margin for interrupt latency).
+static constexpr uint16_t RESET_LOW_US = 500;
+/// Time from the end of reset pulse to sampling presence pulse.
+static constexpr uint16_t PRESENCE_SAMPLE_US = 70;
+/// Time from sampling presence pulse to the first slot.
+static constexpr uint16_t PRESENCE_WAIT_US = 410;
+/// Low time of write 1 slot (busy wait in interrupt).
+static constexpr uint8_t WRITE1_LOW_US = 6;
+/// Length of write 1 slot.
+static constexpr uint16_t WRITE1_SLOT_US = 64;
+/// Low time of write 0 slot (60-120us, leaves margin for interrupt latency).
+static constexpr uint16_t WRITE0_LOW_US = 70;
+/// Recovery time after write 0 slot.
+static constexpr uint16_t WRITE0_RECOVERY_US = 10;
+/// Low time of read slot (busy wait in interrupt).
+static constexpr uint8_t READ_LOW_US = 3;
+/// Time from releasing the bus to sampling in read slot (busy wait in interrupt).
+static constexpr uint8_t READ_SAMPLE_US = 10;
+/// Length of read slot.
+static constexpr uint16_t READ_SLOT_US = 66;
+
+/// Command to address the only device on the bus.
+static constexpr uint8_t CMD_SKIP_ROM = 0xCC;
+/// Command to address a device by its ROM.
+static constexpr uint8_t CMD_MATCH_ROM = 0x55;
+/// Command to read ROM of the only device on the bus.
+static constexpr uint8_t CMD_READ_ROM = 0x33;
+
+OneWireAsync* volatile OneWireAsync::s_active_ = nullptr;
+
+namespace
+{
+  /// Stop the timer and its interrupt.
+  inline void stopTimer()
+  {
+    TIMSK3 &= ~_BV(OCIE3A);
+    TCCR3B = 0;
+  }
+}
+
+ISR(TIMER3_COMPA_vect)
+{
+  OneWireAsync::interrupt();
+}
+
+OneWireAsync::OneWireAsync(uint8_t pin) noexcept :
+  in_reg_(portInputRegister(digitalPinToPort(pin))),
+  mode_reg_(portModeRegister(digitalPinToPort(pin))),
+  out_reg_(portOutputRegister(digitalPinToPort(pin))),
+  mask_(digitalPinToBitMask(pin))
+{}
+
+bool OneWireAsync::start(const uint8_t* tx, uint8_t tx_len, uint8_t* rx, uint8_t rx_len, bool power) noexcept
+{
+  if (tx_len > MAX_TX)
+    return false;
+  uint8_t sreg = SREG;
+  cli();
+  if (s_active_) {
+    SREG = sreg;
+    return false;
+  }
+  s_active_ = this;
+  SREG = sreg;
+
+  memcpy(tx_, tx, tx_len);
+  tx_len_ = tx_len;
+  rx_ = rx;
+  rx_len_ = rx_len;
+  if (rx_len)
+    memset(rx, 0, rx_len);
+  bit_ = 0;
+  power_ = power;
+  state_ = State::RESET;
+  status_ = Status::BUSY;
+
+  // CTC mode with prescaler 8, first step right away
+  TCCR3A = 0;
+  TCCR3B = 0;
+  TCNT3 = 0;
+  OCR3A = MIN_TICKS;
+  TIFR3 = _BV(OCF3A);
+  TIMSK3 |= _BV(OCIE3A);
+  TCCR3B = _BV(WGM32) | _BV(CS31);
+  return true;
+}
+
+uint8_t OneWireAsync::addressCommand(uint8_t* tx, const uint8_t* rom, uint8_t cmd) noexcept
+{
+  if (rom) {
+    tx[0] = CMD_MATCH_ROM;
+    memcpy(tx + 1, rom, 8);
+    tx[9] = cmd;
+    return 10;
+  } else {
+    tx[0] = CMD_SKIP_ROM;
+    tx[1] = cmd;
+    return 2;
+  }
+}
+
+bool OneWireAsync::startCommand(const uint8_t* rom, uint8_t cmd, uint8_t* rx, uint8_t rx_len, bool power) noexcept
+{
+  uint8_t tx[MAX_TX];
+  uint8_t len = addressCommand(tx, rom, cmd);
+  return start(tx, len, rx, rx_len, power);
+}
+
+bool OneWireAsync::startWrite(const uint8_t* rom, uint8_t cmd, const uint8_t* data, uint8_t len, bool power) noexcept
+{
+  uint8_t tx[MAX_TX];
+  uint8_t tx_len = addressCommand(tx, rom, cmd);
+  if (tx_len + len > MAX_TX)
+    return false;
+  memcpy(tx + tx_len, data, len);
+  return start(tx, tx_len + len, nullptr, 0, power);
+}
+
+bool OneWireAsync::startReadROM(uint8_t* rom) noexcept
+{
+  const uint8_t cmd = CMD_READ_ROM;
+  return start(&cmd, 1, rom, 8);
+}
+
+OneWireAsync::Status OneWireAsync::poll() const noexcept
+{
+  // received data are written by the interrupt, don't let the compiler cache them
+  asm volatile("" ::: "memory");
+  return status_;
+}
+
+void OneWireAsync::abort() noexcept
+{
+  uint8_t sreg = SREG;
+  cli();
+  if (s_active_ == this) {
+    stopTimer();
+    s_active_ = nullptr;
+  }
+  release();
+  if (status_ == Status::BUSY)
+    status_ = Status::IDLE;
+  SREG = sreg;
+}
+
+bool OneWireAsync::isBusy() noexcept
+{
+  return s_active_ != nullptr;
+}
+
+uint8_t OneWireAsync::crc8(const uint8_t* data, uint8_t len) noexcept
+{
+  // polynomial x^8 + x^5 + x^4 + 1, LSB first
+  uint8_t crc = 0;
+  while (len--) {
+    uint8_t b = *data++;
+    for (uint8_t i = 0; i < 8; ++i) {
+      uint8_t mix = (crc ^ b) & 1;
+      crc >>= 1;
+      if (mix)
+        crc ^= 0x8C;
+      b >>= 1;
+    }
+  }
+  return crc;
+}
+
+void OneWireAsync::interrupt() noexcept
+{
+  auto self = s_active_;
+  uint16_t us = self ? self->step() : 0;
+  if (!us) {
+    stopTimer();
+    s_active_ = nullptr;
+    return;
+  }
+  // the timer restarted at compare match, so the time is relative to the start of this step
+  uint16_t ticks = us * TICKS_PER_US;
+  uint16_t now = TCNT3;
+  if (ticks < now + MIN_TICKS)
+    ticks = now + MIN_TICKS;
+  OCR3A = ticks - 1;
+}
+
+uint16_t OneWireAsync::step() noexcept
+{
+  switch (state_) {
+    case State::RESET:
+      driveLow();
+      state_ = State::RESET_RELEASE;
+      return RESET_LOW_US;
+
+    case State::RESET_RELEASE:
+      release();
+      state_ = State::PRESENCE;
+      return PRESENCE_SAMPLE_US;
+
+    case State::PRESENCE:
+      if (sample()) {
+        // nobody pulled the bus low
+        status_ = Status::NO_DEVICE;
+        return 0;
+      }
+      state_ = State::SLOT;
+      return PRESENCE_WAIT_US;
+
+    case State::SLOT_RELEASE:
+      release();
+      state_ = State::SLOT;
+      return WRITE0_RECOVERY_US;
+
+    case State::SLOT:
+    default:
+      break;
+  }
+
+  uint8_t mask = 1 << (bit_ & 7);
+  uint8_t index = bit_ >> 3;
+  if (index < tx_len_) {
+    // write slot, LSB first
+    ++bit_;
+    driveLow();
+    if (tx_[index] & mask) {
+      delayMicroseconds(WRITE1_LOW_US);
+      release();
+      return WRITE1_SLOT_US;
+    }
+    state_ = State::SLOT_RELEASE;
+    return WRITE0_LOW_US;
+  }
+  index -= tx_len_;
+  if (index < rx_len_) {
+    // read slot, LSB first
+    ++bit_;
+    driveLow();
+    delayMicroseconds(READ_LOW_US);
+    release();
+    delayMicroseconds(READ_SAMPLE_US);
+    if (sample())
+      rx_[index] |= mask;
+    return READ_SLOT_US;
+  }
+
+  // transaction finished
+  if (power_)
+    driveHigh();
+  status_ = Status::DONE;
+  return 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Interrupt-driven non-blocking OneWire transport.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+/*!
+ * @brief Interrupt-driven non-blocking OneWire transport.
+ *
+ * Standard OneWire library bit-bangs the whole transaction with interrupts
+ * disabled in each bit slot, so a scratchpad read blocks the caller for
+ * several milliseconds and delays other interrupts (e.g., fan tachometer).
+ *
+ * This class executes one OneWire transaction (reset, write bytes, read bytes)
+ * in the background. Each interrupt of hardware timer 3 (compare match A)
+ * advances the transaction by one phase of a bit slot, so interrupts are
+ * disabled for at most ~15us at a time and the foreground only starts the
+ * transaction and polls for its completion.
+ *
+ * Since there is only one timer, only one transaction on all buses can run
+ * at a time. Timer 3 must not be used otherwise (i.e., no PWM on pins 2, 3, 5).
+ */
+class OneWireAsync
+{
+public:
+  /// Status of the transaction.
+  enum class Status : uint8_t
+  {
+    IDLE,       ///< No transaction started.
+    BUSY,       ///< Transaction in progress.
+    DONE,       ///< Transaction finished, data read.
+    NO_DEVICE   ///< No presence pulse detected after reset.
+  };
+
+  /// Maximum number of bytes to write in one transaction (Match ROM + ROM + command + 3B data).
+  static constexpr uint8_t MAX_TX = 13;
+
+  /*!
+   * @brief Construct transport on a given pin.
+   *
+   * @param pin pin of the OneWire bus (with external pull-up resistor).
+   */
+  explicit OneWireAsync(uint8_t pin) noexcept;
+
+  /*!
+   * @brief Start a transaction (reset, write and read).
+   *
+   * @param tx bytes to write after reset (copied).
+   * @param tx_len count of bytes to write (at most MAX_TX).
+   * @param rx buffer to read bytes into, must stay valid until the transaction finishes.
+   * @param rx_len count of bytes to read.
+   * @param power if set, drive the bus high after the transaction to power parasitic devices
+   *    (until the next transaction or abort()).
+   * @return true, if the transaction started, false if another transaction is running.
+   */
+  bool start(const uint8_t* tx, uint8_t tx_len, uint8_t* rx, uint8_t rx_len, bool power = false) noexcept;
+
+  /*!
+   * @brief Start a function command transaction.
+   *
+   * @param rom ROM of the device to address via Match ROM or nullptr to use Skip ROM.
+   * @param cmd function command.
+   * @param rx buffer to read bytes into, must stay valid until the transaction finishes.
+   * @param rx_len count of bytes to read.
+   * @param power if set, drive the bus high after the transaction.
+   * @return true, if the transaction started, false if another transaction is running.
+   */
+  bool startCommand(const uint8_t* rom, uint8_t cmd, uint8_t* rx = nullptr, uint8_t rx_len = 0, bool power = false) noexcept;
+
+  /*!
+   * @brief Start a function command transaction writing data.
+   *
+   * @param rom ROM of the device to address via Match ROM or nullptr to use Skip ROM.
+   * @param cmd function command.
+   * @param data data to write after the command (copied).
+   * @param len count of data bytes (at most 3 with Match ROM).
+   * @param power if set, drive the bus high after the transaction.
+   * @return true, if the transaction started, false if another transaction is running.
+   */
+  bool startWrite(const uint8_t* rom, uint8_t cmd, const uint8_t* data, uint8_t len, bool power = false) noexcept;
+
+  /*!
+   * @brief Start reading ROM of the only device on the bus (Read ROM).
+   *
+   * @param rom buffer for 8 bytes of ROM, must stay valid until the transaction finishes.
+   * @return true, if the transaction started, false if another transaction is running.
+   */
+  bool startReadROM(uint8_t* rom) noexcept;
+
+  /// Get the status of the last transaction (memory barrier for reading received data).
+  Status poll() const noexcept;
+
+  /// Abort running transaction (if any) and release the bus.
+  void abort() noexcept;
+
+  /// Check whether any transaction is running on any bus.
+  static bool isBusy() noexcept;
+
+  /// Timer interrupt handler, do not call directly.
+  static void interrupt() noexcept;
+
+  /// Compute Dallas/Maxim CRC-8 used by ROM and scratchpad.
+  static uint8_t crc8(const uint8_t* data, uint8_t len) noexcept;
+
+private:
+  /// State of the transaction state machine.
+  enum class State : uint8_t
+  {
+    RESET,          ///< Start reset pulse.
+    RESET_RELEASE,  ///< End reset pulse.
+    PRESENCE,       ///< Sample presence pulse.
+    SLOT,           ///< Start next bit slot.
+    SLOT_RELEASE    ///< End write 0 slot.
+  };
+
+  /// Fill ROM addressing and function command into the buffer, return # of bytes.
+  static uint8_t addressCommand(uint8_t* tx, const uint8_t* rom, uint8_t cmd) noexcept;
+
+  /// Execute one step of the state machine, return microseconds to next step or 0 when done.
+  uint16_t step() noexcept;
+
+  inline void driveLow() noexcept { *out_reg_ &= ~mask_; *mode_reg_ |= mask_; }
+  inline void driveHigh() noexcept { *out_reg_ |= mask_; *mode_reg_ |= mask_; }
+  inline void release() noexcept { *mode_reg_ &= ~mask_; *out_reg_ &= ~mask_; }
+  inline bool sample() const noexcept { return (*in_reg_ & mask_) != 0; }
+
+  volatile uint8_t* in_reg_;    ///< Input register of the pin.
+  volatile uint8_t* mode_reg_;  ///< Direction register of the pin.
+  volatile uint8_t* out_reg_;   ///< Output register of the pin.
+  uint8_t mask_;                ///< Bit mask of the pin in registers.
+  uint8_t tx_[MAX_TX];          ///< Bytes to write.
+  uint8_t tx_len_ = 0;          ///< Count of bytes to write.
+  uint8_t rx_len_ = 0;          ///< Count of bytes to read.
+  uint8_t* rx_ = nullptr;       ///< Buffer for bytes to read.
+  uint8_t bit_ = 0;             ///< Current bit index (write bits followed by read bits).
+  bool power_ = false;          ///< Drive bus high after the transaction.
+  State state_ = State::RESET;  ///< Current state.
+  volatile Status status_ = Status::IDLE; ///< Current status.
+
+  /// Transport running current transaction.
+  static OneWireAsync* volatile s_active_;
+};
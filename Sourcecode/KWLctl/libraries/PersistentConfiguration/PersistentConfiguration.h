@@ -33,6 +33,14 @@ class Print;
 class PersistentConfigurationBase
 {
 public:
+  /*!
+   * @brief Dump raw contents of the EEPROM to the specified stream.
+   *
+   * @param out stream to which to print.
+   * @param bytes_per_row how many bytes to print per row.
+   */
+  static void dumpRaw(Print& out, unsigned bytes_per_row = 16);
+
 protected:
   /// Function to load defaults.
   using LoadFnc = void (PersistentConfigurationBase::*)();
@@ -71,14 +79,6 @@ protected:
    */
   bool updateRange(const void* ptr, unsigned int size) const;
 
-  /*!
-   * @brief Dump raw contents of the EEPROM to the specified stream.
-   *
-   * @param out stream to which to print.
-   * @param bytes_per_row how many bytes to print per row.
-   */
-  static void dumpRaw(Print& out, unsigned bytes_per_row = 16);
-
   /*!
    * @brief Perform "factory reset".
    *
@@ -18,16 +18,47 @@
  */
 
 #include "TaskTimingStats.h"
+#include "TaskTrace.h"
 
 #include <avr/pgmspace.h>
 #include <stdio.h>
 
 using namespace Scheduler;
 
+namespace
+{
+  /// Function to report overruns to.
+  OverrunCallback s_overrun_fnc = nullptr;
+  /// Argument for overrun function.
+  void* s_overrun_arg = nullptr;
+  /// Budget for tasks without explicit budget.
+  uint16_t s_default_budget_ms = 0;
+
+  /// Check runtime against budget and report overrun, if needed.
+  void checkBudget(const __FlashStringHelper* name, uint8_t id, uint16_t budget_ms, unsigned long runtime)
+  {
+    if (!s_overrun_fnc)
+      return;
+    if (!budget_ms)
+      budget_ms = s_default_budget_ms;
+    if (budget_ms && runtime > budget_ms * 1000UL)
+      s_overrun_fnc(name, id, runtime, s_overrun_arg);
+  }
+}
+
+void Scheduler::setOverrunHandler(OverrunCallback f, void* arg, uint16_t default_budget_ms) noexcept
+{
+  s_overrun_fnc = f;
+  s_overrun_arg = arg;
+  s_default_budget_ms = default_budget_ms;
+}
+
 TaskTimingStats* TaskTimingStats::s_first_stat_ = nullptr;
 
-TaskTimingStats::TaskTimingStats(const __FlashStringHelper* name) noexcept :
+TaskTimingStats::TaskTimingStats(const __FlashStringHelper* name, uint16_t budget_ms) noexcept :
   name_(name),
+  budget_ms_(budget_ms),
+  trace_id_(TaskTrace::allocateId()),
   next_(s_first_stat_)
 {
   s_first_stat_ = this;
@@ -46,6 +77,7 @@ void TaskTimingStats::addRuntime(unsigned long runtime) noexcept
   }
   sum_runtime_ += runtime;
   ++count_runtime_;
+  checkBudget(name_, trace_id_, budget_ms_, runtime);
 }
 
 unsigned long TaskTimingStats::getAvgRuntime() const noexcept
@@ -78,8 +110,10 @@ void TaskTimingStats::resetMaximum() noexcept
 
 TaskPollingStats* TaskPollingStats::s_first_stat_ = nullptr;
 
-TaskPollingStats::TaskPollingStats(const __FlashStringHelper* name) noexcept :
+TaskPollingStats::TaskPollingStats(const __FlashStringHelper* name, uint16_t budget_ms) noexcept :
   name_(name),
+  budget_ms_(budget_ms),
+  trace_id_(TaskTrace::allocateId()),
   next_(s_first_stat_)
 {
   s_first_stat_ = this;
@@ -100,6 +134,7 @@ void TaskPollingStats::addPolltime(unsigned long polltime) noexcept
     sum_polltime_ >>= 1;
     count_polltime_ = 0x8000U;
   }
+  checkBudget(name_, trace_id_, budget_ms_, polltime);
 }
 
 unsigned long TaskPollingStats::getAvgPolltime() const noexcept {
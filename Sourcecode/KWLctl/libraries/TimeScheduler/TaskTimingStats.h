@@ -23,10 +23,35 @@
  */
 #pragma once
 
+#include <stdint.h>
+
 class __FlashStringHelper;
 
 namespace Scheduler
 {
+  /*!
+   * @brief Function to call when a task exceeds its runtime budget.
+   *
+   * The function is called from the scheduler after the task completed, so
+   * it should only record the overrun and defer any expensive reporting.
+   *
+   * @param name name of task statistics.
+   * @param id trace ID of the task.
+   * @param runtime runtime of the task in microseconds.
+   * @param arg user-specified argument.
+   */
+  using OverrunCallback = void(*)(const __FlashStringHelper* name, uint8_t id, unsigned long runtime, void* arg);
+
+  /*!
+   * @brief Set function to call when a task exceeds its runtime budget.
+   *
+   * @param f function to report an overrun to.
+   * @param arg argument to pass to the function.
+   * @param default_budget_ms budget in milliseconds for tasks without explicit
+   *    budget (0 means no budget).
+   */
+  void setOverrunHandler(OverrunCallback f, void* arg, uint16_t default_budget_ms) noexcept;
+
   /*!
    * @brief Statistics for timing operation duration.
    *
@@ -58,12 +83,21 @@ namespace Scheduler
       TaskTimingStats* cur_;
     };
 
-    /// Construct stats for a given task name.
-    explicit TaskTimingStats(const __FlashStringHelper* name) noexcept;
+    /*!
+     * @brief Construct stats for a given task name.
+     *
+     * @param name task name.
+     * @param budget_ms runtime budget in milliseconds, after which an overrun
+     *    is reported (0 for default budget, see setOverrunHandler()).
+     */
+    explicit TaskTimingStats(const __FlashStringHelper* name, uint16_t budget_ms = 0) noexcept;
 
     /// Get statistics name.
     const __FlashStringHelper* getName() const noexcept { return name_; }
 
+    /// Get ID of the task(s) using these statistics in the task trace.
+    uint8_t getTraceId() const noexcept { return trace_id_; }
+
     /// Add one runtime measurement.
     void addRuntime(unsigned long runtime) noexcept;
 
@@ -111,6 +145,10 @@ namespace Scheduler
     unsigned long count_runtime_ = 0;
     /// Count of runtime measurements "eaten out" to keep measurements in range.
     unsigned long adjust_count_runtime_ = 0;
+    /// Runtime budget in milliseconds (0 for default).
+    uint16_t budget_ms_;
+    /// Task ID in the task trace.
+    uint8_t trace_id_;
     /// Next task statistics in the list.
     TaskTimingStats* next_;
     /// First statistics.
@@ -148,12 +186,21 @@ namespace Scheduler
       TaskPollingStats* cur_;
     };
 
-    /// Construct stats for a given task name.
-    explicit TaskPollingStats(const __FlashStringHelper* name) noexcept;
+    /*!
+     * @brief Construct stats for a given task name.
+     *
+     * @param name task name.
+     * @param budget_ms runtime budget in milliseconds, after which an overrun
+     *    is reported (0 for default budget, see setOverrunHandler()).
+     */
+    explicit TaskPollingStats(const __FlashStringHelper* name, uint16_t budget_ms = 0) noexcept;
 
     /// Get statistics name.
     const __FlashStringHelper* getName() const noexcept { return name_; }
 
+    /// Get ID of the task(s) using these statistics in the task trace.
+    uint8_t getTraceId() const noexcept { return trace_id_; }
+
     /// Add time spent in polling.
     void addPolltime(unsigned long polltime) noexcept;
 
@@ -193,6 +240,10 @@ namespace Scheduler
     unsigned long sum_polltime_ = 0;
     /// Count of polltime measurements for this task.
     unsigned count_polltime_ = 0;
+    /// Runtime budget in milliseconds (0 for default).
+    uint16_t budget_ms_;
+    /// Task ID in the task trace.
+    uint8_t trace_id_;
     /// Next task statistics in the list.
     TaskPollingStats* next_;
     /// First statistics.
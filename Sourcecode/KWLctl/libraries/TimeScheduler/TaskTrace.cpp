@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+#include "TaskTrace.h"
+
+using namespace Scheduler;
+
+namespace
+{
+  /// Next trace ID to allocate (0 is reserved for unaccounted tasks).
+  uint8_t s_next_id = TaskTrace::UNACCOUNTED_ID + 1;
+
+#if SCHEDULER_TRACE_SIZE > 0
+  /// One trace entry.
+  struct TraceEntry
+  {
+    uint8_t id;
+    unsigned long start;
+    unsigned long duration;
+  };
+
+  TraceEntry s_entries[SCHEDULER_TRACE_SIZE];
+  /// Index of the next entry to write.
+  uint8_t s_next = 0;
+  /// Count of valid entries.
+  uint8_t s_count = 0;
+  /// Flag whether recording is stopped for dumping.
+  bool s_stopped = false;
+
+  /// Convert a nibble to a hex digit.
+  inline char hexDigit(uint8_t nibble)
+  {
+    return char(nibble < 10 ? '0' + nibble : 'a' - 10 + nibble);
+  }
+
+  /// Append a value as little-endian hex bytes.
+  char* appendHex(char* p, unsigned long value, uint8_t bytes)
+  {
+    while (bytes--) {
+      auto b = uint8_t(value);
+      *p++ = hexDigit(b >> 4);
+      *p++ = hexDigit(b & 15);
+      value >>= 8;
+    }
+    return p;
+  }
+#endif
+}
+
+volatile uint8_t TaskTrace::s_current_task_ __attribute__ ((section (".noinit")));
+
+uint8_t TaskTrace::allocateId() noexcept
+{
+  auto id = s_next_id;
+  if (s_next_id < NO_TASK_ID - 1)
+    ++s_next_id;
+  return id;
+}
+
+#if SCHEDULER_TRACE_SIZE > 0
+
+void TaskTrace::record(uint8_t id, unsigned long start, unsigned long end) noexcept
+{
+  if (s_stopped)
+    return;
+  auto& e = s_entries[s_next];
+  e.id = id;
+  e.start = start;
+  e.duration = end - start;
+  if (++s_next == SCHEDULER_TRACE_SIZE)
+    s_next = 0;
+  if (s_count < SCHEDULER_TRACE_SIZE)
+    ++s_count;
+}
+
+void TaskTrace::stop() noexcept
+{
+  s_stopped = true;
+}
+
+void TaskTrace::restart() noexcept
+{
+  s_next = s_count = 0;
+  s_stopped = false;
+}
+
+uint8_t TaskTrace::size() noexcept
+{
+  return s_count;
+}
+
+uint8_t TaskTrace::toHex(uint8_t first, char* buffer, unsigned size) noexcept
+{
+  // oldest entry is at s_next, if the ring is full, otherwise at 0
+  uint8_t index = (s_count < SCHEDULER_TRACE_SIZE) ? first : uint8_t((s_next + first) % SCHEDULER_TRACE_SIZE);
+  uint8_t count = 0;
+  char* p = buffer;
+  while (first + count < s_count && size > ENTRY_SIZE * 2) {
+    auto& e = s_entries[index];
+    p = appendHex(p, e.id, 1);
+    p = appendHex(p, e.start, 4);
+    p = appendHex(p, e.duration, 4);
+    size -= ENTRY_SIZE * 2;
+    ++count;
+    if (++index == SCHEDULER_TRACE_SIZE)
+      index = 0;
+  }
+  *p = 0;
+  return count;
+}
+
+#else
+
+void TaskTrace::stop() noexcept {}
+
+void TaskTrace::restart() noexcept {}
+
+uint8_t TaskTrace::size() noexcept { return 0; }
+
+uint8_t TaskTrace::toHex(uint8_t, char* buffer, unsigned) noexcept
+{
+  *buffer = 0;
+  return 0;
+}
+
+#endif
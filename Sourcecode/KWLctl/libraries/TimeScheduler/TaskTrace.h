@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018 Ivan Schréter (schreter@gmx.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This copyright notice MUST APPEAR in all copies of the software!
+ */
+
+/*!
+ * @file
+ * @brief Trace of task invocations for scheduler tasks.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * NOTE: Number of trace entries kept in RAM. Each entry consumes 9B of memory.
+ * Define the macro to 0 globally (compiler flags) to disable tracing.
+ */
+#ifndef SCHEDULER_TRACE_SIZE
+#define SCHEDULER_TRACE_SIZE 48
+#endif
+
+/*
+ * NOTE: Poll tasks run in each scheduler loop, so they would overwrite the trace
+ * quickly. Only poll task invocations taking at least this many microseconds
+ * are recorded. Define the macro to 0 to record all poll task invocations.
+ */
+#ifndef SCHEDULER_TRACE_POLL_THRESHOLD
+#define SCHEDULER_TRACE_POLL_THRESHOLD 500
+#endif
+
+namespace Scheduler
+{
+  /*!
+   * @brief Ring buffer of recent task invocations.
+   *
+   * For each task invocation, the task ID (see TaskTimingStats::getTraceId()
+   * and TaskPollingStats::getTraceId()), start time and duration in microseconds
+   * are recorded. The trace can be dumped in a compact binary form (hex-encoded
+   * to be transportable via MQTT or serial port) and converted to a timeline
+   * on the host.
+   *
+   * Each serialized entry consists of 9 bytes: task ID (1B), start time (4B,
+   * little-endian) and duration (4B, little-endian).
+   */
+  class TaskTrace
+  {
+  public:
+    /// Trace ID used for unaccounted tasks.
+    static constexpr uint8_t UNACCOUNTED_ID = 0;
+
+    /// Trace ID used when no task is running.
+    static constexpr uint8_t NO_TASK_ID = 255;
+
+    /// Size of one serialized entry in bytes.
+    static constexpr uint8_t ENTRY_SIZE = 9;
+
+    /// Allocate a new trace ID for a task statistics object.
+    static uint8_t allocateId() noexcept;
+
+    /*!
+     * @brief Set ID of the currently running task.
+     *
+     * The ID is kept in a non-initialized memory section, so it survives a
+     * reset and can be read by crash handler (e.g., watchdog interrupt).
+     * Since timed and poll tasks share the ID space, one slot is sufficient.
+     *
+     * @param id task trace ID or NO_TASK_ID after the task finished.
+     */
+    static inline void setCurrentTask(uint8_t id) noexcept { s_current_task_ = id; }
+
+    /// Get ID of the currently running task or NO_TASK_ID.
+    static inline uint8_t getCurrentTask() noexcept { return s_current_task_; }
+
+    /*!
+     * @brief Record one task invocation.
+     *
+     * @param id task trace ID.
+     * @param start start time of the task in microseconds.
+     * @param end end time of the task in microseconds.
+     */
+  #if SCHEDULER_TRACE_SIZE > 0
+    static void record(uint8_t id, unsigned long start, unsigned long end) noexcept;
+  #else
+    static inline void record(uint8_t, unsigned long, unsigned long) noexcept {}
+  #endif
+
+    /// Record one poll task invocation, if it took long enough.
+    static inline void recordPoll(uint8_t id, unsigned long start, unsigned long end) noexcept
+    {
+      if (end - start >= SCHEDULER_TRACE_POLL_THRESHOLD)
+        record(id, start, end);
+    }
+
+    /// Stop recording to take a consistent snapshot of the trace.
+    static void stop() noexcept;
+
+    /// Clear the trace and restart recording.
+    static void restart() noexcept;
+
+    /// Get count of valid entries in the trace.
+    static uint8_t size() noexcept;
+
+    /*!
+     * @brief Serialize trace entries as hexadecimal string.
+     *
+     * @param first index of the first entry to serialize (0 is the oldest entry).
+     * @param buffer,size buffer where to materialize the string.
+     * @return number of serialized entries.
+     */
+    static uint8_t toHex(uint8_t first, char* buffer, unsigned size) noexcept;
+
+  private:
+    /// ID of the currently running task.
+    static volatile uint8_t s_current_task_;
+  };
+}
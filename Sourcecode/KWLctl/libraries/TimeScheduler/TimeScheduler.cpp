@@ -27,8 +27,9 @@ namespace
   static const char SchedulerName[] PROGMEM = ("Scheduler");
   static const char AllTasksName[] PROGMEM = ("AllTasks");
 
-  static Scheduler::TaskTimingStats s_scheduler_runtime_stats(reinterpret_cast<const __FlashStringHelper*>(&SchedulerName[0]));
-  static Scheduler::TaskTimingStats s_total_runtime_stats(reinterpret_cast<const __FlashStringHelper*>(&AllTasksName[0]));
+  // sum of all tasks in one loop run is not subject to budget, set maximum
+  static Scheduler::TaskTimingStats s_scheduler_runtime_stats(reinterpret_cast<const __FlashStringHelper*>(&SchedulerName[0]), 0xffff);
+  static Scheduler::TaskTimingStats s_total_runtime_stats(reinterpret_cast<const __FlashStringHelper*>(&AllTasksName[0]), 0xffff);
 }
 
 unsigned long Scheduler::TimeScheduler::runTimedTasks() noexcept
@@ -24,6 +24,7 @@
 #pragma once
 
 #include "TaskBase.h"
+#include "TaskTrace.h"
 
 /*!
  * @brief Simple scheduler for cooperative multitasking.
@@ -48,6 +49,10 @@
  * much time. There is also a possibility to create unaccounted tasks, but
  * this is discouraged.
  *
+ * Additionally, recent task invocations are recorded in TaskTrace ring buffer,
+ * so the order of task executions can be analyzed (e.g., to find out which
+ * task delayed another one).
+ *
  * Following classes are implemented by the scheduler:
  *    - TimedTask and UnaccountedTimedTask for regular tasks,
  *    - PollTask and UnaccountedPollTask for polling tasks.
@@ -103,9 +108,12 @@ namespace Scheduler
   private:
     static unsigned long invoke(TaskBase& t, unsigned long start) noexcept {
       auto& instance = static_cast<TimedTask<Args...>&>(t);
+      TaskTrace::setCurrentTask(instance.stats_.getTraceId());
       instance.call_invoker_.invoke();
+      TaskTrace::setCurrentTask(TaskTrace::NO_TASK_ID);
       auto end = micros();
       instance.stats_.addRuntime(end - start);
+      TaskTrace::record(instance.stats_.getTraceId(), start, end);
       return end;
     }
 
@@ -138,10 +146,14 @@ namespace Scheduler
     {}
 
   private:
-    static unsigned long invoke(TaskBase& t, unsigned long /*start*/) {
+    static unsigned long invoke(TaskBase& t, unsigned long start) {
       auto& instance = static_cast<UnaccountedTimedTask<Args...>&>(t);
+      TaskTrace::setCurrentTask(TaskTrace::UNACCOUNTED_ID);
       instance.call_invoker_.invoke();
-      return micros();
+      TaskTrace::setCurrentTask(TaskTrace::NO_TASK_ID);
+      auto end = micros();
+      TaskTrace::record(TaskTrace::UNACCOUNTED_ID, start, end);
+      return end;
     }
 
     SchedulerImpl::call_invoker<Args...> call_invoker_;
@@ -177,9 +189,12 @@ namespace Scheduler
   private:
     static unsigned long invoke(TaskBase& t, unsigned long start) noexcept {
       auto& instance = static_cast<PollTask<Args...>&>(t);
+      TaskTrace::setCurrentTask(instance.stats_.getTraceId());
       instance.call_invoker_.invoke();
+      TaskTrace::setCurrentTask(TaskTrace::NO_TASK_ID);
       auto end = micros();
       instance.stats_.addPolltime(end - start);
+      TaskTrace::recordPoll(instance.stats_.getTraceId(), start, end);
       return end;
     }
 
@@ -212,10 +227,14 @@ namespace Scheduler
     {}
 
   private:
-    static unsigned long invoke(TaskBase& t, unsigned long /*start*/) noexcept {
+    static unsigned long invoke(TaskBase& t, unsigned long start) noexcept {
       auto& instance = static_cast<UnaccountedPollTask<Args...>&>(t);
+      TaskTrace::setCurrentTask(TaskTrace::UNACCOUNTED_ID);
       instance.call_invoker_.invoke();
-      return micros();
+      TaskTrace::setCurrentTask(TaskTrace::NO_TASK_ID);
+      auto end = micros();
+      TaskTrace::recordPoll(TaskTrace::UNACCOUNTED_ID, start, end);
+      return end;
     }
 
     SchedulerImpl::call_invoker<Args...> call_invoker_;